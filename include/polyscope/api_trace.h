@@ -0,0 +1,31 @@
+// Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
+#pragma once
+
+#include <string>
+
+namespace polyscope {
+
+class Structure;
+
+// Record what a program does with polyscope to a trace file, so the same workload can be replayed without the program
+// (e.g. with the polyscope-trace-replay tool on the mock backend) for profiling. The trace holds the data of every
+// structure and quantity as it is registered or changed, their settings, and the camera and scene options for every
+// frame. Traces use the snapshot file format (see snapshot.h), and are written as the program runs.
+void startTrace(std::string filename);
+void stopTrace();
+bool isTracing();
+
+// Replay a trace in the current session, replacing all structures, and drawing one frame for each recorded frame.
+// Returns the number of frames drawn.
+size_t replayTrace(std::string filename);
+
+namespace trace {
+
+// Internal hooks, which do nothing unless a trace is being recorded
+void markStructureChanged(Structure* s); // registered, quantities added or removed, or refreshed
+void markStructureRemoved(std::string typeName, std::string name);
+void recordFrame(); // called once per main loop iteration, after drawing
+
+} // namespace trace
+
+} // namespace polyscope
@@ -0,0 +1,67 @@
+// Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "glm/mat4x4.hpp"
+
+namespace polyscope {
+
+// A camera pose at a point in time
+struct CameraPathKeyframe {
+  double time; // in seconds from the start of the path
+  glm::mat4 viewMat;
+  double fov;
+};
+
+// A sequence of camera poses, which can be recorded from the interactive view, saved to a file, and replayed frame by
+// frame. Used for repeatable benchmarks and demo videos.
+class CameraPath {
+public:
+  std::vector<CameraPathKeyframe> keyframes; // ordered by time
+
+  // Add a keyframe at or after the last one. With no pose given, uses the current camera.
+  void addKeyframe(double time);
+  void addKeyframe(double time, const glm::mat4& viewMat, double fov);
+  double duration() const;
+
+  // The pose at time t, which is clamped to the path. Poses are blended between keyframes the same way as for
+  // view::startFlightTo().
+  void evaluate(double t, glm::mat4& viewMatOut, double& fovOut) const;
+
+  // Keyframes are stored in json, with the same fields as view::getCameraJson()
+  std::string toJson() const;
+  static CameraPath fromJson(std::string jsonData);
+  void save(std::string filename) const;
+  static CameraPath load(std::string filename);
+};
+
+// Record the camera as the user moves it around in the main loop. A keyframe is added whenever the camera moves, plus
+// one at each end so the path also keeps the time spent standing still.
+void startRecordingCameraPath();
+CameraPath stopRecordingCameraPath();
+bool isRecordingCameraPath();
+
+// Per-frame timings from replayCameraPath(), in milliseconds
+struct CameraPathTimings {
+  std::vector<double> frameTimes;
+  double mean = 0.;
+  double median = 0.;
+  double percentile95 = 0.;
+  double max = 0.;
+};
+
+// Render the path one frame at a time, advancing the camera by frameStep seconds per frame regardless of how long each
+// frame takes to draw, so that every replay renders exactly the same images. If framePrefix is not empty, each frame is
+// also saved as framePrefix_000000 etc, with options::screenshotExtension. The camera is restored afterwards.
+//
+// Frame times are measured on the CPU and include swapping the display buffers, but not UI drawing or file output.
+CameraPathTimings replayCameraPath(const CameraPath& path, double frameStep = 1. / 60., std::string framePrefix = "");
+
+namespace view {
+// Internal helper, called once per main loop iteration like updateFlight()
+void updateCameraPathRecording();
+} // namespace view
+
+} // namespace polyscope
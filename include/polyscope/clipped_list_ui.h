@@ -0,0 +1,40 @@
+// Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace polyscope {
+
+// A GUI list which stays cheap to build no matter how many items it holds, used for lists of structures and quantities
+// once they have at least minItems entries. It has a filter box and a scrolling region in which only the visible rows
+// are built. Each row has an "enabled" checkbox and a label, and clicking a label selects that item; the caller then
+// builds the full UI for the selected item only.
+class ClippedListUI {
+
+public:
+  static const size_t minItems = 32;
+
+  // Call whenever the items change (in number, order, or labels). Until then, the items matching the filter are cached.
+  void markItemsChanged();
+
+  // Build the list, returning the index of the selected item or -1 if there is none. The selection is remembered by
+  // label, so it survives changes to the list.
+  long long build(size_t nItems, const std::function<const std::string&(size_t)>& label,
+                  const std::function<bool(size_t)>& isEnabled, const std::function<void(size_t, bool)>& setEnabled);
+
+private:
+  void updateMatches(size_t nItems, const std::function<const std::string&(size_t)>& label);
+
+  char filterText[128] = "";
+  std::string matchedFilterText; // the filter the matches were computed for
+  bool matchesValid = false;
+  std::vector<size_t> matches;
+
+  std::string selectedLabel;
+  long long selectedIndex = -1;
+};
+
+} // namespace polyscope
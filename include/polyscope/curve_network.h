@@ -54,14 +54,15 @@ public:
   // Render for picking
   virtual void drawPick() override;
 
-  // A characteristic length for the structure
-  virtual double lengthScale() override;
-
-  // Axis-aligned bounding box for the structure
-  virtual std::tuple<glm::vec3, glm::vec3> boundingBox() override;
   virtual std::string typeName() override;
   
   virtual void refresh() override;
+  virtual double drawMargin() override;
+
+  // Snapshots (see snapshot.h)
+  virtual bool writeSnapshot(SnapshotWriter& writer) override;
+  static CurveNetwork* readSnapshot(std::string name, SnapshotReader& reader); // creates and registers the network
+  CurveNetworkQuantity* readQuantitySnapshot(std::string kind, std::string name, SnapshotReader& reader);
 
   // === Quantities
 
@@ -135,6 +136,9 @@ public:
   std::string getMaterial();
 
 private:
+  // Compute the (cached) bounding box and length scale
+  virtual void computeExtents(std::tuple<glm::vec3, glm::vec3>& bboxOut, double& lengthScaleOut) override;
+
   // === Visualization parameters
   PersistentValue<glm::vec3> color;
   PersistentValue<ScaledValue<float>> radius;
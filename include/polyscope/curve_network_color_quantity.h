@@ -40,6 +40,8 @@ public:
   virtual void createProgram() override;
 
   void buildNodeInfoGUI(size_t vInd) override;
+  virtual std::string snapshotKind() override;
+  virtual void writeSnapshot(SnapshotWriter& writer) override;
 
   // === Members
   std::vector<glm::vec3> values;
@@ -56,6 +58,8 @@ public:
   virtual void createProgram() override;
 
   void buildEdgeInfoGUI(size_t eInd) override;
+  virtual std::string snapshotKind() override;
+  virtual void writeSnapshot(SnapshotWriter& writer) override;
 
   // === Members
   std::vector<glm::vec3> values;
@@ -17,6 +17,8 @@ public:
   virtual void draw() override;
   virtual void buildCustomUI() override;
   virtual std::string niceName() override;
+  virtual std::string snapshotKind() override;
+  virtual void writeSnapshot(SnapshotWriter& writer) override;
   virtual void refresh() override;
 
 protected:
@@ -17,6 +17,7 @@ public:
 
 
   virtual void draw() override;
+  virtual double drawMargin() override;
   virtual void buildCustomUI() override;
 
   // Allow children to append to the UI
@@ -60,6 +61,8 @@ public:
                                  VectorType vectorType_ = VectorType::STANDARD);
 
   virtual std::string niceName() override;
+  virtual std::string snapshotKind() override;
+  virtual void writeSnapshot(SnapshotWriter& writer) override;
   virtual void buildNodeInfoGUI(size_t vInd) override;
   virtual void refresh() override;
 };
@@ -73,6 +76,8 @@ public:
                                  VectorType vectorType_ = VectorType::STANDARD);
 
   virtual std::string niceName() override;
+  virtual std::string snapshotKind() override;
+  virtual void writeSnapshot(SnapshotWriter& writer) override;
   virtual void buildEdgeInfoGUI(size_t fInd) override;
   virtual void refresh() override;
 };
@@ -1,10 +1,34 @@
 // Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
 #pragma once
 
+#include <cstddef>
 #include <string>
 
 
 namespace polyscope {
 
 std::string promptForFilename(std::string filename = "out");
-}
+
+// A file mapped read-only in to memory, so large data can be used in place without reading all of it up front. Throws
+// std::runtime_error if the file cannot be mapped.
+class MappedFile {
+public:
+  MappedFile(std::string filename);
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  const void* data() const { return ptr; }
+  size_t size() const { return length; }
+
+private:
+  void* ptr = nullptr;
+  size_t length = 0;
+#ifdef _WIN32
+  void* fileHandle = nullptr;
+  void* mappingHandle = nullptr;
+#endif
+};
+
+} // namespace polyscope
@@ -0,0 +1,61 @@
+// Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
+#pragma once
+
+#include "polyscope/scaled_value.h"
+
+namespace polyscope {
+
+// Holds a value in polyscope::options which requires some action when it changes, such as reconfiguring the render
+// engine. It converts to and from the underlying type, so `polyscope::options::ssaaFactor = 2;` works as it would for a
+// plain variable, and the change handler runs exactly once, immediately, whenever an assignment changes the value.
+//
+// There is no way to get a mutable pointer to the value, since a change made through it would go unnoticed. Widgets
+// which edit a value in place (e.g. in ImGui) should edit a copy, then assign it back.
+template <typename T>
+class ObservedOptionBase {
+
+public:
+  constexpr ObservedOptionBase(T value_, void (*onChange_)()) : value(value_), onChange(onChange_) {}
+
+  ObservedOptionBase(const ObservedOptionBase&) = delete;
+  ObservedOptionBase& operator=(const ObservedOptionBase&) = delete;
+
+  ObservedOptionBase& operator=(const T& newValue) {
+    if (!(newValue == value)) {
+      value = newValue;
+      if (onChange) onChange();
+    }
+    return *this;
+  }
+
+  operator T() const { return value; }
+  const T& get() const { return value; }
+  const T* operator->() const { return &value; }
+
+protected:
+  T value;
+  void (*onChange)();
+};
+
+template <typename T>
+class ObservedOption : public ObservedOptionBase<T> {
+public:
+  using ObservedOptionBase<T>::ObservedOptionBase;
+  using ObservedOptionBase<T>::operator=;
+};
+
+// Options which used to be plain ScaledValues keep their methods, so e.g. `options::groundPlaneHeightFactor.set(0.1,
+// false)` and `options::groundPlaneHeightFactor.asAbsolute()` still work. There is no getValuePtr(), for the reason
+// above.
+template <typename T>
+class ObservedOption<ScaledValue<T>> : public ObservedOptionBase<ScaledValue<T>> {
+public:
+  using ObservedOptionBase<ScaledValue<T>>::ObservedOptionBase;
+  using ObservedOptionBase<ScaledValue<T>>::operator=;
+
+  T asAbsolute() const { return this->value.asAbsolute(); }
+  bool isRelative() const { return this->value.isRelative(); }
+  void set(T value_, bool relativeFlag_ = true) { *this = ScaledValue<T>(value_, relativeFlag_); }
+};
+
+} // namespace polyscope
@@ -1,6 +1,7 @@
 // Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
 #pragma once
 
+#include "polyscope/observed_option.h"
 #include "polyscope/scaled_value.h"
 #include "polyscope/types.h"
 
@@ -33,6 +34,12 @@ extern bool usePrefsFile;
 // Should we redraw every frame, even if not requested? (default: false)
 extern bool alwaysRedraw;
 
+// When there has been no input and no redraw has been requested for a few frames, block waiting for window events
+// instead of running the main loop at maxFPS. The user callback still runs at least once every idleTimeout seconds.
+// (default: false, default timeout: 0.5)
+extern bool sleepWhenIdle;
+extern float idleTimeout;
+
 // Should we center/scale every structure after it is loaded up (default: false)
 extern bool autocenterStructures;
 extern bool autoscaleStructures;
@@ -43,14 +50,22 @@ extern bool openImGuiWindowForUserCallback;
 // If true, the user callback will be invoked for nested calls to polyscope::show(), otherwise not (default: false)
 extern bool invokeUserCallbackForNestedShow;
 
+// Number of threads used for parallel and background work, including the calling thread. 0 means one per hardware
+// thread. 1 does all work serially on the calling thread, so background jobs finish before returning and results are
+// reproducible run to run. (default: 0) See also tasks::setExecutor().
+extern ObservedOption<int> nThreads;
+
 // === Scene options
 
+// Note: options held in an ObservedOption take effect immediately when assigned (see observed_option.h)
+
 // Behavior of the ground plane
-extern GroundPlaneMode groundPlaneMode;
-extern bool groundPlaneEnabled; // deprecated, but kept and respected for compatability. use groundPlaneMode.
-extern ScaledValue<float> groundPlaneHeightFactor;
-extern int shadowBlurIters;
-extern float shadowDarkness;
+extern ObservedOption<GroundPlaneMode> groundPlaneMode;
+// deprecated, but kept and respected for compatability. use groundPlaneMode.
+extern ObservedOption<bool> groundPlaneEnabled;
+extern ObservedOption<ScaledValue<float>> groundPlaneHeightFactor;
+extern ObservedOption<int> shadowBlurIters;
+extern ObservedOption<float> shadowDarkness;
 
 extern bool screenshotTransparency;     // controls whether screenshots taken by clicking the GUI button have a
                                         // transparent background
@@ -60,11 +75,31 @@ extern std::string screenshotExtension; // sets the extension used for automatic
 // === Rendering parameters
 
 // SSAA scaling in pixel multiples
-extern int ssaaFactor;
+extern ObservedOption<int> ssaaFactor;
+
+// Progressive anti-aliasing: rather than supersampling, average sub-pixel jittered frames while the view is still. When
+// enabled the scene is rendered at 1x and ssaaFactor is ignored.
+extern ObservedOption<bool> progressiveAA;
+extern int progressiveAASamples; // number of frames averaged before the image is converged
 
 // Transparency settings for the renderer
-extern TransparencyMode transparencyMode;
-extern int transparencyRenderPasses;
+extern ObservedOption<TransparencyMode> transparencyMode;
+extern ObservedOption<int> transparencyRenderPasses;
+
+// Skip drawing structures, and spatial chunks of large structures, which are outside of the view. Those which cover
+// less than smallFeatureCullingPixels on screen are skipped too (0 disables this). (default: true, 0)
+extern ObservedOption<bool> frustumCulling;
+extern ObservedOption<float> smallFeatureCullingPixels;
+
+// Also skip those which are hidden behind other opaque structures. The (at most) occlusionMaxOccluders largest
+// structures on screen are drawn in a depth pre-pass every frame, which is read back to test the rest against, so this
+// only pays off for scenes with many hidden parts. (default: false, 16)
+extern ObservedOption<bool> occlusionCulling;
+extern ObservedOption<int> occlusionMaxOccluders;
+
+// Surface meshes with level of detail enabled are simplified as far as possible while their error stays below this
+// many pixels on screen (see SurfaceMesh::setLevelOfDetail()). (default: 1)
+extern ObservedOption<float> lodPixelError;
 
 // === Debug options
 
@@ -9,9 +9,11 @@
 #include "polyscope/render/materials.h"
 #include "polyscope/surface_parameterization_enums.h"
 
+#include <cstdint>
 #include <iostream>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace polyscope {
 
@@ -22,29 +24,149 @@ namespace polyscope {
 // We carefully overload the copy and move operators to allow the value to take the _value_ of other variables via
 // assignment, but always retain its name after creation.
 
-// Note that PersistentValue<T> can only be instantiated if T is one of the types for which the global table is declared
-// below and instantiated in persistent_value.cpp.
+// Note that PersistentValue<T> can only be instantiated if T is one of the types for which the global store is declared
+// below.
+//
+// Each (name, type) pair is interned once on construction into a small integer key; afterwards reads and writes of the
+// cache are plain array accesses. Values of all types live in a single store, densely packed per type, which can be
+// snapshotted and restored in bulk (see snapshotPersistentValues() below).
 
 
 namespace detail {
-// Simple wrapper class holding the cache for persistent values
-template <typename T>
-class PersistentCache {
+
+// clang-format off
+enum class PersistentType : unsigned char { Double = 0, Float, Bool, String, Vec3, Mat4, ScaledDouble, ScaledFloat, ParamVizStyle, BackfacePolicy };
+template <typename T> struct PersistentTypeOf;
+template<> struct PersistentTypeOf<double>              { static const PersistentType value = PersistentType::Double; };
+template<> struct PersistentTypeOf<float>               { static const PersistentType value = PersistentType::Float; };
+template<> struct PersistentTypeOf<bool>                { static const PersistentType value = PersistentType::Bool; };
+template<> struct PersistentTypeOf<std::string>         { static const PersistentType value = PersistentType::String; };
+template<> struct PersistentTypeOf<glm::vec3>           { static const PersistentType value = PersistentType::Vec3; };
+template<> struct PersistentTypeOf<glm::mat4>           { static const PersistentType value = PersistentType::Mat4; };
+template<> struct PersistentTypeOf<ScaledValue<double>> { static const PersistentType value = PersistentType::ScaledDouble; };
+template<> struct PersistentTypeOf<ScaledValue<float>>  { static const PersistentType value = PersistentType::ScaledFloat; };
+template<> struct PersistentTypeOf<ParamVizStyle>       { static const PersistentType value = PersistentType::ParamVizStyle; };
+template<> struct PersistentTypeOf<BackfacePolicy>      { static const PersistentType value = PersistentType::BackfacePolicy; };
+// clang-format on
+
+typedef uint32_t PersistentKey;
+
+// The cached values, indexed by key. Keys without a value map to noValue.
+class PersistentValueTable {
 public:
-  std::unordered_map<std::string, T> cache;
+  static const uint32_t noValue = static_cast<uint32_t>(-1);
+
+  bool has(PersistentKey key) const {
+    return key < valueIndex.size() && valueIndex[key] != noValue;
+  }
+  template <typename T>
+  T get(PersistentKey key) const {
+    return values<T>()[valueIndex[key]];
+  }
+  template <typename T>
+  void set(PersistentKey key, const T& value) {
+    if (key >= valueIndex.size()) {
+      valueIndex.resize(key + 1, noValue);
+    }
+    std::vector<T>& vals = values<T>();
+    if (valueIndex[key] == noValue) {
+      valueIndex[key] = static_cast<uint32_t>(vals.size());
+      vals.push_back(value);
+    } else {
+      vals[valueIndex[key]] = value;
+    }
+  }
+
+  // Dense storage for each type
+  template <typename T>
+  std::vector<T>& values();
+  template <typename T>
+  const std::vector<T>& values() const {
+    return const_cast<PersistentValueTable*>(this)->values<T>();
+  }
+
+  std::vector<uint32_t> valueIndex;
+
+  // clang-format off
+  std::vector<double> values_double;
+  std::vector<float> values_float;
+  std::vector<char> values_bool; // (not std::vector<bool>, which cannot hand out references)
+  std::vector<std::string> values_string;
+  std::vector<glm::vec3> values_glmvec3;
+  std::vector<glm::mat4> values_glmmat4;
+  std::vector<ScaledValue<double>> values_scaleddouble;
+  std::vector<ScaledValue<float>> values_scaledfloat;
+  std::vector<ParamVizStyle> values_paramVizStyle;
+  std::vector<BackfacePolicy> values_backfacePolicy;
+  // clang-format on
 };
-// Helper to get the global cache for a particular type of persistent value
-template <typename T>
-PersistentCache<T>& getPersistentCacheRef();
+
+// clang-format off
+template<> inline std::vector<double>&              PersistentValueTable::values<double>()              { return values_double; }
+template<> inline std::vector<float>&               PersistentValueTable::values<float>()               { return values_float; }
+template<> inline std::vector<std::string>&         PersistentValueTable::values<std::string>()         { return values_string; }
+template<> inline std::vector<glm::vec3>&           PersistentValueTable::values<glm::vec3>()           { return values_glmvec3; }
+template<> inline std::vector<glm::mat4>&           PersistentValueTable::values<glm::mat4>()           { return values_glmmat4; }
+template<> inline std::vector<ScaledValue<double>>& PersistentValueTable::values<ScaledValue<double>>() { return values_scaleddouble; }
+template<> inline std::vector<ScaledValue<float>>&  PersistentValueTable::values<ScaledValue<float>>()  { return values_scaledfloat; }
+template<> inline std::vector<ParamVizStyle>&       PersistentValueTable::values<ParamVizStyle>()       { return values_paramVizStyle; }
+template<> inline std::vector<BackfacePolicy>&      PersistentValueTable::values<BackfacePolicy>()      { return values_backfacePolicy; }
+// clang-format on
+
+// bools are stored as chars
+template <>
+inline bool PersistentValueTable::get<bool>(PersistentKey key) const {
+  return values_bool[valueIndex[key]] != 0;
+}
+template <>
+inline void PersistentValueTable::set<bool>(PersistentKey key, const bool& value) {
+  if (key >= valueIndex.size()) {
+    valueIndex.resize(key + 1, noValue);
+  }
+  if (valueIndex[key] == noValue) {
+    valueIndex[key] = static_cast<uint32_t>(values_bool.size());
+    values_bool.push_back(value);
+  } else {
+    values_bool[valueIndex[key]] = value;
+  }
+}
+
+// The global cache of persistent values: the interned keys, and the table of values.
+class PersistentStore {
+public:
+  // Get the key for a name and type, creating it if needed. Keys are never removed, so they stay valid for good.
+  PersistentKey intern(const std::string& name, PersistentType type);
+
+  size_t keyCount() const { return keys.size(); }
+  const std::string& keyName(PersistentKey key) const { return *keys[key].name; }
+  PersistentType keyType(PersistentKey key) const { return keys[key].type; }
+
+  PersistentValueTable table;
+
+private:
+  struct KeyInfo {
+    const std::string* name; // points in to firstKeyByName, whose nodes do not move
+    PersistentType type;
+    PersistentKey nextSameName; // the same name may be used with several types
+  };
+  static const PersistentKey noKey = static_cast<PersistentKey>(-1);
+
+  std::unordered_map<std::string, PersistentKey> firstKeyByName;
+  std::vector<KeyInfo> keys;
+};
+
+extern PersistentStore persistentStore;
+
 } // namespace detail
 
 template <typename T>
 class PersistentValue {
 public:
   // Basic constructor, used on initial creation
-  PersistentValue(const std::string& name_, T value_) : name(name_), value(value_) {
-    if (detail::getPersistentCacheRef<T>().cache.find(name) != detail::getPersistentCacheRef<T>().cache.end()) {
-      value = detail::getPersistentCacheRef<T>().cache[name];
+  PersistentValue(const std::string& name_, T value_)
+      : key(detail::persistentStore.intern(name_, detail::PersistentTypeOf<T>::value)), value(value_) {
+    if (detail::persistentStore.table.has(key)) {
+      value = detail::persistentStore.table.get<T>(key);
     } else {
       // Update cache value
       manuallyChanged();
@@ -88,7 +210,7 @@ public:
   // Explicit setter, which takes care of storing in cache
   void set(T value_) {
     value = value_;
-    detail::getPersistentCacheRef<T>().cache[name] = value;
+    detail::persistentStore.table.set<T>(key, value);
   }
 
   // Make all template variants friends, so conversion can access private members
@@ -96,35 +218,26 @@ public:
   friend class PersistentValue;
 
 private:
-  const std::string name;
+  const detail::PersistentKey key;
   T value;
 };
 
-// clang-format off
-namespace detail {
-extern PersistentCache<double> persistentCache_double;
-extern PersistentCache<float> persistentCache_float;
-extern PersistentCache<bool> persistentCache_bool;
-extern PersistentCache<std::string> persistentCache_string;
-extern PersistentCache<glm::vec3> persistentCache_glmvec3;
-extern PersistentCache<glm::mat4> persistentCache_glmmat4;
-extern PersistentCache<ScaledValue<double>> persistentCache_scaleddouble;
-extern PersistentCache<ScaledValue<float>> persistentCache_scaledfloat;
-extern PersistentCache<ParamVizStyle> persistentCache_paramVizStyle;
-extern PersistentCache<BackfacePolicy> persistentCache_backfacePolicy;
-
-template<> inline PersistentCache<double>&                  getPersistentCacheRef<double>()                 { return persistentCache_double; }
-template<> inline PersistentCache<float>&                   getPersistentCacheRef<float>()                  { return persistentCache_float; }
-template<> inline PersistentCache<bool>&                    getPersistentCacheRef<bool>()                   { return persistentCache_bool; }
-template<> inline PersistentCache<std::string>&             getPersistentCacheRef<std::string>()            { return persistentCache_string; }
-template<> inline PersistentCache<glm::vec3>&               getPersistentCacheRef<glm::vec3>()              { return persistentCache_glmvec3; }
-template<> inline PersistentCache<glm::mat4>&               getPersistentCacheRef<glm::mat4>()              { return persistentCache_glmmat4; }
-template<> inline PersistentCache<ScaledValue<double>>&     getPersistentCacheRef<ScaledValue<double>>()    { return persistentCache_scaleddouble; }
-template<> inline PersistentCache<ScaledValue<float>>&      getPersistentCacheRef<ScaledValue<float>>()     { return persistentCache_scaledfloat; }
-template<> inline PersistentCache<ParamVizStyle>&           getPersistentCacheRef<ParamVizStyle>()          { return persistentCache_paramVizStyle; }
-template<> inline PersistentCache<BackfacePolicy>&          getPersistentCacheRef<BackfacePolicy>()         { return persistentCache_backfacePolicy; }
-}
-// clang-format on
+// A copy of every cached persistent value. Snapshots are cheap to take and restore, since the values are stored densely.
+// Note that restoring only affects the cache, and hence values which are created afterwards (e.g. by registering a
+// structure with the same name again); values which currently exist are unchanged.
+typedef detail::PersistentValueTable PersistentValueSnapshot;
+PersistentValueSnapshot snapshotPersistentValues();
+void restorePersistentValues(const PersistentValueSnapshot& snapshot);
+
+// Write the cached persistent values to a json file, or add the values from such a file to the cache. This can be used
+// to keep appearance settings between sessions, loading them before structures are registered.
+void savePersistentValues(std::string filename);
+void loadPersistentValues(std::string filename);
 
+namespace detail {
+// The json text used by the functions above. Reading throws on malformed input.
+std::string persistentValuesToJSON();
+void persistentValuesFromJSON(const std::string& text);
+} // namespace detail
 
 } // namespace polyscope
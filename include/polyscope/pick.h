@@ -4,6 +4,7 @@
 #include "polyscope/structure.h"
 
 #include <cstdint>
+#include <unordered_set>
 #include <utility>
 
 namespace polyscope {
@@ -15,6 +16,9 @@ namespace pick {
 // Request 'count' contiguous indices for drawing a pick buffer. The return value is the start of the range.
 size_t requestPickBufferRange(Structure* requestingStructure, size_t count);
 
+// Forget the ranges allocated to these structures (which are being deleted)
+void releasePickBufferRanges(const std::unordered_set<Structure*>& structures);
+
 
 // == Main query
 // Get the structure which was clicked on (nullptr if none), and the pick ID in local indices for that structure (such
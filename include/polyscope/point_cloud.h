@@ -52,10 +52,14 @@ public:
   // Standard structure overrides
   virtual void draw() override;
   virtual void drawPick() override;
-  virtual double lengthScale() override;
-  virtual std::tuple<glm::vec3, glm::vec3> boundingBox() override;
   virtual std::string typeName() override;
   virtual void refresh() override;
+  virtual double drawMargin() override;
+
+  // Snapshots (see snapshot.h)
+  virtual bool writeSnapshot(SnapshotWriter& writer) override;
+  static PointCloud* readSnapshot(std::string name, SnapshotReader& reader); // creates and registers the point cloud
+  PointCloudQuantity* readQuantitySnapshot(std::string kind, std::string name, SnapshotReader& reader);
 
   // === Quantities
 
@@ -126,7 +130,17 @@ public:
   std::vector<std::string> addStructureRules(std::vector<std::string> initRules);
   void fillGeometryBuffers(render::ShaderProgram& p);
 
+  // Large clouds are drawn in a spatial order, so that the runs of points which are culled together are compact.
+  // Per-point data must be put in this order for drawing.
+  template <typename T>
+  std::vector<T> inDrawOrder(const std::vector<T>& data);
+  const std::vector<size_t>& getPointDrawOrder(); // the point at each position in the drawing data; empty for identity
+
 private:
+  // Compute the (cached) bounding box and length scale
+  virtual void computeExtents(std::tuple<glm::vec3, glm::vec3>& bboxOut, double& lengthScaleOut) override;
+  virtual void computeCullingChunks(std::vector<CullingChunk>& chunksOut) override;
+
   // === Visualization parameters
   PersistentValue<glm::vec3> pointColor;
   PersistentValue<ScaledValue<float>> pointRadius;
@@ -136,6 +150,8 @@ private:
   // if nullptr, prepare() (resp. preparePick()) needs to be called
   std::shared_ptr<render::ShaderProgram> program;
   std::shared_ptr<render::ShaderProgram> pickProgram;
+  std::vector<size_t> pointDrawOrder;
+  bool pointDrawOrderValid = false; // until the points change (see refresh())
 
   // === Helpers
   // Do setup work related to drawing, including allocating openGL data
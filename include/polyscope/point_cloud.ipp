@@ -28,6 +28,11 @@ PointCloud* registerPointCloud2D(std::string name, const T& points) {
   return s;
 }
 
+template <typename T>
+std::vector<T> PointCloud::inDrawOrder(const std::vector<T>& data) {
+  return applyPermutation(data, getPointDrawOrder());
+}
+
 template <class V>
 void PointCloud::updatePointPositions(const V& newPositions) {
   points = standardizeVectorArray<glm::vec3, 3>(newPositions);
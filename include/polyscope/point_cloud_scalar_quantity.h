@@ -24,6 +24,8 @@ public:
   virtual void refresh() override;
 
   virtual std::string niceName() override;
+  virtual std::string snapshotKind() override;
+  virtual void writeSnapshot(SnapshotWriter& writer) override;
 
 
 protected:
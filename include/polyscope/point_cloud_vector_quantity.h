@@ -16,9 +16,12 @@ public:
   std::vector<glm::vec3> vectors;
 
   virtual void draw() override;
+  virtual double drawMargin() override;
   virtual void buildCustomUI() override;
   virtual void buildPickUI(size_t ind) override;
   virtual std::string niceName() override;
+  virtual std::string snapshotKind() override;
+  virtual void writeSnapshot(SnapshotWriter& writer) override;
   virtual void refresh() override;
 
   // === Members
@@ -84,6 +84,23 @@ void removeAllStructures();
 // Recompute the global state::lengthScale, boundingBox, and center by looping over registered structures
 void updateStructureExtents();
 
+// === Batch structure registration and removal
+
+// While a batch is open, registering and removing structures skips the bookkeeping which would otherwise happen for
+// each one (updating the scene extents, auto-centering/scaling, releasing pick ranges, requesting a redraw); endBatch()
+// does it all in one pass. Batches may be nested, the work happens when the outermost one ends.
+void beginBatch();
+void endBatch();
+
+// Opens a batch for its lifetime
+class StructureBatch {
+public:
+  StructureBatch() { beginBatch(); }
+  ~StructureBatch() { endBatch(); }
+  StructureBatch(const StructureBatch&) = delete;
+  StructureBatch& operator=(const StructureBatch&) = delete;
+};
+
 // Essentially regenerates all state and programs within Polyscope, calling refresh() recurisvely on all structures and
 // quantities
 void refresh();
@@ -96,6 +113,14 @@ void draw(bool withUI = true);
 // Request that the 3D scene be redrawn for the next frame. Should be called anytime something changes in the scene.
 void requestRedraw();
 
+// Request a redraw for a change which only affects how the scene is viewed (camera motion, field of view, etc). Unlike
+// requestRedraw(), view-independent cached data like the ground shadow is kept.
+void requestViewRedraw();
+
+// Incremented by every requestRedraw(). Cached data which depends only on the contents of the scene is regenerated when
+// this changes.
+size_t sceneContentVersion();
+
 // Has a redraw been requested for the next frame?
 bool redrawRequested();
 
@@ -113,9 +138,10 @@ void popContext();
 void mainLoopIteration();
 void initializeImGUIContext();
 void drawStructures();
+void drawOcclusionPrepass(); // see options::occlusionCulling
 
-// Called to check any options that might have been changed and perform appropriate updates. Users generally should not
-// need to call this directly.
+// Deprecated: options held in an ObservedOption take effect immediately when they are assigned, so there is no need to
+// call this. Kept so existing code continues to compile.
 void processLazyProperties();
 
 
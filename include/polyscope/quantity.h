@@ -2,6 +2,7 @@
 #pragma once
 
 #include "polyscope/persistent_value.h"
+#include "polyscope/snapshot.h"
 
 #include <string>
 
@@ -38,8 +39,23 @@ public:
   // A decorated name for the quantity that will be used in headers. For instance, for surface scalar named "value" we
   // return "value (scalar)"
   virtual std::string niceName();
+  const std::string& cachedNiceName(); // niceName(), computed once (the name and type of a quantity never change)
   std::string uniquePrefix();
 
+  // How far this quantity may draw outside of its parent's bounding box, used for culling
+  virtual double drawMargin();
+
+  // Wait for any drawing data being assembled in the background (see render::StagedPreparation). Called before the
+  // quantity is removed, and before the parent's data changes.
+  virtual void cancelBackgroundPreparation();
+
+  // = Snapshots (see snapshot.h)
+
+  // Quantities which can be saved in a snapshot return a non-empty kind, and write the data needed to re-create them.
+  // The parent structure reads it back in its readQuantitySnapshot().
+  virtual std::string snapshotKind();
+  virtual void writeSnapshot(SnapshotWriter& writer);
+
   // === Member variables ===
   S& parent;              // the parent structure with which this quantity is associated
   const std::string name; // a name for this quantity, which must be unique amongst quantities on `parent`
@@ -47,6 +63,9 @@ public:
   // Is this quantity currently being displayed?
   PersistentValue<bool> enabled; // should be set by setEnabled()
   bool dominates = false;
+
+private:
+  std::string niceNameCache;
 };
 
 
@@ -28,7 +28,7 @@ void Quantity<S>::draw() {}
 template <typename S>
 void Quantity<S>::buildUI() {
 
-  if (ImGui::TreeNode(niceName().c_str())) {
+  if (ImGui::TreeNode(cachedNiceName().c_str())) {
 
     // Enabled checkbox
     bool enabledLocal = enabled.get();
@@ -89,6 +89,30 @@ std::string Quantity<S>::niceName() {
   return name;
 }
 
+template <typename S>
+const std::string& Quantity<S>::cachedNiceName() {
+  if (niceNameCache.empty()) {
+    niceNameCache = niceName();
+  }
+  return niceNameCache;
+}
+
+template <typename S>
+double Quantity<S>::drawMargin() {
+  return 0.;
+}
+
+template <typename S>
+void Quantity<S>::cancelBackgroundPreparation() {}
+
+template <typename S>
+std::string Quantity<S>::snapshotKind() {
+  return "";
+}
+
+template <typename S>
+void Quantity<S>::writeSnapshot(SnapshotWriter& writer) {}
+
 template <typename S>
 std::string Quantity<S>::uniquePrefix() {
   return parent.uniquePrefix() + name + "#";
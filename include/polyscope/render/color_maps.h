@@ -1,6 +1,7 @@
 // Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
 #pragma once
 
+#include <cstdint>
 #include <vector>
 
 #include "polyscope/color_management.h"
@@ -74,10 +75,19 @@ struct ValueColorMap {
     double lowerVal = std::floor(scaledVal);
     double upperBlendVal = scaledVal - lowerVal;
     unsigned int lowerInd = static_cast<unsigned int>(lowerVal);
-    unsigned int upperInd = lowerInd + 1;
+    unsigned int upperInd = std::min(lowerInd + 1, static_cast<unsigned int>(values.size() - 1));
 
     return (float)(1.0 - upperBlendVal) * values[lowerInd] + (float)upperBlendVal * values[upperInd];
   }
+
+  // Samples many values at once, after mapping each from [rangeMin, rangeMax] to [0,1]. Same results as getValue() (up
+  // to float rounding), including black for non-finite values. Large arrays are processed in parallel chunks.
+  void getValues(const float* vals, size_t n, double rangeMin, double rangeMax, glm::vec3* colorsOut) const;
+  void getValues(const double* vals, size_t n, double rangeMin, double rangeMax, glm::vec3* colorsOut) const;
+
+  // Same, with 8-bit output (3 bytes per value)
+  void getValues(const float* vals, size_t n, double rangeMin, double rangeMax, uint8_t* rgbOut) const;
+  void getValues(const double* vals, size_t n, double rangeMin, double rangeMax, uint8_t* rgbOut) const;
 };
 
 
@@ -2,8 +2,10 @@
 #pragma once
 
 #include <array>
+#include <chrono>
 #include <cstdint>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "polyscope/render/color_maps.h"
@@ -34,6 +36,13 @@ enum class DrawMode {
   IndexedLineStripAdjacency
 };
 
+// A range of the data drawn by a ShaderProgram, in the same units as its draw length (vertices, or indices for the
+// indexed modes)
+struct DrawRange {
+  uint32_t start;
+  uint32_t count;
+};
+
 enum class FilterMode { Nearest = 0, Linear };
 enum class TextureFormat { RGB8 = 0, RGBA8, RG16F, RGB16F, RGBA16F, RGBA32F, RGB32F, R32F, R16F, DEPTH24 };
 enum class RenderBufferType { Color, ColorAlpha, Depth, Float4 };
@@ -48,7 +57,8 @@ namespace render {
 class TextureBuffer {
 public:
   // abstract class: use the factory methods from the Engine class
-  TextureBuffer(int dim_, TextureFormat format_, unsigned int sizeX_, unsigned int sizeY_ = -1);
+  TextureBuffer(int dim_, TextureFormat format_, unsigned int sizeX_, unsigned int sizeY_ = -1,
+                unsigned int sizeZ_ = -1);
 
   virtual ~TextureBuffer();
 
@@ -58,11 +68,16 @@ public:
 
   unsigned int getSizeX() const { return sizeX; }
   unsigned int getSizeY() const { return sizeY; }
+  unsigned int getSizeZ() const { return sizeZ; }
   int getDimension() const { return dim; }
   unsigned int getTotalSize() const; // product of dimensions
 
   virtual void setFilterMode(FilterMode newMode);
 
+  // Overwrite a box of a 3D texture with data for a single channel format, x fastest
+  virtual void setSubData3D(unsigned int offX, unsigned int offY, unsigned int offZ, unsigned int sizeX_,
+                            unsigned int sizeY_, unsigned int sizeZ_, const float* data) = 0;
+
   // Get texture data CPU-side
   // (call the version which matches the dimension of the texture datatype, otherwise you will get an error. remember
   // that the texture datatype is a distinct concepts from its spatial dimension stored in dim)
@@ -80,7 +95,7 @@ public:
 protected:
   int dim;
   TextureFormat format;
-  unsigned int sizeX, sizeY;
+  unsigned int sizeX, sizeY, sizeZ;
 };
 
 class RenderBuffer {
@@ -143,6 +158,7 @@ public:
   virtual std::array<float, 4> readFloat4(int xPos, int yPos) = 0;
   virtual void blitTo(FrameBuffer* other) = 0;
   virtual std::vector<unsigned char> readBuffer() = 0;
+  virtual std::vector<float> readDepth() = 0; // in [0,1], row-major from the bottom left
 
 protected:
   unsigned int sizeX, sizeY;
@@ -189,6 +205,17 @@ struct ShaderStageSpecification {
   const std::string src;
 };
 
+// A shader stage whose source has been split at its `${ TAG }$` tags, so replacement rules can be applied by splicing
+// text between the segments (see shader_builder.h). Implicitly constructed from a specification, parsing its source.
+// Throws std::runtime_error on unmatched tags.
+struct ParsedShaderStage {
+  ParsedShaderStage(const ShaderStageSpecification& spec);
+
+  ShaderStageSpecification spec;
+  std::vector<std::string> segments; // source text around the tags, one more than the number of tags
+  std::vector<std::string> tags;
+};
+
 // A simple interface for replacement rules to customize shaders
 // The "replacements" are key-value pairs will be used to modify the program source. Each key corresponds to a tag in
 // the program source, which will be replaced by the string value (if many such replacements exist, the values are
@@ -276,6 +303,10 @@ public:
   // Call once to initialize GLSL code used by multiple shaders
   static void initCommonShaders(); // TODO
 
+  // Limit draw() to some ranges of the data, e.g. the parts of a structure which are not culled. The ranges are read at
+  // every draw, so they must stay valid for as long as they are set. If they are null or empty, everything is drawn.
+  void setDrawRanges(const std::vector<DrawRange>* ranges) { drawRanges = ranges; }
+
   // Draw!
   virtual void draw() = 0;
 
@@ -295,10 +326,33 @@ protected:
   bool primitiveRestartIndexSet = false;
   unsigned int restartIndex = -1;
 
+  const std::vector<DrawRange>* drawRanges = nullptr;
+
   // Tessellation parameters
   unsigned int nPatchVertices;
 };
 
+// Values which are shared by all shader programs during a frame. Rather than being set as uniforms on every program,
+// these are stored in a single uniform block (declared in shaders by the FRAME_UNIFORMS rule), which is uploaded only
+// when one of the values changes.
+// Layout matches the std140 layout of the uniform block; don't reorder members.
+struct FrameUniforms {
+  glm::mat4 projMatrix{1.};
+  glm::mat4 invProjMatrix{1.};
+  glm::vec4 viewport{0., 0., 0., 0.};
+  glm::vec2 viewportDim{0., 0.};
+  float pixelScale = 1.;
+  float pad0 = 0.;
+};
+
+// Counters for occlusion culling, see Engine::beginOcclusionPrepass()
+struct OcclusionStats {
+  size_t nOccluders = 0;         // structures drawn in the depth pre-pass
+  size_t nTested = 0;            // boxes tested against the pyramid since it was built
+  size_t nOccluded = 0;          // ... and how many of them were hidden
+  double buildMilliseconds = 0.; // time to draw the pre-pass, read it back, and build the pyramid
+};
+
 // A few forward declarations for types that engine needs to touch
 class GroundPlane;
 
@@ -336,6 +390,12 @@ public:
   void setCurrentPixelScaling(float scale);
   float getCurrentPixelScaling();
 
+  // Per-frame uniforms (see FrameUniforms). The viewport and pixel scaling are tracked by the setters above.
+  void updateFrameCameraUniforms(); // recompute the projection from the current view, call before drawing
+  void setFrameProjectionMatrix(const glm::mat4& P); // draw with some other projection, e.g. for offscreen passes
+  void flushFrameUniforms();        // upload the block if anything changed, called by programs before each draw
+  const FrameUniforms& getFrameUniforms();
+
   // Helpers
   void allocateGlobalBuffersAndPrograms(); // called once during startup
 
@@ -357,6 +417,8 @@ public:
   virtual std::tuple<int, int> getWindowPos() = 0;
   virtual bool windowRequestsClose() = 0;
   virtual void pollEvents() = 0;
+  virtual void waitEvents(double timeoutSeconds) = 0; // like pollEvents(), but blocks until an event or the timeout
+  size_t windowEventCount = 0; // incremented by the backend for each input/window event, used to detect idle periods
   virtual bool isKeyPressed(char c) = 0; // for lowercase a-z and 0-9 only
   virtual std::string getClipboardText() = 0;
   virtual void setClipboardText(std::string text) = 0;
@@ -384,6 +446,10 @@ public:
   virtual std::shared_ptr<TextureBuffer> generateTextureBuffer(TextureFormat format, unsigned int sizeX_,
                                                                unsigned int sizeY_,
                                                                float* data) = 0; // 2d
+  virtual std::shared_ptr<TextureBuffer> generateTextureBuffer(TextureFormat format, unsigned int sizeX_,
+                                                               unsigned int sizeY_, unsigned int sizeZ_,
+                                                               float* data) = 0; // 3d
+  virtual unsigned int getMax3DTextureSize() = 0; // largest 3d texture supported, in texels per side
 
   // create render buffers
   virtual std::shared_ptr<RenderBuffer> generateRenderBuffer(RenderBufferType type, unsigned int sizeX_,
@@ -392,9 +458,18 @@ public:
   virtual std::shared_ptr<FrameBuffer> generateFrameBuffer(unsigned int sizeX_, unsigned int sizeY_) = 0;
 
   // == create shader programs
-  virtual std::shared_ptr<ShaderProgram>
+  std::shared_ptr<ShaderProgram>
   requestShader(const std::string& programName, const std::vector<std::string>& customRules,
-                ShaderReplacementDefaults defaults = ShaderReplacementDefaults::SceneObject) = 0;
+                ShaderReplacementDefaults defaults = ShaderReplacementDefaults::SceneObject);
+
+  // Shader permutations. The sources for each combination of a program and its rules are assembled on first request and
+  // kept. A permutation is written as the program name followed by all of its rules (including the default rules),
+  // separated by spaces. Recording the permutations a workload uses (e.g. with polyscope-trace-replay) and
+  // precomputing them at startup assembles and checks all of their sources before anything is drawn.
+  std::vector<std::string> getShaderPermutations(); // every permutation requested so far, sorted
+  void precomputeShaderPermutations(const std::vector<std::string>& permutations);
+  void saveShaderPermutations(std::string filename); // one per line
+  void loadShaderPermutations(std::string filename); // and precompute them
 
   // === The frame buffers used in the rendering pipeline
   // The size of these buffers is always kept in sync with the screen size
@@ -408,9 +483,13 @@ public:
   std::shared_ptr<TextureBuffer> sceneColor, sceneColorFinal, sceneDepth, sceneDepthMin;
   std::shared_ptr<RenderBuffer> pickColorBuffer, pickDepthBuffer;
 
+  // History for progressive anti-aliasing, alternately read and written each sample (allocated on first use)
+  std::array<std::shared_ptr<FrameBuffer>, 2> progressiveBuffers;
+  std::array<std::shared_ptr<TextureBuffer>, 2> progressiveColors;
+
   // General-use programs used by the engine
   std::shared_ptr<ShaderProgram> renderTexturePlain, renderTextureDot3, renderTextureMap3, renderTextureSphereBG;
-  std::shared_ptr<ShaderProgram> compositePeel, mapLight, copyDepth;
+  std::shared_ptr<ShaderProgram> compositePeel, mapLight, copyDepth, blendHistory;
 
   // Manage transparency and culling
   void setTransparencyMode(TransparencyMode newMode);
@@ -428,6 +507,28 @@ public:
   void setSSAAFactor(int newVal);
   int getSSAAFactor();
 
+  // Progressive anti-aliasing. While the view and scene are unchanged, each redraw renders the scene with a different
+  // sub-pixel jitter and averages it in to a history buffer, until options::progressiveAASamples have been accumulated.
+  // Any change restarts from a single un-jittered sample.
+  void setProgressiveAA(bool newVal);
+  bool getProgressiveAA();
+  int getProgressiveSampleCount();
+  void applyProgressiveJitter();      // call after the frame uniforms are updated, before drawing the scene
+  void accumulateProgressiveSample(); // call after the scene has been resolved to sceneColorFinal
+  std::shared_ptr<TextureBuffer>& getSceneColorResolved(); // the scene color which should be shown on screen
+
+  // Occlusion culling. Large opaque structures are drawn to a low-resolution depth buffer, which is read back and
+  // reduced to a pyramid of maximum depths. Bounding boxes which are entirely behind the pyramid are hidden. The
+  // pyramid only applies to the camera and scene contents it was built with, so other passes (reflections, shadows)
+  // are not affected.
+  void beginOcclusionPrepass(); // bind and clear the pre-pass buffer, then draw the occluders
+  void endOcclusionPrepass();   // read back the pre-pass and build the pyramid for the current camera
+  void buildOcclusionPyramid(const std::vector<float>& depth, unsigned int sizeX, unsigned int sizeY,
+                             const glm::mat4& viewProj); // from a depth buffer, drawn with this view-projection matrix
+  void clearOcclusionPyramid();
+  bool boxIsOccluded(const glm::mat4& viewProj, const glm::mat4& model, glm::vec3 bboxMin, glm::vec3 bboxMax);
+  OcclusionStats occlusionStats;
+
 
   // == Cached data
 
@@ -460,9 +561,23 @@ protected:
   // Render state
   int ssaaFactor = 1;
   bool enableFXAA = true;
+  bool progressiveAA = false;
+  int progressiveSampleCount = 0;
+  int progressiveCurrent = 0; // which of progressiveBuffers holds the latest history
+  glm::mat4 progressiveViewMat, progressiveProjMat;
+  size_t progressiveContentVersion = 0;
+  void ensureProgressiveBuffers();
+  std::shared_ptr<FrameBuffer> occlusionBuffer; // (allocated on first use)
+  std::vector<std::vector<float>> occlusionPyramid; // level 0 is the pre-pass resolution
+  std::vector<glm::uvec2> occlusionPyramidSizes;
+  glm::mat4 occlusionViewProj;
+  size_t occlusionContentVersion = 0;
+  std::chrono::steady_clock::time_point occlusionBuildStart;
   glm::vec4 currViewport; // TODO remove global viewport size. There is no reason for this, and stops us from doing
                           // screenshot renders while minimized.
   float currPixelScale;
+  FrameUniforms frameUniforms;
+  bool frameUniformsDirty = true;
   TransparencyMode transparencyMode = TransparencyMode::None;
 
   // Cached lazy seettings for the resolve and relight program
@@ -480,13 +595,27 @@ protected:
   virtual std::shared_ptr<ShaderProgram> generateShaderProgram(const std::vector<ShaderStageSpecification>& stages,
                                                                DrawMode dm) = 0;
 
+  // Shader program & rule caches, filled by the backend
+  std::unordered_map<std::string, std::pair<std::vector<ParsedShaderStage>, DrawMode>> registeredShaderPrograms;
+  std::unordered_map<std::string, ShaderReplacementRule> registeredShaderRules;
+
+  // Assembled sources of each permutation requested so far, by permutation (see getShaderPermutations())
+  std::unordered_map<std::string, std::pair<std::vector<ShaderStageSpecification>, DrawMode>> shaderPermutations;
+  const std::pair<std::vector<ShaderStageSpecification>, DrawMode>&
+  assembleShaderPermutation(const std::string& programName, const std::vector<std::string>& rules);
+
+  // write frameUniforms to the backend's uniform block
+  virtual void uploadFrameUniforms() = 0;
+
   // Internal windowing and engine details
   ImFontAtlas* globalFontAtlas = nullptr;
 
   // Default rule lists (see enum for explanation)
-  std::vector<std::string> defaultRules_sceneObject{"GLSL_VERSION", "GLOBAL_FRAGMENT_FILTER", "LIGHT_MATCAP"};
-  std::vector<std::string> defaultRules_pick{"GLSL_VERSION", "GLOBAL_FRAGMENT_FILTER", "SHADE_COLOR", "LIGHT_PASSTHRU"};
-  std::vector<std::string> defaultRules_process{"GLSL_VERSION"};
+  std::vector<std::string> defaultRules_sceneObject{"GLSL_VERSION", "FRAME_UNIFORMS", "GLOBAL_FRAGMENT_FILTER",
+                                                    "LIGHT_MATCAP"};
+  std::vector<std::string> defaultRules_pick{"GLSL_VERSION", "FRAME_UNIFORMS", "GLOBAL_FRAGMENT_FILTER", "SHADE_COLOR",
+                                             "LIGHT_PASSTHRU"};
+  std::vector<std::string> defaultRules_process{"GLSL_VERSION", "FRAME_UNIFORMS"};
 };
 
 
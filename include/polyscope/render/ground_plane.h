@@ -31,6 +31,8 @@ public:
   void buildGui();
   void prepare(); // does any and all setup work / allocations / etc. Should be called whenever the mode is changed.
 
+  size_t shadowMapRenderCount = 0; // how many times the shadow has been rendered (it is cached between frames)
+
 
   // == Appearance Parameters
 
@@ -59,6 +61,20 @@ private:
 
   void populateGroundPlaneGeometry();
   bool groundPlanePrepared = false;
+
+  // The shadow is rendered once from a fixed camera looking straight down on the ground, so it does not depend on the
+  // view. It is regenerated only when the scene contents (or the ground itself) change.
+  void renderShadowMap(int iP, float sign, double groundHeight);
+  const int shadowMapResolution = 1024;
+  bool shadowMapValid = false;
+  size_t shadowContentVersionCached = 0;
+  view::UpDir shadowUpDirCached = view::UpDir::XUp;
+  double shadowGroundHeightCached = 0.;
+  int shadowBlurItersCached = 0;
+  glm::mat4 shadowViewProj; // maps world positions on the ground to the shadow texture
+
+  // The reflection is rendered at reduced resolution while the camera is moving
+  glm::mat4 reflectionViewMatCached;
   // which direction the ground plane faces
   view::UpDir groundPlaneViewCached = view::UpDir::XUp; // not actually valid, must populate first time
 };
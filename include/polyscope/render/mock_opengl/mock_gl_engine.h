@@ -23,6 +23,9 @@ public:
   GLTextureBuffer(TextureFormat format, unsigned int sizeX_, unsigned int sizeY_, unsigned char* data = nullptr);
   GLTextureBuffer(TextureFormat format, unsigned int sizeX_, unsigned int sizeY_, float* data);
 
+  // create a 3D texture from data
+  GLTextureBuffer(TextureFormat format, unsigned int sizeX_, unsigned int sizeY_, unsigned int sizeZ_, float* data);
+
   ~GLTextureBuffer() override;
 
 
@@ -31,6 +34,8 @@ public:
   void resize(unsigned int newX, unsigned int newY) override;
 
   void setFilterMode(FilterMode newMode) override;
+  void setSubData3D(unsigned int offX, unsigned int offY, unsigned int offZ, unsigned int sizeX_, unsigned int sizeY_,
+                    unsigned int sizeZ_, const float* data) override;
   void* getNativeHandle() override;
   
   std::vector<float> getDataScalar() override;
@@ -78,6 +83,7 @@ public:
 
   // Query pixels
   std::vector<unsigned char> readBuffer() override;
+  std::vector<float> readDepth() override;
   std::array<float, 4> readFloat4(int xPos, int yPos) override;
   void blitTo(FrameBuffer* other) override;
 
@@ -226,6 +232,7 @@ public:
   std::tuple<int, int> getWindowPos() override;
   bool windowRequestsClose() override;
   void pollEvents() override;
+  void waitEvents(double timeoutSeconds) override;
   bool isKeyPressed(char c) override; // for lowercase a-z and 0-9 only
   std::string getClipboardText() override;
   void setClipboardText(std::string text) override;
@@ -247,6 +254,9 @@ public:
                                                        unsigned char* data = nullptr) override; // 2d
   std::shared_ptr<TextureBuffer> generateTextureBuffer(TextureFormat format, unsigned int sizeX_, unsigned int sizeY_,
                                                        float* data) override; // 2d
+  std::shared_ptr<TextureBuffer> generateTextureBuffer(TextureFormat format, unsigned int sizeX_, unsigned int sizeY_,
+                                                       unsigned int sizeZ_, float* data) override; // 3d
+  unsigned int getMax3DTextureSize() override;
 
   // create render buffers
   std::shared_ptr<RenderBuffer> generateRenderBuffer(RenderBufferType type, unsigned int sizeX_,
@@ -254,22 +264,17 @@ public:
   // create frame buffers
   std::shared_ptr<FrameBuffer> generateFrameBuffer(unsigned int sizeX_, unsigned int sizeY_) override;
 
-  // create shader programs
-  std::shared_ptr<ShaderProgram>
-  requestShader(const std::string& programName, const std::vector<std::string>& customRules,
-                ShaderReplacementDefaults defaults = ShaderReplacementDefaults::SceneObject) override;
-
   // Transparency
   virtual void applyTransparencySettings() override;
 
 protected:
-  // Shader program & rule caches
-  std::unordered_map<std::string, std::pair<std::vector<ShaderStageSpecification>, DrawMode>> registeredShaderPrograms;
-  std::unordered_map<std::string, ShaderReplacementRule> registeredShaderRules;
+  // Shader programs & rules
   void populateDefaultShadersAndRules();
 
   std::shared_ptr<ShaderProgram> generateShaderProgram(const std::vector<ShaderStageSpecification>& stages,
                                                        DrawMode dm) override;
+
+  void uploadFrameUniforms() override;
 };
 
 } // namespace backend_openGL_mock
@@ -59,6 +59,9 @@ public:
   GLTextureBuffer(TextureFormat format, unsigned int sizeX_, unsigned int sizeY_, unsigned char* data = nullptr);
   GLTextureBuffer(TextureFormat format, unsigned int sizeX_, unsigned int sizeY_, float* data);
 
+  // create a 3D texture from data
+  GLTextureBuffer(TextureFormat format, unsigned int sizeX_, unsigned int sizeY_, unsigned int sizeZ_, float* data);
+
   ~GLTextureBuffer() override;
 
 
@@ -67,6 +70,8 @@ public:
   void resize(unsigned int newX, unsigned int newY) override;
 
   void setFilterMode(FilterMode newMode) override;
+  void setSubData3D(unsigned int offX, unsigned int offY, unsigned int offZ, unsigned int sizeX_, unsigned int sizeY_,
+                    unsigned int sizeZ_, const float* data) override;
   void* getNativeHandle() override;
   
   std::vector<float> getDataScalar() override;
@@ -121,6 +126,7 @@ public:
 
   // Query pixels
   std::vector<unsigned char> readBuffer() override;
+  std::vector<float> readDepth() override;
   std::array<float, 4> readFloat4(int xPos, int yPos) override;
   void blitTo(FrameBuffer* other) override;
 
@@ -273,6 +279,7 @@ public:
   std::tuple<int, int> getWindowPos() override;
   bool windowRequestsClose() override;
   void pollEvents() override;
+  void waitEvents(double timeoutSeconds) override;
   bool isKeyPressed(char c) override; // for lowercase a-z and 0-9 only
   std::string getClipboardText() override;
   void setClipboardText(std::string text) override;
@@ -294,6 +301,9 @@ public:
                                                        unsigned char* data = nullptr) override; // 2d
   std::shared_ptr<TextureBuffer> generateTextureBuffer(TextureFormat format, unsigned int sizeX_, unsigned int sizeY_,
                                                        float* data) override; // 2d
+  std::shared_ptr<TextureBuffer> generateTextureBuffer(TextureFormat format, unsigned int sizeX_, unsigned int sizeY_,
+                                                       unsigned int sizeZ_, float* data) override; // 3d
+  unsigned int getMax3DTextureSize() override;
 
   // create render buffers
   std::shared_ptr<RenderBuffer> generateRenderBuffer(RenderBufferType type, unsigned int sizeX_,
@@ -301,11 +311,6 @@ public:
   // create frame buffers
   std::shared_ptr<FrameBuffer> generateFrameBuffer(unsigned int sizeX_, unsigned int sizeY_) override;
 
-  // general flexible interface
-  std::shared_ptr<ShaderProgram>
-  requestShader(const std::string& programName, const std::vector<std::string>& customRules,
-                ShaderReplacementDefaults defaults = ShaderReplacementDefaults::SceneObject) override;
-
   // === Implementation details
 
   // Add a shader programs/rules so that they can be requested above
@@ -321,10 +326,11 @@ protected:
   // Internal windowing and engine details
   GLFWwindow* mainWindow = nullptr;
 
-  // Shader program & rule caches
-  // TODO oneday make these caches of precompiled programs which are shared, rather than caches of the sources
-  std::unordered_map<std::string, std::pair<std::vector<ShaderStageSpecification>, DrawMode>> registeredShaderPrograms;
-  std::unordered_map<std::string, ShaderReplacementRule> registeredShaderRules;
+  // Per-frame uniforms
+  VertexBufferHandle frameUniformsBuffer = 0;
+  void uploadFrameUniforms() override;
+
+  // Shader programs & rules
   void populateDefaultShadersAndRules();
   
   std::shared_ptr<ShaderProgram> generateShaderProgram(const std::vector<ShaderStageSpecification>& stages,
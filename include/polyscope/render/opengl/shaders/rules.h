@@ -9,6 +9,7 @@ namespace render {
 namespace backend_openGL3_glfw {
 
 extern const ShaderReplacementRule GLSL_VERSION;
+extern const ShaderReplacementRule FRAME_UNIFORMS;
 extern const ShaderReplacementRule GLOBAL_FRAGMENT_FILTER;
 extern const ShaderReplacementRule LIGHT_MATCAP;
 extern const ShaderReplacementRule LIGHT_PASSTHRU;
@@ -16,6 +16,7 @@ extern const ShaderStageSpecification COMPOSITE_PEEL;
 extern const ShaderStageSpecification DEPTH_COPY;
 extern const ShaderStageSpecification DEPTH_TO_MASK;
 extern const ShaderStageSpecification BLUR_RGB;
+extern const ShaderStageSpecification BLEND_HISTORY;
 
 extern const ShaderStageSpecification SCALAR_TEXTURE_COLORMAP;
 
@@ -5,6 +5,14 @@
 namespace polyscope {
 namespace render {
 
+// Apply replacement rules to shader stages. The text for each tag is the concatenation of the rules' replacements for
+// it, in rule order. Uniforms are unioned on all stages, attributes on vertex stages and textures on fragment stages;
+// throws std::runtime_error if a rule conflicts with an existing one of the same name.
+std::vector<ShaderStageSpecification>
+applyShaderReplacements(const std::vector<ParsedShaderStage>& stages,
+                        const std::vector<const ShaderReplacementRule*>& replacementRules);
+
+// Convenience version, which parses the stages first
 std::vector<ShaderStageSpecification>
 applyShaderReplacements(const std::vector<ShaderStageSpecification>& stages,
                         const std::vector<ShaderReplacementRule>& replacementRules);
@@ -0,0 +1,83 @@
+// Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
+#pragma once
+
+#include "polyscope/render/engine.h"
+#include "polyscope/task_scheduler.h"
+
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace polyscope {
+namespace render {
+
+// Attribute arrays which have been assembled on the CPU, but not yet uploaded to a ShaderProgram. Assembling these is
+// usually the slow part of preparing a structure or quantity for drawing, and does not touch the render engine, so it
+// can happen on a worker thread. Only uploadTo() must be called from the render thread.
+class StagedAttributes {
+
+public:
+  template <typename T>
+  void add(std::string name, std::vector<T>&& data) {
+    std::shared_ptr<std::vector<T>> dataPtr = std::make_shared<std::vector<T>>(std::move(data));
+    uploads.push_back([name, dataPtr](ShaderProgram& p) { p.setAttribute(name, *dataPtr); });
+  }
+
+  // Also limit the program to these ranges on upload (see ShaderProgram::setDrawRanges())
+  void setDrawRanges(const std::vector<DrawRange>* ranges) {
+    uploads.push_back([ranges](ShaderProgram& p) { p.setDrawRanges(ranges); });
+  }
+
+  void uploadTo(ShaderProgram& p) {
+    for (std::function<void(ShaderProgram&)>& f : uploads) {
+      f(p);
+    }
+    uploads.clear();
+  }
+
+private:
+  std::vector<std::function<void(ShaderProgram&)>> uploads;
+};
+
+// Assembles a StagedAttributes on a worker thread, and hands it to the render thread once it is done.
+//
+// The assembly function usually reads data from its structure or quantity. Whoever owns a StagedPreparation must call
+// cancel() before modifying that data or destroying it (the destructor also cancels, so declare this after any data
+// the job reads). If the job calls virtual functions of its owner, the most-derived class must cancel in its
+// destructor, since the overrides are gone by the time this destructor runs.
+class StagedPreparation {
+
+public:
+  ~StagedPreparation() { cancel(); }
+
+  void start(std::function<StagedAttributes()> assemble) {
+    cancel();
+    result = tasks::async(assemble);
+  }
+
+  // Has a job been started which has not been taken or cancelled?
+  bool started() { return result.valid(); }
+
+  // Is the result available? Never blocks.
+  bool ready() { return result.valid() && result.wait_for(std::chrono::seconds(0)) == std::future_status::ready; }
+
+  // Get the result, blocking until it is available if needed.
+  StagedAttributes take() { return result.get(); }
+
+  // Wait for any job in flight and discard its result.
+  void cancel() {
+    if (result.valid()) {
+      result.wait();
+      result = std::future<StagedAttributes>();
+    }
+  }
+
+private:
+  std::future<StagedAttributes> result;
+};
+
+} // namespace render
+} // namespace polyscope
@@ -19,6 +19,10 @@ public:
   void draw();
   void buildParametersGUI();
 
+  // Append more lines to the ribbon (e.g. as they arrive from a background trace). Buffers are rebuilt on next draw.
+  void addRibbons(const std::vector<std::vector<std::array<glm::vec3, 2>>>& newRibbons);
+  size_t nRibbons();
+
   Structure& parentStructure;
   const std::string uniqueName;
 
@@ -34,6 +38,7 @@ public:
 private:
   // Data
   std::vector<std::vector<std::array<glm::vec3, 2>>> ribbons;
+  std::vector<float> ribbonColorValues; // colormap sample for each line, fixed so colors persist across rebuilds
   double normalOffsetFraction;
 
   PersistentValue<bool> enabled;
@@ -44,7 +49,7 @@ private:
   void deleteProgram();
 
   std::string cMap = "spectral";
-  
+
   std::shared_ptr<render::ShaderProgram> program;
 };
 
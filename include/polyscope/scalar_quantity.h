@@ -4,6 +4,7 @@
 #include "polyscope/polyscope.h"
 #include "polyscope/render/engine.h"
 #include "polyscope/scaled_value.h"
+#include "polyscope/snapshot.h"
 
 namespace polyscope {
 
@@ -24,6 +25,11 @@ public:
   // Set uniforms in rendering programs for scalars
   void setScalarUniforms(render::ShaderProgram& p);
 
+  // Snapshots: writes the data type and values, followed by settings which are restored by readScalarSnapshot(). The
+  // caller reads the data type and values itself, to create the quantity.
+  void writeScalarSnapshot(SnapshotWriter& writer);
+  void readScalarSnapshot(SnapshotReader& reader);
+
   // === Members
   QuantityT& quantity;
   std::vector<double> values;
@@ -40,6 +46,9 @@ public:
   std::pair<double, double> getMapRange();
   QuantityT* resetMapRange(); // reset to full range
 
+  // The color of each value with the current colormap and range (e.g. for exporting), without isolines
+  std::vector<glm::vec3> getColors();
+
   // Isolines
   QuantityT* setIsolinesEnabled(bool newEnabled);
   bool getIsolinesEnabled();
@@ -117,6 +117,21 @@ void ScalarQuantity<QuantityT>::setScalarUniforms(render::ShaderProgram& p) {
   }
 }
 
+template <typename QuantityT>
+void ScalarQuantity<QuantityT>::writeScalarSnapshot(SnapshotWriter& writer) {
+  writer.write<DataType>(dataType);
+  writer.writeArray(values);
+  writer.write<double>(vizRange.first);
+  writer.write<double>(vizRange.second);
+}
+
+template <typename QuantityT>
+void ScalarQuantity<QuantityT>::readScalarSnapshot(SnapshotReader& reader) {
+  double rangeMin = reader.read<double>();
+  double rangeMax = reader.read<double>();
+  setMapRange(std::make_pair(rangeMin, rangeMax));
+}
+
 template <typename QuantityT>
 QuantityT* ScalarQuantity<QuantityT>::resetMapRange() {
   switch (dataType) {
@@ -150,6 +165,14 @@ std::string ScalarQuantity<QuantityT>::getColorMap() {
   return cMap.get();
 }
 
+template <typename QuantityT>
+std::vector<glm::vec3> ScalarQuantity<QuantityT>::getColors() {
+  std::vector<glm::vec3> colors(values.size());
+  render::engine->getColorMap(cMap.get()).getValues(values.data(), values.size(), vizRange.first, vizRange.second,
+                                                    colors.data());
+  return colors;
+}
+
 template <typename QuantityT>
 QuantityT* ScalarQuantity<QuantityT>::setMapRange(std::pair<double, double> val) {
   vizRange = val;
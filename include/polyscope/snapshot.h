@@ -0,0 +1,196 @@
+// Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace polyscope {
+
+class Structure;
+
+// Save the whole state of the viewer to a binary snapshot file: all registered structures along with their quantities,
+// the persistent values holding their appearance settings, the camera, and the scene options. Structures and
+// quantities which do not support snapshots are skipped with a warning.
+void saveSnapshot(std::string filename);
+
+// Replace all structures with the contents of a snapshot file, and restore its camera and options. Data which
+// structures derive from their inputs (normals, connectivity, etc) is read from the file rather than recomputed.
+void loadSnapshot(std::string filename);
+
+
+// === Reading and writing snapshot files
+
+// A snapshot file is an 8-byte magic string and a version number, followed by a sequence of chunks. Each chunk is a
+// 4-character tag and a payload size, and chunks may be nested. Arrays are written as raw bytes starting at an 8-byte
+// aligned offset in the file, so they can be used in place from a memory-mapped file.
+
+class SnapshotWriter {
+public:
+  SnapshotWriter();
+
+  // Chunks must be properly nested
+  void beginChunk(const char* tag);
+  void endChunk();
+  void cancelChunk(); // drop the innermost open chunk and everything written in it
+
+  // Values of trivially-copyable types are written as raw bytes
+  template <typename T>
+  void write(const T& val) {
+    static_assert(std::is_trivially_copyable<T>::value, "snapshot values must be trivially copyable");
+    writeBytes(&val, sizeof(T));
+  }
+  void writeString(const std::string& str);
+
+  template <typename T>
+  void writeArray(const std::vector<T>& arr) {
+    static_assert(std::is_trivially_copyable<T>::value, "snapshot arrays must be trivially copyable");
+    write<uint64_t>(arr.size());
+    write<uint32_t>(sizeof(T));
+    pad();
+    writeBytes(arr.data(), arr.size() * sizeof(T));
+  }
+
+  // Lists of lists (e.g. polygonal faces) are written as two arrays: the start of each list, and the concatenated lists
+  template <typename T>
+  void writeNestedArray(const std::vector<std::vector<T>>& arr);
+
+  void writeToFile(std::string filename);
+
+  // Append everything written so far to a stream and clear the buffer, for files which are written incrementally. There
+  // must be no open chunks.
+  void flush(std::ostream& out);
+
+private:
+  void writeBytes(const void* bytes, size_t nBytes);
+  void pad(); // to 8-byte alignment
+
+  std::vector<char> buffer;
+  std::vector<size_t> openChunks; // offset of the header for each open chunk
+};
+
+// Reads part of a snapshot: either the whole file, or the payload of a chunk. Throws std::runtime_error on malformed
+// data.
+class SnapshotReader {
+public:
+  // Reads a file which was written with SnapshotWriter, checking its header
+  static SnapshotReader fromFile(std::string filename);
+
+  // Reading chunks in sequence. If the next chunk has this tag, returns true and sets `payload` to read from it.
+  bool nextChunk(const char* tag, SnapshotReader& payload);
+  bool atEnd() const; // (ignoring padding)
+  std::string peekChunkTag() const; // empty if there is no next chunk
+  void skipChunk();
+
+  template <typename T>
+  T read() {
+    static_assert(std::is_trivially_copyable<T>::value, "snapshot values must be trivially copyable");
+    T val;
+    readBytes(&val, sizeof(T));
+    return val;
+  }
+  std::string readString();
+
+  template <typename T>
+  std::vector<T> readArray() {
+    static_assert(std::is_trivially_copyable<T>::value, "snapshot arrays must be trivially copyable");
+    uint64_t size = read<uint64_t>();
+    uint32_t elemSize = read<uint32_t>();
+    if (elemSize != sizeof(T)) {
+      throw std::runtime_error("snapshot array has elements of the wrong size");
+    }
+    skipPadding();
+    if (size > (end - pos) / sizeof(T)) {
+      throw std::runtime_error("snapshot is truncated");
+    }
+    std::vector<T> arr(size);
+    readBytes(arr.data(), size * sizeof(T));
+    return arr;
+  }
+
+  // An array which must have one entry per element of a structure (or similar)
+  template <typename T>
+  std::vector<T> readArray(size_t expectedSize) {
+    std::vector<T> arr = readArray<T>();
+    if (arr.size() != expectedSize) {
+      throw std::runtime_error("snapshot array has " + std::to_string(arr.size()) + " entries, expected " +
+                               std::to_string(expectedSize));
+    }
+    return arr;
+  }
+
+  // Enums are written as their underlying value, which must be at most `last` (enums index tables and switches, so
+  // other values are not safe to use)
+  template <typename E>
+  E readEnum(E last) {
+    typedef typename std::underlying_type<E>::type U;
+    U val = read<U>();
+    if (static_cast<uint64_t>(val) > static_cast<uint64_t>(last)) {
+      throw std::runtime_error("snapshot has an invalid enum value " + std::to_string(val));
+    }
+    return static_cast<E>(val);
+  }
+
+  template <typename T>
+  std::vector<std::vector<T>> readNestedArray();
+
+  SnapshotReader() {}
+
+private:
+  SnapshotReader(std::shared_ptr<const std::vector<char>> data_, size_t pos_, size_t end_)
+      : data(data_), pos(pos_), end(end_) {}
+
+  void readBytes(void* bytes, size_t nBytes);
+  void checkAvailable(size_t nBytes) const;
+  void skipPadding();
+
+  std::shared_ptr<const std::vector<char>> data; // the whole file
+  size_t pos = 0;
+  size_t end = 0;
+};
+
+namespace detail {
+// Parts of snapshots which are also used by api traces (see api_trace.h)
+void writeSnapshotOptions(SnapshotWriter& writer);
+void readSnapshotOptions(SnapshotReader& reader);
+Structure* readSnapshotStructure(std::string typeName, std::string name, SnapshotReader& reader);
+} // namespace detail
+
+
+template <typename T>
+void SnapshotWriter::writeNestedArray(const std::vector<std::vector<T>>& arr) {
+  std::vector<uint64_t> starts;
+  std::vector<T> entries;
+  starts.reserve(arr.size() + 1);
+  for (const std::vector<T>& list : arr) {
+    starts.push_back(entries.size());
+    entries.insert(entries.end(), list.begin(), list.end());
+  }
+  starts.push_back(entries.size());
+  writeArray(starts);
+  writeArray(entries);
+}
+
+template <typename T>
+std::vector<std::vector<T>> SnapshotReader::readNestedArray() {
+  std::vector<uint64_t> starts = readArray<uint64_t>();
+  std::vector<T> entries = readArray<T>();
+  if (starts.empty() || starts.back() != entries.size()) {
+    throw std::runtime_error("snapshot nested array is malformed");
+  }
+  std::vector<std::vector<T>> arr(starts.size() - 1);
+  for (size_t i = 0; i + 1 < starts.size(); i++) {
+    if (starts[i] > starts[i + 1]) {
+      throw std::runtime_error("snapshot nested array is malformed");
+    }
+    arr[i].assign(entries.begin() + starts[i], entries.begin() + starts[i + 1]);
+  }
+  return arr;
+}
+
+} // namespace polyscope
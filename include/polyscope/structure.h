@@ -1,6 +1,7 @@
 // Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
 #pragma once
 
+#include "polyscope/clipped_list_ui.h"
 #include "polyscope/persistent_value.h"
 #include "polyscope/quantity.h"
 #include "polyscope/render/engine.h"
@@ -12,6 +13,8 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <tuple>
+#include <vector>
 
 
 namespace polyscope {
@@ -50,9 +53,23 @@ public:
   const std::string name; // should be unique amongst registered structures with this type
   std::string uniquePrefix();
 
-  // = Length and bounding box (returned in object coordinates)
-  virtual std::tuple<glm::vec3, glm::vec3> boundingBox() = 0; // get axis-aligned bounding box
-  virtual double lengthScale() = 0;                           // get characteristic length
+  // = Length and bounding box (with the object transform applied). These are cached, and only recomputed after
+  // markExtentsDirty() or when the transform changes.
+  std::tuple<glm::vec3, glm::vec3> boundingBox(); // get axis-aligned bounding box
+  double lengthScale();                           // get characteristic length
+
+  // = Culling (see options::frustumCulling)
+  // Decide which parts of the structure to draw with the current camera, which may be a reflected or shadow camera.
+  // Returns false if none of it is visible. Programs drawing the structure's chunks are limited to the visible ones.
+  bool updateCulling();
+  // The ranges of the structure's primitives which are drawn after the last updateCulling(), or none if the whole
+  // structure is drawn
+  const std::vector<DrawRange>& getVisibleDrawRanges() const;
+  // How far anything drawn for the structure (point spheres, tubes, vectors, etc) may reach outside its bounding box
+  virtual double drawMargin();
+  // Fraction of the screen covered by the bounding box with the current camera, used to pick occluders. 1 if the box
+  // reaches behind the camera.
+  double screenCoverage();
 
   // = Basic state
   virtual std::string typeName() = 0;
@@ -70,6 +87,10 @@ public:
   // Get rid of it (invalidates the object and all pointers, etc!)
   void remove();
 
+  // Write the data needed to re-create the structure and its quantities in to a snapshot (see snapshot.h). Returns
+  // false if this type of structure cannot be saved in snapshots.
+  virtual bool writeSnapshot(SnapshotWriter& writer);
+
   // Selection tools
   virtual Structure* setEnabled(bool newEnabled);
   bool isEnabled();
@@ -81,6 +102,35 @@ public:
   double getTransparency();
 
 protected:
+  // Compute the bounding box and length scale from scratch, with the object transform applied. Implemented by each
+  // structure; use boundingBox() and lengthScale() to get the cached values.
+  virtual void computeExtents(std::tuple<glm::vec3, glm::vec3>& bboxOut, double& lengthScaleOut) = 0;
+
+  // Extents of a set of points (in parallel), the usual implementation of computeExtents(). The length scale is twice
+  // the largest distance of any point from the center of the bounding box.
+  void computePointExtents(const std::vector<glm::vec3>& points, std::tuple<glm::vec3, glm::vec3>& bboxOut,
+                           double& lengthScaleOut);
+
+  // Must be called whenever the geometry changes (refresh() does this)
+  void markExtentsDirty();
+
+  // A group of nearby primitives, for culling: their bounding box in object coordinates, and the range of data which
+  // draws them in each of the structure's programs which share its usual layout.
+  struct CullingChunk {
+    glm::vec3 bboxMin;
+    glm::vec3 bboxMax;
+    DrawRange range;
+  };
+
+  // Split the structure in to chunks for culling, of about this many primitives. The result is cached until
+  // markExtentsDirty(). By default there are none, and the structure is only culled as a whole.
+  virtual void computeCullingChunks(std::vector<CullingChunk>& chunksOut);
+  static const size_t cullingChunkSize = 4096;
+
+  // The visible chunks after the last updateCulling(). Programs which draw the chunks should set this with
+  // ShaderProgram::setDrawRanges().
+  std::vector<DrawRange> visibleDrawRanges;
+
   // = State
   PersistentValue<bool> enabled;
   
@@ -91,6 +141,16 @@ protected:
 
   // Widget that wraps the transform
   TransformationGizmo transformGizmo;
+
+private:
+  void ensureExtents();
+  bool extentsValid = false;
+  glm::mat4 extentsTransform; // the object transform the cached extents were computed with
+  std::tuple<glm::vec3, glm::vec3> cachedBoundingBox;
+  double cachedLengthScale = 0.;
+
+  std::vector<CullingChunk> cullingChunks;
+  bool cullingChunksValid = false;
 };
 
 
@@ -120,6 +180,9 @@ public:
   // Re-perform any setup work, including refreshing all quantities
   virtual void refresh() override;
 
+  // The largest margin of any enabled quantity
+  virtual double drawMargin() override;
+
   // = Manage quantities
 
   // Note: takes ownership of pointer after it is passed in
@@ -134,11 +197,22 @@ public:
 
   void setAllQuantitiesEnabled(bool newEnabled);
 
+  // = Snapshots of the quantities which support them. Reading calls S::readQuantitySnapshot(kind, name, reader) for
+  // each quantity, which should re-create it from the data written by its writeSnapshot().
+  void writeQuantitySnapshots(SnapshotWriter& writer);
+  void readQuantitySnapshots(SnapshotReader& reader);
+
   // = Quantities
   std::map<std::string, std::unique_ptr<QuantityType>> quantities;
   Quantity<S>* dominantQuantity = nullptr; // If non-null, a special quantity of which only one can be drawn for
                                            // the structure. Handles common case of a surface color, e.g. color of
                                            // a mesh or point cloud. The dominant quantity must always be enabled.
+
+private:
+  // GUI list used once there are many quantities
+  ClippedListUI quantityListUI;
+  std::vector<QuantityType*> quantityListItems;
+  bool quantityListDirty = true;
 };
 
 
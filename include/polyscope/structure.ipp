@@ -1,4 +1,5 @@
 // Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
+#include "polyscope/api_trace.h"
 #include "polyscope/polyscope.h"
 #include "polyscope/structure.h"
 
@@ -34,6 +35,8 @@ void QuantityStructure<S>::addQuantity(QuantityType* q, bool allowReplacement) {
 
   // Add the new quantity
   quantities[q->name] = std::unique_ptr<QuantityType>(q);
+  quantityListDirty = true;
+  trace::markStructureChanged(this);
 
   // Re-enable the quantity if we're replacing an enabled quantity
   if (existingQuantityWasEnabled) {
@@ -52,12 +55,25 @@ typename QuantityStructure<S>::QuantityType* QuantityStructure<S>::getQuantity(s
 
 template <typename S>
 void QuantityStructure<S>::refresh() {
+  markExtentsDirty();
   for (auto& qp : quantities) {
     qp.second->refresh();
   }
+  trace::markStructureChanged(this);
   requestRedraw();
 }
 
+template <typename S>
+double QuantityStructure<S>::drawMargin() {
+  double margin = 0.;
+  for (auto& qp : quantities) {
+    if (qp.second->isEnabled()) {
+      margin = std::max(margin, qp.second->drawMargin());
+    }
+  }
+  return margin;
+}
+
 template <typename S>
 void QuantityStructure<S>::removeQuantity(std::string name) {
   if (quantities.find(name) == quantities.end()) {
@@ -70,8 +86,11 @@ void QuantityStructure<S>::removeQuantity(std::string name) {
     clearDominantQuantity();
   }
 
-  // Delete the quantity
+  // Delete the quantity, once nothing in the background still reads it
+  q.cancelBackgroundPreparation();
   quantities.erase(name);
+  quantityListDirty = true;
+  trace::markStructureChanged(this);
 }
 
 template <typename S>
@@ -118,8 +137,29 @@ void QuantityStructure<S>::setAllQuantitiesEnabled(bool newEnabled) {
 template <typename S>
 void QuantityStructure<S>::buildQuantitiesUI() {
   // Build the quantities
-  for (auto& x : quantities) {
-    x.second->buildUI();
+  if (quantities.size() < ClippedListUI::minItems) {
+    for (auto& x : quantities) {
+      x.second->buildUI();
+    }
+    return;
+  }
+
+  // Long lists only build the visible rows, and the full UI of the selected quantity
+  if (quantityListDirty) {
+    quantityListItems.clear();
+    for (auto& x : quantities) {
+      quantityListItems.push_back(x.second.get());
+    }
+    quantityListDirty = false;
+    quantityListUI.markItemsChanged();
+  }
+  std::vector<QuantityType*>& items = quantityListItems;
+  long long iSelected = quantityListUI.build(
+      items.size(), [&](size_t i) -> const std::string& { return items[i]->cachedNiceName(); },
+      [&](size_t i) { return items[i]->isEnabled(); }, [&](size_t i, bool e) { items[i]->setEnabled(e); });
+  if (iSelected >= 0) {
+    ImGui::SetNextTreeNodeOpen(true, ImGuiCond_Appearing);
+    items[iSelected]->buildUI();
   }
 }
 
@@ -132,4 +172,40 @@ void QuantityStructure<S>::buildStructureOptionsUI() {
   }
 }
 
+template <typename S>
+void QuantityStructure<S>::writeQuantitySnapshots(SnapshotWriter& writer) {
+  for (auto& x : quantities) {
+    QuantityType& q = *x.second;
+    std::string kind = q.snapshotKind();
+    if (kind.empty()) {
+      warning("quantity type not supported in snapshots, skipping", name + ": " + q.name);
+      continue;
+    }
+
+    writer.beginChunk("QNTY");
+    writer.writeString(kind);
+    writer.writeString(q.name);
+    writer.write<char>(q.isEnabled());
+    q.writeSnapshot(writer);
+    writer.endChunk();
+  }
+}
+
+template <typename S>
+void QuantityStructure<S>::readQuantitySnapshots(SnapshotReader& reader) {
+  SnapshotReader qReader;
+  while (reader.nextChunk("QNTY", qReader)) {
+    std::string kind = qReader.readString();
+    std::string qName = qReader.readString();
+    bool qEnabled = qReader.read<char>();
+
+    QuantityType* q = static_cast<S*>(this)->readQuantitySnapshot(kind, qName, qReader);
+    if (q == nullptr) {
+      warning("unrecognized quantity type in snapshot, skipping", name + ": " + qName + " (" + kind + ")");
+      continue;
+    }
+    q->setEnabled(qEnabled);
+  }
+}
+
 } // namespace polyscope
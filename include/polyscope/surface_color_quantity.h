@@ -4,6 +4,7 @@
 #include "polyscope/affine_remapper.h"
 #include "polyscope/render/engine.h"
 #include "polyscope/surface_mesh.h"
+#include "polyscope/surface_mesh_lod.h"
 
 namespace polyscope {
 
@@ -38,9 +39,11 @@ public:
   SurfaceVertexColorQuantity(std::string name, std::vector<glm::vec3> values_, SurfaceMesh& mesh_);
 
   virtual void createProgram() override;
-  void fillColorBuffers(render::ShaderProgram& p);
+  void fillColorBuffers(render::ShaderProgram& p, const SurfaceMeshLOD* lod);
 
   void buildVertexInfoGUI(size_t vInd) override;
+  virtual std::string snapshotKind() override;
+  virtual void writeSnapshot(SnapshotWriter& writer) override;
 
   // === Members
   std::vector<glm::vec3> values;
@@ -55,9 +58,11 @@ public:
   SurfaceFaceColorQuantity(std::string name, std::vector<glm::vec3> values_, SurfaceMesh& mesh_);
 
   virtual void createProgram() override;
-  void fillColorBuffers(render::ShaderProgram& p);
+  void fillColorBuffers(render::ShaderProgram& p, const SurfaceMeshLOD* lod);
 
   void buildFaceInfoGUI(size_t fInd) override;
+  virtual std::string snapshotKind() override;
+  virtual void writeSnapshot(SnapshotWriter& writer) override;
 
   // === Members
   std::vector<glm::vec3> values;
@@ -1,6 +1,7 @@
 // Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
 #pragma once
 
+#include <future>
 #include <memory>
 #include <vector>
 
@@ -8,9 +9,11 @@
 #include "polyscope/color_management.h"
 #include "polyscope/polyscope.h"
 #include "polyscope/render/engine.h"
+#include "polyscope/render/staged_attributes.h"
 #include "polyscope/standardize_data_array.h"
 #include "polyscope/structure.h"
 #include "polyscope/surface_mesh_enums.h"
+#include "polyscope/surface_mesh_lod.h"
 #include "polyscope/surface_mesh_quantity.h"
 
 // Alllll the quantities
@@ -66,6 +69,7 @@ public:
   // Construct a new surface mesh structure
   SurfaceMesh(std::string name, const std::vector<glm::vec3>& vertexPositions,
               const std::vector<std::vector<size_t>>& faceIndices);
+  ~SurfaceMesh();
 
   // Build the imgui display
   virtual void buildCustomUI() override;
@@ -78,15 +82,16 @@ public:
   // Render for picking
   virtual void drawPick() override;
 
-  // A characteristic length for the structure
-  virtual double lengthScale() override;
-
-  // Axis-aligned bounding box for the structure
-  virtual std::tuple<glm::vec3, glm::vec3> boundingBox() override;
   virtual std::string typeName() override;
 
   virtual void refresh() override;
 
+  // Snapshots (see snapshot.h). The derived connectivity and geometry data is saved too, so loading does not need to
+  // recompute it.
+  virtual bool writeSnapshot(SnapshotWriter& writer) override;
+  static SurfaceMesh* readSnapshot(std::string name, SnapshotReader& reader); // creates and registers the mesh
+  SurfaceMeshQuantity* readQuantitySnapshot(std::string kind, std::string name, SnapshotReader& reader);
+
   // === Quantity-related
   // clang-format off
 
@@ -206,6 +211,11 @@ public:
   std::vector<std::vector<size_t>> edgeIndices;
   std::vector<std::vector<size_t>> halfedgeIndices;
 
+  // The order faces are drawn in: drawing data holds the triangles of face drawnFace(0), then drawnFace(1), etc.
+  // Empty == default ordering (see setDrawOrderOptimized()).
+  std::vector<size_t> faceDrawOrder;
+  size_t drawnFace(size_t iDraw) const { return faceDrawOrder.empty() ? iDraw : faceDrawOrder[iDraw]; }
+
   // Counts
   size_t nVertices() const { return vertices.size(); }
   size_t nFaces() const { return faces.size(); }
@@ -303,12 +313,42 @@ public:
   SurfaceMesh* setBackfacePolicy(BackfacePolicy newPolicy);
   BackfacePolicy getBackfacePolicy();
 
+  // Level of detail. When enabled, simplified versions of the mesh are built in the background (see
+  // surface_mesh_lod.h), and each culling chunk is drawn with the coarsest version whose error covers at most
+  // options::lodPixelError pixels on screen. Picking always uses the full mesh. The mesh itself and its vertex and face
+  // scalar and color quantities are simplified, other quantities are always drawn at full resolution.
+  SurfaceMesh* setLevelOfDetail(bool enabled);
+  bool isLevelOfDetail();
+  std::shared_ptr<const SurfaceMeshLOD> getLevelOfDetailData(); // null until the simplified versions are ready
+
+  // Draw order. When enabled, faces are drawn in an order which keeps neighboring faces together and draws outward
+  // facing parts of the mesh first, for less overdraw (see surface_mesh_draw_order.h). Face indices are unchanged, so
+  // face quantities, permutations and picking are unaffected.
+  SurfaceMesh* setDrawOrderOptimized(bool enabled);
+  bool isDrawOrderOptimized();
+
   // Rendering helpers used by quantities
   std::vector<std::string> addStructureRules(std::vector<std::string> initRules);
   void setStructureUniforms(render::ShaderProgram& p);
-  void fillGeometryBuffers(render::ShaderProgram& p);
+  // If `lod` is given, the triangles of its simplified versions are appended, and the program draws the versions
+  // chosen for the current view. Quantities should append their values with SurfaceMeshLOD::appendVertexValues() etc.
+  void fillGeometryBuffers(render::ShaderProgram& p, const SurfaceMeshLOD* lod = nullptr);
+  // CPU-side part of fillGeometryBuffers(), which may be called from a worker thread
+  render::StagedAttributes assembleGeometryBuffers(bool wantsBary, bool wantsEdge, bool smoothShade,
+                                                   const SurfaceMeshLOD* lod = nullptr);
+
+  // Drawing data is assembled on worker threads. This waits for (and discards) any such work in flight for the mesh and
+  // its quantities; it must be called before modifying the mesh data.
+  void cancelBackgroundPreparation();
 
 private:
+  // Construct from the mesh data written by writeSnapshot(), without recomputing anything
+  SurfaceMesh(std::string name, SnapshotReader& reader);
+
+  // Compute the (cached) bounding box and length scale
+  virtual void computeExtents(std::tuple<glm::vec3, glm::vec3>& bboxOut, double& lengthScaleOut) override;
+  virtual void computeCullingChunks(std::vector<CullingChunk>& chunksOut) override;
+
   // Visualization settings
   PersistentValue<bool> shadeSmooth;
   PersistentValue<glm::vec3> surfaceColor;
@@ -316,6 +356,7 @@ private:
   PersistentValue<std::string> material;
   PersistentValue<float> edgeWidth;
   PersistentValue<BackfacePolicy> backfacePolicy;
+  PersistentValue<bool> levelOfDetail;
 
   // Do setup work related to drawing, including allocating openGL data
   void prepare();
@@ -337,6 +378,18 @@ private:
   // Drawing related things
   std::shared_ptr<render::ShaderProgram> program;
   std::shared_ptr<render::ShaderProgram> pickProgram;
+  std::shared_ptr<render::ShaderProgram> preparingProgram; // becomes `program` once its buffers are ready
+  render::StagedPreparation geometryStaging;
+
+  // Level of detail
+  std::shared_ptr<const SurfaceMeshLOD> lod;
+  std::future<std::shared_ptr<SurfaceMeshLOD>> lodBuild;
+  std::vector<DrawRange> lodDrawRanges; // the chosen version of each visible chunk, for programs with `lod` data
+  void updateLevelOfDetail();           // start or finish building `lod`
+  void updateLevelOfDetailRanges();     // choose versions for the current view
+
+  // Rebuild all programs after a change to what goes in drawing data (`lod` or faceDrawOrder), but not to the mesh
+  void drawDataChanged();
 
 
   // === Helper functions
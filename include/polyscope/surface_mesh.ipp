@@ -45,6 +45,7 @@ SurfaceMesh* registerSurfaceMesh(std::string name, const V& vertexPositions, con
 
 template <class V>
 void SurfaceMesh::updateVertexPositions(const V& newPositions) {
+  cancelBackgroundPreparation();
   vertices = standardizeVectorArray<glm::vec3, 3>(newPositions);
 
   // Rebuild any necessary quantities
@@ -0,0 +1,79 @@
+// Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "glm/vec3.hpp"
+
+namespace polyscope {
+
+// Simplified versions of a surface mesh, for drawing parts of it which are far away (see
+// SurfaceMesh::setLevelOfDetail()).
+//
+// The mesh is split in to chunks of consecutive faces, and each chunk is simplified on its own by collapsing edges in
+// order of quadric error, giving a sequence of levels with about half as many triangles each. Vertices on the border
+// between chunks and on the boundary of the mesh never move, so neighboring chunks can be drawn at different levels
+// without cracks. Each collapse moves a vertex on to one of its neighbors, so the simplified triangles only use
+// vertices of the original mesh, and values defined on vertices need no remapping. Each simplified triangle also
+// remembers the face it came from, for values defined on faces.
+struct SurfaceMeshLOD {
+
+  struct Level {
+    size_t triangleStart; // in `triangles`
+    size_t triangleCount;
+    double error; // estimated distance from the original surface, in object coordinates
+  };
+
+  struct Chunk {
+    glm::vec3 bboxMin;
+    glm::vec3 bboxMax;
+    size_t fullTriangleStart; // the chunk's triangles in the full-resolution triangulation
+    size_t fullTriangleCount;
+    std::vector<Level> levels; // from finest to coarsest
+  };
+
+  std::vector<Chunk> chunks;
+
+  // The triangles of all levels of all chunks, as indices of original vertices, and the face each one came from
+  std::vector<std::array<size_t, 3>> triangles;
+  std::vector<size_t> triangleFaces;
+
+  // Drawing data for the mesh holds the full-resolution triangulation, followed by `triangles`. These append values
+  // for the simplified triangles (three per triangle) to drawing data which already holds the full-resolution values.
+  template <typename T>
+  void appendVertexValues(std::vector<T>& drawValues, const std::vector<T>& vertexValues) const;
+  template <typename T>
+  void appendFaceValues(std::vector<T>& drawValues, const std::vector<T>& faceValues) const;
+};
+
+// Build the levels for a mesh, whose faces are split in to chunks of about chunkTriangles triangles. Faces are
+// triangulated as fans from their first vertex. Chunks are simplified in parallel.
+std::shared_ptr<SurfaceMeshLOD> buildSurfaceMeshLOD(const std::vector<glm::vec3>& vertices,
+                                                    const std::vector<std::vector<size_t>>& faces,
+                                                    size_t chunkTriangles);
+
+
+template <typename T>
+void SurfaceMeshLOD::appendVertexValues(std::vector<T>& drawValues, const std::vector<T>& vertexValues) const {
+  drawValues.reserve(drawValues.size() + 3 * triangles.size());
+  for (const std::array<size_t, 3>& tri : triangles) {
+    for (size_t iV : tri) {
+      drawValues.push_back(vertexValues[iV]);
+    }
+  }
+}
+
+template <typename T>
+void SurfaceMeshLOD::appendFaceValues(std::vector<T>& drawValues, const std::vector<T>& faceValues) const {
+  drawValues.reserve(drawValues.size() + 3 * triangles.size());
+  for (size_t iF : triangleFaces) {
+    drawValues.push_back(faceValues[iF]);
+    drawValues.push_back(faceValues[iF]);
+    drawValues.push_back(faceValues[iF]);
+  }
+}
+
+} // namespace polyscope
@@ -93,6 +93,8 @@ public:
 
   virtual void buildHalfedgeInfoGUI(size_t heInd) override;
   virtual std::string niceName() override;
+  virtual std::string snapshotKind() override;
+  virtual void writeSnapshot(SnapshotWriter& writer) override;
 
   // === Members
   std::vector<glm::vec2> coords; // on corners
@@ -113,6 +115,8 @@ public:
 
   virtual void buildVertexInfoGUI(size_t vInd) override;
   virtual std::string niceName() override;
+  virtual std::string snapshotKind() override;
+  virtual void writeSnapshot(SnapshotWriter& writer) override;
 
   // === Members
   std::vector<glm::vec2> coords; // on vertices
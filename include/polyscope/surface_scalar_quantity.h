@@ -7,6 +7,7 @@
 #include "polyscope/render/engine.h"
 #include "polyscope/scalar_quantity.h"
 #include "polyscope/surface_mesh.h"
+#include "polyscope/surface_mesh_lod.h"
 
 namespace polyscope {
 
@@ -18,14 +19,25 @@ public:
   virtual void draw() override;
   virtual void buildCustomUI() override;
   virtual std::string niceName() override;
+  virtual std::string snapshotKind() override;
+  virtual void writeSnapshot(SnapshotWriter& writer) override;
   virtual void refresh() override;
+  virtual void cancelBackgroundPreparation() override;
 
 protected:
   const std::string definedOn;
   std::shared_ptr<render::ShaderProgram> program;
+  std::shared_ptr<render::ShaderProgram> preparingProgram; // becomes `program` once its buffers are ready
+  render::StagedPreparation colorStaging;
 
   // Helpers
-  virtual void createProgram() = 0;
+  // Creates the program on the first call, then uploads its buffers once they have been assembled in the background
+  void prepareProgram();
+  virtual std::shared_ptr<render::ShaderProgram> requestProgram() = 0;
+  // May run on a worker thread. `lod` is non-null if the mesh geometry includes simplified triangles (see
+  // supportsLevelOfDetail()).
+  virtual void assembleColorBuffers(render::StagedAttributes& attributes, const SurfaceMeshLOD* lod) = 0;
+  virtual bool supportsLevelOfDetail() { return false; }
 };
 
 // ========================================================
@@ -36,10 +48,11 @@ class SurfaceVertexScalarQuantity : public SurfaceScalarQuantity {
 public:
   SurfaceVertexScalarQuantity(std::string name, const std::vector<double>& values_, SurfaceMesh& mesh_,
                               DataType dataType_ = DataType::STANDARD);
+  virtual ~SurfaceVertexScalarQuantity();
 
-  virtual void createProgram() override;
-
-  void fillColorBuffers(render::ShaderProgram& p);
+  virtual std::shared_ptr<render::ShaderProgram> requestProgram() override;
+  virtual void assembleColorBuffers(render::StagedAttributes& attributes, const SurfaceMeshLOD* lod) override;
+  virtual bool supportsLevelOfDetail() override { return true; }
 
   void buildVertexInfoGUI(size_t vInd) override;
 };
@@ -53,10 +66,11 @@ class SurfaceFaceScalarQuantity : public SurfaceScalarQuantity {
 public:
   SurfaceFaceScalarQuantity(std::string name, const std::vector<double>& values_, SurfaceMesh& mesh_,
                             DataType dataType_ = DataType::STANDARD);
+  virtual ~SurfaceFaceScalarQuantity();
 
-  virtual void createProgram() override;
-
-  void fillColorBuffers(render::ShaderProgram& p);
+  virtual std::shared_ptr<render::ShaderProgram> requestProgram() override;
+  virtual void assembleColorBuffers(render::StagedAttributes& attributes, const SurfaceMeshLOD* lod) override;
+  virtual bool supportsLevelOfDetail() override { return true; }
 
   void buildFaceInfoGUI(size_t fInd) override;
 };
@@ -70,11 +84,10 @@ class SurfaceEdgeScalarQuantity : public SurfaceScalarQuantity {
 public:
   SurfaceEdgeScalarQuantity(std::string name, const std::vector<double>& values_, SurfaceMesh& mesh_,
                             DataType dataType_ = DataType::STANDARD);
-  //   ~SurfaceVertexScalarQuantity();
+  virtual ~SurfaceEdgeScalarQuantity();
 
-  virtual void createProgram() override;
-
-  void fillColorBuffers(render::ShaderProgram& p);
+  virtual std::shared_ptr<render::ShaderProgram> requestProgram() override;
+  virtual void assembleColorBuffers(render::StagedAttributes& attributes, const SurfaceMeshLOD* lod) override;
 
   void buildEdgeInfoGUI(size_t edgeInd) override;
 };
@@ -87,11 +100,10 @@ class SurfaceHalfedgeScalarQuantity : public SurfaceScalarQuantity {
 public:
   SurfaceHalfedgeScalarQuantity(std::string name, const std::vector<double>& values_, SurfaceMesh& mesh_,
                                 DataType dataType_ = DataType::STANDARD);
-  //   ~SurfaceVertexScalarQuantity();
-
-  virtual void createProgram() override;
+  virtual ~SurfaceHalfedgeScalarQuantity();
 
-  void fillColorBuffers(render::ShaderProgram& p);
+  virtual std::shared_ptr<render::ShaderProgram> requestProgram() override;
+  virtual void assembleColorBuffers(render::StagedAttributes& attributes, const SurfaceMeshLOD* lod) override;
 
   void buildHalfedgeInfoGUI(size_t heInd) override;
 };
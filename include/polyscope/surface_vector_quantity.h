@@ -10,6 +10,8 @@
 
 namespace polyscope {
 
+class FieldTraceJob;
+
 // ==== Common base class
 
 // Represents a general vector field associated with a surface mesh, including
@@ -18,9 +20,12 @@ class SurfaceVectorQuantity : public SurfaceMeshQuantity {
 public:
   SurfaceVectorQuantity(std::string name, SurfaceMesh& mesh_, MeshElement definedOn_,
                         VectorType vectorType_ = VectorType::STANDARD);
+  virtual ~SurfaceVectorQuantity();
 
   virtual void draw() override;
+  virtual double drawMargin() override;
   virtual void buildCustomUI() override;
+  virtual SurfaceVectorQuantity* setEnabled(bool newEnabled) override;
 
   // Allow children to append to the UI
   virtual void drawSubUI();
@@ -75,6 +80,12 @@ protected:
   // A ribbon viz that is appropriate for some fields
   std::unique_ptr<RibbonArtist> ribbonArtist;
   PersistentValue<bool> ribbonEnabled;
+
+  // Ribbon lines are traced in the background and streamed in to the ribbon artist as they finish
+  std::unique_ptr<FieldTraceJob> ribbonTraceJob;
+  void startRibbonTrace(const std::vector<glm::vec2>& field, int nSym);
+  void drawRibbon();
+  void clearRibbon(); // cancels any in-flight tracing
 };
 
 
@@ -87,6 +98,8 @@ public:
 
   virtual void refresh() override;
   virtual std::string niceName() override;
+  virtual std::string snapshotKind() override;
+  virtual void writeSnapshot(SnapshotWriter& writer) override;
   virtual void buildVertexInfoGUI(size_t vInd) override;
 };
 
@@ -100,6 +113,8 @@ public:
 
   virtual void refresh() override;
   virtual std::string niceName() override;
+  virtual std::string snapshotKind() override;
+  virtual void writeSnapshot(SnapshotWriter& writer) override;
   virtual void buildFaceInfoGUI(size_t fInd) override;
 };
 
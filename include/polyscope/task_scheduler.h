@@ -0,0 +1,49 @@
+// Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <type_traits>
+
+namespace polyscope {
+namespace tasks {
+
+// A small work-stealing thread pool shared by everything in polyscope that does parallel or background work. The
+// number of threads is set by options::nThreads; alternately, the host application can route all tasks to its own
+// executor with setExecutor().
+
+// Number of threads which may run tasks, including the calling thread (always at least 1)
+size_t threadCount();
+
+// Run `task` asynchronously. If only one thread is in use, it runs immediately on the calling thread.
+void submit(std::function<void()> task);
+
+// As submit(), but returns a future for the task's result. Don't block on the future from inside another task.
+template <typename F>
+std::future<typename std::result_of<F()>::type> async(F&& f);
+
+// Call body(chunkBegin, chunkEnd) for consecutive chunks of grainSize indices covering [begin, end), in parallel, and
+// wait for all of them. The calling thread runs chunks too, so this may be called from inside a task. Chunk boundaries
+// depend only on the range and grainSize, so combining per-chunk results in chunk order gives the same answer for any
+// number of threads. If body throws, the first exception is rethrown here once all chunks have finished.
+void parallelFor(size_t begin, size_t end, size_t grainSize, const std::function<void(size_t, size_t)>& body);
+
+// Number of chunks parallelFor() will use for a range
+inline size_t chunkCount(size_t begin, size_t end, size_t grainSize) {
+  return end > begin ? (end - begin + grainSize - 1) / grainSize : 0;
+}
+
+// Send all tasks to a host-provided executor rather than polyscope's own threads. The executor is called with each task
+// and must eventually run it exactly once, on any thread. Pass an empty function to go back to the internal pool.
+void setExecutor(std::function<void(std::function<void()>)> executor);
+
+// Finish all queued tasks and stop the worker threads. They are started again on next use. Must not be called from a
+// task.
+void shutdown();
+
+} // namespace tasks
+} // namespace polyscope
+
+#include "polyscope/task_scheduler.ipp"
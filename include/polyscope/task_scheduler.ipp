@@ -0,0 +1,18 @@
+// Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
+
+namespace polyscope {
+namespace tasks {
+
+template <typename F>
+std::future<typename std::result_of<F()>::type> async(F&& f) {
+  typedef typename std::result_of<F()>::type R;
+
+  // std::function requires a copyable target, so hold the packaged task by pointer
+  std::shared_ptr<std::packaged_task<R()>> task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+  std::future<R> result = task->get_future();
+  submit([task]() { (*task)(); });
+  return result;
+}
+
+} // namespace tasks
+} // namespace polyscope
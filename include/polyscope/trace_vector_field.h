@@ -3,8 +3,15 @@
 
 #include "polyscope/surface_mesh.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
 namespace polyscope {
 
+class FieldTracer;
+
 // Trace lines through a vector field on a mesh.
 // Return is a list of lines, each entry is (position, normal)
 // Input field should be identified (raised to power), not disambiguated
@@ -17,5 +24,48 @@ std::vector<std::vector<std::array<glm::vec3, 2>>> traceField(SurfaceMesh& mesh,
 glm::vec2 rotateToTangentBasis(glm::vec2 v, const glm::vec3& oldBasisX, const glm::vec3& oldBasisY,
                                const glm::vec3& newBasisX, const glm::vec3& newBasisY);
 
+// Traces lines through a vector field as background tasks (see task_scheduler.h), so the calling thread does not need
+// to wait for the result. All mesh data needed is copied at construction, so the mesh may change while the job runs.
+// Each line is seeded by its index, so the set of traced lines is the same as traceField() produces, independent of
+// thread scheduling. Destroying the job cancels any work still in flight.
+class FieldTraceJob {
+
+public:
+  // Arguments are as in traceField()
+  FieldTraceJob(SurfaceMesh& mesh, const std::vector<glm::vec2>& field, int nSym = 1, size_t nLines = 0);
+  ~FieldTraceJob();
+
+  FieldTraceJob(const FieldTraceJob&) = delete;
+  FieldTraceJob& operator=(const FieldTraceJob&) = delete;
+
+  // Move all lines which have finished since the last call to the end of `out`. Returns the number of lines moved.
+  size_t takeFinishedLines(std::vector<std::vector<std::array<glm::vec3, 2>>>& out);
+
+  // Stop tracing as soon as possible. Blocks until all tasks have exited (each finishes at most its current line).
+  void cancel();
+
+  // True once every line has been traced, or the job was cancelled.
+  bool isFinished();
+
+  size_t nLinesFinished();
+  size_t nLinesTotal = 0;
+
+private:
+  void traceBatch(size_t iBatch);
+
+  std::unique_ptr<FieldTracer> tracer;
+  std::atomic<bool> cancelRequested{false};
+  std::atomic<size_t> nLinesDone{0};
+
+  // Lines are traced in batches, one task per batch
+  size_t nBatches = 0;
+  size_t nBatchesDone = 0; // guarded by batchMutex
+  std::mutex batchMutex;
+  std::condition_variable batchesDone;
+
+  std::mutex finishedMutex;
+  std::vector<std::vector<std::array<glm::vec3, 2>>> finishedLines;
+};
+
 
 } // namespace polyscope
@@ -22,6 +22,9 @@ public:
   void draw();
   void buildParametersUI();
 
+  // How far the vectors reach from their bases (see Structure::drawMargin())
+  double drawMargin();
+
 
   // === Option accessors
 
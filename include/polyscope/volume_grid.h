@@ -0,0 +1,203 @@
+// Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
+#pragma once
+
+#include "polyscope/persistent_value.h"
+#include "polyscope/polyscope.h"
+#include "polyscope/render/engine.h"
+#include "polyscope/render/staged_attributes.h"
+#include "polyscope/standardize_data_array.h"
+#include "polyscope/structure.h"
+#include "polyscope/volume_grid_isosurface.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace polyscope {
+
+class SurfaceMesh;
+
+// A dense 3D grid of scalar samples, such as a CT scan or a simulation volume. It is drawn as slices through the grid,
+// colored from a 3D texture, and as an isosurface which is re-extracted on worker threads as the iso-value changes.
+//
+// Sample (i, j, k) is at origin + spacing * (i, j, k), and samples are ordered with i fastest. Samples may be floats,
+// half floats or 16 bit unsigned integers, and may be used in place rather than copied (e.g. from a memory-mapped
+// file), in which case they must not change while the grid exists. Large, mostly empty volumes can instead be stored
+// sparsely in bricks (see VolumeGridBricks), of which only the ones the slices pass through are sent to the GPU.
+class VolumeGrid : public Structure {
+public:
+  // === Member functions ===
+
+  // Construct a new grid over `samples`. If dataOwner is non-null, the grid keeps it alive as long as it uses the
+  // samples.
+  VolumeGrid(std::string name, VolumeGridSamples samples, glm::vec3 origin, glm::vec3 spacing,
+             std::shared_ptr<const void> dataOwner);
+
+  // === Overrides
+
+  // Build the imgui display
+  virtual void buildCustomUI() override;
+  virtual void buildCustomOptionsUI() override;
+  virtual void buildPickUI(size_t localPickID) override;
+
+  // Standard structure overrides
+  virtual void draw() override;
+  virtual void drawPick() override;
+  virtual std::string typeName() override;
+  virtual void refresh() override;
+
+  // === Geometry
+
+  glm::uvec3 getDims() const { return samples.dims; }
+  glm::vec3 getOrigin() const { return origin; }
+  glm::vec3 getSpacing() const { return spacing; }
+  size_t nSamples() const { return samples.size(); }
+  float getSample(size_t i, size_t j, size_t k) const { return samples.at(i, j, k); }
+  const VolumeGridSamples& getSamples() const { return samples; }
+  bool isSparse() const { return samples.bricks != nullptr; }
+
+  // Misc data
+  static const std::string structureTypeName;
+
+  // === Slices
+
+  // Slices perpendicular to each axis (0, 1, 2 for x, y, z), at a position in [0, 1] across the grid
+  VolumeGrid* setAxisSliceEnabled(int axis, bool newVal);
+  bool getAxisSliceEnabled(int axis);
+  VolumeGrid* setAxisSlicePosition(int axis, double newVal);
+  double getAxisSlicePosition(int axis);
+
+  // A slice along an arbitrary plane, in the grid's coordinates
+  VolumeGrid* setPlaneSliceEnabled(bool newVal);
+  bool getPlaneSliceEnabled();
+  VolumeGrid* setPlaneSlice(glm::vec3 point, glm::vec3 normal);
+
+  // The color map and the range of values mapped across it, for slices
+  VolumeGrid* setColorMap(std::string val);
+  std::string getColorMap();
+  VolumeGrid* setMapRange(std::pair<double, double> val);
+  std::pair<double, double> getMapRange();
+  VolumeGrid* resetMapRange(); // reset to the range of the data
+
+  // Sparse grids keep the bricks which the slices pass through in an atlas on the GPU of at most this many bytes (256
+  // MB by default). Bricks are paged in as the slices move, evicting the least recently used ones.
+  VolumeGrid* setBrickMemoryBudget(size_t bytes);
+  size_t getBrickMemoryBudget();
+
+  // === Isosurface
+
+  VolumeGrid* setIsosurfaceEnabled(bool newVal);
+  bool getIsosurfaceEnabled();
+
+  // Samples which are >= the iso-value are inside. Changing the value starts extracting a new surface in the
+  // background; the previous surface is drawn until it is done.
+  VolumeGrid* setIsoValue(double newVal);
+  double getIsoValue();
+
+  VolumeGrid* setIsosurfaceColor(glm::vec3 newVal);
+  glm::vec3 getIsosurfaceColor();
+  VolumeGrid* setMaterial(std::string name);
+  std::string getMaterial();
+
+  // The isosurface at the current iso-value, extracting it now if it is out of date
+  const VolumeGridIsosurface& getIsosurface();
+
+  // Register the current isosurface as a surface mesh, to add quantities to it, etc
+  SurfaceMesh* registerIsosurfaceAsMesh(std::string meshName = "");
+
+private:
+  // Compute the (cached) bounding box and length scale
+  virtual void computeExtents(std::tuple<glm::vec3, glm::vec3>& bboxOut, double& lengthScaleOut) override;
+
+  // === Data
+  std::shared_ptr<const void> dataOwner;
+  VolumeGridSamples samples;
+  glm::vec3 origin;
+  glm::vec3 spacing;
+  std::pair<double, double> dataRange; // of the finite samples
+  VolumeGridBlockRanges blockRanges;
+
+  // === Visualization parameters
+  PersistentValue<bool> sliceXEnabled;
+  PersistentValue<bool> sliceYEnabled;
+  PersistentValue<bool> sliceZEnabled;
+  PersistentValue<glm::vec3> axisSlicePositions;
+  PersistentValue<bool> planeSliceEnabled;
+  PersistentValue<glm::vec3> planeSlicePoint;
+  PersistentValue<glm::vec3> planeSliceNormal;
+  PersistentValue<std::string> cMap;
+  std::pair<float, float> vizRange;
+
+  PersistentValue<bool> isosurfaceEnabled;
+  PersistentValue<float> isoValue;
+  PersistentValue<glm::vec3> isosurfaceColor;
+  PersistentValue<std::string> material;
+
+  PersistentValue<bool>& axisSliceEnabled(int axis);
+
+  // === Drawing
+  // if nullptr, prepareVolumeTexture() (resp. prepareSlices()) needs to be called
+  std::shared_ptr<render::TextureBuffer> volumeTexture;
+  std::shared_ptr<render::ShaderProgram> sliceProgram;
+
+  // Upload dense samples to a 3D texture, a slab at a time, or allocate the brick atlas for sparse samples
+  void prepareVolumeTexture();
+  void prepareSlices();
+
+  // The slice polygons, as triangles. For sparse grids, this also pages in the bricks they pass through.
+  struct SlicePlane;
+  std::vector<SlicePlane> slicePlanes();
+  render::StagedAttributes assembleSliceBuffers(bool wantsBary);
+  render::StagedAttributes assembleSparseSliceBuffers(bool wantsBary);
+
+  // The atlas for sparse grids, where each slot holds a brick and the samples just outside it
+  size_t brickMemoryBudget = 256 << 20;
+  glm::uvec3 atlasSlots{0, 0, 0};
+  bool brickBudgetExceeded = false; // by the bricks the slices needed, when they were last assembled
+  std::unique_ptr<VolumeGridBrickCache> brickCache;
+  void uploadBricks(const std::vector<std::pair<uint32_t, uint32_t>>& bricksAndSlots);
+
+  // The isosurface is extracted and its buffers assembled on a worker thread. The program for the previous surface (if
+  // any) is drawn until the new one is ready.
+  void prepareIsosurface();
+  void startIsosurfaceExtraction();
+  static render::StagedAttributes assembleIsosurfaceBuffers(const VolumeGridIsosurface& surface, bool wantsBary);
+  std::shared_ptr<render::ShaderProgram> isosurfaceProgram;
+  std::shared_ptr<render::ShaderProgram> preparingIsosurfaceProgram;
+  std::shared_ptr<const VolumeGridIsosurface> isosurface; // most recently extracted surface, or null
+  float isosurfaceValue = 0.;                             // the iso-value `isosurface` was extracted at
+  std::shared_ptr<const VolumeGridIsosurface> pendingIsosurface; // filled in by the job in isosurfaceStaging
+  float pendingIsoValue = 0.;
+  render::StagedPreparation isosurfaceStaging; // declared after the data the job reads
+};
+
+// Shorthand to add a volume grid to polyscope. The values are copied, converted to floats.
+template <class T>
+VolumeGrid* registerVolumeGrid(std::string name, glm::uvec3 dims, glm::vec3 origin, glm::vec3 spacing,
+                               const T& values);
+
+// Add a volume grid of half floats or 16 bit integers (according to `type`), taking the values
+VolumeGrid* registerVolumeGrid(std::string name, glm::uvec3 dims, glm::vec3 origin, glm::vec3 spacing,
+                               std::vector<uint16_t> values, VolumeDataType type);
+
+// Add a sparse volume grid, stored in bricks (see makeVolumeGridBricks())
+VolumeGrid* registerSparseVolumeGrid(std::string name, glm::vec3 origin, glm::vec3 spacing, VolumeGridBricks bricks);
+
+// Add a volume grid which uses samples in place, without copying them. The data must stay valid and unchanged until
+// the grid is removed.
+VolumeGrid* registerVolumeGridView(std::string name, glm::uvec3 dims, glm::vec3 origin, glm::vec3 spacing,
+                                   const void* data, VolumeDataType type);
+
+// Add a volume grid from a raw file of samples (after headerBytes bytes), which is memory-mapped rather than read, so
+// only the parts which are used are loaded
+VolumeGrid* registerVolumeGridFromRawFile(std::string name, std::string filename, glm::uvec3 dims, glm::vec3 origin,
+                                          glm::vec3 spacing, VolumeDataType type, size_t headerBytes = 0);
+
+// Shorthand to get a volume grid from polyscope
+inline VolumeGrid* getVolumeGrid(std::string name = "");
+inline bool hasVolumeGrid(std::string name = "");
+inline void removeVolumeGrid(std::string name = "", bool errorIfAbsent = true);
+
+} // namespace polyscope
+
+#include "polyscope/volume_grid.ipp"
@@ -0,0 +1,32 @@
+// Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
+#pragma once
+
+namespace polyscope {
+
+
+// Shorthand to add a volume grid to polyscope
+template <class T>
+VolumeGrid* registerVolumeGrid(std::string name, glm::uvec3 dims, glm::vec3 origin, glm::vec3 spacing,
+                               const T& values) {
+  validateSize(values, static_cast<size_t>(dims.x) * dims.y * dims.z, "volume grid " + name);
+  std::shared_ptr<std::vector<float>> data = std::make_shared<std::vector<float>>(standardizeArray<float, T>(values));
+  VolumeGrid* s =
+      new VolumeGrid(name, VolumeGridSamples(data->data(), VolumeDataType::Float, dims), origin, spacing, data);
+  bool success = registerStructure(s);
+  if (!success) {
+    safeDelete(s);
+  }
+  return s;
+}
+
+
+// Shorthand to get a volume grid from polyscope
+inline VolumeGrid* getVolumeGrid(std::string name) {
+  return dynamic_cast<VolumeGrid*>(getStructure(VolumeGrid::structureTypeName, name));
+}
+inline bool hasVolumeGrid(std::string name) { return hasStructure(VolumeGrid::structureTypeName, name); }
+inline void removeVolumeGrid(std::string name, bool errorIfAbsent) {
+  removeStructure(VolumeGrid::structureTypeName, name, errorIfAbsent);
+}
+
+} // namespace polyscope
@@ -0,0 +1,76 @@
+// Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "glm/vec2.hpp"
+#include "glm/vec3.hpp"
+
+namespace polyscope {
+
+struct VolumeGridSamples;
+
+// The samples of a sparse grid, in bricks of 8^3 samples. Bricks in which every sample is the background value are not
+// stored, so memory is proportional to the occupied part of the grid (plus 4 bytes per brick for the index).
+struct VolumeGridBricks {
+  static const unsigned int brickSize = 8;           // samples per side
+  static const uint32_t emptyBrick = 0xffffffff;     // in brickIndex
+  static const size_t brickSamplesCount = 8 * 8 * 8; // samples per brick
+
+  glm::uvec3 dims{0, 0, 0};    // in samples
+  glm::uvec3 nBricks{0, 0, 0}; // bricks per side, rounded up; samples past the end of the grid are unused
+  float background = 0.;
+
+  std::vector<uint32_t> brickIndex;    // for each brick (x fastest), its index in the stored bricks, or emptyBrick
+  std::vector<glm::uvec3> brickCoords; // for each stored brick, its position in bricks
+  std::vector<float> brickSamples;     // brickSamplesCount samples for each stored brick, x fastest
+  std::vector<glm::vec2> brickRanges;  // (min, max) of each stored brick's samples in the grid, non-finite as -infinity
+
+  size_t nStoredBricks() const { return brickCoords.size(); }
+
+  float sample(size_t x, size_t y, size_t z) const {
+    const size_t B = brickSize;
+    uint32_t iB = brickIndex[x / B + nBricks.x * (y / B + nBricks.y * (z / B))];
+    if (iB == emptyBrick) return background;
+    return brickSamples[iB * brickSamplesCount + x % B + B * (y % B + B * (z % B))];
+  }
+};
+
+// Build a sparse grid from the given bricks, each of which has brickSamplesCount samples. Throws std::runtime_error if
+// a brick is out of bounds or given twice.
+VolumeGridBricks makeVolumeGridBricks(glm::uvec3 dims, const std::vector<glm::uvec3>& brickCoords,
+                                      const std::vector<float>& brickSamples, float background);
+
+// Build a sparse grid from dense samples, keeping only the bricks which have a sample other than the background. The
+// dense samples are only read once, so they can be memory-mapped (see MappedFile).
+VolumeGridBricks makeVolumeGridBricks(const VolumeGridSamples& samples, float background);
+
+// Assigns bricks to the slots of a fixed-size cache (such as a texture atlas on the GPU), evicting the least recently
+// requested bricks when it is full.
+class VolumeGridBrickCache {
+public:
+  static const uint32_t noSlot = 0xffffffff;
+
+  VolumeGridBrickCache(size_t nSlots);
+
+  // Get slots for all of the bricks, which must be distinct. Bricks which are already resident keep their slots; the
+  // others are added to `toUpload` along with the slot they were given. If there are more bricks than slots, some of
+  // the bricks which were not resident get noSlot.
+  std::vector<uint32_t> request(const std::vector<uint32_t>& bricks,
+                                std::vector<std::pair<uint32_t, uint32_t>>& toUpload);
+
+  size_t nSlots() const { return slotBrick.size(); }
+  size_t nResident() const { return brickSlot.size(); }
+
+private:
+  std::vector<uint32_t> slotBrick;    // brick in each slot, or VolumeGridBricks::emptyBrick
+  std::vector<uint64_t> slotLastUse;  // request counter when each slot was last used
+  std::unordered_map<uint32_t, uint32_t> brickSlot;
+  uint64_t requestCount = 0;
+};
+
+} // namespace polyscope
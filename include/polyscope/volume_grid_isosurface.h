@@ -0,0 +1,85 @@
+// Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "glm/vec2.hpp"
+#include "glm/vec3.hpp"
+
+#include "polyscope/volume_grid_bricks.h"
+
+namespace polyscope {
+
+// How the samples of a volume are stored
+enum class VolumeDataType { Float = 0, Half, UInt16 };
+
+// IEEE half precision to float
+float halfToFloat(uint16_t h);
+
+// A view of the samples of a grid, which does not own them. Dense samples are stored with sample (i, j, k) at
+// i + dims.x * (j + dims.y * k); sparse samples are stored in bricks.
+struct VolumeGridSamples {
+  VolumeGridSamples() {}
+  VolumeGridSamples(const void* data_, VolumeDataType type_, glm::uvec3 dims_)
+      : data(data_), type(type_), dims(dims_) {}
+  explicit VolumeGridSamples(const VolumeGridBricks* bricks_) : dims(bricks_->dims), bricks(bricks_) {}
+
+  const void* data = nullptr;
+  VolumeDataType type = VolumeDataType::Float;
+  glm::uvec3 dims{0, 0, 0};
+  const VolumeGridBricks* bricks = nullptr; // if non-null, the samples are here rather than in data
+
+  size_t size() const { return static_cast<size_t>(dims.x) * dims.y * dims.z; }
+  float operator[](size_t i) const {
+    if (bricks != nullptr) {
+      return bricks->sample(i % dims.x, (i / dims.x) % dims.y, i / (static_cast<size_t>(dims.x) * dims.y));
+    }
+    switch (type) {
+    case VolumeDataType::Float:
+      return static_cast<const float*>(data)[i];
+    case VolumeDataType::Half:
+      return halfToFloat(static_cast<const uint16_t*>(data)[i]);
+    case VolumeDataType::UInt16:
+      return static_cast<const uint16_t*>(data)[i];
+    }
+    return 0.;
+  }
+  float at(size_t x, size_t y, size_t z) const {
+    if (bricks != nullptr) return bricks->sample(x, y, z);
+    return (*this)[x + dims.x * (y + dims.y * z)];
+  }
+};
+
+// The range of the samples in each block of cells, used to skip blocks which an isosurface does not pass through.
+// Non-finite samples count as -infinity, like they are treated by extractIsosurface(). For sparse grids, blocks line up
+// with bricks, and the ranges are looked up from the bricks rather than stored.
+struct VolumeGridBlockRanges {
+  static const unsigned int blockSize = 8; // cells per side
+  glm::uvec3 nBlocks{0, 0, 0};
+  std::vector<glm::vec2> ranges; // (min, max) of the samples at the corners of the cells in each block, x fastest
+  const VolumeGridBricks* bricks = nullptr; // if non-null, ranges is empty
+
+  glm::vec2 range(unsigned int bx, unsigned int by, unsigned int bz) const;
+};
+VolumeGridBlockRanges computeVolumeGridBlockRanges(const VolumeGridSamples& samples);
+
+// A triangle mesh, which can be passed directly to registerSurfaceMesh()
+struct VolumeGridIsosurface {
+  std::vector<glm::vec3> vertices;
+  std::vector<glm::vec3> normals; // unit, pointing towards lower values
+  std::vector<std::array<uint32_t, 3>> triangles;
+};
+
+// Extract the surface where the samples cross isoValue, in parallel over slabs of blocks. Samples which are >= isoValue
+// are inside. Each cell is split in to six tetrahedra around its diagonal, which triangulates every cell unambiguously
+// without a case table. Only blocks which have samples on both sides are visited, so re-extracting at a new value
+// mostly costs time proportional to the size of the surface. Vertices are shared between neighboring cells, so the
+// surface is closed away from the boundary of the grid, and triangles are oriented so their normals point towards
+// lower values.
+VolumeGridIsosurface extractIsosurface(const VolumeGridSamples& samples, const VolumeGridBlockRanges& blockRanges,
+                                       glm::vec3 origin, glm::vec3 spacing, float isoValue);
+
+} // namespace polyscope
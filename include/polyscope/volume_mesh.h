@@ -0,0 +1,191 @@
+// Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
+#pragma once
+
+#include "polyscope/color_management.h"
+#include "polyscope/persistent_value.h"
+#include "polyscope/polyscope.h"
+#include "polyscope/render/engine.h"
+#include "polyscope/render/staged_attributes.h"
+#include "polyscope/standardize_data_array.h"
+#include "polyscope/structure.h"
+#include "polyscope/volume_mesh_cells.h"
+#include "polyscope/volume_mesh_quantity.h"
+
+#include "polyscope/volume_mesh_scalar_quantity.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace polyscope {
+
+// Forward declare volume mesh
+class VolumeMesh;
+
+// Forward declare quantity types
+class VolumeMeshVertexScalarQuantity;
+class VolumeMeshCellScalarQuantity;
+
+
+template <> // Specialize the quantity type
+struct QuantityTypeHelper<VolumeMesh> {
+  typedef VolumeMeshQuantity type;
+};
+
+// A mesh of tets and hexes (see VolumeMeshCells). It is drawn as its exterior faces, which are found when the mesh is
+// created. A slice plane cuts away part of the mesh to show the cells inside; the cut cells are clipped against it on
+// worker threads, and the previous geometry is drawn until they are done.
+class VolumeMesh : public QuantityStructure<VolumeMesh> {
+public:
+  // === Member functions ===
+
+  // Construct a new volume mesh structure
+  VolumeMesh(std::string name, std::vector<glm::vec3> vertices, VolumeMeshCells cells);
+  ~VolumeMesh();
+
+  // === Overloads
+
+  // Build the imgui display
+  virtual void buildCustomUI() override;
+  virtual void buildCustomOptionsUI() override;
+  virtual void buildPickUI(size_t localPickID) override;
+
+  // Render the the structure on screen
+  virtual void draw() override;
+
+  // Render for picking
+  virtual void drawPick() override;
+
+  virtual std::string typeName() override;
+
+  virtual void refresh() override;
+
+  // === Quantities
+
+  // Scalars
+  template <class T>
+  VolumeMeshVertexScalarQuantity* addVertexScalarQuantity(std::string name, const T& values,
+                                                          DataType type = DataType::STANDARD);
+  template <class T>
+  VolumeMeshCellScalarQuantity* addCellScalarQuantity(std::string name, const T& values,
+                                                      DataType type = DataType::STANDARD);
+
+
+  // === Members and utilities
+
+  // The vertices and cells that make up this mesh
+  std::vector<glm::vec3> vertices;
+  size_t nVertices() const { return vertices.size(); }
+
+  VolumeMeshCells cells;
+  size_t nCells() const { return cells.nCells(); }
+  size_t nTets() const { return nTetCells; }
+  size_t nHexes() const { return nCells() - nTetCells; }
+
+  // The faces which belong to only one cell, populated on construction
+  const VolumeMeshExterior& getExterior() const { return exterior; }
+  size_t nExteriorFaces() const { return exterior.nFaces(); }
+
+  // Misc data
+  static const std::string structureTypeName;
+
+  // Small utilities
+  std::vector<std::string> addStructureRules(std::vector<std::string> initRules);
+  void setStructureUniforms(render::ShaderProgram& p);
+
+  // The drawn triangles with the given slice plane (see triangulateVolumeMesh()), as attributes for a MESH program. May
+  // run on a worker thread.
+  render::StagedAttributes assembleGeometryBuffers(bool wantsBary, bool wantsEdge, VolumeMeshSlicePlane slice,
+                                                   const std::vector<double>* values, bool valuesOnCells);
+
+  // Drawing data is assembled on worker threads, and must be rebuilt whenever the slice plane changes. Programs
+  // remember the version of the slice they were built for, and are redrawn until a newer one is ready.
+  VolumeMeshSlicePlane getSlicePlane();
+  uint64_t getSliceVersion() const { return sliceVersion; }
+
+  // Wait for any drawing data being assembled in the background, for this mesh and its quantities
+  void cancelBackgroundPreparation();
+
+  // === Get/set visualization parameters
+
+  // A plane which cuts away the part of the mesh on the side its normal points to
+  VolumeMesh* setPlaneSliceEnabled(bool newVal);
+  bool getPlaneSliceEnabled();
+  VolumeMesh* setPlaneSlice(glm::vec3 point, glm::vec3 normal);
+
+  // set the base color of the mesh
+  VolumeMesh* setColor(glm::vec3 newVal);
+  glm::vec3 getColor();
+
+  // Width of the edges. Scaled such that 1 is a reasonable weight for visible edges. Set to 0 to disable.
+  VolumeMesh* setEdgeWidth(double newVal);
+  double getEdgeWidth();
+
+  // Color of edges
+  VolumeMesh* setEdgeColor(glm::vec3 newVal);
+  glm::vec3 getEdgeColor();
+
+  // Material
+  VolumeMesh* setMaterial(std::string name);
+  std::string getMaterial();
+
+private:
+  // Compute the (cached) bounding box and length scale
+  virtual void computeExtents(std::tuple<glm::vec3, glm::vec3>& bboxOut, double& lengthScaleOut) override;
+
+  // === Data
+  size_t nTetCells = 0;
+  VolumeMeshExterior exterior;
+
+  // === Visualization parameters
+  PersistentValue<bool> planeSliceEnabled;
+  PersistentValue<glm::vec3> planeSlicePoint;
+  PersistentValue<glm::vec3> planeSliceNormal;
+  PersistentValue<glm::vec3> color;
+  PersistentValue<glm::vec3> edgeColor;
+  PersistentValue<float> edgeWidth;
+  PersistentValue<std::string> material;
+  uint64_t sliceVersion = 0;
+
+  // Drawing related things
+  // if nullptr, prepare() needs to be called
+  std::shared_ptr<render::ShaderProgram> program;
+  std::shared_ptr<render::ShaderProgram> preparingProgram; // becomes `program` once its buffers are ready
+  uint64_t programSliceVersion = 0;
+  uint64_t preparingSliceVersion = 0;
+  render::StagedPreparation geometryStaging; // declared after the data the job reads
+
+  // === Helpers
+
+  // Keep the program up to date with the slice plane, assembling its buffers on a worker thread
+  void prepare();
+
+  void slicePlaneChanged();
+
+  // === Quantity adder implementations
+  // clang-format off
+  VolumeMeshVertexScalarQuantity* addVertexScalarQuantityImpl(std::string name, const std::vector<double>& data, DataType type);
+  VolumeMeshCellScalarQuantity* addCellScalarQuantityImpl(std::string name, const std::vector<double>& data, DataType type);
+  // clang-format on
+};
+
+
+// Shorthand to add a volume mesh to polyscope. Each cell is a list of 4 (tet) or 8 (hex) vertex indices.
+template <class V, class C>
+VolumeMesh* registerVolumeMesh(std::string name, const V& vertexPositions, const C& cellIndices);
+
+// Shorthand to add a volume mesh of only tets or only hexes, as an array with 4 (resp. 8) indices per cell
+template <class V, class T>
+VolumeMesh* registerTetMesh(std::string name, const V& vertexPositions, const T& tetIndices);
+template <class V, class H>
+VolumeMesh* registerHexMesh(std::string name, const V& vertexPositions, const H& hexIndices);
+
+// Shorthand to get a volume mesh from polyscope
+inline VolumeMesh* getVolumeMesh(std::string name = "");
+inline bool hasVolumeMesh(std::string name = "");
+inline void removeVolumeMesh(std::string name = "", bool errorIfAbsent = true);
+
+
+} // namespace polyscope
+
+#include "polyscope/volume_mesh.ipp"
@@ -0,0 +1,69 @@
+// Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
+#pragma once
+
+namespace polyscope {
+
+
+// Shorthand to add a volume mesh to polyscope
+template <class V, class C>
+VolumeMesh* registerVolumeMesh(std::string name, const V& vertexPositions, const C& cellIndices) {
+  VolumeMesh* s = new VolumeMesh(name, standardizeVectorArray<glm::vec3, 3>(vertexPositions),
+                                 makeVolumeMeshCells(standardizeNestedList<size_t, C>(cellIndices)));
+  bool success = registerStructure(s);
+  if (!success) {
+    safeDelete(s);
+  }
+  return s;
+}
+
+template <class V, class T>
+VolumeMesh* registerTetMesh(std::string name, const V& vertexPositions, const T& tetIndices) {
+  VolumeMesh* s = new VolumeMesh(name, standardizeVectorArray<glm::vec3, 3>(vertexPositions),
+                                 makeVolumeMeshCells(standardizeVectorArray<std::array<size_t, 4>, 4>(tetIndices)));
+  bool success = registerStructure(s);
+  if (!success) {
+    safeDelete(s);
+  }
+  return s;
+}
+
+template <class V, class H>
+VolumeMesh* registerHexMesh(std::string name, const V& vertexPositions, const H& hexIndices) {
+  VolumeMesh* s = new VolumeMesh(name, standardizeVectorArray<glm::vec3, 3>(vertexPositions),
+                                 makeVolumeMeshCells(standardizeVectorArray<std::array<size_t, 8>, 8>(hexIndices)));
+  bool success = registerStructure(s);
+  if (!success) {
+    safeDelete(s);
+  }
+  return s;
+}
+
+
+// Shorthand to get a volume mesh from polyscope
+inline VolumeMesh* getVolumeMesh(std::string name) {
+  return dynamic_cast<VolumeMesh*>(getStructure(VolumeMesh::structureTypeName, name));
+}
+inline bool hasVolumeMesh(std::string name) { return hasStructure(VolumeMesh::structureTypeName, name); }
+inline void removeVolumeMesh(std::string name, bool errorIfAbsent) {
+  removeStructure(VolumeMesh::structureTypeName, name, errorIfAbsent);
+}
+
+
+// =====================================================
+// ============== Quantities
+// =====================================================
+
+template <class T>
+VolumeMeshVertexScalarQuantity* VolumeMesh::addVertexScalarQuantity(std::string name, const T& data, DataType type) {
+  validateSize(data, nVertices(), "volume mesh vertex scalar quantity " + name);
+  return addVertexScalarQuantityImpl(name, standardizeArray<double, T>(data), type);
+}
+
+template <class T>
+VolumeMeshCellScalarQuantity* VolumeMesh::addCellScalarQuantity(std::string name, const T& data, DataType type) {
+  validateSize(data, nCells(), "volume mesh cell scalar quantity " + name);
+  return addCellScalarQuantityImpl(name, standardizeArray<double, T>(data), type);
+}
+
+
+} // namespace polyscope
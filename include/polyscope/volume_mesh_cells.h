@@ -0,0 +1,100 @@
+// Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "glm/vec3.hpp"
+
+namespace polyscope {
+
+// The cells of a volume mesh, in flat CSR form: the vertices of cell c are cellVertices[cellStart[c]] through
+// cellVertices[cellStart[c + 1] - 1]. Each cell is a tet (4 vertices) or a hex (8 vertices).
+//
+// Hexes are numbered with 0-1-2-3 around one face and 4-5-6-7 around the opposite face, such that 4 is across from 0,
+// 5 from 1, and so on. Cells may be oriented either way; faces are oriented outwards when they are extracted.
+struct VolumeMeshCells {
+  static const uint32_t noVertex = 0xffffffff; // pads triangles in face arrays
+
+  std::vector<uint32_t> cellStart{0};
+  std::vector<uint32_t> cellVertices;
+
+  size_t nCells() const { return cellStart.size() - 1; }
+  size_t cellSize(size_t c) const { return cellStart[c + 1] - cellStart[c]; }
+  const uint32_t* cell(size_t c) const { return &cellVertices[cellStart[c]]; }
+};
+
+// Build the CSR cells from a list of cells. Indices which do not fit in 32 bits become noVertex, so that they are
+// caught by validateVolumeMeshCells().
+VolumeMeshCells makeVolumeMeshCells(const std::vector<std::vector<size_t>>& cells);
+template <size_t N>
+VolumeMeshCells makeVolumeMeshCells(const std::vector<std::array<size_t, N>>& cells);
+
+// Returns the index of the first cell which is not a tet or a hex or which has a vertex index >= nVertices, or
+// cells.nCells() if they are all valid.
+size_t validateVolumeMeshCells(const VolumeMeshCells& cells, size_t nVertices);
+
+// The faces of a cell of the given size (4 or 8)
+size_t volumeMeshCellFaceCount(size_t cellSize);
+
+// The faces of a volume mesh which belong to only one cell. These are found by sorting the vertices of every face of
+// every cell, hashing the sorted faces into partitions, and finding the faces which appear only once in each
+// partition, with the partitions processed in parallel.
+struct VolumeMeshExterior {
+  std::vector<std::array<uint32_t, 4>> faces; // outward-facing; triangles end with VolumeMeshCells::noVertex
+  std::vector<uint32_t> faceCells;            // the cell each face belongs to
+  std::vector<size_t> cellFaceStart;          // faces of cell c are [cellFaceStart[c], cellFaceStart[c + 1])
+
+  size_t nFaces() const { return faces.size(); }
+};
+
+VolumeMeshExterior computeVolumeMeshExterior(const std::vector<glm::vec3>& vertices, const VolumeMeshCells& cells);
+
+// A plane which cuts away the part of a volume mesh on the side that `normal` points to
+struct VolumeMeshSlicePlane {
+  bool enabled = false;
+  glm::vec3 point{0., 0., 0.};
+  glm::vec3 normal{1., 0., 0.};
+};
+
+// The triangles which are drawn for a volume mesh: its exterior faces, clipped by the slice plane if it is enabled,
+// and the polygons where the plane cuts through cells, which face towards the side that was cut away.
+struct VolumeMeshTriangles {
+  std::vector<glm::vec3> positions;  // 3 per triangle
+  std::vector<glm::vec3> normals;    // per corner, the normal of the polygon the triangle came from
+  std::vector<glm::vec3> edgeIsReal; // per corner, whether each edge of the triangle is an edge of its polygon
+  std::vector<double> values;        // per corner, if values were given
+
+  size_t nTriangles() const { return positions.size() / 3; }
+};
+
+// Triangulate the mesh on worker threads. `values` may be null, or hold a value per vertex (interpolated across the
+// slice) or per cell (if valuesOnCells).
+VolumeMeshTriangles triangulateVolumeMesh(const std::vector<glm::vec3>& vertices, const VolumeMeshCells& cells,
+                                          const VolumeMeshExterior& exterior, const VolumeMeshSlicePlane& slice,
+                                          const std::vector<double>* values, bool valuesOnCells);
+
+
+// === Implementation details
+
+inline uint32_t volumeMeshIndex(size_t v) {
+  return v < VolumeMeshCells::noVertex ? static_cast<uint32_t>(v) : VolumeMeshCells::noVertex;
+}
+
+template <size_t N>
+VolumeMeshCells makeVolumeMeshCells(const std::vector<std::array<size_t, N>>& cells) {
+  VolumeMeshCells result;
+  result.cellStart.reserve(cells.size() + 1);
+  result.cellVertices.reserve(N * cells.size());
+  for (const std::array<size_t, N>& c : cells) {
+    for (size_t v : c) {
+      result.cellVertices.push_back(volumeMeshIndex(v));
+    }
+    result.cellStart.push_back(static_cast<uint32_t>(result.cellVertices.size()));
+  }
+  return result;
+}
+
+} // namespace polyscope
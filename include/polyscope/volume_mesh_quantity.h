@@ -0,0 +1,20 @@
+// Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
+#pragma once
+
+#include "polyscope/quantity.h"
+#include "polyscope/structure.h"
+
+namespace polyscope {
+
+// Forward declare
+class VolumeMesh;
+
+// Extend Quantity<VolumeMesh>
+class VolumeMeshQuantity : public Quantity<VolumeMesh> {
+public:
+  VolumeMeshQuantity(std::string name, VolumeMesh& parentStructure, bool dominates = false);
+  virtual ~VolumeMeshQuantity() {};
+};
+
+
+} // namespace polyscope
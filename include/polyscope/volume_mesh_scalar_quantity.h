@@ -0,0 +1,60 @@
+// Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
+#pragma once
+
+#include "polyscope/affine_remapper.h"
+#include "polyscope/histogram.h"
+#include "polyscope/render/color_maps.h"
+#include "polyscope/render/engine.h"
+#include "polyscope/render/staged_attributes.h"
+#include "polyscope/scalar_quantity.h"
+#include "polyscope/volume_mesh.h"
+
+namespace polyscope {
+
+class VolumeMeshScalarQuantity : public VolumeMeshQuantity, public ScalarQuantity<VolumeMeshScalarQuantity> {
+public:
+  VolumeMeshScalarQuantity(std::string name, VolumeMesh& mesh_, std::string definedOn,
+                           const std::vector<double>& values_, DataType dataType);
+
+  virtual void draw() override;
+  virtual void buildCustomUI() override;
+  virtual std::string niceName() override;
+  virtual void refresh() override;
+  virtual void cancelBackgroundPreparation() override;
+
+protected:
+  const std::string definedOn;
+  std::shared_ptr<render::ShaderProgram> program;
+  std::shared_ptr<render::ShaderProgram> preparingProgram; // becomes `program` once its buffers are ready
+  uint64_t programSliceVersion = 0;
+  uint64_t preparingSliceVersion = 0;
+  render::StagedPreparation colorStaging;
+
+  // Helpers
+  // Keep the program up to date with the parent's slice plane, assembling its buffers on a worker thread
+  void prepareProgram();
+};
+
+// ========================================================
+// ==========           Vertex Scalar            ==========
+// ========================================================
+
+class VolumeMeshVertexScalarQuantity : public VolumeMeshScalarQuantity {
+public:
+  VolumeMeshVertexScalarQuantity(std::string name, const std::vector<double>& values_, VolumeMesh& mesh_,
+                                 DataType dataType_ = DataType::STANDARD);
+};
+
+
+// ========================================================
+// ==========             Cell Scalar            ==========
+// ========================================================
+
+class VolumeMeshCellScalarQuantity : public VolumeMeshScalarQuantity {
+public:
+  VolumeMeshCellScalarQuantity(std::string name, const std::vector<double>& values_, VolumeMesh& mesh_,
+                               DataType dataType_ = DataType::STANDARD);
+};
+
+
+} // namespace polyscope
@@ -0,0 +1,221 @@
+// Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
+#include "polyscope/api_trace.h"
+
+#include "polyscope/messages.h"
+#include "polyscope/persistent_value.h"
+#include "polyscope/polyscope.h"
+#include "polyscope/render/engine.h"
+#include "polyscope/snapshot.h"
+#include "polyscope/structure.h"
+#include "polyscope/view.h"
+
+#include <fstream>
+#include <memory>
+#include <set>
+#include <tuple>
+#include <vector>
+
+namespace polyscope {
+
+namespace {
+
+const uint32_t traceVersion = 1;
+
+// A trace is a TRCE chunk holding the version, followed by these chunks in the order they happened:
+//   STRC: (re-)register a structure, as in snapshots. Preceded by a PVAL chunk with the settings to create it with.
+//   RMST: remove a structure (type name, name)
+//   ENAB: the enabled state of every structure (count, then type name, name, enabled for each)
+//   FRAM: draw a frame (camera json, scene options)
+struct TraceRecording {
+  std::ofstream out;
+  SnapshotWriter writer;
+  std::set<std::pair<std::string, std::string>> changedStructures; // (type name, name) since the last frame
+  std::vector<std::tuple<std::string, std::string, bool>> lastEnabled;
+};
+
+std::unique_ptr<TraceRecording> activeTrace;
+
+Structure* findStructure(const std::string& typeName, const std::string& name) {
+  auto typeIt = state::structures.find(typeName);
+  if (typeIt == state::structures.end()) return nullptr;
+  auto it = typeIt->second.find(name);
+  if (it == typeIt->second.end()) return nullptr;
+  return it->second;
+}
+
+void writeChangedStructures(TraceRecording& trace) {
+  if (trace.changedStructures.empty()) return;
+
+  trace.writer.beginChunk("PVAL");
+  trace.writer.writeString(detail::persistentValuesToJSON());
+  trace.writer.endChunk();
+
+  for (const std::pair<std::string, std::string>& key : trace.changedStructures) {
+    Structure* s = findStructure(key.first, key.second);
+    if (s == nullptr) continue;
+
+    trace.writer.beginChunk("STRC");
+    trace.writer.writeString(key.first);
+    trace.writer.writeString(key.second);
+    if (s->writeSnapshot(trace.writer)) {
+      trace.writer.endChunk();
+    } else {
+      trace.writer.cancelChunk();
+      warning("structure type not supported in traces, skipping", key.second + " (" + key.first + ")");
+    }
+  }
+  trace.changedStructures.clear();
+}
+
+void writeEnabledStates(TraceRecording& trace) {
+  std::vector<std::tuple<std::string, std::string, bool>> enabled;
+  for (auto& typeStructures : state::structures) {
+    for (auto& x : typeStructures.second) {
+      enabled.emplace_back(typeStructures.first, x.first, x.second->isEnabled());
+    }
+  }
+  if (enabled == trace.lastEnabled) return;
+
+  trace.writer.beginChunk("ENAB");
+  trace.writer.write<uint64_t>(enabled.size());
+  for (const std::tuple<std::string, std::string, bool>& e : enabled) {
+    trace.writer.writeString(std::get<0>(e));
+    trace.writer.writeString(std::get<1>(e));
+    trace.writer.write<char>(std::get<2>(e));
+  }
+  trace.writer.endChunk();
+  trace.lastEnabled = std::move(enabled);
+}
+
+} // namespace
+
+
+void startTrace(std::string filename) {
+  stopTrace();
+
+  std::unique_ptr<TraceRecording> trace(new TraceRecording());
+  trace->out.open(filename, std::ios::binary);
+  if (!trace->out) {
+    error("failed to open trace file " + filename);
+    return;
+  }
+
+  trace->writer.beginChunk("TRCE");
+  trace->writer.write<uint32_t>(traceVersion);
+  trace->writer.endChunk();
+
+  // Everything which already exists
+  for (auto& typeStructures : state::structures) {
+    for (auto& x : typeStructures.second) {
+      trace->changedStructures.emplace(typeStructures.first, x.first);
+    }
+  }
+
+  activeTrace = std::move(trace);
+}
+
+void stopTrace() {
+  if (!activeTrace) return;
+  activeTrace->writer.flush(activeTrace->out);
+  activeTrace.reset();
+}
+
+bool isTracing() { return activeTrace != nullptr; }
+
+size_t replayTrace(std::string filename) {
+  size_t nFrames = 0;
+
+  try {
+    SnapshotReader reader = SnapshotReader::fromFile(filename);
+    SnapshotReader chunk;
+    if (!reader.nextChunk("TRCE", chunk)) {
+      throw std::runtime_error("not a trace");
+    }
+    uint32_t version = chunk.read<uint32_t>();
+    if (version != traceVersion) {
+      throw std::runtime_error("unsupported trace version " + std::to_string(version));
+    }
+
+    removeAllStructures();
+
+    std::string structureValues;
+    while (!reader.atEnd()) {
+      if (reader.nextChunk("PVAL", chunk)) {
+        structureValues = chunk.readString();
+      } else if (reader.nextChunk("STRC", chunk)) {
+        std::string typeName = chunk.readString();
+        std::string name = chunk.readString();
+        // (remove the old version first, so that it does not write its settings over the new ones)
+        removeStructure(typeName, name, false);
+        detail::persistentValuesFromJSON(structureValues);
+        detail::readSnapshotStructure(typeName, name, chunk);
+      } else if (reader.nextChunk("RMST", chunk)) {
+        std::string typeName = chunk.readString();
+        std::string name = chunk.readString();
+        removeStructure(typeName, name, false);
+      } else if (reader.nextChunk("ENAB", chunk)) {
+        uint64_t nStructures = chunk.read<uint64_t>();
+        for (uint64_t i = 0; i < nStructures; i++) {
+          std::string typeName = chunk.readString();
+          std::string name = chunk.readString();
+          bool enabled = chunk.read<char>();
+          Structure* s = findStructure(typeName, name);
+          if (s != nullptr && s->isEnabled() != enabled) {
+            s->setEnabled(enabled);
+          }
+        }
+      } else if (reader.nextChunk("FRAM", chunk)) {
+        view::setCameraFromJson(chunk.readString(), false);
+        detail::readSnapshotOptions(chunk);
+        draw();
+        render::engine->swapDisplayBuffers();
+        nFrames++;
+      } else {
+        // (from a newer version)
+        reader.skipChunk();
+      }
+    }
+
+  } catch (const std::exception& e) {
+    error("failed to replay trace " + filename + ": " + e.what());
+  }
+
+  return nFrames;
+}
+
+namespace trace {
+
+void markStructureChanged(Structure* s) {
+  if (!activeTrace) return;
+  activeTrace->changedStructures.emplace(s->typeName(), s->name);
+}
+
+void markStructureRemoved(std::string typeName, std::string name) {
+  if (!activeTrace) return;
+  activeTrace->changedStructures.erase(std::make_pair(typeName, name));
+  activeTrace->writer.beginChunk("RMST");
+  activeTrace->writer.writeString(typeName);
+  activeTrace->writer.writeString(name);
+  activeTrace->writer.endChunk();
+}
+
+void recordFrame() {
+  if (!activeTrace) return;
+  TraceRecording& trace = *activeTrace;
+
+  writeChangedStructures(trace);
+  writeEnabledStates(trace);
+
+  trace.writer.beginChunk("FRAM");
+  trace.writer.writeString(view::getCameraJson());
+  detail::writeSnapshotOptions(trace.writer);
+  trace.writer.endChunk();
+
+  // Written every frame, so the trace is usable even if the program crashes
+  trace.writer.flush(trace.out);
+  trace.out.flush();
+}
+
+} // namespace trace
+
+} // namespace polyscope
@@ -0,0 +1,256 @@
+// Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
+#include "polyscope/camera_path.h"
+
+#include "polyscope/messages.h"
+#include "polyscope/options.h"
+#include "polyscope/polyscope.h"
+#include "polyscope/render/engine.h"
+#include "polyscope/screenshot.h"
+#include "polyscope/utilities.h"
+#include "polyscope/view.h"
+
+#include "json/json.hpp"
+using json = nlohmann::json;
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace polyscope {
+
+namespace {
+
+// Recording state
+bool recording = false;
+CameraPath recordedPath;
+std::chrono::steady_clock::time_point recordingStart;
+double lastRecordedFrameTime = 0.;
+
+double recordingTime() {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - recordingStart).count();
+}
+
+} // namespace
+
+void CameraPath::addKeyframe(double time) { addKeyframe(time, view::getCameraViewMatrix(), view::fov); }
+
+void CameraPath::addKeyframe(double time, const glm::mat4& viewMat, double fov) {
+  if (!keyframes.empty() && time < keyframes.back().time) {
+    throw std::runtime_error("camera path keyframes must be added in order of time");
+  }
+  keyframes.push_back(CameraPathKeyframe{time, viewMat, fov});
+}
+
+double CameraPath::duration() const {
+  if (keyframes.empty()) return 0.;
+  return keyframes.back().time - keyframes.front().time;
+}
+
+void CameraPath::evaluate(double t, glm::mat4& viewMatOut, double& fovOut) const {
+  if (keyframes.empty()) {
+    viewMatOut = view::getCameraViewMatrix();
+    fovOut = view::fov;
+    return;
+  }
+
+  // First keyframe strictly after t
+  auto next = std::upper_bound(keyframes.begin(), keyframes.end(), t,
+                               [](double time, const CameraPathKeyframe& k) { return time < k.time; });
+  if (next == keyframes.begin()) {
+    viewMatOut = keyframes.front().viewMat;
+    fovOut = keyframes.front().fov;
+    return;
+  }
+  if (next == keyframes.end()) {
+    viewMatOut = keyframes.back().viewMat;
+    fovOut = keyframes.back().fov;
+    return;
+  }
+  const CameraPathKeyframe& k0 = *(next - 1);
+  const CameraPathKeyframe& k1 = *next;
+  float u = static_cast<float>((t - k0.time) / (k1.time - k0.time));
+
+  glm::mat3x4 R0, R1;
+  glm::vec3 T0, T1;
+  splitTransform(k0.viewMat, R0, T0);
+  splitTransform(k1.viewMat, R1, T1);
+  glm::dualquat q0 = glm::dualquat_cast(R0);
+  glm::dualquat q1 = glm::dualquat_cast(R1);
+
+  // q and -q are the same rotation; take the short way around
+  if (glm::dot(q0.real, q1.real) < 0.f) {
+    q1.real = -q1.real;
+    q1.dual = -q1.dual;
+  }
+
+  glm::dualquat interpR = glm::lerp(q0, q1, u);
+  glm::vec3 interpT = glm::mix(T0, T1, u);
+  viewMatOut = buildTransform(glm::mat3x4_cast(interpR), interpT);
+  fovOut = (1. - u) * k0.fov + u * k1.fov;
+}
+
+std::string CameraPath::toJson() const {
+  json jKeyframes = json::array();
+  for (const CameraPathKeyframe& k : keyframes) {
+    // (note weird glm indexing, glm is [col][row])
+    std::array<double, 16> viewMatFlat;
+    for (int i = 0; i < 4; i++) {
+      for (int j = 0; j < 4; j++) {
+        viewMatFlat[4 * i + j] = k.viewMat[j][i];
+      }
+    }
+    jKeyframes.push_back({{"time", k.time}, {"fov", k.fov}, {"viewMat", viewMatFlat}});
+  }
+
+  json j = {{"keyframes", jKeyframes}};
+  return j.dump();
+}
+
+CameraPath CameraPath::fromJson(std::string jsonData) {
+  json j = json::parse(jsonData);
+
+  CameraPath path;
+  for (const json& jKey : j.at("keyframes")) {
+    const json& matData = jKey.at("viewMat");
+    if (matData.size() != 16) {
+      throw std::runtime_error("camera path keyframe has a malformed view matrix");
+    }
+    glm::mat4 viewMat;
+    auto it = matData.begin();
+    for (int i = 0; i < 4; i++) {
+      for (int j = 0; j < 4; j++) {
+        viewMat[j][i] = it->get<float>();
+        it++;
+      }
+    }
+    path.addKeyframe(jKey.at("time").get<double>(), viewMat, jKey.at("fov").get<double>());
+  }
+  return path;
+}
+
+void CameraPath::save(std::string filename) const {
+  std::ofstream outStream(filename);
+  if (!outStream) {
+    polyscope::error("failed to open camera path file " + filename);
+    return;
+  }
+  outStream << toJson() << std::endl;
+}
+
+CameraPath CameraPath::load(std::string filename) {
+  std::ifstream inStream(filename);
+  if (!inStream) {
+    polyscope::error("failed to open camera path file " + filename);
+    return CameraPath();
+  }
+
+  try {
+    std::stringstream text;
+    text << inStream.rdbuf();
+    return fromJson(text.str());
+  } catch (const std::exception& e) {
+    polyscope::error("failed to parse camera path file " + filename + ": " + e.what());
+    return CameraPath();
+  }
+}
+
+void startRecordingCameraPath() {
+  recording = true;
+  recordedPath = CameraPath();
+  recordingStart = std::chrono::steady_clock::now();
+  lastRecordedFrameTime = 0.;
+  recordedPath.addKeyframe(0.);
+}
+
+CameraPath stopRecordingCameraPath() {
+  if (!recording) return CameraPath();
+
+  recording = false;
+  double t = recordingTime();
+  if (t > recordedPath.keyframes.back().time) {
+    recordedPath.addKeyframe(t);
+  }
+
+  CameraPath path;
+  std::swap(path, recordedPath);
+  return path;
+}
+
+bool isRecordingCameraPath() { return recording; }
+
+CameraPathTimings replayCameraPath(const CameraPath& path, double frameStep, std::string framePrefix) {
+  CameraPathTimings timings;
+  if (path.keyframes.empty()) return timings;
+  if (!(frameStep > 0.)) {
+    polyscope::error("camera path frame step must be positive");
+    return timings;
+  }
+
+  glm::mat4 initialViewMat = view::viewMat;
+  double initialFov = view::fov;
+  view::immediatelyEndFlight();
+
+  // (the small epsilon keeps the last keyframe when the duration is a multiple of the step)
+  size_t nFrames = static_cast<size_t>(std::floor(path.duration() / frameStep + 1e-6)) + 1;
+  timings.frameTimes.reserve(nFrames);
+  for (size_t iFrame = 0; iFrame < nFrames; iFrame++) {
+    path.evaluate(path.keyframes.front().time + iFrame * frameStep, view::viewMat, view::fov);
+    requestViewRedraw();
+    render::engine->pollEvents(); // keep the window responsive, but ignore any input
+
+    auto frameStart = std::chrono::steady_clock::now();
+    draw(false);
+    render::engine->swapDisplayBuffers();
+    auto frameEnd = std::chrono::steady_clock::now();
+    timings.frameTimes.push_back(std::chrono::duration<double, std::milli>(frameEnd - frameStart).count());
+
+    if (!framePrefix.empty()) {
+      char buff[50];
+      snprintf(buff, 50, "_%06zu", iFrame);
+      screenshot(framePrefix + buff + options::screenshotExtension, false);
+    }
+  }
+
+  view::viewMat = initialViewMat;
+  view::fov = initialFov;
+  requestViewRedraw();
+
+  // Summary statistics
+  std::vector<double> sorted = timings.frameTimes;
+  std::sort(sorted.begin(), sorted.end());
+  double sum = 0.;
+  for (double t : sorted) sum += t;
+  timings.mean = sum / sorted.size();
+  timings.median = sorted[sorted.size() / 2];
+  timings.percentile95 = sorted[static_cast<size_t>(std::ceil(0.95 * sorted.size())) - 1];
+  timings.max = sorted.back();
+
+  return timings;
+}
+
+namespace view {
+
+void updateCameraPathRecording() {
+  if (!recording) return;
+
+  double t = recordingTime();
+  CameraPathKeyframe last = recordedPath.keyframes.back();
+  glm::mat4 currViewMat = getCameraViewMatrix();
+  if (currViewMat != last.viewMat || fov != last.fov) {
+    // The camera stood still from the last keyframe until the previous frame
+    if (lastRecordedFrameTime > last.time) {
+      recordedPath.addKeyframe(lastRecordedFrameTime, last.viewMat, last.fov);
+    }
+    recordedPath.addKeyframe(t, currViewMat, fov);
+  }
+  lastRecordedFrameTime = t;
+}
+
+} // namespace view
+
+} // namespace polyscope
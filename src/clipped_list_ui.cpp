@@ -0,0 +1,95 @@
+// Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
+#include "polyscope/clipped_list_ui.h"
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace polyscope {
+
+namespace {
+
+std::string toLower(std::string s) {
+  std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return std::tolower(c); });
+  return s;
+}
+
+} // namespace
+
+const size_t ClippedListUI::minItems;
+
+void ClippedListUI::markItemsChanged() { matchesValid = false; }
+
+void ClippedListUI::updateMatches(size_t nItems, const std::function<const std::string&(size_t)>& label) {
+  matchedFilterText = filterText;
+  std::string filterLower = toLower(matchedFilterText);
+
+  matches.clear();
+  selectedIndex = -1;
+  for (size_t i = 0; i < nItems; i++) {
+    const std::string& itemLabel = label(i);
+    if (filterLower.empty() || toLower(itemLabel).find(filterLower) != std::string::npos) {
+      matches.push_back(i);
+    }
+    if (!selectedLabel.empty() && itemLabel == selectedLabel) {
+      selectedIndex = i;
+    }
+  }
+
+  matchesValid = true;
+}
+
+long long ClippedListUI::build(size_t nItems, const std::function<const std::string&(size_t)>& label,
+                               const std::function<bool(size_t)>& isEnabled,
+                               const std::function<void(size_t, bool)>& setEnabled) {
+
+  ImGui::PushItemWidth(-1);
+  ImGui::InputText("##filter", filterText, sizeof(filterText));
+  ImGui::PopItemWidth();
+  if (!matchesValid || matchedFilterText != filterText) {
+    updateMatches(nItems, label);
+  }
+
+  // Scrolling region showing at most a dozen rows
+  const size_t maxVisibleRows = 12;
+  float rowHeight = ImGui::GetFrameHeightWithSpacing();
+  float listHeight = rowHeight * std::min(std::max(matches.size(), static_cast<size_t>(1)), maxVisibleRows) +
+                     2 * ImGui::GetStyle().WindowPadding.y;
+  ImGui::BeginChild("##list", ImVec2(0, listHeight), true);
+
+  // Only the visible rows are built
+  ImGuiListClipper clipper;
+  clipper.Begin(static_cast<int>(matches.size()), rowHeight);
+  while (clipper.Step()) {
+    for (int iRow = clipper.DisplayStart; iRow < clipper.DisplayEnd; iRow++) {
+      size_t i = matches[iRow];
+      ImGui::PushID(iRow);
+
+      bool enabled = isEnabled(i);
+      if (ImGui::Checkbox("##enabled", &enabled)) {
+        setEnabled(i, enabled);
+      }
+      ImGui::SameLine();
+
+      bool isSelected = static_cast<long long>(i) == selectedIndex;
+      if (ImGui::Selectable(label(i).c_str(), isSelected)) {
+        selectedIndex = isSelected ? -1 : static_cast<long long>(i);
+        selectedLabel = isSelected ? "" : label(i);
+      }
+
+      ImGui::PopID();
+    }
+  }
+  clipper.End();
+
+  ImGui::EndChild();
+
+  if (matches.size() != nItems) {
+    ImGui::Text("%d of %d shown", static_cast<int>(matches.size()), static_cast<int>(nItems));
+  }
+
+  return selectedIndex;
+}
+
+} // namespace polyscope
@@ -7,6 +7,7 @@
 
 #include "imgui.h"
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 
@@ -50,20 +51,10 @@ CurveNetwork::CurveNetwork(std::string name, std::vector<glm::vec3> nodes_, std:
 
 // Helper to set uniforms
 void CurveNetwork::setCurveNetworkNodeUniforms(render::ShaderProgram& p) {
-  glm::mat4 P = view::getCameraPerspectiveMatrix();
-  glm::mat4 Pinv = glm::inverse(P);
-  p.setUniform("u_invProjMatrix", glm::value_ptr(Pinv));
-  p.setUniform("u_viewport", render::engine->getCurrentViewport());
   p.setUniform("u_pointRadius", getRadius());
 }
 
-void CurveNetwork::setCurveNetworkEdgeUniforms(render::ShaderProgram& p) {
-  glm::mat4 P = view::getCameraPerspectiveMatrix();
-  glm::mat4 Pinv = glm::inverse(P);
-  p.setUniform("u_invProjMatrix", glm::value_ptr(Pinv));
-  p.setUniform("u_viewport", render::engine->getCurrentViewport());
-  p.setUniform("u_radius", getRadius());
-}
+void CurveNetwork::setCurveNetworkEdgeUniforms(render::ShaderProgram& p) { p.setUniform("u_radius", getRadius()); }
 
 void CurveNetwork::draw() {
   if (!isEnabled()) {
@@ -226,6 +217,63 @@ void CurveNetwork::refresh() {
   QuantityStructure<CurveNetwork>::refresh(); // call base class version, which refreshes quantities
 }
 
+bool CurveNetwork::writeSnapshot(SnapshotWriter& writer) {
+  writer.writeArray(nodes);
+  writer.writeArray(edges);
+  writeQuantitySnapshots(writer);
+  return true;
+}
+
+CurveNetwork* CurveNetwork::readSnapshot(std::string name, SnapshotReader& reader) {
+  std::vector<glm::vec3> nodes = reader.readArray<glm::vec3>();
+  std::vector<std::array<size_t, 2>> edges = reader.readArray<std::array<size_t, 2>>();
+  for (const std::array<size_t, 2>& edge : edges) {
+    if (edge[0] >= nodes.size() || edge[1] >= nodes.size()) {
+      throw std::runtime_error("snapshot data for curve network " + name + " has an edge with an invalid node index");
+    }
+  }
+
+  CurveNetwork* s = new CurveNetwork(name, std::move(nodes), std::move(edges));
+  bool success = registerStructure(s);
+  if (!success) {
+    safeDelete(s);
+    return s;
+  }
+
+  s->readQuantitySnapshots(reader);
+  return s;
+}
+
+CurveNetworkQuantity* CurveNetwork::readQuantitySnapshot(std::string kind, std::string name, SnapshotReader& reader) {
+  if (kind == "nodeScalar" || kind == "edgeScalar") {
+    DataType type = reader.readEnum(DataType::MAGNITUDE);
+    std::vector<double> values = reader.readArray<double>(kind == "nodeScalar" ? nNodes() : nEdges());
+    CurveNetworkScalarQuantity* q;
+    if (kind == "nodeScalar") {
+      q = addNodeScalarQuantityImpl(name, values, type);
+    } else {
+      q = addEdgeScalarQuantityImpl(name, values, type);
+    }
+    q->readScalarSnapshot(reader);
+    return q;
+  }
+  if (kind == "nodeColor") {
+    return addNodeColorQuantityImpl(name, reader.readArray<glm::vec3>(nNodes()));
+  }
+  if (kind == "edgeColor") {
+    return addEdgeColorQuantityImpl(name, reader.readArray<glm::vec3>(nEdges()));
+  }
+  if (kind == "nodeVector" || kind == "edgeVector") {
+    VectorType type = reader.readEnum(VectorType::AMBIENT);
+    std::vector<glm::vec3> vectors = reader.readArray<glm::vec3>(kind == "nodeVector" ? nNodes() : nEdges());
+    if (kind == "nodeVector") {
+      return addNodeVectorQuantityImpl(name, vectors, type);
+    }
+    return addEdgeVectorQuantityImpl(name, vectors, type);
+  }
+  return nullptr;
+}
+
 void CurveNetwork::geometryChanged() {
   refresh();
 }
@@ -306,34 +354,12 @@ void CurveNetwork::buildCustomOptionsUI() {
   }
 }
 
-double CurveNetwork::lengthScale() {
-  // TODO cache
-
-  // Measure length scale as twice the radius from the center of the bounding box
-  auto bound = boundingBox();
-  glm::vec3 center = 0.5f * (std::get<0>(bound) + std::get<1>(bound));
-
-  double lengthScale = 0.0;
-  for (glm::vec3& rawP : nodes) {
-    glm::vec3 p = glm::vec3(objectTransform.get() * glm::vec4(rawP, 1.0));
-    lengthScale = std::max(lengthScale, (double)glm::length2(p - center));
-  }
-
-  return 2 * std::sqrt(lengthScale);
+double CurveNetwork::drawMargin() {
+  return std::max(static_cast<double>(getRadius()), QuantityStructure<CurveNetwork>::drawMargin());
 }
 
-std::tuple<glm::vec3, glm::vec3> CurveNetwork::boundingBox() {
-
-  glm::vec3 min = glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
-  glm::vec3 max = -glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
-
-  for (glm::vec3& rawP : nodes) {
-    glm::vec3 p = glm::vec3(objectTransform.get() * glm::vec4(rawP, 1.0));
-    min = componentwiseMin(min, p);
-    max = componentwiseMax(max, p);
-  }
-
-  return std::make_tuple(min, max);
+void CurveNetwork::computeExtents(std::tuple<glm::vec3, glm::vec3>& bboxOut, double& lengthScaleOut) {
+  computePointExtents(nodes, bboxOut, lengthScaleOut);
 }
 
 CurveNetwork* CurveNetwork::setColor(glm::vec3 newVal) {
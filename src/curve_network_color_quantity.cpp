@@ -83,6 +83,10 @@ void CurveNetworkNodeColorQuantity::buildNodeInfoGUI(size_t vInd) {
   ImGui::NextColumn();
 }
 
+std::string CurveNetworkNodeColorQuantity::snapshotKind() { return "nodeColor"; }
+
+void CurveNetworkNodeColorQuantity::writeSnapshot(SnapshotWriter& writer) { writer.writeArray(values); }
+
 std::string CurveNetworkColorQuantity::niceName() { return name + " (" + definedOn + " color)"; }
 
 void CurveNetworkColorQuantity::refresh() {
@@ -150,4 +154,8 @@ void CurveNetworkEdgeColorQuantity::buildEdgeInfoGUI(size_t eInd) {
   ImGui::NextColumn();
 }
 
+std::string CurveNetworkEdgeColorQuantity::snapshotKind() { return "edgeColor"; }
+
+void CurveNetworkEdgeColorQuantity::writeSnapshot(SnapshotWriter& writer) { writer.writeArray(values); }
+
 } // namespace polyscope
@@ -61,6 +61,10 @@ void CurveNetworkScalarQuantity::refresh() {
 
 std::string CurveNetworkScalarQuantity::niceName() { return name + " (" + definedOn + " scalar)"; }
 
+std::string CurveNetworkScalarQuantity::snapshotKind() { return definedOn + "Scalar"; }
+
+void CurveNetworkScalarQuantity::writeSnapshot(SnapshotWriter& writer) { writeScalarSnapshot(writer); }
+
 // ========================================================
 // ==========             Node Scalar            ==========
 // ========================================================
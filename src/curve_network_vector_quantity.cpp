@@ -22,6 +22,8 @@ void CurveNetworkVectorQuantity::prepareVectorArtist() {
   vectorArtist.reset(new VectorArtist(parent, name + "#vectorartist", vectorRoots, vectors, vectorType));
 }
 
+double CurveNetworkVectorQuantity::drawMargin() { return vectorArtist ? vectorArtist->drawMargin() : 0.; }
+
 void CurveNetworkVectorQuantity::draw() {
   if (!isEnabled()) return;
   vectorArtist->draw();
@@ -60,6 +62,13 @@ std::string CurveNetworkVectorQuantity::getMaterial() { return vectorArtist->get
 
 std::string CurveNetworkEdgeVectorQuantity::niceName() { return name + " (edge vector)"; }
 
+std::string CurveNetworkEdgeVectorQuantity::snapshotKind() { return "edgeVector"; }
+
+void CurveNetworkEdgeVectorQuantity::writeSnapshot(SnapshotWriter& writer) {
+  writer.write<VectorType>(vectorType);
+  writer.writeArray(vectors);
+}
+
 // ========================================================
 // ==========           Node Vector            ==========
 // ========================================================
@@ -96,6 +105,13 @@ void CurveNetworkNodeVectorQuantity::buildNodeInfoGUI(size_t iV) {
 
 std::string CurveNetworkNodeVectorQuantity::niceName() { return name + " (node vector)"; }
 
+std::string CurveNetworkNodeVectorQuantity::snapshotKind() { return "nodeVector"; }
+
+void CurveNetworkNodeVectorQuantity::writeSnapshot(SnapshotWriter& writer) {
+  writer.write<VectorType>(vectorType);
+  writer.writeArray(vectors);
+}
+
 // ========================================================
 // ==========            Edge Vector             ==========
 // ========================================================
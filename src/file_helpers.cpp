@@ -4,6 +4,20 @@
 #include "imgui.h"
 #include "polyscope/polyscope.h"
 
+#include <stdexcept>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace polyscope {
 
 namespace {
@@ -49,4 +63,63 @@ std::string promptForFilename(std::string initName) {
 
   return stringOut;
 }
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(std::string filename) {
+  fileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                           FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (fileHandle == INVALID_HANDLE_VALUE) {
+    fileHandle = nullptr;
+    throw std::runtime_error("could not open " + filename);
+  }
+  LARGE_INTEGER fileSize;
+  GetFileSizeEx(fileHandle, &fileSize);
+  length = static_cast<size_t>(fileSize.QuadPart);
+  if (length == 0) return;
+
+  mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mappingHandle != nullptr) {
+    ptr = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+  }
+  if (ptr == nullptr) {
+    if (mappingHandle != nullptr) CloseHandle(mappingHandle);
+    CloseHandle(fileHandle);
+    throw std::runtime_error("could not map " + filename);
+  }
+}
+
+MappedFile::~MappedFile() {
+  if (ptr != nullptr) UnmapViewOfFile(ptr);
+  if (mappingHandle != nullptr) CloseHandle(mappingHandle);
+  if (fileHandle != nullptr) CloseHandle(fileHandle);
+}
+
+#else
+
+MappedFile::MappedFile(std::string filename) {
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) throw std::runtime_error("could not open " + filename);
+  struct stat fileStat;
+  if (fstat(fd, &fileStat) != 0) {
+    close(fd);
+    throw std::runtime_error("could not read " + filename);
+  }
+  length = static_cast<size_t>(fileStat.st_size);
+  if (length > 0) {
+    ptr = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  close(fd); // the mapping stays valid after the file is closed
+  if (ptr == MAP_FAILED) {
+    ptr = nullptr;
+    throw std::runtime_error("could not map " + filename);
+  }
+}
+
+MappedFile::~MappedFile() {
+  if (ptr != nullptr) munmap(ptr, length);
+}
+
+#endif
+
 } // namespace polyscope
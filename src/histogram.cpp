@@ -3,6 +3,7 @@
 
 #include "polyscope/affine_remapper.h"
 #include "polyscope/polyscope.h"
+#include "polyscope/task_scheduler.h"
 
 #include "imgui.h"
 
@@ -56,21 +57,33 @@ void Histogram::buildHistogram(std::vector<double>& values, const std::vector<do
     double inc = range / binCount;
     std::vector<double> sumBin(binCount, 0.0);
 
-    // count values in buckets
-    for (size_t iData = 0; iData < N; iData++) {
-
-      double iBinf = binCount * (values[iData] - dataRange.first) / range;
-      size_t iBin = std::floor(glm::clamp(iBinf, 0.0, (double)binCount - 1));
-
-      // NaN values and finite values near the bottom of float range lead to craziness, so only increment bins if we got
-      // something reasonable
-      if (iBin < binCount) {
-        if (weighted) {
-          sumBin[iBin] += weights[iData];
-        } else {
-          sumBin[iBin] += 1.0;
+    // count values in buckets, with separate sums for each chunk of data which are then added up in order
+    const size_t grainSize = 16384;
+    std::vector<std::vector<double>> chunkSumBin(tasks::chunkCount(0, N, grainSize));
+    tasks::parallelFor(0, N, grainSize, [&](size_t begin, size_t end) {
+      std::vector<double>& chunkSum = chunkSumBin[begin / grainSize];
+      chunkSum.resize(binCount, 0.0);
+
+      for (size_t iData = begin; iData < end; iData++) {
+
+        double iBinf = binCount * (values[iData] - dataRange.first) / range;
+        size_t iBin = std::floor(glm::clamp(iBinf, 0.0, (double)binCount - 1));
+
+        // NaN values and finite values near the bottom of float range lead to craziness, so only increment bins if we
+        // got something reasonable
+        if (iBin < binCount) {
+          if (weighted) {
+            chunkSum[iBin] += weights[iData];
+          } else {
+            chunkSum[iBin] += 1.0;
+          }
         }
       }
+    });
+    for (const std::vector<double>& chunkSum : chunkSumBin) {
+      for (size_t iBin = 0; iBin < binCount; iBin++) {
+        sumBin[iBin] += chunkSum[iBin];
+      }
     }
 
 
@@ -1,9 +1,45 @@
 // Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
 #include "polyscope/options.h"
 
+#include "polyscope/polyscope.h"
+#include "polyscope/render/engine.h"
+#include "polyscope/task_scheduler.h"
+
 namespace polyscope {
 namespace options {
 
+namespace {
+// Side effects of changing options, run whenever an ObservedOption is assigned a new value. Anything set before the
+// engine exists is applied by init().
+
+void onTransparencyModeChange() {
+  if (render::engine) render::engine->setTransparencyMode(transparencyMode);
+}
+
+void onAntiAliasingChange() {
+  if (!render::engine) return;
+  render::engine->setProgressiveAA(progressiveAA);
+  render::engine->setSSAAFactor(progressiveAA ? 1 : ssaaFactor.get());
+}
+
+void onGroundPlaneEnabledChange() {
+  // the deprecated groundPlaneEnabled = false sets the mode to None, so there is only one variable to check
+  if (!groundPlaneEnabled) groundPlaneMode = GroundPlaneMode::None;
+}
+
+void onGroundPlaneModeChange() {
+  if (render::engine) render::engine->groundPlane.prepare();
+  requestRedraw();
+}
+
+void onAppearanceChange() { requestRedraw(); }
+
+void onThreadCountChange() {
+  tasks::shutdown(); // restarted with the new size on next use
+}
+
+} // namespace
+
 std::string programName = "Polyscope";
 int verbosity = 1;
 std::string printPrefix = "[polyscope] ";
@@ -13,10 +49,13 @@ int maxFPS = 60;
 bool usePrefsFile = true;
 bool initializeWithDefaultStructures = true;
 bool alwaysRedraw = false;
+bool sleepWhenIdle = false;
+float idleTimeout = 0.5;
 bool autocenterStructures = false;
 bool autoscaleStructures = false;
 bool openImGuiWindowForUserCallback = true;
 bool invokeUserCallbackForNestedShow = false;
+ObservedOption<int> nThreads(0, &onThreadCountChange);
 
 bool screenshotTransparency = true;
 std::string screenshotExtension = ".png";
@@ -24,19 +63,28 @@ std::string screenshotExtension = ".png";
 // == Scene options
 
 // Ground plane / shadows
-bool groundPlaneEnabled = true;
-GroundPlaneMode groundPlaneMode = GroundPlaneMode::TileReflection;
-ScaledValue<float> groundPlaneHeightFactor = 0;
-int shadowBlurIters = 2; 
-float shadowDarkness = 0.4; 
+ObservedOption<bool> groundPlaneEnabled(true, &onGroundPlaneEnabledChange);
+ObservedOption<GroundPlaneMode> groundPlaneMode(GroundPlaneMode::TileReflection, &onGroundPlaneModeChange);
+ObservedOption<ScaledValue<float>> groundPlaneHeightFactor(0., &onAppearanceChange);
+ObservedOption<int> shadowBlurIters(2, &onAppearanceChange);
+ObservedOption<float> shadowDarkness(0.4, &onAppearanceChange);
 
 // Rendering options
 
-int ssaaFactor = 1;
+ObservedOption<int> ssaaFactor(1, &onAntiAliasingChange);
+ObservedOption<bool> progressiveAA(false, &onAntiAliasingChange);
+int progressiveAASamples = 16;
 
 // Transparency
-TransparencyMode transparencyMode = TransparencyMode::None;
-int transparencyRenderPasses = 8;
+ObservedOption<TransparencyMode> transparencyMode(TransparencyMode::None, &onTransparencyModeChange);
+ObservedOption<int> transparencyRenderPasses(8, &onAppearanceChange);
+
+// Culling
+ObservedOption<bool> frustumCulling(true, &onAppearanceChange);
+ObservedOption<float> smallFeatureCullingPixels(0., &onAppearanceChange);
+ObservedOption<bool> occlusionCulling(false, &onAppearanceChange);
+ObservedOption<int> occlusionMaxOccluders(16, &onAppearanceChange);
+ObservedOption<float> lodPixelError(1., &onAppearanceChange);
 
 // enabled by default in debug mode
 #ifndef NDEBUG
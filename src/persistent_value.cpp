@@ -1,21 +1,210 @@
 #include "polyscope/persistent_value.h"
 
+#include "polyscope/messages.h"
 #include "polyscope/render/color_maps.h"
 
+#include "json/json.hpp"
+using json = nlohmann::json;
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
 namespace polyscope {
 namespace detail {
-// storage for persistent value global caches
+
+// storage for the persistent value global cache
+PersistentStore persistentStore;
+
+const uint32_t PersistentValueTable::noValue;
+const PersistentKey PersistentStore::noKey;
+
+PersistentKey PersistentStore::intern(const std::string& name, PersistentType type) {
+
+  auto it = firstKeyByName.find(name);
+  if (it == firstKeyByName.end()) {
+    PersistentKey newKey = static_cast<PersistentKey>(keys.size());
+    it = firstKeyByName.emplace(name, newKey).first;
+    keys.push_back(KeyInfo{&it->first, type, noKey});
+    return newKey;
+  }
+
+  // Walk the keys which share this name, looking for the one with this type
+  PersistentKey key = it->second;
+  while (keys[key].type != type) {
+    if (keys[key].nextSameName == noKey) {
+      PersistentKey newKey = static_cast<PersistentKey>(keys.size());
+      keys[key].nextSameName = newKey;
+      keys.push_back(KeyInfo{&it->first, type, noKey});
+      return newKey;
+    }
+    key = keys[key].nextSameName;
+  }
+  return key;
+}
+
+namespace {
+
+// === Conversion to and from json for each cached type
+
 // clang-format off
-PersistentCache<double> persistentCache_double;
-PersistentCache<float> persistentCache_float;
-PersistentCache<bool> persistentCache_bool;
-PersistentCache<std::string> persistentCache_string;
-PersistentCache<glm::vec3> persistentCache_glmvec3;
-PersistentCache<glm::mat4> persistentCache_glmmat4;
-PersistentCache<ScaledValue<double>> persistentCache_scaleddouble;
-PersistentCache<ScaledValue<float>> persistentCache_scaledfloat;
-PersistentCache<ParamVizStyle> persistentCache_paramVizStyle;
-PersistentCache<BackfacePolicy> persistentCache_backfacePolicy;
+const char* typeNames[] = {"double", "float", "bool", "string", "vec3", "mat4", "scaledDouble", "scaledFloat", "paramVizStyle", "backfacePolicy"};
 // clang-format on
+const size_t nTypes = sizeof(typeNames) / sizeof(typeNames[0]);
+
+template <typename T>
+json toJSON(const T& val) {
+  return val;
+}
+template <>
+json toJSON(const glm::vec3& val) {
+  return {val.x, val.y, val.z};
+}
+template <>
+json toJSON(const glm::mat4& val) {
+  json j = json::array();
+  for (int iCol = 0; iCol < 4; iCol++) {
+    for (int iRow = 0; iRow < 4; iRow++) {
+      j.push_back(val[iCol][iRow]);
+    }
+  }
+  return j;
+}
+template <>
+json toJSON(const ScaledValue<double>& val) {
+  ScaledValue<double> v = val;
+  return {*v.getValuePtr(), v.isRelative()};
+}
+template <>
+json toJSON(const ScaledValue<float>& val) {
+  ScaledValue<float> v = val;
+  return {*v.getValuePtr(), v.isRelative()};
+}
+template <>
+json toJSON(const ParamVizStyle& val) {
+  return static_cast<int>(val);
+}
+template <>
+json toJSON(const BackfacePolicy& val) {
+  return static_cast<int>(val);
+}
+
+template <typename T>
+T fromJSON(const json& j) {
+  return j.get<T>();
+}
+template <>
+glm::vec3 fromJSON(const json& j) {
+  return glm::vec3{j.at(0).get<float>(), j.at(1).get<float>(), j.at(2).get<float>()};
+}
+template <>
+glm::mat4 fromJSON(const json& j) {
+  glm::mat4 val;
+  for (int iCol = 0; iCol < 4; iCol++) {
+    for (int iRow = 0; iRow < 4; iRow++) {
+      val[iCol][iRow] = j.at(4 * iCol + iRow).get<float>();
+    }
+  }
+  return val;
+}
+template <>
+ScaledValue<double> fromJSON(const json& j) {
+  return ScaledValue<double>(j.at(0).get<double>(), j.at(1).get<bool>());
+}
+template <>
+ScaledValue<float> fromJSON(const json& j) {
+  return ScaledValue<float>(j.at(0).get<float>(), j.at(1).get<bool>());
+}
+template <>
+ParamVizStyle fromJSON(const json& j) {
+  return static_cast<ParamVizStyle>(j.get<int>());
+}
+template <>
+BackfacePolicy fromJSON(const json& j) {
+  return static_cast<BackfacePolicy>(j.get<int>());
+}
+
+template <typename T>
+json valueToJSON(PersistentKey key) {
+  return toJSON<T>(persistentStore.table.get<T>(key));
+}
+
+template <typename T>
+void valueFromJSON(const std::string& name, const json& j) {
+  PersistentKey key = persistentStore.intern(name, PersistentTypeOf<T>::value);
+  persistentStore.table.set<T>(key, fromJSON<T>(j));
+}
+
+// clang-format off
+typedef json (*ValueToJSONFunc)(PersistentKey);
+typedef void (*ValueFromJSONFunc)(const std::string&, const json&);
+const ValueToJSONFunc valueToJSONFuncs[] = {
+  &valueToJSON<double>, &valueToJSON<float>, &valueToJSON<bool>, &valueToJSON<std::string>, &valueToJSON<glm::vec3>,
+  &valueToJSON<glm::mat4>, &valueToJSON<ScaledValue<double>>, &valueToJSON<ScaledValue<float>>,
+  &valueToJSON<ParamVizStyle>, &valueToJSON<BackfacePolicy>};
+const ValueFromJSONFunc valueFromJSONFuncs[] = {
+  &valueFromJSON<double>, &valueFromJSON<float>, &valueFromJSON<bool>, &valueFromJSON<std::string>,
+  &valueFromJSON<glm::vec3>, &valueFromJSON<glm::mat4>, &valueFromJSON<ScaledValue<double>>,
+  &valueFromJSON<ScaledValue<float>>, &valueFromJSON<ParamVizStyle>, &valueFromJSON<BackfacePolicy>};
+// clang-format on
+
+} // namespace
+} // namespace detail
+
+PersistentValueSnapshot snapshotPersistentValues() { return detail::persistentStore.table; }
+
+void restorePersistentValues(const PersistentValueSnapshot& snapshot) { detail::persistentStore.table = snapshot; }
+
+void savePersistentValues(std::string filename) {
+  std::ofstream outStream(filename);
+  if (!outStream) {
+    polyscope::error("failed to open persistent value file " + filename);
+    return;
+  }
+  outStream << detail::persistentValuesToJSON() << std::endl;
+}
+
+void loadPersistentValues(std::string filename) {
+  std::ifstream inStream(filename);
+  if (!inStream) {
+    polyscope::error("failed to open persistent value file " + filename);
+    return;
+  }
+
+  try {
+    std::stringstream text;
+    text << inStream.rdbuf();
+    detail::persistentValuesFromJSON(text.str());
+  } catch (const std::exception& e) {
+    polyscope::error("failed to parse persistent value file " + filename + ": " + e.what());
+  }
+}
+
+namespace detail {
+
+std::string persistentValuesToJSON() {
+  json values = json::array();
+  for (PersistentKey key = 0; key < persistentStore.keyCount(); key++) {
+    if (!persistentStore.table.has(key)) continue;
+    size_t iType = static_cast<size_t>(persistentStore.keyType(key));
+    values.push_back({persistentStore.keyName(key), typeNames[iType], valueToJSONFuncs[iType](key)});
+  }
+  return values.dump();
+}
+
+void persistentValuesFromJSON(const std::string& text) {
+  json values = json::parse(text);
+  for (const json& entry : values) {
+    std::string name = entry.at(0);
+    std::string typeName = entry.at(1);
+    size_t iType = std::find(typeNames, typeNames + nTypes, typeName) - typeNames;
+    if (iType == nTypes) {
+      polyscope::warning("unrecognized type in persistent values", typeName);
+      continue;
+    }
+    valueFromJSONFuncs[iType](name, entry.at(2));
+  }
+}
+
 } // namespace detail
 } // namespace polyscope
@@ -3,6 +3,7 @@
 
 #include "polyscope/polyscope.h"
 
+#include <algorithm>
 #include <limits>
 #include <tuple>
 
@@ -49,6 +50,14 @@ size_t requestPickBufferRange(Structure* requestingStructure, size_t count) {
   return ret;
 }
 
+void releasePickBufferRanges(const std::unordered_set<Structure*>& structures) {
+  auto isReleased = [&](const std::tuple<size_t, size_t, Structure*>& range) {
+    return structures.find(std::get<2>(range)) != structures.end();
+  };
+  structureRanges.erase(std::remove_if(structureRanges.begin(), structureRanges.end(), isReleased),
+                        structureRanges.end());
+}
+
 // == Manage stateful picking
 
 void resetSelection() {
@@ -138,10 +147,12 @@ std::pair<Structure*, size_t> evaluatePickQuery(int xPos, int yPos) {
   pickFramebuffer->clearColor = glm::vec3{0., 0., 0.};
   if (!pickFramebuffer->bindForRendering()) return {nullptr, 0};
   pickFramebuffer->clear();
+  render::engine->updateFrameCameraUniforms();
 
   // Render pick buffer
   for (auto cat : state::structures) {
     for (auto x : cat.second) {
+      if (!x.second->isEnabled() || !x.second->updateCulling()) continue;
       x.second->drawPick();
     }
   }
@@ -5,6 +5,7 @@
 #include "polyscope/pick.h"
 #include "polyscope/polyscope.h"
 #include "polyscope/render/engine.h"
+#include "polyscope/task_scheduler.h"
 
 #include "polyscope/point_cloud_color_quantity.h"
 #include "polyscope/point_cloud_scalar_quantity.h"
@@ -12,8 +13,10 @@
 
 #include "imgui.h"
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <limits>
 
 using std::cout;
 using std::endl;
@@ -23,6 +26,60 @@ namespace polyscope {
 // Initialize statics
 const std::string PointCloud::structureTypeName = "Point Cloud";
 
+namespace {
+
+// Spread the low 10 bits of x out to every third bit
+uint32_t spreadBits(uint32_t x) {
+  x &= 0x3ff;
+  x = (x | (x << 16)) & 0x030000ff;
+  x = (x | (x << 8)) & 0x0300f00f;
+  x = (x | (x << 4)) & 0x030c30c3;
+  x = (x | (x << 2)) & 0x09249249;
+  return x;
+}
+
+// Order points along a Morton (z-order) curve through a 1024^3 grid over their bounding box, so that any run of
+// consecutive points in the order is spatially compact, regardless of the order the points were given in. Points in the
+// same grid cell keep their relative order. Clouds of at most minPoints points are left as they are (empty result).
+std::vector<size_t> computeSpatialPointOrder(const std::vector<glm::vec3>& points, size_t minPoints) {
+  if (points.size() <= minPoints || points.size() > std::numeric_limits<uint32_t>::max()) return {};
+
+  glm::vec3 bboxMin = glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+  glm::vec3 bboxMax = -glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+  for (const glm::vec3& p : points) {
+    bboxMin = componentwiseMin(bboxMin, p);
+    bboxMax = componentwiseMax(bboxMax, p);
+  }
+  glm::vec3 extent = bboxMax - bboxMin;
+  glm::vec3 scale;
+  for (int d = 0; d < 3; d++) {
+    scale[d] = extent[d] > 0 ? 1024.f / extent[d] : 0.f;
+  }
+
+  // Sort by cell code, then by index
+  std::vector<uint64_t> keys(points.size());
+  tasks::parallelFor(0, points.size(), 16384, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      uint32_t code = 0;
+      for (int d = 0; d < 3; d++) {
+        float cell = (points[i][d] - bboxMin[d]) * scale[d];
+        uint32_t iCell = cell > 0 ? static_cast<uint32_t>(std::min(cell, 1023.f)) : 0; // (also catches NaN)
+        code |= spreadBits(iCell) << d;
+      }
+      keys[i] = (static_cast<uint64_t>(code) << 32) | i;
+    }
+  });
+  std::sort(keys.begin(), keys.end());
+
+  std::vector<size_t> order(points.size());
+  for (size_t i = 0; i < points.size(); i++) {
+    order[i] = static_cast<size_t>(keys[i] & 0xffffffff);
+  }
+  return order;
+}
+
+} // namespace
+
 // Constructor
 PointCloud::PointCloud(std::string name, std::vector<glm::vec3> points_)
     : QuantityStructure<PointCloud>(name, structureTypeName), points(std::move(points_)),
@@ -33,11 +90,6 @@ PointCloud::PointCloud(std::string name, std::vector<glm::vec3> points_)
 
 // Helper to set uniforms
 void PointCloud::setPointCloudUniforms(render::ShaderProgram& p) {
-  glm::mat4 P = view::getCameraPerspectiveMatrix();
-  glm::mat4 Pinv = glm::inverse(P);
-  p.setUniform("u_invProjMatrix", glm::value_ptr(Pinv));
-  p.setUniform("u_viewport", render::engine->getCurrentViewport());
-
   if (pointRadiusQuantityName != "" && !pointRadiusQuantityAutoscale) {
     // special case: ignore radius uniform
     p.setUniform("u_pointRadius", 1.);
@@ -117,9 +169,10 @@ void PointCloud::preparePick() {
 
   // Fill color buffer with packed point indices
   std::vector<glm::vec3> pickColors;
-  for (size_t i = pickStart; i < pickStart + pickCount; i++) {
-    glm::vec3 val = pick::indToVec(i);
-    pickColors.push_back(pick::indToVec(i));
+  const std::vector<size_t>& order = getPointDrawOrder();
+  for (size_t iDraw = 0; iDraw < pickCount; iDraw++) {
+    size_t i = order.empty() ? iDraw : order[iDraw];
+    pickColors.push_back(pick::indToVec(pickStart + i));
   }
 
   // Store data in buffers
@@ -174,13 +227,22 @@ std::vector<double> PointCloud::resolvePointRadiusQuantity() {
 }
 
 void PointCloud::fillGeometryBuffers(render::ShaderProgram& p) {
-  p.setAttribute("a_position", points);
+  p.setAttribute("a_position", inDrawOrder(points));
+  p.setDrawRanges(&visibleDrawRanges);
 
   if (pointRadiusQuantityName != "") {
     // Resolve the quantity
     std::vector<double> pointRadiusQuantityVals = resolvePointRadiusQuantity();
-    p.setAttribute("a_pointRadius", pointRadiusQuantityVals);
+    p.setAttribute("a_pointRadius", inDrawOrder(pointRadiusQuantityVals));
+  }
+}
+
+const std::vector<size_t>& PointCloud::getPointDrawOrder() {
+  if (!pointDrawOrderValid) {
+    pointDrawOrder = computeSpatialPointOrder(points, cullingChunkSize);
+    pointDrawOrderValid = true;
   }
+  return pointDrawOrder;
 }
 
 void PointCloud::geometryChanged() { refresh(); }
@@ -244,46 +306,101 @@ void PointCloud::buildCustomOptionsUI() {
   }
 }
 
-double PointCloud::lengthScale() {
-  // TODO cache
-
-  // Measure length scale as twice the radius from the center of the bounding box
-  auto bound = boundingBox();
-  glm::vec3 center = 0.5f * (std::get<0>(bound) + std::get<1>(bound));
-
-  double lengthScale = 0.0;
-  for (glm::vec3& rawP : points) {
-    glm::vec3 p = glm::vec3(objectTransform.get() * glm::vec4(rawP, 1.0));
-    lengthScale = std::max(lengthScale, (double)glm::length2(p - center));
-  }
-
-  return 2 * std::sqrt(lengthScale);
+void PointCloud::computeExtents(std::tuple<glm::vec3, glm::vec3>& bboxOut, double& lengthScaleOut) {
+  computePointExtents(points, bboxOut, lengthScaleOut);
 }
 
-std::tuple<glm::vec3, glm::vec3> PointCloud::boundingBox() {
 
-  glm::vec3 min = glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
-  glm::vec3 max = -glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+void PointCloud::computeCullingChunks(std::vector<CullingChunk>& chunksOut) {
+  // Consecutive points in the (spatial) drawing order
+  if (points.size() <= cullingChunkSize) return;
+  const std::vector<size_t>& order = getPointDrawOrder();
+  chunksOut.resize(tasks::chunkCount(0, points.size(), cullingChunkSize));
+  tasks::parallelFor(0, points.size(), cullingChunkSize, [&](size_t begin, size_t end) {
+    CullingChunk& chunk = chunksOut[begin / cullingChunkSize];
+    chunk.bboxMin = glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+    chunk.bboxMax = -glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+    for (size_t iDraw = begin; iDraw < end; iDraw++) {
+      const glm::vec3& p = points[order.empty() ? iDraw : order[iDraw]];
+      chunk.bboxMin = componentwiseMin(chunk.bboxMin, p);
+      chunk.bboxMax = componentwiseMax(chunk.bboxMax, p);
+    }
+    chunk.range = DrawRange{static_cast<uint32_t>(begin), static_cast<uint32_t>(end - begin)};
+  });
+}
 
-  for (glm::vec3& rawP : points) {
-    glm::vec3 p = glm::vec3(objectTransform.get() * glm::vec4(rawP, 1.0));
-    min = componentwiseMin(min, p);
-    max = componentwiseMax(max, p);
+double PointCloud::drawMargin() {
+  // Radii from a quantity which is not autoscaled have no bound
+  if (pointRadiusQuantityName != "" && !pointRadiusQuantityAutoscale) {
+    return std::numeric_limits<double>::infinity();
   }
-
-  return std::make_tuple(min, max);
+  return std::max(static_cast<double>(pointRadius.get().asAbsolute()), QuantityStructure<PointCloud>::drawMargin());
 }
 
-
 std::string PointCloud::typeName() { return structureTypeName; }
 
 
 void PointCloud::refresh() {
   program.reset();
   pickProgram.reset();
+  pointDrawOrderValid = false;
   QuantityStructure<PointCloud>::refresh(); // call base class version, which refreshes quantities
 }
 
+bool PointCloud::writeSnapshot(SnapshotWriter& writer) {
+  writer.writeArray(points);
+  writer.writeString(pointRadiusQuantityName);
+  writer.write<char>(pointRadiusQuantityAutoscale);
+  writeQuantitySnapshots(writer);
+  return true;
+}
+
+PointCloud* PointCloud::readSnapshot(std::string name, SnapshotReader& reader) {
+  std::vector<glm::vec3> points = reader.readArray<glm::vec3>();
+  std::string radiusQuantityName = reader.readString();
+  bool radiusQuantityAutoscale = reader.read<char>();
+
+  PointCloud* s = new PointCloud(name, std::move(points));
+  bool success = registerStructure(s);
+  if (!success) {
+    safeDelete(s);
+    return s;
+  }
+
+  s->readQuantitySnapshots(reader);
+  if (radiusQuantityName != "") {
+    s->setPointRadiusQuantity(radiusQuantityName, radiusQuantityAutoscale);
+  }
+  return s;
+}
+
+PointCloudQuantity* PointCloud::readQuantitySnapshot(std::string kind, std::string name, SnapshotReader& reader) {
+  if (kind == "scalar") {
+    DataType type = reader.readEnum(DataType::MAGNITUDE);
+    std::vector<double> values = reader.readArray<double>(nPoints());
+    PointCloudScalarQuantity* q = addScalarQuantityImpl(name, values, type);
+    q->readScalarSnapshot(reader);
+    return q;
+  }
+  if (kind == "color") {
+    return addColorQuantityImpl(name, reader.readArray<glm::vec3>(nPoints()));
+  }
+  if (kind == "vector") {
+    VectorType type = reader.readEnum(VectorType::AMBIENT);
+    std::vector<glm::vec3> vectors = reader.readArray<glm::vec3>(nPoints());
+    return addVectorQuantityImpl(name, vectors, type);
+  }
+  if (kind == "parameterization") {
+    ParamCoordsType type = reader.readEnum(ParamCoordsType::WORLD);
+    ParamVizStyle style = reader.readEnum(ParamVizStyle::LOCAL_RAD);
+    std::vector<glm::vec2> coords = reader.readArray<glm::vec2>(nPoints());
+    PointCloudParameterizationQuantity* q = addParameterizationQuantityImpl(name, coords, type);
+    q->setStyle(style);
+    return q;
+  }
+  return nullptr;
+}
+
 
 // === Set point size from a scalar quantity
 void PointCloud::setPointRadiusQuantity(PointCloudScalarQuantity* quantity, bool autoScale) {
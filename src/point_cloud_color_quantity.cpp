@@ -40,13 +40,17 @@ void PointCloudColorQuantity::draw() {
 
 std::string PointCloudColorQuantity::niceName() { return name + " (color)"; }
 
+std::string PointCloudColorQuantity::snapshotKind() { return "color"; }
+
+void PointCloudColorQuantity::writeSnapshot(SnapshotWriter& writer) { writer.writeArray(values); }
+
 void PointCloudColorQuantity::createPointProgram() {
   // Create the program to draw this quantity
   pointProgram = render::engine->requestShader("RAYCAST_SPHERE", parent.addStructureRules({"SPHERE_PROPAGATE_COLOR", "SHADE_COLOR"}));
 
   // Fill buffers
   parent.fillGeometryBuffers(*pointProgram);
-  pointProgram->setAttribute("a_color", values);
+  pointProgram->setAttribute("a_color", parent.inDrawOrder(values));
 
   render::engine->setMaterial(*pointProgram, parent.getMaterial());
 }
@@ -79,7 +79,7 @@ void PointCloudParameterizationQuantity::createProgram() {
 
   // Fill buffers
   parent.fillGeometryBuffers(*program);
-  program->setAttribute("a_value2", coords);
+  program->setAttribute("a_value2", parent.inDrawOrder(coords));
 
   render::engine->setMaterial(*program, parent.getMaterial());
 }
@@ -264,6 +264,14 @@ void PointCloudParameterizationQuantity::refresh() {
 
 std::string PointCloudParameterizationQuantity::niceName() { return name + " (point parameterization)"; }
 
+std::string PointCloudParameterizationQuantity::snapshotKind() { return "parameterization"; }
+
+void PointCloudParameterizationQuantity::writeSnapshot(SnapshotWriter& writer) {
+  writer.write<ParamCoordsType>(coordsType);
+  writer.write<ParamVizStyle>(getStyle());
+  writer.writeArray(coords);
+}
+
 void PointCloudParameterizationQuantity::buildPickUI(size_t ind) {
   ImGui::TextUnformatted(name.c_str());
   ImGui::NextColumn();
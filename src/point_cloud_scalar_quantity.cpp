@@ -63,7 +63,7 @@ void PointCloudScalarQuantity::createPointProgram() {
 
   // Fill buffers
   parent.fillGeometryBuffers(*pointProgram);
-  pointProgram->setAttribute("a_value", values);
+  pointProgram->setAttribute("a_value", parent.inDrawOrder(values));
   pointProgram->setTextureFromColormap("t_colormap", cMap.get());
 
   render::engine->setMaterial(*pointProgram, parent.getMaterial());
@@ -84,4 +84,8 @@ void PointCloudScalarQuantity::buildPickUI(size_t ind) {
 
 std::string PointCloudScalarQuantity::niceName() { return name + " (scalar)"; }
 
+std::string PointCloudScalarQuantity::snapshotKind() { return "scalar"; }
+
+void PointCloudScalarQuantity::writeSnapshot(SnapshotWriter& writer) { writeScalarSnapshot(writer); }
+
 } // namespace polyscope
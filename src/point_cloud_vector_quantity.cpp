@@ -28,6 +28,8 @@ PointCloudVectorQuantity::PointCloudVectorQuantity(std::string name, std::vector
   }
 }
 
+double PointCloudVectorQuantity::drawMargin() { return vectorArtist ? vectorArtist->drawMargin() : 0.; }
+
 void PointCloudVectorQuantity::draw() {
   if (!isEnabled()) return;
   vectorArtist->draw();
@@ -81,4 +83,11 @@ std::string PointCloudVectorQuantity::getMaterial() { return vectorArtist->getMa
 
 std::string PointCloudVectorQuantity::niceName() { return name + " (vector)"; }
 
+std::string PointCloudVectorQuantity::snapshotKind() { return "vector"; }
+
+void PointCloudVectorQuantity::writeSnapshot(SnapshotWriter& writer) {
+  writer.write<VectorType>(vectorType);
+  writer.writeArray(vectors);
+}
+
 } // namespace polyscope
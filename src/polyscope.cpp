@@ -1,13 +1,18 @@
 // Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
 #include "polyscope/polyscope.h"
 
+#include <algorithm>
 #include <chrono>
 #include <fstream>
 #include <iostream>
 #include <thread>
+#include <unordered_set>
 
 #include "imgui.h"
 
+#include "polyscope/api_trace.h"
+#include "polyscope/camera_path.h"
+#include "polyscope/clipped_list_ui.h"
 #include "polyscope/pick.h"
 #include "polyscope/render/engine.h"
 #include "polyscope/view.h"
@@ -37,6 +42,75 @@ struct ContextEntry {
 std::vector<ContextEntry> contextStack;
 
 bool redrawNextFrame = true;
+size_t contentVersion = 0;
+
+// Union of the extents of all registered structures, before the fallbacks for an empty scene are applied. Registering a
+// structure merges it in here, rather than revisiting every structure.
+glm::vec3 sceneBboxMin = glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+glm::vec3 sceneBboxMax = -glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+double sceneLengthScale = 0.0;
+
+// Deferred work for an open batch of structure registrations / removals, see beginBatch()
+int batchDepth = 0;
+bool batchExtentsDirty = false;
+std::unordered_set<Structure*> batchRegistered; // to auto-center/scale
+std::unordered_set<Structure*> batchRemoved;    // to release pick ranges (deleted, only used as keys)
+
+void mergeStructureExtents(Structure* s) {
+  sceneLengthScale = std::max(sceneLengthScale, s->lengthScale());
+  std::tuple<glm::vec3, glm::vec3> bbox = s->boundingBox();
+  sceneBboxMin = componentwiseMin(sceneBboxMin, std::get<0>(bbox));
+  sceneBboxMax = componentwiseMax(sceneBboxMax, std::get<1>(bbox));
+}
+
+void applySceneExtents() {
+  state::lengthScale = sceneLengthScale;
+  glm::vec3 minBbox = sceneBboxMin;
+  glm::vec3 maxBbox = sceneBboxMax;
+
+  if (!isFinite(minBbox) || !isFinite(maxBbox)) {
+    minBbox = -glm::vec3{1, 1, 1};
+    maxBbox = glm::vec3{1, 1, 1};
+  }
+  std::get<0>(state::boundingBox) = minBbox;
+  std::get<1>(state::boundingBox) = maxBbox;
+
+  // If we got a bounding box but not a length scale we can use the size of the
+  // box as a scale. If we got neither, we'll end up with a constant near 1 due
+  // to the above correction
+  if (state::lengthScale == 0) {
+    state::lengthScale = glm::length(maxBbox - minBbox);
+  }
+
+  // Center is center of bounding box
+  state::center = 0.5f * (minBbox + maxBbox);
+}
+
+// Push the options which are held by the engine to it. Changes are applied on assignment, so this is only needed
+// for options which were set before the engine existed.
+void applyEngineOptions() {
+  if (render::engine->getTransparencyMode() != options::transparencyMode) {
+    render::engine->setTransparencyMode(options::transparencyMode);
+  }
+  if (options::progressiveAA != render::engine->getProgressiveAA() ||
+      (options::progressiveAA ? 1 : options::ssaaFactor.get()) != render::engine->getSSAAFactor()) {
+    render::engine->setProgressiveAA(options::progressiveAA);
+    render::engine->setSSAAFactor(options::progressiveAA ? 1 : options::ssaaFactor.get());
+  }
+}
+
+// Incremented whenever a structure is registered or removed
+size_t structureListVersion = 1;
+
+// Cached GUI state for each type of structure, see buildStructureGui()
+struct StructureCategoryUI {
+  std::string headerLabel;
+  size_t headerLabelCount = 0;
+  std::vector<Structure*> items; // for the clipped list
+  size_t itemsVersion = 0;
+  ClippedListUI list;
+};
+std::map<std::string, StructureCategoryUI> structureCategoryUIs;
 
 // Some state about imgui windows to stack them
 float imguiStackMargin = 10;
@@ -115,6 +189,9 @@ void init(std::string backend) {
   // Initialize the rendering engine
   render::initializeRenderEngine(backend);
 
+  // Apply any options which were set before the engine existed
+  applyEngineOptions();
+
   // Initialie ImGUI
   IMGUI_CHECKVERSION();
   render::engine->initializeImGui();
@@ -182,7 +259,12 @@ void popContext() {
   contextStack.pop_back();
 }
 
-void requestRedraw() { redrawNextFrame = true; }
+void requestRedraw() {
+  redrawNextFrame = true;
+  contentVersion++;
+}
+void requestViewRedraw() { redrawNextFrame = true; }
+size_t sceneContentVersion() { return contentVersion; }
 bool redrawRequested() { return redrawNextFrame; }
 
 void drawStructures() {
@@ -195,11 +277,49 @@ void drawStructures() {
       // render::engine->setDepthMode();
       // render::engine->applyTransparencySettings();
 
+      if (!s.second->isEnabled() || !s.second->updateCulling()) continue;
       s.second->draw();
     }
   }
 }
 
+void drawOcclusionPrepass() {
+  render::engine->clearOcclusionPyramid();
+
+  // (simple transparency draws without depth testing, so nothing is ever hidden)
+  if (!options::occlusionCulling || render::engine->getTransparencyMode() == TransparencyMode::Simple) return;
+
+  // The largest opaque structures on screen are the occluders
+  const double minOccluderCoverage = 0.01;
+  std::vector<std::pair<double, Structure*>> occluders;
+  for (auto& catMap : state::structures) {
+    for (auto& s : catMap.second) {
+      Structure* structure = s.second;
+      if (!structure->isEnabled()) continue;
+      if (render::engine->transparencyEnabled() && structure->getTransparency() < 1.) continue;
+      if (!structure->updateCulling()) continue;
+      double coverage = structure->screenCoverage();
+      if (coverage >= minOccluderCoverage) {
+        occluders.emplace_back(coverage, structure);
+      }
+    }
+  }
+  size_t maxOccluders = std::max(options::occlusionMaxOccluders.get(), 0);
+  size_t nOccluders = std::min(occluders.size(), maxOccluders);
+  std::partial_sort(occluders.begin(), occluders.begin() + nOccluders, occluders.end(),
+                    [](const std::pair<double, Structure*>& a, const std::pair<double, Structure*>& b) {
+                      return a.first > b.first;
+                    });
+  if (nOccluders == 0) return;
+
+  render::engine->beginOcclusionPrepass();
+  for (size_t i = 0; i < nOccluders; i++) {
+    occluders[i].second->draw();
+  }
+  render::engine->endOcclusionPrepass();
+  render::engine->occlusionStats.nOccluders = nOccluders;
+}
+
 
 namespace {
 
@@ -208,9 +328,10 @@ float dragDistSinceLastRelease = 0.0;
 void processInputEvents() {
   ImGuiIO& io = ImGui::GetIO();
 
-  // If any mouse button is pressed, trigger a redraw
+  // If any mouse button is pressed, trigger a redraw. Input only moves the camera, so this does not invalidate the
+  // caches of the scene contents (anything which changes the contents requests its own redraw).
   if (ImGui::IsAnyMouseDown()) {
-    requestRedraw();
+    requestViewRedraw();
   }
 
   bool widgetCapturedMouse = false;
@@ -227,7 +348,7 @@ void processInputEvents() {
     double yoffset = io.MouseWheel;
 
     if (xoffset != 0 || yoffset != 0) {
-      requestRedraw();
+      requestViewRedraw();
 
       // On some setups, shift flips the scroll direction, so take the max
       // scrolling in any direction
@@ -323,8 +444,6 @@ void processInputEvents() {
 }
 
 void renderScene() {
-  processLazyProperties();
-
   render::engine->applyTransparencySettings();
 
   render::engine->sceneBuffer->clearColor = {0., 0., 0.};
@@ -335,6 +454,8 @@ void renderScene() {
 
   // If a view has never been set, this will set it to the home view
   view::ensureViewValid();
+  render::engine->updateFrameCameraUniforms();
+  render::engine->applyProgressiveJitter();
 
   if (render::engine->getTransparencyMode() == TransparencyMode::Pretty) {
     // Special depth peeling case: multiple render passes
@@ -351,6 +472,9 @@ void renderScene() {
     render::engine->setDepthMode(); // we need depth to be enabled for the clear below to do anything
     render::engine->sceneDepthMinFrame->clear();
 
+    // (after clearing the min depth, so the pre-pass is not peeled)
+    drawOcclusionPrepass();
+
 
     for (int iPass = 0; iPass < options::transparencyRenderPasses; iPass++) {
 
@@ -375,6 +499,8 @@ void renderScene() {
     }
   } else {
     // Normal case: single render pass
+    drawOcclusionPrepass();
+    render::engine->bindSceneBuffer();
     render::engine->applyTransparencySettings();
 
     drawStructures();
@@ -384,6 +510,8 @@ void renderScene() {
 
     render::engine->sceneBuffer->blitTo(render::engine->sceneBufferFinal.get());
   }
+
+  render::engine->accumulateProgressiveSample();
 } // namespace
 
 void renderSceneToScreen() {
@@ -393,7 +521,7 @@ void renderSceneToScreen() {
     pick::evaluatePickQuery(-1, -1); // populate the buffer
     render::engine->pickFramebuffer->blitTo(render::engine->displayBuffer.get());
   } else {
-    render::engine->applyLightingTransform(render::engine->sceneColorFinal);
+    render::engine->applyLightingTransform(render::engine->getSceneColorResolved());
   }
 }
 
@@ -506,26 +634,52 @@ void buildStructureGui() {
 
   ImGui::Begin("Structures", &showStructureWindow);
 
-  for (auto catMapEntry : state::structures) {
-    std::string catName = catMapEntry.first;
+  for (auto& catMapEntry : state::structures) {
+    const std::string& catName = catMapEntry.first;
 
     std::map<std::string, Structure*>& structureMap = catMapEntry.second;
+    StructureCategoryUI& catUI = structureCategoryUIs[catName];
 
     ImGui::PushID(catName.c_str()); // ensure there are no conflicts with
                                     // identically-named labels
 
+    if (catUI.headerLabel.empty() || catUI.headerLabelCount != structureMap.size()) {
+      catUI.headerLabel = catName + " (" + std::to_string(structureMap.size()) + ")";
+      catUI.headerLabelCount = structureMap.size();
+    }
+
     // Build the structure's UI
     ImGui::SetNextTreeNodeOpen(structureMap.size() > 0, ImGuiCond_FirstUseEver);
-    if (ImGui::CollapsingHeader((catName + " (" + std::to_string(structureMap.size()) + ")").c_str())) {
+    if (ImGui::CollapsingHeader(catUI.headerLabel.c_str())) {
       // Draw shared GUI elements for all instances of the structure
       if (structureMap.size() > 0) {
         structureMap.begin()->second->buildSharedStructureUI();
       }
 
-      for (auto x : structureMap) {
-        ImGui::SetNextTreeNodeOpen(structureMap.size() <= 8,
-                                   ImGuiCond_FirstUseEver); // closed by default if more than 8
-        x.second->buildUI();
+      if (structureMap.size() < ClippedListUI::minItems) {
+        for (auto& x : structureMap) {
+          ImGui::SetNextTreeNodeOpen(structureMap.size() <= 8,
+                                     ImGuiCond_FirstUseEver); // closed by default if more than 8
+          x.second->buildUI();
+        }
+      } else {
+        // Long lists only build the visible rows, and the full UI of the selected structure
+        if (catUI.itemsVersion != structureListVersion) {
+          catUI.items.clear();
+          for (auto& x : structureMap) {
+            catUI.items.push_back(x.second);
+          }
+          catUI.itemsVersion = structureListVersion;
+          catUI.list.markItemsChanged();
+        }
+        std::vector<Structure*>& items = catUI.items;
+        long long iSelected = catUI.list.build(
+            items.size(), [&](size_t i) -> const std::string& { return items[i]->name; },
+            [&](size_t i) { return items[i]->isEnabled(); }, [&](size_t i, bool e) { items[i]->setEnabled(e); });
+        if (iSelected >= 0) {
+          ImGui::SetNextTreeNodeOpen(true, ImGuiCond_Appearing);
+          items[iSelected]->buildUI();
+        }
       }
     }
 
@@ -588,11 +742,13 @@ void buildPickGui() {
 
 auto lastMainLoopIterTime = std::chrono::steady_clock::now();
 
+// Frames in a row with no input and no redraw. After a few of these (to let the UI settle), the main loop goes idle.
+int idleFrameCount = 0;
+const int idleGraceFrames = 3;
+
 } // namespace
 
 void draw(bool withUI) {
-  processLazyProperties();
-
   // Update buffer and context
   render::engine->makeContextCurrent();
   render::engine->bindDisplay();
@@ -629,12 +785,13 @@ void draw(bool withUI) {
     (contextStack.back().callback)();
   }
 
-  processLazyProperties();
+  render::engine->updateFrameCameraUniforms();
 
   // Draw structures in the scene
+  // Clear the flag before rendering, so that anything drawn during this frame can request another one
   if (redrawNextFrame || options::alwaysRedraw) {
-    renderScene();
     redrawNextFrame = false;
+    renderScene();
   }
   renderSceneToScreen();
 
@@ -654,17 +811,19 @@ void draw(bool withUI) {
 
 void mainLoopIteration() {
 
-  processLazyProperties();
-
   // The windowing system will let this busy-loop in some situations, unfortunately. Make sure that doesn't happen.
   if (options::maxFPS != -1) {
-    auto currTime = std::chrono::steady_clock::now();
     long microsecPerLoop = 1000000 / options::maxFPS;
     microsecPerLoop = (95 * microsecPerLoop) / 100; // give a little slack so we actually hit target fps
-    while (std::chrono::duration_cast<std::chrono::microseconds>(currTime - lastMainLoopIterTime).count() <
-           microsecPerLoop) {
+    auto targetTime = lastMainLoopIterTime + std::chrono::microseconds(microsecPerLoop);
+
+    // Sleep through most of the wait, then yield for the remainder since sleeps may overshoot
+    auto currTime = std::chrono::steady_clock::now();
+    if (targetTime - currTime > std::chrono::milliseconds(2)) {
+      std::this_thread::sleep_for(targetTime - currTime - std::chrono::milliseconds(1));
+    }
+    while (std::chrono::steady_clock::now() < targetTime) {
       std::this_thread::yield();
-      currTime = std::chrono::steady_clock::now();
     }
   }
   lastMainLoopIterTime = std::chrono::steady_clock::now();
@@ -672,15 +831,30 @@ void mainLoopIteration() {
   render::engine->makeContextCurrent();
   render::engine->updateWindowSize();
 
-  // Process UI events
-  render::engine->pollEvents();
+  // Process UI events. If nothing has happened for a while, wait for something to happen.
+  size_t eventCountBefore = render::engine->windowEventCount;
+  if (options::sleepWhenIdle && idleFrameCount >= idleGraceFrames && !redrawNextFrame && !options::alwaysRedraw) {
+    render::engine->waitEvents(options::idleTimeout);
+  } else {
+    render::engine->pollEvents();
+  }
   processInputEvents();
   view::updateFlight();
+  view::updateCameraPathRecording();
+
+  if (render::engine->windowEventCount != eventCountBefore || redrawNextFrame || options::alwaysRedraw) {
+    idleFrameCount = 0;
+  } else {
+    idleFrameCount++;
+  }
   showDelayedWarnings();
 
   // Rendering
   draw();
   render::engine->swapDisplayBuffers();
+
+  // (after the user callback, which runs in draw(), so that its changes are recorded with the frame they appear in)
+  trace::recordFrame();
 }
 
 void show(size_t forFrames) {
@@ -742,6 +916,21 @@ bool registerStructure(Structure* s, bool replaceIfPresent) {
     }
   }
 
+  // Add the new structure
+  sMap[s->name] = s;
+  structureListVersion++;
+  trace::markStructureChanged(s);
+
+  if (batchDepth > 0) {
+    // (a new structure may be allocated where a removed one was, so release the old one's ranges now)
+    if (batchRemoved.erase(s) > 0) {
+      pick::releasePickBufferRanges({s});
+    }
+    batchRegistered.insert(s);
+    batchExtentsDirty = true;
+    return true;
+  }
+
   // Center/scale if desired
   if (options::autocenterStructures) {
     s->centerBoundingBox();
@@ -750,9 +939,8 @@ bool registerStructure(Structure* s, bool replaceIfPresent) {
     s->rescaleToUnit();
   }
 
-  // Add the new structure
-  sMap[s->name] = s;
-  updateStructureExtents();
+  mergeStructureExtents(s);
+  applySceneExtents();
   requestRedraw();
 
   return true;
@@ -825,9 +1013,20 @@ void removeStructure(std::string type, std::string name, bool errorIfAbsent) {
 
   // Structure exists, remove it
   Structure* s = sMap[name];
+  trace::markStructureRemoved(type, name);
   pick::resetSelectionIfStructure(s);
   sMap.erase(s->name);
   delete s;
+  structureListVersion++;
+
+  if (batchDepth > 0) {
+    batchRegistered.erase(s);
+    batchRemoved.insert(s);
+    batchExtentsDirty = true;
+    return;
+  }
+
+  pick::releasePickBufferRanges({s});
   updateStructureExtents();
   return;
 }
@@ -871,7 +1070,8 @@ void removeStructure(std::string name, bool errorIfAbsent) {
 
 void removeAllStructures() {
 
-  for (auto typeMap : state::structures) {
+  StructureBatch batch;
+  for (auto& typeMap : state::structures) {
 
     // dodge iterator invalidation
     std::vector<std::string> names;
@@ -889,6 +1089,11 @@ void removeAllStructures() {
   pick::resetSelection();
 }
 
+void processLazyProperties() {
+  // Options now take effect when they are assigned; this only re-syncs the engine, and is kept for compatibility.
+  if (render::engine) applyEngineOptions();
+}
+
 void refresh() {
 
   // reset the ground plane
@@ -904,105 +1109,61 @@ void refresh() {
   requestRedraw();
 }
 
-// Cached versions of lazy properties used for updates
-namespace lazy {
-TransparencyMode transparencyMode = TransparencyMode::None;
-int transparencyRenderPasses = 8;
-int ssaaFactor = 1;
-bool groundPlaneEnabled = true;
-GroundPlaneMode groundPlaneMode = GroundPlaneMode::TileReflection;
-ScaledValue<float> groundPlaneHeightFactor = 0;
-int shadowBlurIters = 2;
-float shadowDarkness = .4;
-} // namespace lazy
-
-void processLazyProperties() {
-
-  // Note: This function essentially represents lazy software design, and it's an ugly and error-prone part of the
-  // system. The reason for it that some settings require action on a change (e..g re-drawing the scene), but we want to
-  // allow variable-set syntax like `polyscope::setting = newVal;` rather than getters and setters like
-  // `polyscope::setSetting(newVal);`. It might have been better to simple set options with setter from the start, but
-  // that ship has sailed.
-  //
-  // This function is a workaround which polls for changes to options settings, and performs any necessary additional
-  // work.
+void updateStructureExtents() {
+  if (batchDepth > 0) {
+    batchExtentsDirty = true;
+    return;
+  }
 
+  // Compute length scale and bbox as the max of all structures (each structure caches its own extents, so this does not
+  // revisit their geometry)
+  sceneLengthScale = 0.0;
+  sceneBboxMin = glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+  sceneBboxMax = -glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
 
-  // transparency mode
-  if (lazy::transparencyMode != options::transparencyMode) {
-    lazy::transparencyMode = options::transparencyMode;
-    render::engine->setTransparencyMode(options::transparencyMode);
+  for (auto& cat : state::structures) {
+    for (auto& x : cat.second) {
+      mergeStructureExtents(x.second);
+    }
   }
 
-  // transparency render passes
-  if (lazy::transparencyRenderPasses != options::transparencyRenderPasses) {
-    lazy::transparencyRenderPasses = options::transparencyRenderPasses;
-    requestRedraw();
-  }
+  applySceneExtents();
+}
 
-  // ssaa
-  if (lazy::ssaaFactor != options::ssaaFactor) {
-    lazy::ssaaFactor = options::ssaaFactor;
-    render::engine->setSSAAFactor(options::ssaaFactor);
-  }
+void beginBatch() { batchDepth++; }
 
-  // ground plane
-  if (lazy::groundPlaneEnabled != options::groundPlaneEnabled || lazy::groundPlaneMode != options::groundPlaneMode) {
-    lazy::groundPlaneEnabled = options::groundPlaneEnabled;
-    if (!options::groundPlaneEnabled) {
-      // if the (depecated) groundPlaneEnabled = false, set mode to None, so we only have one variable to check
-      options::groundPlaneMode = GroundPlaneMode::None;
-    }
-    lazy::groundPlaneMode = options::groundPlaneMode;
-    render::engine->groundPlane.prepare();
-    requestRedraw();
-  }
-  if (lazy::groundPlaneHeightFactor.asAbsolute() != options::groundPlaneHeightFactor.asAbsolute() ||
-      lazy::groundPlaneHeightFactor.isRelative() != options::groundPlaneHeightFactor.isRelative()) {
-    lazy::groundPlaneHeightFactor = options::groundPlaneHeightFactor;
-    requestRedraw();
-  }
-  if (lazy::shadowBlurIters != options::shadowBlurIters) {
-    lazy::shadowBlurIters = options::shadowBlurIters;
-    requestRedraw();
+void endBatch() {
+  if (batchDepth == 0) {
+    error("endBatch() called without a matching beginBatch()");
+    return;
   }
-  if (lazy::shadowDarkness != options::shadowDarkness) {
-    lazy::shadowDarkness = options::shadowDarkness;
-    requestRedraw();
+  if (batchDepth > 1) {
+    batchDepth--;
+    return;
   }
-};
-
-void updateStructureExtents() {
-  // Compute length scale and bbox as the max of all structures
-  state::lengthScale = 0.0;
-  glm::vec3 minBbox = glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
-  glm::vec3 maxBbox = -glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
 
-  for (auto cat : state::structures) {
-    for (auto x : cat.second) {
-      state::lengthScale = std::max(state::lengthScale, x.second->lengthScale());
-      auto bbox = x.second->boundingBox();
-      minBbox = componentwiseMin(minBbox, std::get<0>(bbox));
-      maxBbox = componentwiseMax(maxBbox, std::get<1>(bbox));
-    }
+  if (!batchRemoved.empty()) {
+    pick::releasePickBufferRanges(batchRemoved);
+    batchRemoved.clear();
   }
 
-  if (!isFinite(minBbox) || !isFinite(maxBbox)) {
-    minBbox = -glm::vec3{1, 1, 1};
-    maxBbox = glm::vec3{1, 1, 1};
+  // Center/scale if desired (still inside the batch, so the extents are only updated once below)
+  for (Structure* s : batchRegistered) {
+    if (options::autocenterStructures) {
+      s->centerBoundingBox();
+    }
+    if (options::autoscaleStructures) {
+      s->rescaleToUnit();
+    }
   }
-  std::get<0>(state::boundingBox) = minBbox;
-  std::get<1>(state::boundingBox) = maxBbox;
+  batchRegistered.clear();
 
-  // If we got a bounding box but not a length scale we can use the size of the
-  // box as a scale. If we got neither, we'll end up with a constant near 1 due
-  // to the above correction
-  if (state::lengthScale == 0) {
-    state::lengthScale = glm::length(maxBbox - minBbox);
+  batchDepth--;
+  if (batchExtentsDirty) {
+    batchExtentsDirty = false;
+    updateStructureExtents();
+    requestRedraw();
   }
-
-  // Center is center of bounding box
-  state::center = 0.5f * (minBbox + maxBbox);
 }
 
 
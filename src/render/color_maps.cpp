@@ -3,9 +3,12 @@
 
 #include "polyscope/render/colormap_defs.h"
 #include "polyscope/render/engine.h"
+#include "polyscope/task_scheduler.h"
 
 #include "imgui.h"
 
+#include <algorithm>
+
 namespace polyscope {
 
 void loadColorMap(std::string cmapName, std::string filename) { render::engine->loadColorMap(cmapName, filename); }
@@ -71,5 +74,98 @@ const std::vector<glm::vec3> CM_PHASE =
 // clang-format on
 
 
+// === batch sampling
+
+namespace {
+
+// Values are processed in blocks small enough to keep temporaries in cache, and the loops over a block are kept free
+// of branches and calls so compilers can vectorize them.
+const size_t colorBlockSize = 256;
+const size_t colorParallelGrain = 1 << 16;
+
+// Calls `write(i, lowerInd, upperBlend, finite)` for each value: the color is a blend between entries lowerInd and
+// lowerInd + 1 of the (padded) table, and black if the value is not finite.
+template <typename T, typename Writer>
+void sampleColorMap(size_t nEntries, const T* vals, size_t n, double rangeMin, double rangeMax, Writer write) {
+  double rangeLen = rangeMax - rangeMin;
+  const double scale = rangeLen > 0 ? (nEntries - 1) / rangeLen : 0.;
+  const double maxPos = static_cast<double>(nEntries - 1);
+
+  tasks::parallelFor(0, n, colorParallelGrain, [&](size_t begin, size_t end) {
+    float pos[colorBlockSize];
+    float finite[colorBlockSize];
+    for (size_t blockStart = begin; blockStart < end; blockStart += colorBlockSize) {
+      size_t blockSize = std::min(colorBlockSize, end - blockStart);
+      const T* blockVals = vals + blockStart;
+
+      for (size_t i = 0; i < blockSize; i++) {
+        T v = blockVals[i];
+        bool isFinite = (v - v) == 0; // (false for nan and inf)
+        // (offset in double precision before narrowing, so large values in a narrow range keep their precision)
+        double p = isFinite ? (static_cast<double>(v) - rangeMin) * scale : 0.;
+        pos[i] = static_cast<float>(std::min(maxPos, std::max(0., p))); // (arg order maps a nan from overflow to 0)
+        finite[i] = isFinite ? 1.f : 0.f;
+      }
+
+      for (size_t i = 0; i < blockSize; i++) {
+        uint32_t lowerInd = static_cast<uint32_t>(pos[i]);
+        write(blockStart + i, lowerInd, pos[i] - static_cast<float>(lowerInd), finite[i]);
+      }
+    }
+  });
+}
+
+// The colormap entries with the last one repeated, so every lowerInd + 1 exists
+std::vector<glm::vec3> paddedTable(const std::vector<glm::vec3>& values) {
+  std::vector<glm::vec3> table = values;
+  table.push_back(table.empty() ? glm::vec3{0., 0., 0.} : table.back());
+  return table;
+}
+
+template <typename T>
+void getValuesFloat(const ValueColorMap& cmap, const T* vals, size_t n, double rangeMin, double rangeMax,
+                    glm::vec3* colorsOut) {
+  std::vector<glm::vec3> table = paddedTable(cmap.values);
+  const glm::vec3* t = table.data();
+  sampleColorMap(std::max<size_t>(cmap.values.size(), 1), vals, n, rangeMin, rangeMax,
+                 [&](size_t i, uint32_t lowerInd, float upperBlend, float finite) {
+                   colorsOut[i] = finite * ((1.f - upperBlend) * t[lowerInd] + upperBlend * t[lowerInd + 1]);
+                 });
+}
+
+template <typename T>
+void getValuesByte(const ValueColorMap& cmap, const T* vals, size_t n, double rangeMin, double rangeMax,
+                   uint8_t* rgbOut) {
+  std::vector<glm::vec3> table = paddedTable(cmap.values);
+  const glm::vec3* t = table.data();
+  sampleColorMap(std::max<size_t>(cmap.values.size(), 1), vals, n, rangeMin, rangeMax,
+                 [&](size_t i, uint32_t lowerInd, float upperBlend, float finite) {
+                   glm::vec3 c = finite * ((1.f - upperBlend) * t[lowerInd] + upperBlend * t[lowerInd + 1]);
+                   rgbOut[3 * i + 0] = static_cast<uint8_t>(glm::clamp(c.x, 0.f, 1.f) * 255.f + 0.5f);
+                   rgbOut[3 * i + 1] = static_cast<uint8_t>(glm::clamp(c.y, 0.f, 1.f) * 255.f + 0.5f);
+                   rgbOut[3 * i + 2] = static_cast<uint8_t>(glm::clamp(c.z, 0.f, 1.f) * 255.f + 0.5f);
+                 });
+}
+
+} // namespace
+
+void ValueColorMap::getValues(const float* vals, size_t n, double rangeMin, double rangeMax,
+                              glm::vec3* colorsOut) const {
+  getValuesFloat(*this, vals, n, rangeMin, rangeMax, colorsOut);
+}
+
+void ValueColorMap::getValues(const double* vals, size_t n, double rangeMin, double rangeMax,
+                              glm::vec3* colorsOut) const {
+  getValuesFloat(*this, vals, n, rangeMin, rangeMax, colorsOut);
+}
+
+void ValueColorMap::getValues(const float* vals, size_t n, double rangeMin, double rangeMax, uint8_t* rgbOut) const {
+  getValuesByte(*this, vals, n, rangeMin, rangeMax, rgbOut);
+}
+
+void ValueColorMap::getValues(const double* vals, size_t n, double rangeMin, double rangeMax, uint8_t* rgbOut) const {
+  getValuesByte(*this, vals, n, rangeMin, rangeMax, rgbOut);
+}
+
 } // namespace render
 } // namespace polyscope
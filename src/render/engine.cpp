@@ -4,13 +4,36 @@
 #include "polyscope/polyscope.h"
 #include "polyscope/render/colormap_defs.h"
 #include "polyscope/render/material_defs.h"
+#include "polyscope/render/shader_builder.h"
 
 #include "imgui.h"
 #include "stb_image.h"
 
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <sstream>
 
 namespace polyscope {
 
+namespace {
+// Low-discrepancy sequence used to jitter progressive samples
+float haltonSequence(int index, int base) {
+  float f = 1.;
+  float r = 0.;
+  while (index > 0) {
+    f /= base;
+    r += f * (index % base);
+    index /= base;
+  }
+  return r;
+}
+
+// The occlusion pre-pass is drawn at this fraction of the screen resolution
+const unsigned int occlusionDownsample = 4;
+} // namespace
+
 int dimension(const TextureFormat& x) {
   // clang-format off
   switch (x) {
@@ -44,10 +67,12 @@ std::string modeName(const TransparencyMode& m) {
 
 namespace render {
 
-TextureBuffer::TextureBuffer(int dim_, TextureFormat format_, unsigned int sizeX_, unsigned int sizeY_)
-    : dim(dim_), format(format_), sizeX(sizeX_), sizeY(sizeY_) {
+TextureBuffer::TextureBuffer(int dim_, TextureFormat format_, unsigned int sizeX_, unsigned int sizeY_,
+                             unsigned int sizeZ_)
+    : dim(dim_), format(format_), sizeX(sizeX_), sizeY(sizeY_), sizeZ(sizeZ_) {
   if (sizeX > (1 << 22)) throw std::runtime_error("OpenGL error: invalid texture dimensions");
   if (dim > 1 && sizeY > (1 << 22)) throw std::runtime_error("OpenGL error: invalid texture dimensions");
+  if (dim > 2 && sizeZ > (1 << 22)) throw std::runtime_error("OpenGL error: invalid texture dimensions");
 }
 
 TextureBuffer::~TextureBuffer() {}
@@ -67,8 +92,7 @@ unsigned int TextureBuffer::getTotalSize() const {
   case 2:
     return getSizeX() * getSizeY();
   case 3:
-    throw std::runtime_error("not implemented");
-    return -1;
+    return getSizeX() * getSizeY() * getSizeZ();
   }
   return -1;
 }
@@ -177,7 +201,6 @@ void Engine::buildEngineGui() {
           std::string mName = modeName(m);
           if (ImGui::Selectable(mName.c_str(), transparencyMode == m)) {
             options::transparencyMode = m;
-            requestRedraw();
           }
         }
         ImGui::EndCombo();
@@ -196,8 +219,9 @@ void Engine::buildEngineGui() {
       case TransparencyMode::Pretty: {
         ImGui::TextWrapped("Accurate but expensive transparent rendering. Increase the number of passes to resolve "
                            "complicated scenes.");
-        if (ImGui::InputInt("Render Passes", &options::transparencyRenderPasses)) {
-          requestRedraw();
+        int transparencyRenderPasses = options::transparencyRenderPasses;
+        if (ImGui::InputInt("Render Passes", &transparencyRenderPasses)) {
+          options::transparencyRenderPasses = transparencyRenderPasses;
         }
         break;
       }
@@ -225,7 +249,45 @@ void Engine::buildEngineGui() {
         ssaaFactor = std::min(ssaaFactor, 4);
         ssaaFactor = std::max(ssaaFactor, 1);
         options::ssaaFactor = ssaaFactor;
-        requestRedraw();
+      }
+      bool progressive = options::progressiveAA;
+      if (ImGui::Checkbox("Progressive (when still)", &progressive)) {
+        options::progressiveAA = progressive;
+      }
+      if (options::progressiveAA) {
+        if (ImGui::InputInt("Samples", &options::progressiveAASamples, 1)) {
+          options::progressiveAASamples = std::max(options::progressiveAASamples, 1);
+          requestViewRedraw();
+        }
+        ImGui::Text("accumulated: %d", std::min(progressiveSampleCount, options::progressiveAASamples));
+      }
+      ImGui::TreePop();
+    }
+
+    // == Culling
+    ImGui::SetNextTreeNodeOpen(false, ImGuiCond_FirstUseEver);
+    if (ImGui::TreeNode("Culling")) {
+      bool frustum = options::frustumCulling;
+      if (ImGui::Checkbox("Frustum", &frustum)) {
+        options::frustumCulling = frustum;
+      }
+      float minPixels = options::smallFeatureCullingPixels;
+      if (ImGui::SliderFloat("min size (px)", &minPixels, 0., 10.)) {
+        options::smallFeatureCullingPixels = minPixels;
+      }
+      bool occlusion = options::occlusionCulling;
+      if (ImGui::Checkbox("Occlusion", &occlusion)) {
+        options::occlusionCulling = occlusion;
+      }
+      if (options::occlusionCulling) {
+        int maxOccluders = options::occlusionMaxOccluders;
+        if (ImGui::InputInt("Max occluders", &maxOccluders, 1)) {
+          options::occlusionMaxOccluders = std::max(maxOccluders, 1);
+        }
+        ImGui::Text("occluders: %d", static_cast<int>(occlusionStats.nOccluders));
+        ImGui::Text("hidden: %d of %d boxes tested", static_cast<int>(occlusionStats.nOccluded),
+                    static_cast<int>(occlusionStats.nTested));
+        ImGui::Text("pre-pass: %.2f ms", occlusionStats.buildMilliseconds);
       }
       ImGui::TreePop();
     }
@@ -301,11 +363,43 @@ void Engine::setBackgroundAlpha(float newAlpha) {
   targetBuffer.clearAlpha = newAlpha;
 }
 
-void Engine::setCurrentViewport(glm::vec4 val) { currViewport = val; }
+void Engine::setCurrentViewport(glm::vec4 val) {
+  currViewport = val;
+  if (frameUniforms.viewport != val) {
+    frameUniforms.viewport = val;
+    frameUniforms.viewportDim = glm::vec2{val[2], val[3]};
+    frameUniformsDirty = true;
+  }
+}
 glm::vec4 Engine::getCurrentViewport() { return currViewport; }
-void Engine::setCurrentPixelScaling(float val) { currPixelScale = val; }
+void Engine::setCurrentPixelScaling(float val) {
+  currPixelScale = val;
+  if (frameUniforms.pixelScale != val) {
+    frameUniforms.pixelScale = val;
+    frameUniformsDirty = true;
+  }
+}
 float Engine::getCurrentPixelScaling() { return currPixelScale; }
 
+void Engine::updateFrameCameraUniforms() { setFrameProjectionMatrix(view::getCameraPerspectiveMatrix()); }
+
+void Engine::setFrameProjectionMatrix(const glm::mat4& P) {
+  if (P != frameUniforms.projMatrix) {
+    frameUniforms.projMatrix = P;
+    frameUniforms.invProjMatrix = glm::inverse(P);
+    frameUniformsDirty = true;
+  }
+}
+
+void Engine::flushFrameUniforms() {
+  if (frameUniformsDirty) {
+    uploadFrameUniforms();
+    frameUniformsDirty = false;
+  }
+}
+
+const FrameUniforms& Engine::getFrameUniforms() { return frameUniforms; }
+
 void Engine::bindDisplay() {
   FrameBuffer& targetBuffer = useAltDisplayBuffer ? *displayBufferAlt : *displayBuffer;
   targetBuffer.bindForRendering();
@@ -328,6 +422,10 @@ void Engine::resizeScreenBuffers() {
   sceneBuffer->resize(ssaaFactor * width, ssaaFactor * height);
   sceneBufferFinal->resize(ssaaFactor * width, ssaaFactor * height);
   sceneDepthMinFrame->resize(ssaaFactor * width, ssaaFactor * height);
+  for (std::shared_ptr<FrameBuffer>& b : progressiveBuffers) {
+    if (b) b->resize(ssaaFactor * width, ssaaFactor * height);
+  }
+  progressiveSampleCount = 0;
 }
 
 void Engine::setScreenBufferViewports() {
@@ -341,6 +439,9 @@ void Engine::setScreenBufferViewports() {
   sceneBuffer->setViewport(ssaaFactor * xStart, ssaaFactor * yStart, ssaaFactor * sizeX, ssaaFactor * sizeY);
   sceneBufferFinal->setViewport(ssaaFactor * xStart, ssaaFactor * yStart, ssaaFactor * sizeX, ssaaFactor * sizeY);
   sceneDepthMinFrame->setViewport(ssaaFactor * xStart, ssaaFactor * yStart, ssaaFactor * sizeX, ssaaFactor * sizeY);
+  for (std::shared_ptr<FrameBuffer>& b : progressiveBuffers) {
+    if (b) b->setViewport(ssaaFactor * xStart, ssaaFactor * yStart, ssaaFactor * sizeX, ssaaFactor * sizeY);
+  }
 }
 
 bool Engine::bindSceneBuffer() {
@@ -430,9 +531,7 @@ void Engine::renderBackground() {
     /*
       case BackgroundView::Env: {
         glm::mat4 V = view::getCameraViewMatrix();
-        glm::mat4 P = view::getCameraPerspectiveMatrix();
         renderTextureSphereBG->setUniform("u_viewMatrix", glm::value_ptr(V));
-        renderTextureSphereBG->setUniform("u_projMatrix", glm::value_ptr(P));
         renderTextureSphereBG->setTextureFromBuffer("t_image", envMapOrig.get());
         setDepthMode(DepthMode::LEqualReadOnly);
         renderTextureSphereBG->draw();
@@ -506,6 +605,337 @@ void Engine::setSSAAFactor(int newVal) {
 
 int Engine::getSSAAFactor() { return ssaaFactor; }
 
+void Engine::setProgressiveAA(bool newVal) {
+  progressiveAA = newVal;
+  progressiveSampleCount = 0;
+  requestRedraw();
+}
+
+bool Engine::getProgressiveAA() { return progressiveAA; }
+
+int Engine::getProgressiveSampleCount() { return progressiveSampleCount; }
+
+void Engine::ensureProgressiveBuffers() {
+  if (progressiveBuffers[0]) return;
+
+  for (int i = 0; i < 2; i++) {
+    progressiveColors[i] =
+        generateTextureBuffer(TextureFormat::RGBA16F, sceneColorFinal->getSizeX(), sceneColorFinal->getSizeY());
+    progressiveBuffers[i] = generateFrameBuffer(sceneColorFinal->getSizeX(), sceneColorFinal->getSizeY());
+    progressiveBuffers[i]->addColorBuffer(progressiveColors[i]);
+    progressiveBuffers[i]->setDrawBuffers();
+    progressiveBuffers[i]->clearColor = glm::vec3{0., 0., 0.};
+    progressiveBuffers[i]->clearAlpha = 0.0;
+  }
+  setScreenBufferViewports();
+
+  blendHistory = requestShader("BLEND_HISTORY", {}, render::ShaderReplacementDefaults::Process);
+  blendHistory->setAttribute("a_position", screenTrianglesCoords());
+}
+
+void Engine::applyProgressiveJitter() {
+  if (!progressiveAA) return;
+
+  // Restart if anything changed since the last sample. Animated scenes redraw without requesting it, so they never
+  // accumulate.
+  const glm::mat4& P = frameUniforms.projMatrix;
+  if (view::viewMat != progressiveViewMat || P != progressiveProjMat ||
+      sceneContentVersion() != progressiveContentVersion || options::alwaysRedraw) {
+    progressiveSampleCount = 0;
+    progressiveViewMat = view::viewMat;
+    progressiveProjMat = P;
+    progressiveContentVersion = sceneContentVersion();
+  }
+
+  // The first sample is un-jittered, so an interactive view looks exactly like a plain 1x render
+  if (progressiveSampleCount == 0) return;
+
+  glm::vec2 jitter{haltonSequence(progressiveSampleCount, 2) - 0.5, haltonSequence(progressiveSampleCount, 3) - 0.5};
+  glm::vec2 jitterNDC = 2.f * jitter / frameUniforms.viewportDim;
+  glm::mat4 jitterMat = glm::translate(glm::mat4(1.0), glm::vec3{jitterNDC, 0.});
+  setFrameProjectionMatrix(jitterMat * P);
+}
+
+void Engine::accumulateProgressiveSample() {
+  if (!progressiveAA) return;
+  ensureProgressiveBuffers();
+
+  int iPrev = progressiveCurrent;
+  int iNext = 1 - progressiveCurrent;
+  if (progressiveSampleCount == 0) {
+    progressiveBuffers[iPrev]->clear(); // the history is ignored, but must not hold NaNs
+  }
+
+  // Running average: sample n is mixed in with weight 1/(n+1)
+  progressiveBuffers[iNext]->bindForRendering();
+  setDepthMode(DepthMode::Disable);
+  setBlendMode(BlendMode::Disable);
+  blendHistory->setTextureFromBuffer("t_image", sceneColorFinal.get());
+  blendHistory->setTextureFromBuffer("t_history", progressiveColors[iPrev].get());
+  blendHistory->setUniform("u_weight", 1.f / (progressiveSampleCount + 1));
+  blendHistory->draw();
+
+  progressiveCurrent = iNext;
+  progressiveSampleCount++;
+
+  // Keep refining while the view is still
+  if (progressiveSampleCount < options::progressiveAASamples) {
+    requestViewRedraw();
+  }
+}
+
+std::shared_ptr<TextureBuffer>& Engine::getSceneColorResolved() {
+  if (progressiveAA && progressiveColors[progressiveCurrent]) {
+    return progressiveColors[progressiveCurrent];
+  }
+  return sceneColorFinal;
+}
+
+void Engine::beginOcclusionPrepass() {
+  occlusionBuildStart = std::chrono::steady_clock::now();
+
+  unsigned int sizeX = (std::max(view::bufferWidth, 1) + occlusionDownsample - 1) / occlusionDownsample;
+  unsigned int sizeY = (std::max(view::bufferHeight, 1) + occlusionDownsample - 1) / occlusionDownsample;
+  if (!occlusionBuffer) {
+    occlusionBuffer = generateFrameBuffer(sizeX, sizeY);
+    occlusionBuffer->addColorBuffer(generateRenderBuffer(RenderBufferType::ColorAlpha, sizeX, sizeY));
+    occlusionBuffer->addDepthBuffer(generateRenderBuffer(RenderBufferType::Depth, sizeX, sizeY));
+    occlusionBuffer->setDrawBuffers();
+  }
+  occlusionBuffer->resize(sizeX, sizeY);
+  occlusionBuffer->setViewport(0, 0, sizeX, sizeY);
+
+  occlusionBuffer->clear();
+  occlusionBuffer->bindForRendering();
+  setDepthMode(DepthMode::Less);
+  setBlendMode(BlendMode::Disable);
+}
+
+void Engine::endOcclusionPrepass() {
+  buildOcclusionPyramid(occlusionBuffer->readDepth(), occlusionBuffer->getSizeX(), occlusionBuffer->getSizeY(),
+                        frameUniforms.projMatrix * view::viewMat);
+  occlusionStats.buildMilliseconds =
+      std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - occlusionBuildStart).count();
+}
+
+void Engine::buildOcclusionPyramid(const std::vector<float>& depth, unsigned int sizeX, unsigned int sizeY,
+                                   const glm::mat4& viewProj) {
+  clearOcclusionPyramid();
+  if (sizeX == 0 || sizeY == 0 || depth.size() != static_cast<size_t>(sizeX) * sizeY) return;
+
+  // Level 0 holds the farthest depth of each texel and its neighbors. The pre-pass is only sampled at texel centers, at
+  // a lower resolution than the scene, so without this an occluder could seem to cover a little more than it really
+  // does around its silhouette.
+  std::vector<float> level0(depth.size());
+  for (unsigned int y = 0; y < sizeY; y++) {
+    for (unsigned int x = 0; x < sizeX; x++) {
+      float maxDepth = 0.;
+      for (unsigned int yN = (y > 0 ? y - 1 : y); yN <= std::min(y + 1, sizeY - 1); yN++) {
+        for (unsigned int xN = (x > 0 ? x - 1 : x); xN <= std::min(x + 1, sizeX - 1); xN++) {
+          maxDepth = std::max(maxDepth, depth[yN * sizeX + xN]);
+        }
+      }
+      level0[y * sizeX + x] = maxDepth;
+    }
+  }
+  occlusionPyramid.push_back(std::move(level0));
+  occlusionPyramidSizes.push_back(glm::uvec2{sizeX, sizeY});
+
+  // Each coarser level holds the farthest depth of the 2x2 texels below it
+  while (occlusionPyramidSizes.back().x > 1 || occlusionPyramidSizes.back().y > 1) {
+    glm::uvec2 fineSize = occlusionPyramidSizes.back();
+    glm::uvec2 coarseSize = (fineSize + 1u) / 2u;
+    const std::vector<float>& fine = occlusionPyramid.back();
+    std::vector<float> coarse(coarseSize.x * coarseSize.y);
+    for (unsigned int y = 0; y < coarseSize.y; y++) {
+      for (unsigned int x = 0; x < coarseSize.x; x++) {
+        unsigned int x0 = 2 * x;
+        unsigned int y0 = 2 * y;
+        unsigned int x1 = std::min(x0 + 1, fineSize.x - 1);
+        unsigned int y1 = std::min(y0 + 1, fineSize.y - 1);
+        coarse[y * coarseSize.x + x] = std::max(std::max(fine[y0 * fineSize.x + x0], fine[y0 * fineSize.x + x1]),
+                                                std::max(fine[y1 * fineSize.x + x0], fine[y1 * fineSize.x + x1]));
+      }
+    }
+    occlusionPyramid.push_back(std::move(coarse));
+    occlusionPyramidSizes.push_back(coarseSize);
+  }
+
+  occlusionViewProj = viewProj;
+  occlusionContentVersion = sceneContentVersion();
+}
+
+void Engine::clearOcclusionPyramid() {
+  occlusionPyramid.clear();
+  occlusionPyramidSizes.clear();
+  occlusionStats = OcclusionStats();
+}
+
+bool Engine::boxIsOccluded(const glm::mat4& viewProj, const glm::mat4& model, glm::vec3 bboxMin, glm::vec3 bboxMax) {
+  if (occlusionPyramid.empty() || viewProj != occlusionViewProj ||
+      sceneContentVersion() != occlusionContentVersion) {
+    return false;
+  }
+  occlusionStats.nTested++;
+
+  // Screen rectangle and nearest depth of the box
+  glm::mat4 viewProjModel = viewProj * model;
+  glm::vec3 ndcMin{std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity(),
+                   std::numeric_limits<float>::infinity()};
+  glm::vec3 ndcMax = -ndcMin;
+  for (int iC = 0; iC < 8; iC++) {
+    glm::vec3 corner{(iC & 1) ? bboxMax.x : bboxMin.x, (iC & 2) ? bboxMax.y : bboxMin.y,
+                     (iC & 4) ? bboxMax.z : bboxMin.z};
+    glm::vec4 p = viewProjModel * glm::vec4(corner, 1.);
+    if (p.w <= 0.) return false; // (reaches behind the camera)
+    glm::vec3 ndc = glm::vec3(p) / p.w;
+    ndcMin = glm::min(ndcMin, ndc);
+    ndcMax = glm::max(ndcMax, ndc);
+  }
+  if (ndcMin.z < -1.) return false; // (reaches in front of the near plane)
+  float nearestDepth = 0.5f * ndcMin.z + 0.5f;
+
+  // Go up the pyramid until the rectangle covers at most 2x2 texels, then compare with the farthest of them
+  glm::uvec2 size0 = occlusionPyramidSizes.front();
+  auto toTexel = [](float ndc, unsigned int size) {
+    float t = std::floor((0.5f * ndc + 0.5f) * size);
+    return static_cast<unsigned int>(glm::clamp(t, 0.f, size - 1.f));
+  };
+  unsigned int x0 = toTexel(ndcMin.x, size0.x);
+  unsigned int x1 = toTexel(ndcMax.x, size0.x);
+  unsigned int y0 = toTexel(ndcMin.y, size0.y);
+  unsigned int y1 = toTexel(ndcMax.y, size0.y);
+  size_t level = 0;
+  while (level + 1 < occlusionPyramid.size() && (x1 - x0 > 1 || y1 - y0 > 1)) {
+    x0 /= 2;
+    x1 /= 2;
+    y0 /= 2;
+    y1 /= 2;
+    level++;
+  }
+
+  const std::vector<float>& depths = occlusionPyramid[level];
+  unsigned int levelSizeX = occlusionPyramidSizes[level].x;
+  float farthestDepth = 0.;
+  for (unsigned int y = y0; y <= y1; y++) {
+    for (unsigned int x = x0; x <= x1; x++) {
+      farthestDepth = std::max(farthestDepth, depths[y * levelSizeX + x]);
+    }
+  }
+
+  bool occluded = nearestDepth > farthestDepth;
+  if (occluded) occlusionStats.nOccluded++;
+  return occluded;
+}
+
+std::shared_ptr<ShaderProgram> Engine::requestShader(const std::string& programName,
+                                                    const std::vector<std::string>& customRules,
+                                                    ShaderReplacementDefaults defaults) {
+
+  // Add in the default rules
+  std::vector<std::string> fullCustomRules = customRules;
+  switch (defaults) {
+  case ShaderReplacementDefaults::SceneObject: {
+    fullCustomRules.insert(fullCustomRules.begin(), defaultRules_sceneObject.begin(), defaultRules_sceneObject.end());
+    break;
+  }
+  case ShaderReplacementDefaults::Pick: {
+    fullCustomRules.insert(fullCustomRules.begin(), defaultRules_pick.begin(), defaultRules_pick.end());
+    break;
+  }
+  case ShaderReplacementDefaults::Process: {
+    fullCustomRules.insert(fullCustomRules.begin(), defaultRules_process.begin(), defaultRules_process.end());
+    break;
+  }
+  case ShaderReplacementDefaults::None: {
+    break;
+  }
+  }
+
+  const std::pair<std::vector<ShaderStageSpecification>, DrawMode>& permutation =
+      assembleShaderPermutation(programName, fullCustomRules);
+  return generateShaderProgram(permutation.first, permutation.second);
+}
+
+const std::pair<std::vector<ShaderStageSpecification>, DrawMode>&
+Engine::assembleShaderPermutation(const std::string& programName, const std::vector<std::string>& rules) {
+
+  std::string key = programName;
+  for (const std::string& ruleName : rules) {
+    key += " " + ruleName;
+  }
+  auto cached = shaderPermutations.find(key);
+  if (cached != shaderPermutations.end()) return cached->second;
+
+  // Get the program
+  auto programIt = registeredShaderPrograms.find(programName);
+  if (programIt == registeredShaderPrograms.end()) {
+    throw std::runtime_error("No shader program with name [" + programName + "] registered.");
+  }
+
+  // Get the rules
+  std::vector<const ShaderReplacementRule*> rulePtrs;
+  for (const std::string& ruleName : rules) {
+    auto ruleIt = registeredShaderRules.find(ruleName);
+    if (ruleIt == registeredShaderRules.end()) {
+      throw std::runtime_error("No shader replacement rule with name [" + ruleName + "] registered.");
+    }
+    rulePtrs.push_back(&ruleIt->second);
+  }
+
+  std::vector<ShaderStageSpecification> updatedStages = applyShaderReplacements(programIt->second.first, rulePtrs);
+  return shaderPermutations.emplace(key, std::make_pair(std::move(updatedStages), programIt->second.second))
+      .first->second;
+}
+
+std::vector<std::string> Engine::getShaderPermutations() {
+  std::vector<std::string> permutations;
+  for (auto& x : shaderPermutations) {
+    permutations.push_back(x.first);
+  }
+  std::sort(permutations.begin(), permutations.end());
+  return permutations;
+}
+
+void Engine::precomputeShaderPermutations(const std::vector<std::string>& permutations) {
+  for (const std::string& permutation : permutations) {
+    std::istringstream in(permutation);
+    std::string programName;
+    if (!(in >> programName)) continue; // (blank)
+    std::vector<std::string> rules;
+    std::string ruleName;
+    while (in >> ruleName) {
+      rules.push_back(ruleName);
+    }
+    assembleShaderPermutation(programName, rules);
+  }
+}
+
+void Engine::saveShaderPermutations(std::string filename) {
+  std::ofstream out(filename);
+  if (!out) {
+    error("failed to open shader permutation file " + filename);
+    return;
+  }
+  for (const std::string& permutation : getShaderPermutations()) {
+    out << permutation << "\n";
+  }
+}
+
+void Engine::loadShaderPermutations(std::string filename) {
+  std::ifstream in(filename);
+  if (!in) {
+    error("failed to open shader permutation file " + filename);
+    return;
+  }
+  std::vector<std::string> permutations;
+  std::string line;
+  while (std::getline(in, line)) {
+    permutations.push_back(line);
+  }
+  precomputeShaderPermutations(permutations);
+}
+
 void Engine::allocateGlobalBuffersAndPrograms() {
 
   // Note: The display frame buffer should be manually wrapped by child classes
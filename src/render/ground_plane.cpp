@@ -36,6 +36,33 @@ std::tuple<int, float> getGroundPlaneAxisAndSign() {
 
   return std::tuple<int, float>{iP, sign};
 }
+
+// Conservatively test whether a square on the ground (centered at `center`, spanned by the unit vectors basisX/basisY)
+// could be visible from the camera. The square is hidden only if all four corners lie outside the same clip plane.
+bool groundSquareInFrustum(const glm::mat4& viewProj, glm::vec3 center, glm::vec3 basisX, glm::vec3 basisY,
+                           float halfWidth) {
+  std::array<glm::vec4, 4> corners;
+  for (int i = 0; i < 4; i++) {
+    float sX = (i & 1) ? 1. : -1.;
+    float sY = (i & 2) ? 1. : -1.;
+    glm::vec3 p = center + halfWidth * (sX * basisX + sY * basisY);
+    corners[i] = viewProj * glm::vec4(p, 1.);
+  }
+
+  for (int iC = 0; iC < 3; iC++) {
+    for (float side : {-1.f, 1.f}) {
+      bool allOutside = true;
+      for (const glm::vec4& c : corners) {
+        if (side * c[iC] <= c.w) {
+          allOutside = false;
+          break;
+        }
+      }
+      if (allOutside) return false;
+    }
+  }
+  return true;
+}
 }; // namespace
 
 void GroundPlane::populateGroundPlaneGeometry() {
@@ -111,11 +138,17 @@ void GroundPlane::prepare() {
           render::engine->generateTextureBuffer(TextureFormat::RGBA16F, view::bufferWidth, view::bufferHeight);
       sceneAltColorTexture->setFilterMode(FilterMode::Linear);
     }
-    sceneAltDepthTexture =
-        render::engine->generateTextureBuffer(TextureFormat::DEPTH24, view::bufferWidth, view::bufferHeight);
+    // the shadow map is view-independent, so it gets a fixed resolution rather than following the window
+    unsigned int altWidth = view::bufferWidth;
+    unsigned int altHeight = view::bufferHeight;
+    if (options::groundPlaneMode == GroundPlaneMode::ShadowOnly) {
+      altWidth = shadowMapResolution;
+      altHeight = shadowMapResolution;
+    }
+    sceneAltDepthTexture = render::engine->generateTextureBuffer(TextureFormat::DEPTH24, altWidth, altHeight);
 
 
-    sceneAltFrameBuffer = render::engine->generateFrameBuffer(view::bufferWidth, view::bufferHeight);
+    sceneAltFrameBuffer = render::engine->generateFrameBuffer(altWidth, altHeight);
     if (options::groundPlaneMode == GroundPlaneMode::TileReflection) {
       sceneAltFrameBuffer->addColorBuffer(sceneAltColorTexture);
     }
@@ -135,10 +168,11 @@ void GroundPlane::prepare() {
   if (options::groundPlaneMode == GroundPlaneMode::ShadowOnly) {
     // Blur buffers and program
     for (int i = 0; i < 2; i++) {
-      blurColorTextures[i] =
-          render::engine->generateTextureBuffer(TextureFormat::RGBA16F, view::bufferWidth, view::bufferHeight);
+      blurColorTextures[i] = render::engine->generateTextureBuffer(TextureFormat::RGBA16F, shadowMapResolution / 2,
+                                                                   shadowMapResolution / 2);
       blurColorTextures[i]->setFilterMode(FilterMode::Linear);
-      blurFrameBuffers[i] = render::engine->generateFrameBuffer(view::bufferWidth, view::bufferHeight);
+      blurFrameBuffers[i] = render::engine->generateFrameBuffer(shadowMapResolution / 2, shadowMapResolution / 2);
+      blurFrameBuffers[i]->setViewport(0, 0, shadowMapResolution / 2, shadowMapResolution / 2);
 
       blurFrameBuffers[i]->addColorBuffer(blurColorTextures[i]);
       blurFrameBuffers[i]->setDrawBuffers();
@@ -162,6 +196,95 @@ void GroundPlane::prepare() {
   }
 
   groundPlanePrepared = true;
+  shadowMapValid = false;
+}
+
+void GroundPlane::renderShadowMap(int iP, float sign, double groundHeight) {
+  shadowMapRenderCount++;
+
+  glm::vec3 baseUp{0., 0., 0.};
+  glm::vec3 baseForward{0., 0., 0.};
+  baseUp[iP] = sign;
+  baseForward[(iP + 1) % 3] = sign;
+
+  // The region of the ground covered by the shadow map: the footprint of the scene, padded to leave room for the blur
+  glm::vec3 bboxMin = std::get<0>(state::boundingBox);
+  glm::vec3 bboxMax = std::get<1>(state::boundingBox);
+  glm::vec3 center = 0.5f * (bboxMin + bboxMax);
+  center[iP] = groundHeight;
+  float footprint =
+      std::fmax(bboxMax[(iP + 1) % 3] - bboxMin[(iP + 1) % 3], bboxMax[(iP + 2) % 3] - bboxMin[(iP + 2) % 3]);
+  float halfWidth = 0.75 * footprint + 0.1 * state::lengthScale;
+
+  // A narrow perspective camera far above the ground. This is nearly orthographic, but unlike a true orthographic
+  // projection it keeps working with the ray-cast impostor shaders, which assume a perspective camera.
+  float camDist = 100. * halfWidth;
+  glm::mat4 shadowView = glm::lookAt(center + camDist * baseUp, center, baseForward);
+  glm::mat4 shadowProj = glm::perspective(2.f * std::atan(halfWidth / camDist), 1.f, 0.5f * camDist, 2.f * camDist);
+  shadowViewProj = shadowProj * shadowView;
+
+  // Prepare the alternate scene buffers
+  render::engine->setBlendMode();
+  render::engine->setDepthMode();
+  sceneAltFrameBuffer->resize(shadowMapResolution, shadowMapResolution);
+  sceneAltFrameBuffer->setViewport(0, 0, shadowMapResolution, shadowMapResolution);
+
+  sceneAltFrameBuffer->bindForRendering();
+  sceneAltFrameBuffer->clearColor = {view::bgColor[0], view::bgColor[1], view::bgColor[2]};
+  sceneAltFrameBuffer->clear();
+
+  for (int i = 0; i < 2; i++) {
+    blurFrameBuffers[i]->clear();
+  }
+
+  // Render to a texture so we can sample from it on the ground
+  sceneAltFrameBuffer->bindForRendering();
+
+  // Push a view matrix which projects on to the ground plane, seen from the shadow camera
+  glm::mat4 origViewMat = view::viewMat;
+  glm::mat4 origProjMat = render::engine->getFrameUniforms().projMatrix;
+  glm::mat4 projMat = glm::mat4(1.0);
+  projMat[iP][iP] = 0.;
+  projMat[3][iP] = groundHeight;
+  view::viewMat = shadowView * projMat;
+  render::engine->setFrameProjectionMatrix(shadowProj);
+
+  // Draw everything
+  render::engine->setDepthMode();
+  render::engine->setBlendMode(BlendMode::Disable);
+  drawStructures();
+
+  // Copy the depth buffer to a texture (while downsampling)
+  render::engine->setBlendMode(BlendMode::Disable);
+  blurFrameBuffers[0]->bindForRendering();
+  copyTexProgram->draw();
+
+  // == Blur
+
+  // Do some blur iterations (ends in same buffer it started in)
+  for (int i = 0; i < options::shadowBlurIters; i++) {
+    // horizontal blur
+    blurFrameBuffers[1]->bindForRendering();
+    blurProgram->setTextureFromBuffer("t_image", blurColorTextures[0].get());
+    blurProgram->setUniform("u_horizontal", 1);
+    blurProgram->draw();
+
+    // vertical blur
+    blurFrameBuffers[0]->bindForRendering();
+    blurProgram->setTextureFromBuffer("t_image", blurColorTextures[1].get());
+    blurProgram->setUniform("u_horizontal", 0);
+    blurProgram->draw();
+  }
+
+  // Restore original view
+  view::viewMat = origViewMat;
+  render::engine->setFrameProjectionMatrix(origProjMat);
+
+  shadowMapValid = true;
+  shadowContentVersionCached = sceneContentVersion();
+  shadowUpDirCached = view::upDir;
+  shadowGroundHeightCached = groundHeight;
+  shadowBlurItersCached = options::shadowBlurIters;
 }
 
 void GroundPlane::draw(bool isRedraw) {
@@ -195,21 +318,14 @@ void GroundPlane::draw(bool isRedraw) {
   double bboxBottom = sign == 1.0 ? std::get<0>(state::boundingBox)[iP] : std::get<1>(state::boundingBox)[iP];
   double bboxHeight = std::get<1>(state::boundingBox)[iP] - std::get<0>(state::boundingBox)[iP];
   double heightEPS = state::lengthScale * 1e-4;
-  double groundHeight = bboxBottom - sign * (options::groundPlaneHeightFactor.asAbsolute() + heightEPS);
+  double groundHeight = bboxBottom - sign * (options::groundPlaneHeightFactor->asAbsolute() + heightEPS);
 
-  // Viewport
-  glm::vec4 viewport = render::engine->getCurrentViewport();
-  glm::vec2 viewportDim{viewport[2], viewport[3]};
   int factor = render::engine->getSSAAFactor();
 
   auto setUniforms = [&]() {
     glm::mat4 viewMat = view::getCameraViewMatrix();
     groundPlaneProgram->setUniform("u_viewMatrix", glm::value_ptr(viewMat));
 
-    glm::mat4 projMat = view::getCameraPerspectiveMatrix();
-    groundPlaneProgram->setUniform("u_projMatrix", glm::value_ptr(projMat));
-    groundPlaneProgram->setUniform("u_viewportDim", viewportDim);
-
     if (options::groundPlaneMode == GroundPlaneMode::Tile ||
         options::groundPlaneMode == GroundPlaneMode::TileReflection) {
       groundPlaneProgram->setUniform("u_center", state::center);
@@ -218,7 +334,8 @@ void GroundPlane::draw(bool isRedraw) {
     }
 
     if (options::groundPlaneMode == GroundPlaneMode::ShadowOnly) {
-      groundPlaneProgram->setUniform("u_shadowDarkness", options::shadowDarkness);
+      groundPlaneProgram->setUniform("u_shadowDarkness", options::shadowDarkness.get());
+      groundPlaneProgram->setUniform("u_shadowViewProj", glm::value_ptr(shadowViewProj));
     }
 
     float camHeight = view::getCameraWorldPosition()[iP];
@@ -248,102 +365,68 @@ void GroundPlane::draw(bool isRedraw) {
   // Render the scene to implement the mirror effect
   if (!isRedraw && options::groundPlaneMode == GroundPlaneMode::TileReflection) {
 
-    // Prepare the alternate scene buffers
-    // (use a texture 1/4 the area of the view buffer, it's supposed to be blurry anyway and this saves perf)
-    render::engine->setBlendMode();
-    render::engine->setDepthMode();
-    sceneAltFrameBuffer->resize(factor * view::bufferWidth / 2, factor * view::bufferHeight / 2);
-    sceneAltFrameBuffer->setViewport(0, 0, factor * view::bufferWidth / 2, factor * view::bufferHeight / 2);
-    render::engine->setCurrentPixelScaling(factor / 2.);
-
-    sceneAltFrameBuffer->bindForRendering();
-    sceneAltFrameBuffer->clearColor = {view::bgColor[0], view::bgColor[1], view::bgColor[2]};
-    sceneAltFrameBuffer->clear();
-
-    // Render to a texture so we can sample from it on the ground
-    sceneAltFrameBuffer->bindForRendering();
-
-    // Push a reflected view matrix
-    glm::mat4 origViewMat = view::viewMat;
-
-    glm::vec3 mirrorN = baseUp * sign;
-    glm::mat3 mirrorMat3 = glm::mat3(1.0) - 2.0f * glm::outerProduct(mirrorN, mirrorN);
-    glm::vec3 tVec{0., 0., 0.};
-    tVec[iP] = -groundHeight;
-    glm::mat4 mirrorMat =
-        glm::translate(glm::mat4(1.0), -tVec) * glm::mat4(mirrorMat3) * glm::translate(glm::mat4(1.0), tVec);
-    view::viewMat = view::viewMat * mirrorMat;
+    // Skip the mirrored pass entirely if the ground can't be seen. The tile shader discards everything when the camera
+    // is below the ground, and fades the ground out beyond a fixed distance from the scene center.
+    float camHeight = view::getCameraWorldPosition()[iP];
+    glm::vec3 groundCenter = state::center;
+    groundCenter[iP] = groundHeight;
+    glm::mat4 viewProj = view::getCameraPerspectiveMatrix() * view::getCameraViewMatrix();
+    bool groundVisible =
+        sign * (camHeight - groundHeight) > 0. &&
+        groundSquareInFrustum(viewProj, groundCenter, baseForward, baseRight, 4.25 * state::lengthScale);
+
+    if (groundVisible) {
+
+      // Prepare the alternate scene buffers
+      // (use a texture 1/4 the area of the view buffer, it's supposed to be blurry anyway and this saves perf. While
+      // the camera is moving drop to 1/16 the area, and ask for one more frame afterwards to refine it.)
+      int resDiv = 2;
+      if (view::viewMat != reflectionViewMatCached) {
+        resDiv = 4;
+        reflectionViewMatCached = view::viewMat;
+        requestViewRedraw();
+      }
+      render::engine->setBlendMode();
+      render::engine->setDepthMode();
+      sceneAltFrameBuffer->resize(factor * view::bufferWidth / resDiv, factor * view::bufferHeight / resDiv);
+      sceneAltFrameBuffer->setViewport(0, 0, factor * view::bufferWidth / resDiv, factor * view::bufferHeight / resDiv);
+      render::engine->setCurrentPixelScaling(factor / static_cast<float>(resDiv));
+
+      sceneAltFrameBuffer->bindForRendering();
+      sceneAltFrameBuffer->clearColor = {view::bgColor[0], view::bgColor[1], view::bgColor[2]};
+      sceneAltFrameBuffer->clear();
+
+      // Render to a texture so we can sample from it on the ground
+      sceneAltFrameBuffer->bindForRendering();
+
+      // Push a reflected view matrix
+      glm::mat4 origViewMat = view::viewMat;
+
+      glm::vec3 mirrorN = baseUp * sign;
+      glm::mat3 mirrorMat3 = glm::mat3(1.0) - 2.0f * glm::outerProduct(mirrorN, mirrorN);
+      glm::vec3 tVec{0., 0., 0.};
+      tVec[iP] = -groundHeight;
+      glm::mat4 mirrorMat =
+          glm::translate(glm::mat4(1.0), -tVec) * glm::mat4(mirrorMat3) * glm::translate(glm::mat4(1.0), tVec);
+      view::viewMat = view::viewMat * mirrorMat;
+
+      // Draw everything
+      if (!render::engine->transparencyEnabled()) { // skip when transparency is turned on
+        drawStructures();
+      }
 
-    // Draw everything
-    if (!render::engine->transparencyEnabled()) { // skip when transparency is turned on
-      drawStructures();
+      // Restore original view matrix
+      view::viewMat = origViewMat;
     }
-
-    // Restore original view matrix
-    view::viewMat = origViewMat;
   }
 
   // Render the scene to implement the shadow effect
-  if (!isRedraw && options::groundPlaneMode == GroundPlaneMode::ShadowOnly) {
-
-    // Prepare the alternate scene buffers
-    render::engine->setBlendMode();
-    render::engine->setDepthMode();
-    sceneAltFrameBuffer->resize(factor * view::bufferWidth, factor * view::bufferHeight);
-    sceneAltFrameBuffer->setViewport(0, 0, factor * view::bufferWidth, factor * view::bufferHeight);
-
-    sceneAltFrameBuffer->bindForRendering();
-    sceneAltFrameBuffer->clearColor = {view::bgColor[0], view::bgColor[1], view::bgColor[2]};
-    sceneAltFrameBuffer->clear();
-
-    // Make sure all framebuffers are the right shape
-    for (int i = 0; i < 2; i++) {
-      blurFrameBuffers[i]->resize(factor * view::bufferWidth / 2, factor * view::bufferHeight / 2);
-      blurFrameBuffers[i]->setViewport(0, 0, factor * view::bufferWidth / 2, factor * view::bufferHeight / 2);
-      blurFrameBuffers[i]->clear();
-    }
-
-    // Render to a texture so we can sample from it on the ground
-    sceneAltFrameBuffer->bindForRendering();
-
-    // Push a view matrix which projects on to the ground plane
-    glm::mat4 origViewMat = view::viewMat;
-    glm::mat4 projMat = glm::mat4(1.0);
-    projMat[iP][iP] = 0.;
-    projMat[3][iP] = groundHeight;
-    view::viewMat = view::viewMat * projMat;
-
-    // Draw everything
-    render::engine->setDepthMode();
-    render::engine->setBlendMode(BlendMode::Disable);
-    drawStructures();
-
-    // Copy the depth buffer to a texture (while upsampling)
-    render::engine->setBlendMode(BlendMode::Disable);
-    blurFrameBuffers[0]->bindForRendering();
-    copyTexProgram->draw();
-
-    // == Blur
-
-    // Do some blur iterations (ends in same buffer it started in)
-    int nBlur = options::shadowBlurIters * render::engine->getSSAAFactor();
-    // int nBlur = 0;
-    for (int i = 0; i < nBlur; i++) {
-      // horizontal blur
-      blurFrameBuffers[1]->bindForRendering();
-      blurProgram->setTextureFromBuffer("t_image", blurColorTextures[0].get());
-      blurProgram->setUniform("u_horizontal", 1);
-      blurProgram->draw();
-
-      // vertical blur
-      blurFrameBuffers[0]->bindForRendering();
-      blurProgram->setTextureFromBuffer("t_image", blurColorTextures[1].get());
-      blurProgram->setUniform("u_horizontal", 0);
-      blurProgram->draw();
+  // (only when the scene has changed, moving the camera reuses the cached shadow)
+  if (options::groundPlaneMode == GroundPlaneMode::ShadowOnly) {
+    if (!shadowMapValid || shadowContentVersionCached != sceneContentVersion() || shadowUpDirCached != view::upDir ||
+        shadowGroundHeightCached != groundHeight || shadowBlurItersCached != options::shadowBlurIters) {
+      renderShadowMap(iP, sign, groundHeight);
     }
-
-    // Restore original view matrix
-    view::viewMat = origViewMat;
   }
 
   render::engine->bindSceneBuffer();
@@ -383,14 +466,16 @@ void GroundPlane::buildGui() {
         std::string mName = modeName(m);
         if (ImGui::Selectable(mName.c_str(), options::groundPlaneMode == m)) {
           options::groundPlaneMode = m;
-          requestRedraw();
         }
       }
       ImGui::EndCombo();
     }
     ImGui::PopItemWidth();
 
-    if (ImGui::SliderFloat("Height", options::groundPlaneHeightFactor.getValuePtr(), -1.0, 1.0)) requestRedraw();
+    ScaledValue<float> heightFactor = options::groundPlaneHeightFactor;
+    if (ImGui::SliderFloat("Height", heightFactor.getValuePtr(), -1.0, 1.0)) {
+      options::groundPlaneHeightFactor = heightFactor;
+    }
 
     switch (options::groundPlaneMode) {
     case GroundPlaneMode::None:
@@ -399,11 +484,14 @@ void GroundPlane::buildGui() {
       break;
     case GroundPlaneMode::TileReflection:
       break;
-    case GroundPlaneMode::ShadowOnly:
-      if (ImGui::SliderFloat("Shadow Darkness", &options::shadowDarkness, .0, 1.0)) requestRedraw();
-      if (ImGui::InputInt("Blur Iterations", &options::shadowBlurIters, 1)) requestRedraw();
+    case GroundPlaneMode::ShadowOnly: {
+      float shadowDarkness = options::shadowDarkness;
+      if (ImGui::SliderFloat("Shadow Darkness", &shadowDarkness, .0, 1.0)) options::shadowDarkness = shadowDarkness;
+      int shadowBlurIters = options::shadowBlurIters;
+      if (ImGui::InputInt("Blur Iterations", &shadowBlurIters, 1)) options::shadowBlurIters = shadowBlurIters;
       break;
     }
+    }
 
 
     ImGui::TreePop();
@@ -81,6 +81,16 @@ GLTextureBuffer::GLTextureBuffer(TextureFormat format_, unsigned int sizeX_, uns
   setFilterMode(FilterMode::Nearest);
 }
 
+// create a 3D texture from data
+GLTextureBuffer::GLTextureBuffer(TextureFormat format_, unsigned int sizeX_, unsigned int sizeY_, unsigned int sizeZ_,
+                                 float* data)
+    : TextureBuffer(3, format_, sizeX_, sizeY_, sizeZ_) {
+
+  checkGLError();
+
+  setFilterMode(FilterMode::Nearest);
+}
+
 GLTextureBuffer::~GLTextureBuffer() {}
 
 void GLTextureBuffer::resize(unsigned int newLen) {
@@ -90,8 +100,8 @@ void GLTextureBuffer::resize(unsigned int newLen) {
   bind();
   if (dim == 1) {
   }
-  if (dim == 2) {
-    throw std::runtime_error("OpenGL error: called 1D resize on 2D texture");
+  if (dim >= 2) {
+    throw std::runtime_error("OpenGL error: called 1D resize on " + std::to_string(dim) + "D texture");
   }
   checkGLError();
 }
@@ -101,8 +111,8 @@ void GLTextureBuffer::resize(unsigned int newX, unsigned int newY) {
   TextureBuffer::resize(newX, newY);
 
   bind();
-  if (dim == 1) {
-    throw std::runtime_error("OpenGL error: called 2D resize on 1D texture");
+  if (dim != 2) {
+    throw std::runtime_error("OpenGL error: called 2D resize on " + std::to_string(dim) + "D texture");
   }
   if (dim == 2) {
   }
@@ -133,13 +143,23 @@ void GLTextureBuffer::setFilterMode(FilterMode newMode) {
   checkGLError();
 }
 
+void GLTextureBuffer::setSubData3D(unsigned int offX, unsigned int offY, unsigned int offZ, unsigned int sizeX_,
+                                   unsigned int sizeY_, unsigned int sizeZ_, const float* data) {
+  if (dim != 3) throw std::runtime_error("OpenGL error: called setSubData3D on " + std::to_string(dim) + "D texture");
+  if (dimension(format) != 1) throw std::runtime_error("OpenGL error: setSubData3D requires a single channel format");
+  if (offX + sizeX_ > sizeX || offY + sizeY_ > sizeY || offZ + sizeZ_ > sizeZ) {
+    throw std::runtime_error("OpenGL error: setSubData3D out of bounds");
+  }
+  checkGLError();
+}
+
 void* GLTextureBuffer::getNativeHandle() { return nullptr; }
 
 std::vector<float> GLTextureBuffer::getDataScalar() {
   if (dimension(format) != 1)
     throw std::runtime_error("called getDataScalar on texture which does not have a 1 dimensional format");
   std::vector<float> outData;
-  outData.resize(getSizeX() * getSizeY());
+  outData.resize(getTotalSize());
 
   return outData;
 }
@@ -314,6 +334,15 @@ std::vector<unsigned char> GLFrameBuffer::readBuffer() {
   return buff;
 }
 
+std::vector<float> GLFrameBuffer::readDepth() {
+  bind();
+
+  // (nothing is ever drawn, so this is always the cleared depth)
+  std::vector<float> buff(getSizeX() * getSizeY(), clearDepth);
+
+  return buff;
+}
+
 void GLFrameBuffer::blitTo(FrameBuffer* targetIn) {
 
   // it _better_ be a GL buffer
@@ -1122,6 +1151,7 @@ void GLShaderProgram::activateTextures() {
 
 void GLShaderProgram::draw() {
   validateData();
+  render::engine->flushFrameUniforms();
 
   if (usePrimitiveRestart) {
   }
@@ -1249,6 +1279,8 @@ bool MockGLEngine::windowRequestsClose() { return false; }
 
 void MockGLEngine::pollEvents() {}
 
+void MockGLEngine::waitEvents(double timeoutSeconds) {}
+
 bool MockGLEngine::isKeyPressed(char c) { return false; }
 
 void MockGLEngine::ImGuiNewFrame() {
@@ -1300,6 +1332,14 @@ std::shared_ptr<TextureBuffer> MockGLEngine::generateTextureBuffer(TextureFormat
   GLTextureBuffer* newT = new GLTextureBuffer(format, sizeX_, sizeY_, data);
   return std::shared_ptr<TextureBuffer>(newT);
 }
+std::shared_ptr<TextureBuffer> MockGLEngine::generateTextureBuffer(TextureFormat format, unsigned int sizeX_,
+                                                                   unsigned int sizeY_, unsigned int sizeZ_,
+                                                                   float* data) {
+  GLTextureBuffer* newT = new GLTextureBuffer(format, sizeX_, sizeY_, sizeZ_, data);
+  return std::shared_ptr<TextureBuffer>(newT);
+}
+
+unsigned int MockGLEngine::getMax3DTextureSize() { return 2048; } // (the minimum OpenGL 4 guarantees)
 
 
 std::shared_ptr<RenderBuffer> MockGLEngine::generateRenderBuffer(RenderBufferType type, unsigned int sizeX_,
@@ -1319,50 +1359,7 @@ std::shared_ptr<ShaderProgram> MockGLEngine::generateShaderProgram(const std::ve
   return std::shared_ptr<ShaderProgram>(newP);
 }
 
-std::shared_ptr<ShaderProgram> MockGLEngine::requestShader(const std::string& programName,
-                                                           const std::vector<std::string>& customRules,
-                                                           ShaderReplacementDefaults defaults) {
-
-  // Get the program
-  if (registeredShaderPrograms.find(programName) == registeredShaderPrograms.end()) {
-    throw std::runtime_error("No shader program with name [" + programName + "] registered.");
-  }
-  const std::vector<ShaderStageSpecification>& stages = registeredShaderPrograms[programName].first;
-  DrawMode dm = registeredShaderPrograms[programName].second;
-
-  // Add in the default rules
-  std::vector<std::string> fullCustomRules = customRules;
-  switch (defaults) {
-  case ShaderReplacementDefaults::SceneObject: {
-    fullCustomRules.insert(fullCustomRules.begin(), defaultRules_sceneObject.begin(), defaultRules_sceneObject.end());
-    break;
-  }
-  case ShaderReplacementDefaults::Pick: {
-    fullCustomRules.insert(fullCustomRules.begin(), defaultRules_pick.begin(), defaultRules_pick.end());
-    break;
-  }
-  case ShaderReplacementDefaults::Process: {
-    fullCustomRules.insert(fullCustomRules.begin(), defaultRules_process.begin(), defaultRules_process.end());
-    break;
-  }
-  case ShaderReplacementDefaults::None: {
-    break;
-  }
-  }
-
-  // Get the rules
-  std::vector<ShaderReplacementRule> rules;
-  for (const std::string& ruleName : fullCustomRules) {
-    if (registeredShaderRules.find(ruleName) == registeredShaderRules.end()) {
-      throw std::runtime_error("No shader replacement rule with name [" + ruleName + "] registered.");
-    }
-    ShaderReplacementRule& thisRule = registeredShaderRules[ruleName];
-    rules.push_back(thisRule);
-  }
-
-  std::vector<ShaderStageSpecification> updatedStages = applyShaderReplacements(stages, rules);
-  return generateShaderProgram(updatedStages, dm);
-}
+void MockGLEngine::uploadFrameUniforms() {}
 
 void MockGLEngine::applyTransparencySettings() {}
 
@@ -1395,6 +1392,7 @@ void MockGLEngine::populateDefaultShadersAndRules() {
   registeredShaderPrograms.insert({"DEPTH_TO_MASK", {{TEXTURE_DRAW_VERT_SHADER, DEPTH_TO_MASK}, DrawMode::Triangles}});
   registeredShaderPrograms.insert({"SCALAR_TEXTURE_COLORMAP", {{TEXTURE_DRAW_VERT_SHADER, SCALAR_TEXTURE_COLORMAP}, DrawMode::Triangles}});
   registeredShaderPrograms.insert({"BLUR_RGB", {{TEXTURE_DRAW_VERT_SHADER, BLUR_RGB}, DrawMode::Triangles}});
+  registeredShaderPrograms.insert({"BLEND_HISTORY", {{TEXTURE_DRAW_VERT_SHADER, BLEND_HISTORY}, DrawMode::Triangles}});
   registeredShaderPrograms.insert({"TRANSFORMATION_GIZMO_ROT", {{TRANSFORMATION_GIZMO_ROT_VERT, TRANSFORMATION_GIZMO_ROT_FRAG}, DrawMode::Triangles}});
 
 
@@ -1402,6 +1400,7 @@ void MockGLEngine::populateDefaultShadersAndRules() {
 
   // Utilitiy rules
   registeredShaderRules.insert({"GLSL_VERSION", GLSL_VERSION});
+  registeredShaderRules.insert({"FRAME_UNIFORMS", FRAME_UNIFORMS});
   registeredShaderRules.insert({"GLOBAL_FRAGMENT_FILTER", GLOBAL_FRAGMENT_FILTER});
   registeredShaderRules.insert({"DOWNSAMPLE_RESOLVE_1", DOWNSAMPLE_RESOLVE_1});
   registeredShaderRules.insert({"DOWNSAMPLE_RESOLVE_2", DOWNSAMPLE_RESOLVE_2});
@@ -1434,6 +1433,7 @@ void MockGLEngine::populateDefaultShadersAndRules() {
   registeredShaderRules.insert({"MESH_PROPAGATE_VALUE2", MESH_PROPAGATE_VALUE2});
   registeredShaderRules.insert({"MESH_PROPAGATE_COLOR", MESH_PROPAGATE_COLOR});
   registeredShaderRules.insert({"MESH_PROPAGATE_HALFEDGE_VALUE", MESH_PROPAGATE_HALFEDGE_VALUE});
+  registeredShaderRules.insert({"MESH_SAMPLE_VOLUME_VALUE", MESH_SAMPLE_VOLUME_VALUE});
   registeredShaderRules.insert({"MESH_PROPAGATE_PICK", MESH_PROPAGATE_PICK});
 
   // sphere things
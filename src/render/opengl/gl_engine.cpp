@@ -25,6 +25,7 @@
 
 #include "stb_image.h"
 
+#include <algorithm>
 #include <set>
 
 namespace polyscope {
@@ -38,6 +39,9 @@ namespace backend_openGL3_glfw {
 
 GLEngine* glEngine = nullptr; // alias for global engine pointer
 
+// The uniform buffer binding point used for the FrameUniforms block
+const GLuint frameUniformsBinding = 0;
+
 void initializeRenderEngine() {
   glEngine = new GLEngine();
   glEngine->initialize();
@@ -265,6 +269,19 @@ GLTextureBuffer::GLTextureBuffer(TextureFormat format_, unsigned int sizeX_, uns
   setFilterMode(FilterMode::Nearest);
 }
 
+// create a 3D texture from data
+GLTextureBuffer::GLTextureBuffer(TextureFormat format_, unsigned int sizeX_, unsigned int sizeY_, unsigned int sizeZ_,
+                                 float* data)
+    : TextureBuffer(3, format_, sizeX_, sizeY_, sizeZ_) {
+
+  glGenTextures(1, &handle);
+  glBindTexture(GL_TEXTURE_3D, handle);
+  glTexImage3D(GL_TEXTURE_3D, 0, internalFormat(format), sizeX, sizeY, sizeZ, 0, formatF(format), GL_FLOAT, data);
+  checkGLError();
+
+  setFilterMode(FilterMode::Nearest);
+}
+
 GLTextureBuffer::~GLTextureBuffer() { glDeleteTextures(1, &handle); }
 
 void GLTextureBuffer::resize(unsigned int newLen) {
@@ -275,8 +292,8 @@ void GLTextureBuffer::resize(unsigned int newLen) {
   if (dim == 1) {
     glTexImage1D(GL_TEXTURE_1D, 0, internalFormat(format), sizeX, 0, formatF(format), type(format), nullptr);
   }
-  if (dim == 2) {
-    throw std::runtime_error("OpenGL error: called 1D resize on 2D texture");
+  if (dim >= 2) {
+    throw std::runtime_error("OpenGL error: called 1D resize on " + std::to_string(dim) + "D texture");
   }
   checkGLError();
 }
@@ -286,8 +303,8 @@ void GLTextureBuffer::resize(unsigned int newX, unsigned int newY) {
   TextureBuffer::resize(newX, newY);
 
   bind();
-  if (dim == 1) {
-    throw std::runtime_error("OpenGL error: called 2D resize on 1D texture");
+  if (dim != 2) {
+    throw std::runtime_error("OpenGL error: called 2D resize on " + std::to_string(dim) + "D texture");
   }
   if (dim == 2) {
     glTexImage2D(GL_TEXTURE_2D, 0, internalFormat(format), sizeX, sizeY, 0, formatF(format), type(format), nullptr);
@@ -310,10 +327,26 @@ void GLTextureBuffer::setFilterMode(FilterMode newMode) {
     break;
   }
   glTexParameteri(textureType(), GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  if (dim == 2) {
+  if (dim >= 2) {
     glTexParameteri(textureType(), GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
   }
+  if (dim == 3) {
+    glTexParameteri(textureType(), GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+  }
+
+  checkGLError();
+}
+
+void GLTextureBuffer::setSubData3D(unsigned int offX, unsigned int offY, unsigned int offZ, unsigned int sizeX_,
+                                   unsigned int sizeY_, unsigned int sizeZ_, const float* data) {
+  if (dim != 3) throw std::runtime_error("OpenGL error: called setSubData3D on " + std::to_string(dim) + "D texture");
+  if (dimension(format) != 1) throw std::runtime_error("OpenGL error: setSubData3D requires a single channel format");
+  if (offX + sizeX_ > sizeX || offY + sizeY_ > sizeY || offZ + sizeZ_ > sizeZ) {
+    throw std::runtime_error("OpenGL error: setSubData3D out of bounds");
+  }
 
+  bind();
+  glTexSubImage3D(GL_TEXTURE_3D, 0, offX, offY, offZ, sizeX_, sizeY_, sizeZ_, formatF(format), GL_FLOAT, data);
   checkGLError();
 }
 
@@ -367,6 +400,8 @@ GLenum GLTextureBuffer::textureType() {
     return GL_TEXTURE_1D;
   } else if (dim == 2) {
     return GL_TEXTURE_2D;
+  } else if (dim == 3) {
+    return GL_TEXTURE_3D;
   }
   throw std::runtime_error("bad texture type");
 }
@@ -593,6 +628,22 @@ std::vector<unsigned char> GLFrameBuffer::readBuffer() {
   return buff;
 }
 
+std::vector<float> GLFrameBuffer::readDepth() {
+
+  glFlush();
+  glFinish();
+
+  bind();
+
+  int w = getSizeX();
+  int h = getSizeY();
+
+  std::vector<float> buff(w * h);
+  glReadPixels(0, 0, w, h, GL_DEPTH_COMPONENT, GL_FLOAT, &(buff.front()));
+
+  return buff;
+}
+
 void GLFrameBuffer::blitTo(FrameBuffer* targetIn) {
 
   // it _better_ be a GL buffer
@@ -728,6 +779,12 @@ void GLShaderProgram::compileGLProgram(const std::vector<ShaderStageSpecificatio
   glLinkProgram(programHandle);
   printProgramInfoLog(programHandle);
 
+  // Attach the shared per-frame uniforms, if this program uses them
+  GLuint frameBlockIndex = glGetUniformBlockIndex(programHandle, "FrameUniforms");
+  if (frameBlockIndex != GL_INVALID_INDEX) {
+    glUniformBlockBinding(programHandle, frameBlockIndex, frameUniformsBinding);
+  }
+
 
   // Delete the shaders we just compiled, they aren't used after link
   for (ShaderHandle h : handles) {
@@ -1567,6 +1624,9 @@ void GLShaderProgram::activateTextures() {
     case 2:
       targetType = GL_TEXTURE_2D;
       break;
+    case 3:
+      targetType = GL_TEXTURE_3D;
+      break;
     }
 
     glActiveTexture(GL_TEXTURE0 + t.index);
@@ -1577,6 +1637,7 @@ void GLShaderProgram::activateTextures() {
 
 void GLShaderProgram::draw() {
   validateData();
+  render::engine->flushFrameUniforms();
 
   glUseProgram(programHandle);
   glBindVertexArray(vaoHandle);
@@ -1588,48 +1649,70 @@ void GLShaderProgram::draw() {
 
   activateTextures();
 
+  GLenum mode = GL_POINTS;
+  bool indexed = false;
   switch (drawMode) {
   case DrawMode::Points:
-    glDrawArrays(GL_POINTS, 0, drawDataLength);
+    mode = GL_POINTS;
     break;
   case DrawMode::Triangles:
-    glDrawArrays(GL_TRIANGLES, 0, drawDataLength);
+    mode = GL_TRIANGLES;
     break;
   case DrawMode::Lines:
-    glDrawArrays(GL_LINES, 0, drawDataLength);
+    mode = GL_LINES;
     break;
   case DrawMode::TrianglesAdjacency:
-    glDrawArrays(GL_TRIANGLES_ADJACENCY, 0, drawDataLength);
+    mode = GL_TRIANGLES_ADJACENCY;
     break;
   case DrawMode::Patches:
     glPatchParameteri(GL_PATCH_VERTICES, nPatchVertices);
-    glDrawArrays(GL_PATCHES, 0, drawDataLength);
+    mode = GL_PATCHES;
     break;
   case DrawMode::LinesAdjacency:
-    glDrawArrays(GL_LINES_ADJACENCY, 0, drawDataLength);
+    mode = GL_LINES_ADJACENCY;
     break;
   case DrawMode::IndexedLines:
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexVBO);
-    glDrawElements(GL_LINES, drawDataLength, GL_UNSIGNED_INT, 0);
+    mode = GL_LINES;
+    indexed = true;
     break;
   case DrawMode::IndexedLineStrip:
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexVBO);
-    glDrawElements(GL_LINE_STRIP, drawDataLength, GL_UNSIGNED_INT, 0);
+    mode = GL_LINE_STRIP;
+    indexed = true;
     break;
   case DrawMode::IndexedLinesAdjacency:
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexVBO);
-    glDrawElements(GL_LINES_ADJACENCY, drawDataLength, GL_UNSIGNED_INT, 0);
+    mode = GL_LINES_ADJACENCY;
+    indexed = true;
     break;
   case DrawMode::IndexedLineStripAdjacency:
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexVBO);
-    glDrawElements(GL_LINE_STRIP_ADJACENCY, drawDataLength, GL_UNSIGNED_INT, 0);
+    mode = GL_LINE_STRIP_ADJACENCY;
+    indexed = true;
     break;
   case DrawMode::IndexedTriangles:
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexVBO);
-    glDrawElements(GL_TRIANGLES, drawDataLength, GL_UNSIGNED_INT, 0);
+    mode = GL_TRIANGLES;
+    indexed = true;
     break;
   }
 
+  if (indexed) {
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexVBO);
+  }
+  auto drawRange = [&](unsigned int start, unsigned int count) {
+    if (indexed) {
+      glDrawElements(mode, count, GL_UNSIGNED_INT, reinterpret_cast<void*>(start * sizeof(unsigned int)));
+    } else {
+      glDrawArrays(mode, start, count);
+    }
+  };
+
+  if (drawRanges == nullptr || drawRanges->empty()) {
+    drawRange(0, drawDataLength);
+  } else {
+    for (const DrawRange& r : *drawRanges) {
+      if (r.start >= drawDataLength) continue;
+      drawRange(r.start, std::min<unsigned int>(r.count, drawDataLength - r.start));
+    }
+  }
+
   if (usePrimitiveRestart) {
     glDisable(GL_PRIMITIVE_RESTART);
   }
@@ -1668,6 +1751,19 @@ void GLEngine::initialize() {
   glfwSwapInterval(1); // Enable vsync
   glfwSetWindowPos(mainWindow, view::initWindowPosX, view::initWindowPosY);
 
+  // Count input and window events, so the main loop can tell when it is idle. These are installed before ImGui's
+  // callbacks, which chain to them.
+  // clang-format off
+  glfwSetCursorPosCallback(mainWindow, [](GLFWwindow*, double, double) { glEngine->windowEventCount++; });
+  glfwSetMouseButtonCallback(mainWindow, [](GLFWwindow*, int, int, int) { glEngine->windowEventCount++; });
+  glfwSetScrollCallback(mainWindow, [](GLFWwindow*, double, double) { glEngine->windowEventCount++; });
+  glfwSetKeyCallback(mainWindow, [](GLFWwindow*, int, int, int, int) { glEngine->windowEventCount++; });
+  glfwSetCharCallback(mainWindow, [](GLFWwindow*, unsigned int) { glEngine->windowEventCount++; });
+  glfwSetWindowSizeCallback(mainWindow, [](GLFWwindow*, int, int) { glEngine->windowEventCount++; });
+  glfwSetWindowFocusCallback(mainWindow, [](GLFWwindow*, int) { glEngine->windowEventCount++; });
+  glfwSetWindowRefreshCallback(mainWindow, [](GLFWwindow*) { glEngine->windowEventCount++; });
+  // clang-format on
+
   // Set initial window size
   int newBufferWidth, newBufferHeight, newWindowWidth, newWindowHeight;
   glfwGetFramebufferSize(mainWindow, &newBufferWidth, &newBufferHeight);
@@ -1703,9 +1799,23 @@ void GLEngine::initialize() {
     // glClearDepth(1.);
   }
 
+  { // Create the buffer for the per-frame uniform block, which stays bound for the lifetime of the engine
+    glGenBuffers(1, &frameUniformsBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, frameUniformsBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, frameUniformsBinding, frameUniformsBuffer);
+    checkGLError();
+  }
+
   populateDefaultShadersAndRules();
 }
 
+void GLEngine::uploadFrameUniforms() {
+  glBindBuffer(GL_UNIFORM_BUFFER, frameUniformsBuffer);
+  glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), &frameUniforms);
+  checkGLError();
+}
+
 
 void GLEngine::initializeImGui() {
 
@@ -1813,6 +1923,8 @@ bool GLEngine::windowRequestsClose() {
 
 void GLEngine::pollEvents() { glfwPollEvents(); }
 
+void GLEngine::waitEvents(double timeoutSeconds) { glfwWaitEventsTimeout(timeoutSeconds); }
+
 bool GLEngine::isKeyPressed(char c) {
   if (c >= '0' && c <= '9') return ImGui::IsKeyPressed(GLFW_KEY_0 + (c - '0'));
   if (c >= 'a' && c <= 'z') return ImGui::IsKeyPressed(GLFW_KEY_A + (c - 'a'));
@@ -1958,6 +2070,18 @@ std::shared_ptr<TextureBuffer> GLEngine::generateTextureBuffer(TextureFormat for
   GLTextureBuffer* newT = new GLTextureBuffer(format, sizeX_, sizeY_, data);
   return std::shared_ptr<TextureBuffer>(newT);
 }
+std::shared_ptr<TextureBuffer> GLEngine::generateTextureBuffer(TextureFormat format, unsigned int sizeX_,
+                                                               unsigned int sizeY_, unsigned int sizeZ_, float* data) {
+  GLTextureBuffer* newT = new GLTextureBuffer(format, sizeX_, sizeY_, sizeZ_, data);
+  return std::shared_ptr<TextureBuffer>(newT);
+}
+
+unsigned int GLEngine::getMax3DTextureSize() {
+  GLint maxSize = 0;
+  glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &maxSize);
+  checkGLError();
+  return static_cast<unsigned int>(maxSize);
+}
 
 std::shared_ptr<RenderBuffer> GLEngine::generateRenderBuffer(RenderBufferType type, unsigned int sizeX_,
                                                              unsigned int sizeY_) {
@@ -1976,51 +2100,6 @@ std::shared_ptr<ShaderProgram> GLEngine::generateShaderProgram(const std::vector
   return std::shared_ptr<ShaderProgram>(newP);
 }
 
-std::shared_ptr<ShaderProgram> GLEngine::requestShader(const std::string& programName,
-                                                       const std::vector<std::string>& customRules,
-                                                       ShaderReplacementDefaults defaults) {
-
-  // Get the program
-  if (registeredShaderPrograms.find(programName) == registeredShaderPrograms.end()) {
-    throw std::runtime_error("No shader program with name [" + programName + "] registered.");
-  }
-  const std::vector<ShaderStageSpecification>& stages = registeredShaderPrograms[programName].first;
-  DrawMode dm = registeredShaderPrograms[programName].second;
-
-  // Add in the default rules
-  std::vector<std::string> fullCustomRules = customRules;
-  switch (defaults) {
-  case ShaderReplacementDefaults::SceneObject: {
-    fullCustomRules.insert(fullCustomRules.begin(), defaultRules_sceneObject.begin(), defaultRules_sceneObject.end());
-    break;
-  }
-  case ShaderReplacementDefaults::Pick: {
-    fullCustomRules.insert(fullCustomRules.begin(), defaultRules_pick.begin(), defaultRules_pick.end());
-    break;
-  }
-  case ShaderReplacementDefaults::Process: {
-    fullCustomRules.insert(fullCustomRules.begin(), defaultRules_process.begin(), defaultRules_process.end());
-    break;
-  }
-  case ShaderReplacementDefaults::None: {
-    break;
-  }
-  }
-
-  // Get the rules
-  std::vector<ShaderReplacementRule> rules;
-  for (const std::string& ruleName : fullCustomRules) {
-    if (registeredShaderRules.find(ruleName) == registeredShaderRules.end()) {
-      throw std::runtime_error("No shader replacement rule with name [" + ruleName + "] registered.");
-    }
-    ShaderReplacementRule& thisRule = registeredShaderRules[ruleName];
-    rules.push_back(thisRule);
-  }
-
-  std::vector<ShaderStageSpecification> updatedStages = applyShaderReplacements(stages, rules);
-  return generateShaderProgram(updatedStages, dm);
-}
-
 void GLEngine::populateDefaultShadersAndRules() {
   // Note: we use .insert({key, value}) rather than map[key] = value to support const members in the value.
 
@@ -2047,12 +2126,14 @@ void GLEngine::populateDefaultShadersAndRules() {
   registeredShaderPrograms.insert({"DEPTH_TO_MASK", {{TEXTURE_DRAW_VERT_SHADER, DEPTH_TO_MASK}, DrawMode::Triangles}});
   registeredShaderPrograms.insert({"SCALAR_TEXTURE_COLORMAP", {{TEXTURE_DRAW_VERT_SHADER, SCALAR_TEXTURE_COLORMAP}, DrawMode::Triangles}});
   registeredShaderPrograms.insert({"BLUR_RGB", {{TEXTURE_DRAW_VERT_SHADER, BLUR_RGB}, DrawMode::Triangles}});
+  registeredShaderPrograms.insert({"BLEND_HISTORY", {{TEXTURE_DRAW_VERT_SHADER, BLEND_HISTORY}, DrawMode::Triangles}});
   registeredShaderPrograms.insert({"TRANSFORMATION_GIZMO_ROT", {{TRANSFORMATION_GIZMO_ROT_VERT, TRANSFORMATION_GIZMO_ROT_FRAG}, DrawMode::Triangles}});
 
   // === Load rules
 
   // Utility rules
   registeredShaderRules.insert({"GLSL_VERSION", GLSL_VERSION});
+  registeredShaderRules.insert({"FRAME_UNIFORMS", FRAME_UNIFORMS});
   registeredShaderRules.insert({"GLOBAL_FRAGMENT_FILTER", GLOBAL_FRAGMENT_FILTER});
   registeredShaderRules.insert({"DOWNSAMPLE_RESOLVE_1", DOWNSAMPLE_RESOLVE_1});
   registeredShaderRules.insert({"DOWNSAMPLE_RESOLVE_2", DOWNSAMPLE_RESOLVE_2});
@@ -2085,6 +2166,7 @@ void GLEngine::populateDefaultShadersAndRules() {
   registeredShaderRules.insert({"MESH_PROPAGATE_VALUE2", MESH_PROPAGATE_VALUE2});
   registeredShaderRules.insert({"MESH_PROPAGATE_COLOR", MESH_PROPAGATE_COLOR});
   registeredShaderRules.insert({"MESH_PROPAGATE_HALFEDGE_VALUE", MESH_PROPAGATE_HALFEDGE_VALUE});
+  registeredShaderRules.insert({"MESH_SAMPLE_VOLUME_VALUE", MESH_SAMPLE_VOLUME_VALUE});
   registeredShaderRules.insert({"MESH_PROPAGATE_PICK", MESH_PROPAGATE_PICK});
 
   // sphere things
@@ -52,7 +52,6 @@ const ShaderStageSpecification FLEX_CYLINDER_GEOM_SHADER = {
     
     // uniforms
     {
-        {"u_projMatrix", DataType::Matrix44Float},
         {"u_radius", DataType::Float},
     }, 
 
@@ -69,7 +68,6 @@ R"(
         layout(points) in;
         layout(triangle_strip, max_vertices=14) out;
         in vec4 position_tip[];
-        uniform mat4 u_projMatrix;
         uniform float u_radius;
         out vec3 tipView;
         out vec3 tailView;
@@ -133,9 +131,6 @@ const ShaderStageSpecification FLEX_CYLINDER_FRAG_SHADER = {
     
     // uniforms
     {
-        {"u_projMatrix", DataType::Matrix44Float},
-        {"u_invProjMatrix", DataType::Matrix44Float},
-        {"u_viewport", DataType::Vector4Float},
         {"u_radius", DataType::Float},
     }, 
 
@@ -148,9 +143,6 @@ const ShaderStageSpecification FLEX_CYLINDER_FRAG_SHADER = {
     // source
 R"(
         ${ GLSL_VERSION }$
-        uniform mat4 u_projMatrix; 
-        uniform mat4 u_invProjMatrix;
-        uniform vec4 u_viewport;
         uniform float u_radius;
         in vec3 tailView;
         in vec3 tipView;
@@ -13,7 +13,6 @@ const ShaderStageSpecification TRANSFORMATION_GIZMO_ROT_VERT = {
     // uniforms
     {
         {"u_modelView", DataType::Matrix44Float},
-        {"u_projMatrix", DataType::Matrix44Float},
     }, 
 
     // attributes
@@ -32,7 +31,6 @@ R"(
         ${ GLSL_VERSION }$
 
         uniform mat4 u_modelView;
-        uniform mat4 u_projMatrix;
         in vec3 a_position;
         in vec3 a_normal;
         in vec3 a_color;
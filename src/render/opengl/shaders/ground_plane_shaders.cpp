@@ -15,7 +15,6 @@ const ShaderStageSpecification GROUND_PLANE_VERT_SHADER =  {
     // uniforms
     {
        {"u_viewMatrix", DataType::Matrix44Float},
-       {"u_projMatrix", DataType::Matrix44Float},
        {"u_groundHeight", DataType::Float},
        {"u_basisZ", DataType::Vector3Float},
     },
@@ -32,7 +31,6 @@ R"(
       ${ GLSL_VERSION }$
 
       uniform mat4 u_viewMatrix;
-      uniform mat4 u_projMatrix;
       uniform float u_groundHeight;
       uniform vec3 u_basisZ;
       in vec4 a_position;
@@ -57,7 +55,6 @@ const ShaderStageSpecification GROUND_PLANE_TILE_FRAG_SHADER= {
       {"u_center", DataType::Vector3Float},
       {"u_basisX", DataType::Vector3Float},
       {"u_basisY", DataType::Vector3Float},
-      {"u_viewportDim", DataType::Vector2Float},
       {"u_cameraHeight", DataType::Float},
       {"u_groundHeight", DataType::Float},
       {"u_upSign", DataType::Float}
@@ -82,7 +79,6 @@ R"(
       uniform vec3 u_center;
       uniform vec3 u_basisX;
       uniform vec3 u_basisY;
-      uniform vec2 u_viewportDim;
       uniform float u_cameraHeight;
       uniform float u_groundHeight;
       uniform float u_upSign;
@@ -149,7 +145,6 @@ const ShaderStageSpecification GROUND_PLANE_TILE_REFLECT_FRAG_SHADER = {
       {"u_center", DataType::Vector3Float},
       {"u_basisX", DataType::Vector3Float},
       {"u_basisY", DataType::Vector3Float},
-      {"u_viewportDim", DataType::Vector2Float},
       {"u_cameraHeight", DataType::Float},
       {"u_groundHeight", DataType::Float},
       {"u_upSign", DataType::Float}
@@ -176,7 +171,6 @@ R"(
       uniform vec3 u_center;
       uniform vec3 u_basisX;
       uniform vec3 u_basisY;
-      uniform vec2 u_viewportDim;
       uniform float u_cameraHeight;
       uniform float u_groundHeight;
       uniform float u_upSign;
@@ -251,11 +245,11 @@ const ShaderStageSpecification GROUND_PLANE_SHADOW_FRAG_SHADER = {
 
     { // uniforms
       {"u_lengthScale", DataType::Float},
-      {"u_viewportDim", DataType::Vector2Float},
       {"u_shadowDarkness", DataType::Float},
       {"u_cameraHeight", DataType::Float},
       {"u_groundHeight", DataType::Float},
-      {"u_upSign", DataType::Float}
+      {"u_upSign", DataType::Float},
+      {"u_shadowViewProj", DataType::Matrix44Float},
     }, 
 
     // attributes
@@ -273,12 +267,12 @@ R"(
 
       uniform sampler2D t_shadow;
       uniform mat4 u_viewMatrix;
-      uniform vec2 u_viewportDim;
       uniform float u_lengthScale;
       uniform float u_shadowDarkness;
       uniform float u_cameraHeight;
       uniform float u_groundHeight;
       uniform float u_upSign;
+      uniform mat4 u_shadowViewProj;
       in vec4 PositionWorldHomog;
       layout(location = 0) out vec4 outputF;
       
@@ -289,11 +283,16 @@ R"(
         float depth = gl_FragCoord.z;
         ${ GLOBAL_FRAGMENT_FILTER }$
 
-        vec2 screenCoords = vec2(gl_FragCoord.x / u_viewportDim.x, gl_FragCoord.y / u_viewportDim.y);
-        float shadowVal = texture(t_shadow, screenCoords).r;
+        // Look up the shadow in the ground-aligned shadow map, nothing is shadowed outside of it
+        vec4 shadowPos = u_shadowViewProj * vec4(PositionWorldHomog.xyz / PositionWorldHomog.w, 1.);
+        vec2 shadowCoords = 0.5 * shadowPos.xy / shadowPos.w + 0.5;
+        float shadowVal = 0.;
+        if(all(greaterThanEqual(shadowCoords, vec2(0., 0.))) && all(lessThanEqual(shadowCoords, vec2(1., 1.)))) {
+          shadowVal = texture(t_shadow, shadowCoords).r;
+        }
         shadowVal = pow(clamp(shadowVal, 0., 1.), 0.25);
 
-        float shadowMax = u_shadowDarkness + 0. * PositionWorldHomog.x;  // use PositionWorldHomog to prevent silly optimizing out
+        float shadowMax = u_shadowDarkness;
         vec3 groundColor = vec3(0., 0., 0.);
         //vec3 groundColor = vec3(1., 0., 0.);
 
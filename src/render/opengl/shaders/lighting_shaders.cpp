@@ -196,7 +196,6 @@ const ShaderReplacementRule TRANSPARENCY_PEEL_STRUCTURE (
       {"FRAG_DECLARATIONS", R"(
           uniform float u_transparency;
           uniform sampler2D t_minDepth;
-          uniform vec2 u_viewportDim;
         )"},
       {"GENERATE_ALPHA", R"(
           alphaOut = u_transparency;
@@ -213,7 +212,6 @@ const ShaderReplacementRule TRANSPARENCY_PEEL_STRUCTURE (
     },
     /* uniforms */ {
         {"u_transparency", DataType::Float},
-        {"u_viewportDim", DataType::Vector2Float},
     },
     /* attributes */ {},
     /* textures */ {
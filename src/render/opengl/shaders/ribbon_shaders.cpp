@@ -49,7 +49,6 @@ const ShaderStageSpecification RIBBON_GEOM_SHADER = {
     // uniforms
     {
         {"u_modelView", DataType::Matrix44Float},
-        {"u_projMatrix", DataType::Matrix44Float},
         {"u_ribbonWidth", DataType::Float},
         {"u_depthOffset", DataType::Float},
     }, 
@@ -69,7 +68,6 @@ R"(
         in vec3 Color[];
         in vec3 Normal[];
         uniform mat4 u_modelView;
-        uniform mat4 u_projMatrix;
         uniform float u_ribbonWidth;
         uniform float u_depthOffset;
         out vec3 colorToFrag;
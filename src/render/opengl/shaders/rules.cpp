@@ -15,6 +15,24 @@ const ShaderReplacementRule GLSL_VERSION(
     }
 );
 
+// declares the uniform block of values shared by all programs in a frame (see render::FrameUniforms)
+// (inserted at the version tag, so it is available in every stage)
+const ShaderReplacementRule FRAME_UNIFORMS(
+    /* rule name */ "FRAME_UNIFORMS",
+    /* replacement sources */
+    {
+        {"GLSL_VERSION", R"(
+          layout(std140) uniform FrameUniforms {
+            mat4 u_projMatrix;
+            mat4 u_invProjMatrix;
+            vec4 u_viewport;
+            vec2 u_viewportDim;
+            float u_pixelScale;
+          };
+        )"}, 
+    }
+);
+
 // possibly discards a fragment due to global rules
 const ShaderReplacementRule GLOBAL_FRAGMENT_FILTER(
     /* rule name */ "GLOBAL_FRAGMENT_FILTER",
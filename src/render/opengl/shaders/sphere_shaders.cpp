@@ -47,7 +47,6 @@ const ShaderStageSpecification FLEX_SPHERE_GEOM_SHADER = {
     
     // uniforms
     {
-        {"u_projMatrix", DataType::Matrix44Float},
         {"u_pointRadius", DataType::Float},
     }, 
 
@@ -64,7 +63,6 @@ R"(
         layout(points) in;
         layout(triangle_strip, max_vertices=4) out;
         in vec4 position_tip[];
-        uniform mat4 u_projMatrix;
         uniform float u_pointRadius;
         out vec3 sphereCenterView;
 
@@ -115,9 +113,6 @@ const ShaderStageSpecification FLEX_SPHERE_FRAG_SHADER = {
     
     // uniforms
     {
-        {"u_projMatrix", DataType::Matrix44Float},
-        {"u_invProjMatrix", DataType::Matrix44Float},
-        {"u_viewport", DataType::Vector4Float},
         {"u_pointRadius", DataType::Float},
     }, 
 
@@ -130,9 +125,6 @@ const ShaderStageSpecification FLEX_SPHERE_FRAG_SHADER = {
     // source
 R"(
         ${ GLSL_VERSION }$
-        uniform mat4 u_projMatrix; 
-        uniform mat4 u_invProjMatrix;
-        uniform vec4 u_viewport;
         uniform float u_pointRadius;
         in vec3 sphereCenterView;
         layout(location = 0) out vec4 outputF;
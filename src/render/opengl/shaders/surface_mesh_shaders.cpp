@@ -15,7 +15,6 @@ const ShaderStageSpecification FLEX_MESH_VERT_SHADER = {
     // uniforms
     {
         {"u_modelView", DataType::Matrix44Float},
-        {"u_projMatrix", DataType::Matrix44Float},
     }, 
 
     // attributes
@@ -32,7 +31,6 @@ R"(
         ${ GLSL_VERSION }$
 
         uniform mat4 u_modelView;
-        uniform mat4 u_projMatrix;
         in vec3 a_position;
         in vec3 a_normal;
         in vec3 a_barycoord;
@@ -288,6 +286,33 @@ const ShaderReplacementRule MESH_BACKFACE_DARKEN (
     /* textures */ {}
 );
 
+// value from a scalar volume, at a coordinate in [0,1]^3 across the volume
+const ShaderReplacementRule MESH_SAMPLE_VOLUME_VALUE (
+    /* rule name */ "MESH_SAMPLE_VOLUME_VALUE",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in vec3 a_volumeCoord;
+          out vec3 a_volumeCoordToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_volumeCoordToFrag = a_volumeCoord;
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          in vec3 a_volumeCoordToFrag;
+          uniform sampler3D t_volume;
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          float shadeValue = texture(t_volume, a_volumeCoordToFrag).r;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_volumeCoord", DataType::Vector3Float},
+    },
+    /* textures */ {
+      {"t_volume", 3}
+    }
+);
 
 // data for picking
 const ShaderReplacementRule MESH_PROPAGATE_PICK (
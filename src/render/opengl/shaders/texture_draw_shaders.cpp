@@ -46,7 +46,6 @@ const ShaderStageSpecification  SPHEREBG_DRAW_VERT_SHADER =  {
     // uniforms
     { 
        {"u_viewMatrix", DataType::Matrix44Float},
-       {"u_projMatrix", DataType::Matrix44Float},
     },
 
     // attributes
@@ -62,7 +61,6 @@ R"(
       ${ GLSL_VERSION }$
 
       uniform mat4 u_viewMatrix;
-      uniform mat4 u_projMatrix;
       in vec4 a_position;
       out vec3 viewDir;
 
@@ -211,6 +209,43 @@ R"(
 )"
 };
 
+const ShaderStageSpecification BLEND_HISTORY = {
+  // Running average for progressive rendering: mix the newest frame in to the accumulated history with weight u_weight.
+    
+    // stage
+    ShaderStageType::Fragment,
+    
+    // uniforms
+    { 
+      {"u_weight", DataType::Float},
+    }, 
+
+    // attributes
+    { },
+    
+    // textures 
+    { 
+      {"t_image", 2},
+      {"t_history", 2},
+    },
+    
+    // source 
+R"(
+      ${ GLSL_VERSION }$
+
+      in vec2 tCoord;
+      uniform sampler2D t_image;
+      uniform sampler2D t_history;
+      uniform float u_weight;
+      layout(location = 0) out vec4 outputF;
+
+      void main()
+      {
+        outputF = mix(texture(t_history, tCoord), texture(t_image, tCoord), u_weight);
+      }
+)"
+};
+
 
 const ShaderStageSpecification COMPOSITE_PEEL = {
     
@@ -53,7 +53,6 @@ const ShaderStageSpecification FLEX_VECTOR_GEOM_SHADER = {
     
     // uniforms
     {
-        {"u_projMatrix", DataType::Matrix44Float},
         {"u_lengthMult", DataType::Float},
         {"u_radius", DataType::Float},
     }, 
@@ -71,7 +70,6 @@ R"(
         layout(points) in;
         layout(triangle_strip, max_vertices=14) out;
         in vec4 vector[];
-        uniform mat4 u_projMatrix;
         uniform float u_lengthMult;
         uniform float u_radius;
         out vec3 tipView;
@@ -137,9 +135,6 @@ const ShaderStageSpecification FLEX_VECTOR_FRAG_SHADER = {
     
     // uniforms
     {
-        {"u_projMatrix", DataType::Matrix44Float},
-        {"u_invProjMatrix", DataType::Matrix44Float},
-        {"u_viewport", DataType::Vector4Float},
         {"u_radius", DataType::Float},
     }, 
 
@@ -152,9 +147,6 @@ const ShaderStageSpecification FLEX_VECTOR_FRAG_SHADER = {
     // source
 R"(
         ${ GLSL_VERSION }$
-        uniform mat4 u_projMatrix; 
-        uniform mat4 u_invProjMatrix;
-        uniform vec4 u_viewport;
         uniform float u_radius;
         in vec3 tailView;
         in vec3 tipView;
@@ -4,72 +4,79 @@
 namespace polyscope {
 namespace render {
 
-std::vector<ShaderStageSpecification>
-applyShaderReplacements(const std::vector<ShaderStageSpecification>& stages,
-                        const std::vector<ShaderReplacementRule>& replacementRules) {
-
-  bool debugPrint = false;
-
-  // accumulate the text to be inserted at each tag from all of the rules
-  std::map<std::string, std::string> replacements;
-  for (const ShaderReplacementRule& rule : replacementRules) {
-    if (debugPrint) std::cout << "Replacement rule: " << rule.ruleName << std::endl;
-
-    for (const std::pair<std::string, std::string>& r : rule.replacements) {
-      std::string key = r.first;
-      std::string value = r.second;
-
-      if (replacements.find(key) == replacements.end()) {
-        replacements[key] = "";
-      }
-      replacements[key] = replacements[key] + "// from rule: " + rule.ruleName + "\n" + value + "\n";
-    }
-  }
+namespace {
+const std::string startTagToken = "${ ";
+const std::string endTagToken = " }$";
+} // namespace
 
+ParsedShaderStage::ParsedShaderStage(const ShaderStageSpecification& spec_) : spec(spec_) {
   const auto npos = std::string::npos;
-  const std::string startTagToken = "${ ";
-  const std::string endTagToken = " }$";
-
-  // == Apply the replacements to the shader source
-  std::vector<ShaderStageSpecification> replacedStages;
-  for (ShaderStageSpecification stage : stages) { // iterate by value to modify
-    std::string progText = stage.src;
-    std::string resultText = "";
+  const std::string& src = spec.src;
 
-    while (!progText.empty()) {
+  size_t pos = 0;
+  while (true) {
 
-      if (debugPrint) std::cout << "searching " << progText << std::endl;
+    // Find the next tag in the program
+    auto tagStart = src.find(startTagToken, pos);
+    auto tagEnd = src.find(endTagToken, pos);
 
-      // Find the next tag in the program
-      auto tagStart = progText.find(startTagToken);
-      auto tagEnd = progText.find(endTagToken);
+    if (tagStart != npos && tagEnd == npos) throw std::runtime_error("ShaderBuilder: no end tag matching start tag");
+    if (tagStart == npos && tagEnd != npos) throw std::runtime_error("ShaderBuilder: no start tag matching end tag");
+    if (tagEnd < tagStart) throw std::runtime_error("ShaderBuilder: no start tag matching end tag");
 
-      if (tagStart != npos && tagEnd == npos) throw std::runtime_error("ShaderBuilder: no end tag matching start tag");
-      if (tagStart == npos && tagEnd != npos) throw std::runtime_error("ShaderBuilder: no start tag matching end tag");
-
-      // no more tags, concatenate in the rest of the source finish looping
-      if (tagStart == npos && tagEnd == npos) {
-        resultText += progText;
-        progText = "";
-      } else {
+    // no more tags, the rest of the source is the last segment
+    if (tagStart == npos) {
+      segments.push_back(src.substr(pos));
+      break;
+    }
 
-        if (debugPrint) std::cout << "FOUND TAG: " << tagStart << " " << tagEnd << std::endl;
+    segments.push_back(src.substr(pos, tagStart - pos));
+    tags.push_back(src.substr(tagStart + startTagToken.size(), tagEnd - (tagStart + startTagToken.size())));
+    pos = tagEnd + endTagToken.size();
+  }
+}
 
-        std::string srcBefore = progText.substr(0, tagStart);
-        std::string tag = progText.substr(tagStart + startTagToken.size(), tagEnd - (tagStart + startTagToken.size()));
-        std::string srcAfter = progText.substr(tagEnd + endTagToken.size(), npos);
+std::vector<ShaderStageSpecification>
+applyShaderReplacements(const std::vector<ShaderStageSpecification>& stages,
+                        const std::vector<ShaderReplacementRule>& replacementRules) {
+  std::vector<ParsedShaderStage> parsedStages(stages.begin(), stages.end());
+  std::vector<const ShaderReplacementRule*> rulePtrs;
+  for (const ShaderReplacementRule& rule : replacementRules) {
+    rulePtrs.push_back(&rule);
+  }
+  return applyShaderReplacements(parsedStages, rulePtrs);
+}
 
-        if (debugPrint) std::cout << "  TAG NAME: [" << tag << "]\n";
+std::vector<ShaderStageSpecification>
+applyShaderReplacements(const std::vector<ParsedShaderStage>& parsedStages,
+                        const std::vector<const ShaderReplacementRule*>& replacementRules) {
 
-        resultText += srcBefore + "\n// tag ${ " + tag + " }$\n";
-        if (replacements.find(tag) != replacements.end()) {
-          resultText += replacements[tag];
-          // std::cout << "  ADDING REPLACEMENT: [" << replacements[tag] << "]\n";
+  // == Apply the replacements to the shader source
+  std::vector<ShaderStageSpecification> replacedStages;
+  for (const ParsedShaderStage& parsed : parsedStages) {
+    const ShaderStageSpecification& stage = parsed.spec;
+
+    // Splice the text from each rule in after each tag
+    std::string resultText;
+    resultText.reserve(stage.src.size());
+    for (size_t iT = 0; iT < parsed.tags.size(); iT++) {
+      const std::string& tag = parsed.tags[iT];
+      resultText += parsed.segments[iT];
+      resultText += "\n// tag ${ ";
+      resultText += tag;
+      resultText += " }$\n";
+      for (const ShaderReplacementRule* rule : replacementRules) {
+        for (const std::pair<std::string, std::string>& r : rule->replacements) {
+          if (r.first != tag) continue;
+          resultText += "// from rule: ";
+          resultText += rule->ruleName;
+          resultText += "\n";
+          resultText += r.second;
+          resultText += "\n";
         }
-        // resultText += "// END ADDIITIONS FROM TAG ${ " + tag + " $}\n";
-        progText = srcAfter; // continue processing the remaining program text
       }
     }
+    resultText += parsed.segments.back();
 
     // For now, we put the uniform listings on the all stages, attributes on vertex shaders, and textures on fragment
     // shaders, since this is where they are mostly commonly used. These listings are only used internally by Polyscope
@@ -77,8 +84,8 @@ applyShaderReplacements(const std::vector<ShaderStageSpecification>& stages,
 
     // == Union the uniforms
     std::vector<ShaderSpecUniform> replacedUniforms = stage.uniforms;
-    for (const ShaderReplacementRule& rule : replacementRules) {
-      for (ShaderSpecUniform newU : rule.uniforms) {
+    for (const ShaderReplacementRule* rule : replacementRules) {
+      for (ShaderSpecUniform newU : rule->uniforms) {
 
         // Look for a matching-named existing uniform
         bool existingFound = false;
@@ -104,8 +111,8 @@ applyShaderReplacements(const std::vector<ShaderStageSpecification>& stages,
     // == Union the attributes
     std::vector<ShaderSpecAttribute> replacedAttributes = stage.attributes;
     if (stage.stage == ShaderStageType::Vertex) {
-      for (const ShaderReplacementRule& rule : replacementRules) {
-        for (ShaderSpecAttribute newA : rule.attributes) {
+      for (const ShaderReplacementRule* rule : replacementRules) {
+        for (ShaderSpecAttribute newA : rule->attributes) {
 
           // Look for a matching-named existing attribute
           bool existingFound = false;
@@ -137,8 +144,8 @@ applyShaderReplacements(const std::vector<ShaderStageSpecification>& stages,
     // == Union the textures
     std::vector<ShaderSpecTexture> replacedTextures = stage.textures;
     if (stage.stage == ShaderStageType::Fragment) {
-      for (const ShaderReplacementRule& rule : replacementRules) {
-        for (ShaderSpecTexture newT : rule.textures) {
+      for (const ShaderReplacementRule* rule : replacementRules) {
+        for (ShaderSpecTexture newT : rule->textures) {
 
           // Look for a matching-named existing texture
           bool existingFound = false;
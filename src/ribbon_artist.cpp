@@ -15,16 +15,25 @@ namespace polyscope {
 RibbonArtist::RibbonArtist(Structure& parentStructure_,
                            const std::vector<std::vector<std::array<glm::vec3, 2>>>& ribbons_, std::string uniqueName_,
                            double normalOffsetFraction_)
-    : parentStructure(parentStructure_), uniqueName(uniqueName_), ribbons(ribbons_),
-      normalOffsetFraction(normalOffsetFraction_),
+    : parentStructure(parentStructure_), uniqueName(uniqueName_), normalOffsetFraction(normalOffsetFraction_),
       enabled(parentStructure.uniquePrefix() + "#ribbon#" + uniqueName + "#enabled", true),
       ribbonWidth(parentStructure.uniquePrefix() + "#ribbon#" + uniqueName + "#ribbonWidth", relativeValue(5e-4)),
       material(parentStructure.uniquePrefix() + "#ribbon#" + uniqueName + "#enabled", "wax")
 
 {
-  createProgram();
+  addRibbons(ribbons_);
 }
 
+void RibbonArtist::addRibbons(const std::vector<std::vector<std::array<glm::vec3, 2>>>& newRibbons) {
+  for (const std::vector<std::array<glm::vec3, 2>>& line : newRibbons) {
+    ribbons.push_back(line);
+    ribbonColorValues.push_back(randomUnit());
+  }
+  deleteProgram();
+}
+
+size_t RibbonArtist::nRibbons() { return ribbons.size(); }
+
 void RibbonArtist::deleteProgram() { program.reset(); }
 
 void RibbonArtist::createProgram() {
@@ -47,7 +56,9 @@ void RibbonArtist::createProgram() {
   std::vector<glm::vec3> colors;
   std::vector<unsigned int> indices;
   unsigned int nPts = 0;
-  const render::ValueColorMap& cmapValue = render::engine->getColorMap(cMap);
+  std::vector<glm::vec3> lineColors(ribbonColorValues.size());
+  render::engine->getColorMap(cMap).getValues(ribbonColorValues.data(), ribbonColorValues.size(), 0., 1.,
+                                              lineColors.data());
   for (size_t iLine = 0; iLine < ribbons.size(); iLine++) {
 
     // Process each point from the list
@@ -63,8 +74,7 @@ void RibbonArtist::createProgram() {
       continue;
     }
 
-    // Sample a color for this line
-    glm::vec3 lineColor = cmapValue.getValue(randomUnit());
+    glm::vec3 lineColor = lineColors[iLine];
 
     // Add a false point at the beginning (so it's not a special case for the geometry shader)
     float EPS = 0.01;
@@ -105,7 +115,7 @@ void RibbonArtist::createProgram() {
 
 void RibbonArtist::draw() {
 
-  if (!enabled.get()) {
+  if (!enabled.get() || ribbons.empty()) {
     return;
   }
 
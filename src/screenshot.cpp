@@ -68,7 +68,6 @@ void screenshot(std::string filename, bool transparentBG) {
   if (transparentBG) render::engine->lightCopy = true; // copy directly in to buffer without blending
 
   // == Make sure we render first
-  processLazyProperties();
 
   // save the redraw requested bit and restore it below
   bool requestedAlready = redrawRequested();
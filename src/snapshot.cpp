@@ -0,0 +1,305 @@
+// Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
+#include "polyscope/snapshot.h"
+
+#include "polyscope/curve_network.h"
+#include "polyscope/messages.h"
+#include "polyscope/options.h"
+#include "polyscope/persistent_value.h"
+#include "polyscope/point_cloud.h"
+#include "polyscope/polyscope.h"
+#include "polyscope/surface_mesh.h"
+#include "polyscope/view.h"
+
+#include <algorithm>
+#include <fstream>
+
+namespace polyscope {
+
+namespace {
+
+const char snapshotMagic[8] = {'P', 'S', 'C', 'O', 'P', 'E', 'S', 'N'};
+const uint32_t snapshotVersion = 1;
+const size_t chunkHeaderSize = 16; // tag, flags, payload size
+
+size_t alignUp(size_t offset) { return (offset + 7) / 8 * 8; }
+
+} // namespace
+
+namespace detail {
+
+// === Scene options
+
+void writeSnapshotOptions(SnapshotWriter& writer) {
+  writer.write<GroundPlaneMode>(options::groundPlaneMode);
+  writer.write<ScaledValue<float>>(options::groundPlaneHeightFactor);
+  writer.write<int32_t>(options::shadowBlurIters);
+  writer.write<float>(options::shadowDarkness);
+  writer.write<int32_t>(options::ssaaFactor);
+  writer.write<char>(options::progressiveAA);
+  writer.write<TransparencyMode>(options::transparencyMode);
+  writer.write<int32_t>(options::transparencyRenderPasses);
+}
+
+void readSnapshotOptions(SnapshotReader& reader) {
+  // Read everything before applying any of it, so that invalid data leaves the options unchanged
+  GroundPlaneMode groundPlaneMode = reader.readEnum(GroundPlaneMode::ShadowOnly);
+  ScaledValue<float> groundPlaneHeightFactor = reader.read<ScaledValue<float>>();
+  int32_t shadowBlurIters = reader.read<int32_t>();
+  float shadowDarkness = reader.read<float>();
+  int32_t ssaaFactor = reader.read<int32_t>();
+  bool progressiveAA = reader.read<char>() != 0;
+  TransparencyMode transparencyMode = reader.readEnum(TransparencyMode::Pretty);
+  int32_t transparencyRenderPasses = reader.read<int32_t>();
+
+  options::groundPlaneMode = groundPlaneMode;
+  options::groundPlaneHeightFactor = groundPlaneHeightFactor;
+  options::shadowBlurIters = std::max(shadowBlurIters, 0);
+  options::shadowDarkness = shadowDarkness;
+  options::ssaaFactor = std::min(std::max(ssaaFactor, 1), 4); // (the same range as the ui allows)
+  options::progressiveAA = progressiveAA;
+  options::transparencyMode = transparencyMode;
+  options::transparencyRenderPasses = std::max(transparencyRenderPasses, 0);
+}
+
+// === Structures
+
+Structure* readSnapshotStructure(std::string typeName, std::string name, SnapshotReader& reader) {
+  if (typeName == PointCloud::structureTypeName) {
+    return PointCloud::readSnapshot(name, reader);
+  }
+  if (typeName == CurveNetwork::structureTypeName) {
+    return CurveNetwork::readSnapshot(name, reader);
+  }
+  if (typeName == SurfaceMesh::structureTypeName) {
+    return SurfaceMesh::readSnapshot(name, reader);
+  }
+  warning("unrecognized structure type in snapshot, skipping", name + " (" + typeName + ")");
+  return nullptr;
+}
+
+} // namespace detail
+
+
+void saveSnapshot(std::string filename) {
+  SnapshotWriter writer;
+
+  writer.beginChunk("PVAL");
+  writer.writeString(detail::persistentValuesToJSON());
+  writer.endChunk();
+
+  writer.beginChunk("OPTS");
+  detail::writeSnapshotOptions(writer);
+  writer.endChunk();
+
+  for (auto& typeStructures : state::structures) {
+    for (auto& x : typeStructures.second) {
+      Structure& s = *x.second;
+      writer.beginChunk("STRC");
+      writer.writeString(s.typeName());
+      writer.writeString(s.name);
+      if (s.writeSnapshot(writer)) {
+        writer.endChunk();
+      } else {
+        writer.cancelChunk();
+        warning("structure type not supported in snapshots, skipping", s.name + " (" + s.typeName() + ")");
+      }
+    }
+  }
+
+  // (last, so that it is restored after the structures)
+  writer.beginChunk("CAMR");
+  writer.writeString(view::getCameraJson());
+  writer.endChunk();
+
+  try {
+    writer.writeToFile(filename);
+  } catch (const std::exception& e) {
+    error("failed to write snapshot: " + std::string(e.what()));
+  }
+}
+
+void loadSnapshot(std::string filename) {
+
+  try {
+    SnapshotReader reader = SnapshotReader::fromFile(filename);
+
+    // Clear the scene first, so the structures being removed do not write their settings to the persistent value cache
+    // after it has been loaded
+    removeAllStructures();
+
+    StructureBatch batch;
+    SnapshotReader chunk;
+    while (!reader.atEnd()) {
+      if (reader.nextChunk("PVAL", chunk)) {
+        detail::persistentValuesFromJSON(chunk.readString());
+      } else if (reader.nextChunk("OPTS", chunk)) {
+        detail::readSnapshotOptions(chunk);
+      } else if (reader.nextChunk("STRC", chunk)) {
+        std::string typeName = chunk.readString();
+        std::string name = chunk.readString();
+        detail::readSnapshotStructure(typeName, name, chunk);
+      } else if (reader.nextChunk("CAMR", chunk)) {
+        view::setCameraFromJson(chunk.readString(), false);
+      } else {
+        // (from a newer version)
+        reader.skipChunk();
+      }
+    }
+
+  } catch (const std::exception& e) {
+    error("failed to load snapshot " + filename + ": " + e.what());
+  }
+}
+
+
+// === SnapshotWriter
+
+SnapshotWriter::SnapshotWriter() {
+  writeBytes(snapshotMagic, sizeof(snapshotMagic));
+  write<uint32_t>(snapshotVersion);
+  write<uint32_t>(0); // flags (reserved)
+}
+
+void SnapshotWriter::beginChunk(const char* tag) {
+  pad();
+  openChunks.push_back(buffer.size());
+  writeBytes(tag, 4);
+  write<uint32_t>(0); // flags (reserved)
+  write<uint64_t>(0); // payload size, filled in by endChunk()
+}
+
+void SnapshotWriter::endChunk() {
+  pad();
+  size_t chunkStart = openChunks.back();
+  openChunks.pop_back();
+  uint64_t payloadSize = buffer.size() - chunkStart - chunkHeaderSize;
+  std::memcpy(&buffer[chunkStart + 8], &payloadSize, sizeof(payloadSize));
+}
+
+void SnapshotWriter::cancelChunk() {
+  buffer.resize(openChunks.back());
+  openChunks.pop_back();
+}
+
+void SnapshotWriter::writeString(const std::string& str) {
+  write<uint64_t>(str.size());
+  writeBytes(str.data(), str.size());
+}
+
+void SnapshotWriter::writeToFile(std::string filename) {
+  if (!openChunks.empty()) {
+    throw std::logic_error("snapshot has unterminated chunks");
+  }
+  std::ofstream outStream(filename, std::ios::binary);
+  outStream.write(buffer.data(), buffer.size());
+  if (!outStream) {
+    throw std::runtime_error("could not write " + filename);
+  }
+}
+
+void SnapshotWriter::flush(std::ostream& out) {
+  if (!openChunks.empty()) {
+    throw std::logic_error("snapshot has unterminated chunks");
+  }
+  pad(); // (so offsets in the buffer stay aligned in the file)
+  out.write(buffer.data(), buffer.size());
+  buffer.clear();
+}
+
+void SnapshotWriter::writeBytes(const void* bytes, size_t nBytes) {
+  const char* begin = static_cast<const char*>(bytes);
+  buffer.insert(buffer.end(), begin, begin + nBytes);
+}
+
+void SnapshotWriter::pad() { buffer.resize(alignUp(buffer.size()), 0); }
+
+
+// === SnapshotReader
+
+SnapshotReader SnapshotReader::fromFile(std::string filename) {
+  std::ifstream inStream(filename, std::ios::binary | std::ios::ate);
+  if (!inStream) {
+    throw std::runtime_error("could not open " + filename);
+  }
+  std::shared_ptr<std::vector<char>> data = std::make_shared<std::vector<char>>(inStream.tellg());
+  inStream.seekg(0);
+  inStream.read(data->data(), data->size());
+  if (!inStream) {
+    throw std::runtime_error("could not read " + filename);
+  }
+
+  SnapshotReader reader(data, 0, data->size());
+  char magic[sizeof(snapshotMagic)];
+  reader.readBytes(magic, sizeof(magic));
+  if (std::memcmp(magic, snapshotMagic, sizeof(magic)) != 0) {
+    throw std::runtime_error(filename + " is not a polyscope snapshot");
+  }
+  uint32_t version = reader.read<uint32_t>();
+  if (version != snapshotVersion) {
+    throw std::runtime_error(filename + " has unsupported snapshot version " + std::to_string(version));
+  }
+  reader.read<uint32_t>(); // flags
+  return reader;
+}
+
+bool SnapshotReader::atEnd() const { return alignUp(pos) >= end; }
+
+std::string SnapshotReader::peekChunkTag() const {
+  size_t tagStart = alignUp(pos);
+  if (tagStart >= end || end - tagStart < chunkHeaderSize) {
+    return ""; // no room for a chunk
+  }
+  return std::string(&(*data)[tagStart], 4);
+}
+
+bool SnapshotReader::nextChunk(const char* tag, SnapshotReader& payload) {
+  if (peekChunkTag() != std::string(tag, 4)) {
+    return false;
+  }
+
+  skipPadding();
+  pos += 8; // tag and flags
+  uint64_t payloadSize = read<uint64_t>();
+  checkAvailable(payloadSize);
+  payload = SnapshotReader(data, pos, pos + payloadSize);
+  pos += payloadSize;
+  return true;
+}
+
+void SnapshotReader::skipChunk() {
+  std::string tag = peekChunkTag();
+  SnapshotReader payload;
+  if (tag.empty() || !nextChunk(tag.c_str(), payload)) {
+    throw std::runtime_error("snapshot is truncated");
+  }
+}
+
+std::string SnapshotReader::readString() {
+  uint64_t size = read<uint64_t>();
+  checkAvailable(size);
+  std::string str(&(*data)[pos], size);
+  pos += size;
+  return str;
+}
+
+void SnapshotReader::readBytes(void* bytes, size_t nBytes) {
+  checkAvailable(nBytes);
+  if (nBytes > 0) {
+    std::memcpy(bytes, &(*data)[pos], nBytes);
+  }
+  pos += nBytes;
+}
+
+void SnapshotReader::checkAvailable(size_t nBytes) const {
+  if (nBytes > end - pos) {
+    throw std::runtime_error("snapshot is truncated");
+  }
+}
+
+void SnapshotReader::skipPadding() {
+  size_t alignedPos = alignUp(pos);
+  checkAvailable(alignedPos - pos);
+  pos = alignedPos;
+}
+
+} // namespace polyscope
@@ -1,12 +1,61 @@
 // Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
 #include "polyscope/structure.h"
 
+#include "polyscope/options.h"
 #include "polyscope/polyscope.h"
+#include "polyscope/task_scheduler.h"
 
 #include "imgui.h"
 
+#include <cmath>
+#include <limits>
+
 namespace polyscope {
 
+namespace {
+
+// Could any of this box be seen with this (view-projection) matrix? False if all of its corners are outside the same
+// clipping plane, or if it covers less than options::smallFeatureCullingPixels on screen.
+bool boxIsVisible(const glm::mat4& viewProj, glm::vec3 bboxMin, glm::vec3 bboxMax) {
+  int nOutside[6] = {0, 0, 0, 0, 0, 0};
+  bool allInFront = true;
+  glm::vec2 ndcMin{std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity()};
+  glm::vec2 ndcMax = -ndcMin;
+
+  for (int iC = 0; iC < 8; iC++) {
+    glm::vec3 corner{(iC & 1) ? bboxMax.x : bboxMin.x, (iC & 2) ? bboxMax.y : bboxMin.y,
+                     (iC & 4) ? bboxMax.z : bboxMin.z};
+    glm::vec4 p = viewProj * glm::vec4(corner, 1.);
+    for (int iD = 0; iD < 3; iD++) {
+      if (p[iD] < -p.w) nOutside[2 * iD]++;
+      if (p[iD] > p.w) nOutside[2 * iD + 1]++;
+    }
+    if (p.w > 0) {
+      glm::vec2 ndc = glm::vec2(p) / p.w;
+      ndcMin = glm::min(ndcMin, ndc);
+      ndcMax = glm::max(ndcMax, ndc);
+    } else {
+      allInFront = false;
+    }
+  }
+
+  for (int iP = 0; iP < 6; iP++) {
+    if (nOutside[iP] == 8) return false;
+  }
+
+  float minPixels = options::smallFeatureCullingPixels;
+  if (minPixels > 0 && allInFront) {
+    glm::vec2 sizePixels = 0.5f * (ndcMax - ndcMin) * glm::vec2(view::bufferWidth, view::bufferHeight);
+    if (std::max(sizePixels.x, sizePixels.y) < minPixels) return false;
+  }
+
+  return true;
+}
+
+} // namespace
+
+const size_t Structure::cullingChunkSize;
+
 Structure::Structure(std::string name_, std::string subtypeName)
     : name(name_), enabled(subtypeName + "#" + name + "#enabled", true),
       objectTransform(subtypeName + "#" + name + "#object_transform", glm::mat4(1.0)),
@@ -111,7 +160,10 @@ void Structure::buildStructureOptionsUI() {}
 
 void Structure::buildCustomOptionsUI() {}
 
-void Structure::refresh() { requestRedraw(); }
+void Structure::refresh() {
+  markExtentsDirty();
+  requestRedraw();
+}
 
 void Structure::resetTransform() {
   objectTransform = glm::mat4(1.0);
@@ -134,26 +186,165 @@ void Structure::rescaleToUnit() {
   updateStructureExtents();
 }
 
+std::tuple<glm::vec3, glm::vec3> Structure::boundingBox() {
+  ensureExtents();
+  return cachedBoundingBox;
+}
+
+double Structure::lengthScale() {
+  ensureExtents();
+  return cachedLengthScale;
+}
+
+void Structure::markExtentsDirty() {
+  extentsValid = false;
+  cullingChunksValid = false;
+}
+
+void Structure::ensureExtents() {
+  if (extentsValid && extentsTransform == objectTransform.get()) return;
+  computeExtents(cachedBoundingBox, cachedLengthScale);
+  extentsTransform = objectTransform.get();
+  extentsValid = true;
+}
+
+void Structure::computePointExtents(const std::vector<glm::vec3>& points, std::tuple<glm::vec3, glm::vec3>& bboxOut,
+                                    double& lengthScaleOut) {
+
+  const size_t grainSize = 16384;
+  size_t nChunks = tasks::chunkCount(0, points.size(), grainSize);
+  glm::mat4 T = objectTransform.get();
+  auto transformed = [&](size_t i) { return glm::vec3(T * glm::vec4(points[i], 1.0)); };
+
+  // Bounding box, from per-chunk boxes
+  std::vector<glm::vec3> chunkMin(nChunks, glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity());
+  std::vector<glm::vec3> chunkMax(nChunks, -glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity());
+  tasks::parallelFor(0, points.size(), grainSize, [&](size_t begin, size_t end) {
+    size_t iChunk = begin / grainSize;
+    for (size_t i = begin; i < end; i++) {
+      glm::vec3 p = transformed(i);
+      chunkMin[iChunk] = componentwiseMin(chunkMin[iChunk], p);
+      chunkMax[iChunk] = componentwiseMax(chunkMax[iChunk], p);
+    }
+  });
+  glm::vec3 min = glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+  glm::vec3 max = -glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+  for (size_t iChunk = 0; iChunk < nChunks; iChunk++) {
+    min = componentwiseMin(min, chunkMin[iChunk]);
+    max = componentwiseMax(max, chunkMax[iChunk]);
+  }
+  bboxOut = std::make_tuple(min, max);
+
+  // Measure length scale as twice the radius from the center of the bounding box
+  glm::vec3 center = 0.5f * (min + max);
+  std::vector<double> chunkDist2(nChunks, 0.);
+  tasks::parallelFor(0, points.size(), grainSize, [&](size_t begin, size_t end) {
+    size_t iChunk = begin / grainSize;
+    for (size_t i = begin; i < end; i++) {
+      chunkDist2[iChunk] = std::max(chunkDist2[iChunk], (double)glm::length2(transformed(i) - center));
+    }
+  });
+  double maxDist2 = 0.;
+  for (double d2 : chunkDist2) {
+    maxDist2 = std::max(maxDist2, d2);
+  }
+  lengthScaleOut = 2 * std::sqrt(maxDist2);
+}
+
+bool Structure::updateCulling() {
+  visibleDrawRanges.clear();
+  if (!options::frustumCulling) return true;
+
+  double margin = drawMargin();
+  if (!std::isfinite(margin)) return true;
+  glm::vec3 marginVec = glm::vec3{1., 1., 1.} * static_cast<float>(margin);
+
+  // Cull the whole structure
+  glm::mat4 viewProj = render::engine->getFrameUniforms().projMatrix * view::viewMat;
+  std::tuple<glm::vec3, glm::vec3> bbox = boundingBox();
+  if (!boxIsVisible(viewProj, std::get<0>(bbox) - marginVec, std::get<1>(bbox) + marginVec) ||
+      render::engine->boxIsOccluded(viewProj, glm::mat4(1.), std::get<0>(bbox) - marginVec,
+                                    std::get<1>(bbox) + marginVec)) {
+    return false;
+  }
+
+  // Cull chunks
+  if (!cullingChunksValid) {
+    cullingChunks.clear();
+    computeCullingChunks(cullingChunks);
+    cullingChunksValid = true;
+  }
+  if (cullingChunks.empty()) return true;
+
+  // (chunk boxes are in object coordinates, so the margin is scaled in to them)
+  glm::mat4 T = objectTransform.get();
+  float minScale = std::min(std::min(glm::length(glm::vec3(T[0])), glm::length(glm::vec3(T[1]))),
+                            glm::length(glm::vec3(T[2])));
+  glm::vec3 chunkMarginVec = minScale > 0 ? marginVec / minScale : marginVec;
+  glm::mat4 viewProjModel = viewProj * T;
+  for (const CullingChunk& chunk : cullingChunks) {
+    glm::vec3 chunkMin = chunk.bboxMin - chunkMarginVec;
+    glm::vec3 chunkMax = chunk.bboxMax + chunkMarginVec;
+    if (!boxIsVisible(viewProjModel, chunkMin, chunkMax) ||
+        render::engine->boxIsOccluded(viewProj, T, chunkMin, chunkMax)) {
+      continue;
+    }
+
+    // merge neighboring ranges, so a fully visible structure is still one draw
+    if (!visibleDrawRanges.empty() &&
+        visibleDrawRanges.back().start + visibleDrawRanges.back().count == chunk.range.start) {
+      visibleDrawRanges.back().count += chunk.range.count;
+    } else {
+      visibleDrawRanges.push_back(chunk.range);
+    }
+  }
+
+  return !visibleDrawRanges.empty();
+}
+
+const std::vector<DrawRange>& Structure::getVisibleDrawRanges() const { return visibleDrawRanges; }
+
+double Structure::drawMargin() { return 0.; }
+
+double Structure::screenCoverage() {
+  glm::mat4 viewProj = render::engine->getFrameUniforms().projMatrix * view::viewMat;
+  std::tuple<glm::vec3, glm::vec3> bbox = boundingBox();
+  glm::vec3 bboxMin = std::get<0>(bbox);
+  glm::vec3 bboxMax = std::get<1>(bbox);
+
+  glm::vec2 ndcMin{std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity()};
+  glm::vec2 ndcMax = -ndcMin;
+  for (int iC = 0; iC < 8; iC++) {
+    glm::vec3 corner{(iC & 1) ? bboxMax.x : bboxMin.x, (iC & 2) ? bboxMax.y : bboxMin.y,
+                     (iC & 4) ? bboxMax.z : bboxMin.z};
+    glm::vec4 p = viewProj * glm::vec4(corner, 1.);
+    if (p.w <= 0) return 1.;
+    glm::vec2 ndc = glm::vec2(p) / p.w;
+    ndcMin = glm::min(ndcMin, ndc);
+    ndcMax = glm::max(ndcMax, ndc);
+  }
+
+  // (clipped to the screen, which is [-1,1]^2 in NDC)
+  ndcMin = glm::clamp(ndcMin, -1.f, 1.f);
+  ndcMax = glm::clamp(ndcMax, -1.f, 1.f);
+  glm::vec2 extent = ndcMax - ndcMin;
+  return extent.x * extent.y / 4.;
+}
+
+void Structure::computeCullingChunks(std::vector<CullingChunk>& chunksOut) {}
+
 glm::mat4 Structure::getModelView() { return view::getCameraViewMatrix() * objectTransform.get(); }
 
 void Structure::setTransformUniforms(render::ShaderProgram& p) {
+  // (the projection and viewport are shared by all programs, see render::FrameUniforms)
   glm::mat4 viewMat = getModelView();
   p.setUniform("u_modelView", glm::value_ptr(viewMat));
 
-  glm::mat4 projMat = view::getCameraPerspectiveMatrix();
-  p.setUniform("u_projMatrix", glm::value_ptr(projMat));
-
   if (render::engine->transparencyEnabled()) {
     if (p.hasUniform("u_transparency")) {
       p.setUniform("u_transparency", transparency.get());
     }
 
-    if (p.hasUniform("u_viewportDim")) {
-      glm::vec4 viewport = render::engine->getCurrentViewport();
-      glm::vec2 viewportDim{viewport[2], viewport[3]};
-      p.setUniform("u_viewportDim", viewportDim);
-    }
-
     // Attach the min depth texture, if needed
     // (note that this design is somewhat lazy wrt to the name of the function: it sets a texture, not a uniform, and
     // only actually does anything once on initialization)
@@ -167,6 +358,8 @@ std::string Structure::uniquePrefix() { return typeName() + "#" + name + "#"; }
 
 void Structure::remove() { removeStructure(typeName(), name); }
 
+bool Structure::writeSnapshot(SnapshotWriter& writer) { return false; }
+
 
 Structure* Structure::setTransparency(double newVal) {
   transparency = newVal;
@@ -39,16 +39,18 @@ void SurfaceVertexColorQuantity::createProgram() {
   program = render::engine->requestShader("MESH", parent.addStructureRules({"MESH_PROPAGATE_COLOR", "SHADE_COLOR"}));
 
   // Fill color buffers
-  parent.fillGeometryBuffers(*program);
-  fillColorBuffers(*program);
+  std::shared_ptr<const SurfaceMeshLOD> lod = parent.getLevelOfDetailData();
+  parent.fillGeometryBuffers(*program, lod.get());
+  fillColorBuffers(*program, lod.get());
   render::engine->setMaterial(*program, parent.getMaterial());
 }
 
-void SurfaceVertexColorQuantity::fillColorBuffers(render::ShaderProgram& p) {
+void SurfaceVertexColorQuantity::fillColorBuffers(render::ShaderProgram& p, const SurfaceMeshLOD* lod) {
   std::vector<glm::vec3> colorval;
   colorval.reserve(3 * parent.nFacesTriangulation());
 
-  for (size_t iF = 0; iF < parent.nFaces(); iF++) {
+  for (size_t iDraw = 0; iDraw < parent.nFaces(); iDraw++) {
+    size_t iF = parent.drawnFace(iDraw);
     auto& face = parent.faces[iF];
     size_t D = face.size();
 
@@ -63,6 +65,9 @@ void SurfaceVertexColorQuantity::fillColorBuffers(render::ShaderProgram& p) {
       colorval.push_back(values[vC]);
     }
   }
+  if (lod != nullptr) {
+    lod->appendVertexValues(colorval, values);
+  }
 
   // Store data in buffers
   p.setAttribute("a_color", colorval);
@@ -80,6 +85,10 @@ void SurfaceVertexColorQuantity::buildVertexInfoGUI(size_t vInd) {
   ImGui::NextColumn();
 }
 
+std::string SurfaceVertexColorQuantity::snapshotKind() { return "vertexColor"; }
+
+void SurfaceVertexColorQuantity::writeSnapshot(SnapshotWriter& writer) { writer.writeArray(values); }
+
 std::string SurfaceColorQuantity::niceName() { return name + " (" + definedOn + " color)"; }
 
 void SurfaceColorQuantity::refresh() { 
@@ -101,16 +110,18 @@ void SurfaceFaceColorQuantity::createProgram() {
   program = render::engine->requestShader("MESH", parent.addStructureRules({"MESH_PROPAGATE_COLOR", "SHADE_COLOR"}));
 
   // Fill color buffers
-  parent.fillGeometryBuffers(*program);
-  fillColorBuffers(*program);
+  std::shared_ptr<const SurfaceMeshLOD> lod = parent.getLevelOfDetailData();
+  parent.fillGeometryBuffers(*program, lod.get());
+  fillColorBuffers(*program, lod.get());
   render::engine->setMaterial(*program, parent.getMaterial());
 }
 
-void SurfaceFaceColorQuantity::fillColorBuffers(render::ShaderProgram& p) {
+void SurfaceFaceColorQuantity::fillColorBuffers(render::ShaderProgram& p, const SurfaceMeshLOD* lod) {
   std::vector<glm::vec3> colorval;
   colorval.reserve(3 * parent.nFacesTriangulation());
 
-  for (size_t iF = 0; iF < parent.nFaces(); iF++) {
+  for (size_t iDraw = 0; iDraw < parent.nFaces(); iDraw++) {
+    size_t iF = parent.drawnFace(iDraw);
     auto& face = parent.faces[iF];
     size_t D = face.size();
     size_t triDegree = std::max(0, static_cast<int>(D) - 2);
@@ -118,7 +129,9 @@ void SurfaceFaceColorQuantity::fillColorBuffers(render::ShaderProgram& p) {
       colorval.push_back(values[iF]);
     }
   }
-
+  if (lod != nullptr) {
+    lod->appendFaceValues(colorval, values);
+  }
 
   // Store data in buffers
   p.setAttribute("a_color", colorval);
@@ -137,4 +150,8 @@ void SurfaceFaceColorQuantity::buildFaceInfoGUI(size_t fInd) {
   ImGui::NextColumn();
 }
 
+std::string SurfaceFaceColorQuantity::snapshotKind() { return "faceColor"; }
+
+void SurfaceFaceColorQuantity::writeSnapshot(SnapshotWriter& writer) { writer.writeArray(values); }
+
 } // namespace polyscope
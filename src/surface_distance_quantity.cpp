@@ -124,7 +124,8 @@ void SurfaceDistanceQuantity::fillColorBuffers(render::ShaderProgram& p) {
   std::vector<double> colorval;
   colorval.reserve(3 * parent.nFacesTriangulation());
 
-  for (size_t iF = 0; iF < parent.nFaces(); iF++) {
+  for (size_t iDraw = 0; iDraw < parent.nFaces(); iDraw++) {
+    size_t iF = parent.drawnFace(iDraw);
     auto& face = parent.faces[iF];
     size_t D = face.size();
 
@@ -5,9 +5,14 @@
 #include "polyscope/pick.h"
 #include "polyscope/polyscope.h"
 #include "polyscope/render/engine.h"
+#include "polyscope/surface_mesh_draw_order.h"
+#include "polyscope/task_scheduler.h"
 
 #include "imgui.h"
 
+#include <algorithm>
+#include <chrono>
+#include <limits>
 #include <unordered_map>
 #include <utility>
 
@@ -27,12 +32,83 @@ SurfaceMesh::SurfaceMesh(std::string name, const std::vector<glm::vec3>& vertexP
       surfaceColor(uniquePrefix() + "surfaceColor", getNextUniqueColor()),
       edgeColor(uniquePrefix() + "edgeColor", glm::vec3{0., 0., 0.}), material(uniquePrefix() + "material", "clay"),
       edgeWidth(uniquePrefix() + "edgeWidth", 0.),
-      backfacePolicy(uniquePrefix() + "backfacePolicy", BackfacePolicy::Different) {
+      backfacePolicy(uniquePrefix() + "backfacePolicy", BackfacePolicy::Different),
+      levelOfDetail(uniquePrefix() + "levelOfDetail", false) {
 
   computeCounts();
   computeGeometryData();
 }
 
+SurfaceMesh::SurfaceMesh(std::string name, SnapshotReader& reader)
+    : QuantityStructure<SurfaceMesh>(name, typeName()), shadeSmooth(uniquePrefix() + "shadeSmooth", false),
+      surfaceColor(uniquePrefix() + "surfaceColor", getNextUniqueColor()),
+      edgeColor(uniquePrefix() + "edgeColor", glm::vec3{0., 0., 0.}), material(uniquePrefix() + "material", "clay"),
+      edgeWidth(uniquePrefix() + "edgeWidth", 0.),
+      backfacePolicy(uniquePrefix() + "backfacePolicy", BackfacePolicy::Different),
+      levelOfDetail(uniquePrefix() + "levelOfDetail", false) {
+
+  // (in the order written by writeSnapshot())
+  vertices = reader.readArray<glm::vec3>();
+  faces = reader.readNestedArray<size_t>();
+  edgeIndices = reader.readNestedArray<size_t>();
+  halfedgeIndices = reader.readNestedArray<size_t>();
+  nFacesTriangulationCount = reader.read<uint64_t>();
+  nEdgesCount = reader.read<uint64_t>();
+  nCornersCount = reader.read<uint64_t>();
+
+  faceNormals = reader.readArray<glm::vec3>();
+  vertexNormals = reader.readArray<glm::vec3>();
+  faceAreas = reader.readArray<double>();
+  vertexAreas = reader.readArray<double>();
+  edgeLengths = reader.readArray<double>();
+  faceTangentSpaces = reader.readArray<std::array<glm::vec3, 2>>();
+  vertexTangentSpaces = reader.readArray<std::array<glm::vec3, 2>>();
+
+  // The data is used without further checks, so reject the snapshot if it is truncated or corrupt (this is reported
+  // through error() by loadSnapshot())
+  std::string inconsistent = "snapshot data for surface mesh " + name + " is inconsistent";
+  if (edgeIndices.size() != nFaces() || halfedgeIndices.size() != nFaces() || faceNormals.size() != nFaces() ||
+      faceAreas.size() != nFaces() || vertexNormals.size() != nVertices() || vertexAreas.size() != nVertices() ||
+      edgeLengths.size() != nEdges()) {
+    throw std::runtime_error(inconsistent);
+  }
+  // (tangent spaces are empty if they were never set)
+  if ((hasFaceTangentSpaces() && faceTangentSpaces.size() != nFaces()) ||
+      (hasVertexTangentSpaces() && vertexTangentSpaces.size() != nVertices())) {
+    throw std::runtime_error(inconsistent);
+  }
+  size_t nCornersFound = 0;
+  size_t nTrianglesFound = 0;
+  for (size_t iF = 0; iF < nFaces(); iF++) {
+    const std::vector<size_t>& face = faces[iF];
+    if (face.size() < 3 || edgeIndices[iF].size() != face.size() || halfedgeIndices[iF].size() != face.size()) {
+      throw std::runtime_error(inconsistent);
+    }
+    for (size_t j = 0; j < face.size(); j++) {
+      if (face[j] >= nVertices() || edgeIndices[iF][j] >= nEdges() || halfedgeIndices[iF][j] >= nHalfedges()) {
+        throw std::runtime_error(inconsistent);
+      }
+    }
+    nCornersFound += face.size();
+    nTrianglesFound += face.size() - 2;
+  }
+  if (nCornersFound != nCorners() || nTrianglesFound != nFacesTriangulationCount) {
+    throw std::runtime_error(inconsistent);
+  }
+
+  // Default data sizes, as in computeCounts()
+  vertexDataSize = nVertices();
+  faceDataSize = nFaces();
+  edgeDataSize = nEdges();
+  halfedgeDataSize = nHalfedges();
+  cornerDataSize = nCorners();
+}
+
+SurfaceMesh::~SurfaceMesh() {
+  // quantity preparation reads the mesh data, which is destroyed before the quantities are
+  cancelBackgroundPreparation();
+}
+
 
 void SurfaceMesh::computeCounts() {
 
@@ -112,72 +188,89 @@ void SurfaceMesh::computeGeometryData() {
   // Reset edge-valued
   edgeLengths.resize(nEdges());
 
-  // Loop over faces to compute face-valued quantities
-  for (size_t iF = 0; iF < nFaces(); iF++) {
-    auto& face = faces[iF];
-    size_t D = face.size();
+  // Corner angle weighted normal contributions, indexed like halfedges. Computed in parallel with the face quantities,
+  // then summed in to the vertices in order, so the result does not depend on the number of threads.
+  std::vector<glm::vec3> cornerNormalContrib(nHalfedges(), zero);
 
-    glm::vec3 fN = zero;
-    double fA = 0;
-    if (face.size() == 3) {
-      glm::vec3 pA = vertices[face[0]];
-      glm::vec3 pB = vertices[face[1]];
-      glm::vec3 pC = vertices[face[2]];
+  // Loop over faces to compute face-valued quantities
+  tasks::parallelFor(0, nFaces(), 1024, [&](size_t begin, size_t end) {
+    for (size_t iF = begin; iF < end; iF++) {
+      auto& face = faces[iF];
+      size_t D = face.size();
+
+      glm::vec3 fN = zero;
+      double fA = 0;
+      if (face.size() == 3) {
+        glm::vec3 pA = vertices[face[0]];
+        glm::vec3 pB = vertices[face[1]];
+        glm::vec3 pC = vertices[face[2]];
+
+        fN = glm::cross(pB - pA, pC - pA);
+        fA = 0.5 * glm::length(fN);
+      } else if (face.size() > 3) {
+
+        glm::vec3 pRoot = vertices[face[0]];
+        for (size_t j = 0; j < D; j++) {
+          glm::vec3 pA = vertices[face[j]];
+          glm::vec3 pB = vertices[face[(j + 1) % D]];
+          glm::vec3 pC = vertices[face[(j + 2) % D]];
+
+          fN += glm::cross(pC - pB, pA - pB);
+
+          // _some_ definition of area for a non-triangular face
+          if (j != 0 && j != (D - 1)) {
+            fA += 0.5 * glm::length(glm::cross(pA - pRoot, pB - pRoot));
+          }
+        }
+      }
 
-      fN = glm::cross(pB - pA, pC - pA);
-      fA = 0.5 * glm::length(fN);
-    } else if (face.size() > 3) {
+      // Set face values
+      fN = glm::normalize(fN);
+      faceNormals[iF] = fN;
+      faceAreas[iF] = fA;
 
-      glm::vec3 pRoot = vertices[face[0]];
       for (size_t j = 0; j < D; j++) {
         glm::vec3 pA = vertices[face[j]];
         glm::vec3 pB = vertices[face[(j + 1) % D]];
         glm::vec3 pC = vertices[face[(j + 2) % D]];
 
-        fN += glm::cross(pC - pB, pA - pB);
+        // Corner angle for weighting normals
+        double dot = glm::dot(glm::normalize(pB - pA), glm::normalize(pC - pA));
+        float angle = std::acos(glm::clamp(-1., 1., dot));
+        glm::vec3 normalContrib = angle * fN;
 
-        // _some_ definition of area for a non-triangular face
-        if (j != 0 && j != (D - 1)) {
-          fA += 0.5 * glm::length(glm::cross(pA - pRoot, pB - pRoot));
+        if (std::isfinite(normalContrib.x) && std::isfinite(normalContrib.y) && std::isfinite(normalContrib.z)) {
+          cornerNormalContrib[halfedgeIndices[iF][j]] = normalContrib;
         }
       }
     }
+  });
 
-    // Set face values
-    fN = glm::normalize(fN);
-    faceNormals[iF] = fN;
-    faceAreas[iF] = fA;
+  // Update incident vertices
+  for (size_t iF = 0; iF < nFaces(); iF++) {
+    auto& face = faces[iF];
+    size_t D = face.size();
 
-    // Update incident vertices
     for (size_t j = 0; j < D; j++) {
-      glm::vec3 pA = vertices[face[j]];
-      glm::vec3 pB = vertices[face[(j + 1) % D]];
-      glm::vec3 pC = vertices[face[(j + 2) % D]];
-
-      vertexAreas[face[j]] += fA / D;
-
-      // Corner angle for weighting normals
-      double dot = glm::dot(glm::normalize(pB - pA), glm::normalize(pC - pA));
-      float angle = std::acos(glm::clamp(-1., 1., dot));
-      glm::vec3 normalContrib = angle * fN;
-
-      if (std::isfinite(normalContrib.x) && std::isfinite(normalContrib.y) && std::isfinite(normalContrib.z)) {
-        vertexNormals[face[(j + 1) % D]] += normalContrib;
-      }
+      vertexAreas[face[j]] += faceAreas[iF] / D;
+      vertexNormals[face[(j + 1) % D]] += cornerNormalContrib[halfedgeIndices[iF][j]];
 
       // Compute edge lengths while we're at it
-      edgeLengths[edgeIndices[iF][j]] = glm::length(pA - pB);
+      edgeLengths[edgeIndices[iF][j]] = glm::length(vertices[face[j]] - vertices[face[(j + 1) % D]]);
     }
   }
 
 
   // Normalize vertex normals
-  for (auto& vec : vertexNormals) {
-    double L = glm::length(vec);
-    if (L > 0) {
-      vec /= L;
+  tasks::parallelFor(0, nVertices(), 4096, [&](size_t begin, size_t end) {
+    for (size_t iV = begin; iV < end; iV++) {
+      glm::vec3& vec = vertexNormals[iV];
+      double L = glm::length(vec);
+      if (L > 0) {
+        vec /= L;
+      }
     }
-  }
+  });
 }
 
 void SurfaceMesh::ensureHaveManifoldConnectivity() {
@@ -319,6 +412,9 @@ void SurfaceMesh::draw() {
     return;
   }
 
+  updateLevelOfDetail();
+  updateLevelOfDetailRanges();
+
   render::engine->setBackfaceCull(backfacePolicy.get() == BackfacePolicy::Cull);
 
   // If no quantity is drawing the surface, we should draw it
@@ -326,17 +422,17 @@ void SurfaceMesh::draw() {
 
     if (program == nullptr) {
       prepare();
-
-      // do this now to reduce lag when picking later, etc
-      preparePick();
     }
 
-    // Set uniforms
-    setTransformUniforms(*program);
-    setStructureUniforms(*program);
-    program->setUniform("u_baseColor", getSurfaceColor());
+    // (nothing is drawn until the buffers have been prepared)
+    if (program != nullptr) {
+      // Set uniforms
+      setTransformUniforms(*program);
+      setStructureUniforms(*program);
+      program->setUniform("u_baseColor", getSurfaceColor());
 
-    program->draw();
+      program->draw();
+    }
   }
 
   // Draw the quantities
@@ -363,11 +459,30 @@ void SurfaceMesh::drawPick() {
 }
 
 void SurfaceMesh::prepare() {
-  program = render::engine->requestShader("MESH", addStructureRules({"SHADE_BASECOLOR"}));
 
-  // Populate draw buffers
-  fillGeometryBuffers(*program);
-  render::engine->setMaterial(*program, getMaterial());
+  // On the first call, create the program and start assembling its buffers on a worker thread
+  if (!geometryStaging.started()) {
+    preparingProgram = render::engine->requestShader("MESH", addStructureRules({"SHADE_BASECOLOR"}));
+    bool wantsBary = preparingProgram->hasAttribute("a_barycoord");
+    bool wantsEdge = getEdgeWidth() > 0;
+    bool smooth = isSmoothShade();
+    std::shared_ptr<const SurfaceMeshLOD> lodData = lod;
+    geometryStaging.start([=]() { return assembleGeometryBuffers(wantsBary, wantsEdge, smooth, lodData.get()); });
+  }
+
+  // Keep frames coming until the buffers are ready, then upload them
+  if (!geometryStaging.ready()) {
+    requestViewRedraw();
+    return;
+  }
+  geometryStaging.take().uploadTo(*preparingProgram);
+  render::engine->setMaterial(*preparingProgram, getMaterial());
+  program = preparingProgram;
+  preparingProgram.reset();
+  requestRedraw();
+
+  // do this now to reduce lag when picking later, etc
+  preparePick();
 }
 
 void SurfaceMesh::preparePick() {
@@ -406,7 +521,8 @@ void SurfaceMesh::preparePick() {
   normals.reserve(3 * nFacesTriangulation());
 
   // Build all quantities in each face
-  for (size_t iF = 0; iF < nFaces(); iF++) {
+  for (size_t iDraw = 0; iDraw < nFaces(); iDraw++) {
+    size_t iF = drawnFace(iDraw);
     auto& face = faces[iF];
     size_t D = face.size();
     glm::vec3 faceN = faceNormals[iF];
@@ -479,6 +595,7 @@ void SurfaceMesh::preparePick() {
   pickProgram->setAttribute<glm::vec3, 3>("a_edgeColors", edgeColors);
   pickProgram->setAttribute<glm::vec3, 3>("a_halfedgeColors", halfedgeColors);
   pickProgram->setAttribute("a_faceColor", faceColor);
+  pickProgram->setDrawRanges(&visibleDrawRanges);
 }
 
 std::vector<std::string> SurfaceMesh::addStructureRules(std::vector<std::string> initRules) {
@@ -502,15 +619,17 @@ void SurfaceMesh::setStructureUniforms(render::ShaderProgram& p) {
   }
 }
 
-void SurfaceMesh::fillGeometryBuffers(render::ShaderProgram& p) {
+void SurfaceMesh::fillGeometryBuffers(render::ShaderProgram& p, const SurfaceMeshLOD* lod) {
+  assembleGeometryBuffers(p.hasAttribute("a_barycoord"), getEdgeWidth() > 0, isSmoothShade(), lod).uploadTo(p);
+}
+
+render::StagedAttributes SurfaceMesh::assembleGeometryBuffers(bool wantsBary, bool wantsEdge, bool smoothShade,
+                                                              const SurfaceMeshLOD* lod) {
   std::vector<glm::vec3> positions;
   std::vector<glm::vec3> normals;
   std::vector<glm::vec3> bcoord;
   std::vector<glm::vec3> edgeReal;
 
-  bool wantsBary = p.hasAttribute("a_barycoord");
-  bool wantsEdge = (getEdgeWidth() > 0);
-
   positions.reserve(3 * nFacesTriangulation());
   normals.reserve(3 * nFacesTriangulation());
   if (wantsBary) {
@@ -520,7 +639,8 @@ void SurfaceMesh::fillGeometryBuffers(render::ShaderProgram& p) {
     edgeReal.reserve(3 * nFacesTriangulation());
   }
 
-  for (size_t iF = 0; iF < nFaces(); iF++) {
+  for (size_t iDraw = 0; iDraw < nFaces(); iDraw++) {
+    size_t iF = drawnFace(iDraw);
     auto& face = faces[iF];
     size_t D = face.size();
     glm::vec3 faceN = faceNormals[iF];
@@ -538,7 +658,7 @@ void SurfaceMesh::fillGeometryBuffers(render::ShaderProgram& p) {
       positions.push_back(pB);
       positions.push_back(pC);
 
-      if (isSmoothShade()) {
+      if (smoothShade) {
         normals.push_back(vertexNormals[vRoot]);
         normals.push_back(vertexNormals[vB]);
         normals.push_back(vertexNormals[vC]);
@@ -569,15 +689,41 @@ void SurfaceMesh::fillGeometryBuffers(render::ShaderProgram& p) {
     }
   }
 
+  // Simplified triangles (which show all of their edges)
+  if (lod != nullptr) {
+    for (size_t iT = 0; iT < lod->triangles.size(); iT++) {
+      const std::array<size_t, 3>& tri = lod->triangles[iT];
+      glm::vec3 triN = glm::cross(vertices[tri[1]] - vertices[tri[0]], vertices[tri[2]] - vertices[tri[0]]);
+      float triNLen = glm::length(triN);
+      triN = triNLen > 0 ? triN / triNLen : faceNormals[lod->triangleFaces[iT]];
+
+      for (int j = 0; j < 3; j++) {
+        positions.push_back(vertices[tri[j]]);
+        normals.push_back(smoothShade ? vertexNormals[tri[j]] : triN);
+        if (wantsEdge) {
+          edgeReal.push_back(glm::vec3{1., 1., 1.});
+        }
+      }
+      if (wantsBary) {
+        bcoord.push_back(glm::vec3{1., 0., 0.});
+        bcoord.push_back(glm::vec3{0., 1., 0.});
+        bcoord.push_back(glm::vec3{0., 0., 1.});
+      }
+    }
+  }
+
   // Store data in buffers
-  p.setAttribute("a_position", positions);
-  p.setAttribute("a_normal", normals);
+  render::StagedAttributes attributes;
+  attributes.setDrawRanges(lod != nullptr ? &lodDrawRanges : &visibleDrawRanges);
+  attributes.add("a_position", std::move(positions));
+  attributes.add("a_normal", std::move(normals));
   if (wantsBary) {
-    p.setAttribute("a_barycoord", bcoord);
+    attributes.add("a_barycoord", std::move(bcoord));
   }
   if (wantsEdge) {
-    p.setAttribute("a_edgeIsReal", edgeReal);
+    attributes.add("a_edgeIsReal", std::move(edgeReal));
   }
+  return attributes;
 }
 
 void SurfaceMesh::buildPickUI(size_t localPickID) {
@@ -829,44 +975,287 @@ void SurfaceMesh::buildCustomOptionsUI() {
       setBackfacePolicy(BackfacePolicy::Different);
     ImGui::EndMenu();
   }
+
+  if (ImGui::MenuItem("Level of detail", NULL, levelOfDetail.get())) {
+    setLevelOfDetail(!levelOfDetail.get());
+  }
+  if (ImGui::MenuItem("Optimize draw order", NULL, isDrawOrderOptimized())) {
+    setDrawOrderOptimized(!isDrawOrderOptimized());
+  }
 }
 
 
 void SurfaceMesh::refresh() {
+  cancelBackgroundPreparation();
+  lodBuild = std::future<std::shared_ptr<SurfaceMeshLOD>>();
+  lod.reset(); // (rebuilt on the next draw, if enabled)
   computeGeometryData();
   program.reset();
+  preparingProgram.reset();
   pickProgram.reset();
   requestRedraw();
   QuantityStructure<SurfaceMesh>::refresh(); // call base class version, which refreshes quantities
 }
 
+bool SurfaceMesh::writeSnapshot(SnapshotWriter& writer) {
+  // Mesh data, read back by the snapshot constructor
+  writer.writeArray(vertices);
+  writer.writeNestedArray(faces);
+  writer.writeNestedArray(edgeIndices);
+  writer.writeNestedArray(halfedgeIndices);
+  writer.write<uint64_t>(nFacesTriangulationCount);
+  writer.write<uint64_t>(nEdgesCount);
+  writer.write<uint64_t>(nCornersCount);
+  writer.writeArray(faceNormals);
+  writer.writeArray(vertexNormals);
+  writer.writeArray(faceAreas);
+  writer.writeArray(vertexAreas);
+  writer.writeArray(edgeLengths);
+  writer.writeArray(faceTangentSpaces);
+  writer.writeArray(vertexTangentSpaces);
+
+  // Indexing conventions
+  for (const std::vector<size_t>* perm : {&vertexPerm, &facePerm, &edgePerm, &halfedgePerm, &cornerPerm}) {
+    writer.writeArray(*perm);
+  }
+  for (size_t dataSize : {vertexDataSize, faceDataSize, edgeDataSize, halfedgeDataSize, cornerDataSize}) {
+    writer.write<uint64_t>(dataSize);
+  }
+
+  writeQuantitySnapshots(writer);
+  return true;
+}
+
+SurfaceMesh* SurfaceMesh::readSnapshot(std::string name, SnapshotReader& reader) {
+  std::unique_ptr<SurfaceMesh> mesh(new SurfaceMesh(name, reader));
+
+  // The quantity data in the snapshot has already been permuted, so the permutations are only set after reading the
+  // quantities
+  std::array<std::vector<size_t>, 5> perms;
+  std::array<size_t, 5> dataSizes;
+  for (std::vector<size_t>& perm : perms) {
+    perm = reader.readArray<size_t>();
+  }
+  for (size_t& dataSize : dataSizes) {
+    dataSize = reader.read<uint64_t>();
+  }
+
+  // Permutations hold an index in to the user's data for each element
+  std::array<size_t, 5> counts{
+      {mesh->nVertices(), mesh->nFaces(), mesh->nEdges(), mesh->nHalfedges(), mesh->nCorners()}};
+  for (size_t i = 0; i < perms.size(); i++) {
+    bool valid = perms[i].empty() ? dataSizes[i] == counts[i] : perms[i].size() == counts[i];
+    for (size_t ind : perms[i]) {
+      valid = valid && ind < dataSizes[i];
+    }
+    if (!valid) {
+      throw std::runtime_error("snapshot data for surface mesh " + name + " has an invalid permutation");
+    }
+  }
+
+  SurfaceMesh* s = mesh.release();
+  bool success = registerStructure(s);
+  if (!success) {
+    safeDelete(s);
+    return s;
+  }
+
+  s->readQuantitySnapshots(reader);
+
+  s->vertexPerm = perms[0];
+  s->facePerm = perms[1];
+  s->edgePerm = perms[2];
+  s->halfedgePerm = perms[3];
+  s->cornerPerm = perms[4];
+  s->vertexDataSize = dataSizes[0];
+  s->faceDataSize = dataSizes[1];
+  s->edgeDataSize = dataSizes[2];
+  s->halfedgeDataSize = dataSizes[3];
+  s->cornerDataSize = dataSizes[4];
+  return s;
+}
+
+SurfaceMeshQuantity* SurfaceMesh::readQuantitySnapshot(std::string kind, std::string name, SnapshotReader& reader) {
+  // (the permutations are not set yet, so the arrays have exactly one entry per element)
+  if (kind == "vertexScalar" || kind == "faceScalar" || kind == "edgeScalar" || kind == "halfedgeScalar") {
+    DataType type = reader.readEnum(DataType::MAGNITUDE);
+    size_t count = kind == "vertexScalar" ? nVertices()
+                   : kind == "faceScalar" ? nFaces()
+                   : kind == "edgeScalar" ? nEdges()
+                                          : nHalfedges();
+    std::vector<double> values = reader.readArray<double>(count);
+    SurfaceScalarQuantity* q;
+    if (kind == "vertexScalar") {
+      q = addVertexScalarQuantityImpl(name, values, type);
+    } else if (kind == "faceScalar") {
+      q = addFaceScalarQuantityImpl(name, values, type);
+    } else if (kind == "edgeScalar") {
+      q = addEdgeScalarQuantityImpl(name, values, type);
+    } else {
+      q = addHalfedgeScalarQuantityImpl(name, values, type);
+    }
+    q->readScalarSnapshot(reader);
+    return q;
+  }
+  if (kind == "vertexColor") {
+    return addVertexColorQuantityImpl(name, reader.readArray<glm::vec3>(nVertices()));
+  }
+  if (kind == "faceColor") {
+    return addFaceColorQuantityImpl(name, reader.readArray<glm::vec3>(nFaces()));
+  }
+  if (kind == "vertexVector" || kind == "faceVector") {
+    VectorType type = reader.readEnum(VectorType::AMBIENT);
+    std::vector<glm::vec3> vectors = reader.readArray<glm::vec3>(kind == "vertexVector" ? nVertices() : nFaces());
+    if (kind == "vertexVector") {
+      return addVertexVectorQuantityImpl(name, vectors, type);
+    }
+    return addFaceVectorQuantityImpl(name, vectors, type);
+  }
+  if (kind == "cornerParameterization" || kind == "vertexParameterization") {
+    ParamCoordsType type = reader.readEnum(ParamCoordsType::WORLD);
+    ParamVizStyle style = reader.readEnum(ParamVizStyle::LOCAL_RAD);
+    std::vector<glm::vec2> coords =
+        reader.readArray<glm::vec2>(kind == "cornerParameterization" ? nCorners() : nVertices());
+    SurfaceParameterizationQuantity* q;
+    if (kind == "cornerParameterization") {
+      q = addParameterizationQuantityImpl(name, coords, type);
+    } else {
+      q = addVertexParameterizationQuantityImpl(name, coords, type);
+    }
+    q->setStyle(style);
+    return q;
+  }
+  return nullptr;
+}
+
 void SurfaceMesh::geometryChanged() { refresh(); }
 
-double SurfaceMesh::lengthScale() {
-  // Measure length scale as twice the radius from the center of the bounding box
-  auto bound = boundingBox();
-  glm::vec3 center = 0.5f * (std::get<0>(bound) + std::get<1>(bound));
+void SurfaceMesh::cancelBackgroundPreparation() {
+  geometryStaging.cancel();
+  if (lodBuild.valid()) {
+    lodBuild.wait();
+  }
+  for (auto& q : quantities) {
+    q.second->cancelBackgroundPreparation();
+  }
+}
+
+void SurfaceMesh::computeExtents(std::tuple<glm::vec3, glm::vec3>& bboxOut, double& lengthScaleOut) {
+  computePointExtents(vertices, bboxOut, lengthScaleOut);
+}
+
+void SurfaceMesh::computeCullingChunks(std::vector<CullingChunk>& chunksOut) {
+  // Runs of consecutive faces, with about cullingChunkSize triangles each. Drawing data has 3 vertices per triangle.
+  if (nFacesTriangulation() <= cullingChunkSize) return;
+
+  CullingChunk chunk;
+  size_t chunkStartTri = 0;
+  size_t iTri = 0;
+  auto startChunk = [&]() {
+    chunk.bboxMin = glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+    chunk.bboxMax = -glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+    chunkStartTri = iTri;
+  };
+  auto endChunk = [&]() {
+    chunk.range = DrawRange{static_cast<uint32_t>(3 * chunkStartTri),
+                            static_cast<uint32_t>(3 * (iTri - chunkStartTri))};
+    chunksOut.push_back(chunk);
+  };
+
+  startChunk();
+  for (const std::vector<size_t>& face : faces) {
+    if (face.size() < 3) continue;
+    for (size_t iV : face) {
+      chunk.bboxMin = componentwiseMin(chunk.bboxMin, vertices[iV]);
+      chunk.bboxMax = componentwiseMax(chunk.bboxMax, vertices[iV]);
+    }
+    iTri += face.size() - 2;
+    if (iTri - chunkStartTri >= cullingChunkSize) {
+      endChunk();
+      startChunk();
+    }
+  }
+  if (iTri > chunkStartTri) {
+    endChunk();
+  }
+}
+
+void SurfaceMesh::updateLevelOfDetail() {
+  if (!levelOfDetail.get()) return;
 
-  double lengthScale = 0.0;
-  for (glm::vec3 p : vertices) {
-    glm::vec3 transPos = glm::vec3(objectTransform.get() * glm::vec4(p.x, p.y, p.z, 1.0));
-    lengthScale = std::max(lengthScale, (double)glm::length2(transPos - center));
+  if (lod == nullptr && !lodBuild.valid()) {
+    lodBuild = tasks::async([this]() { return buildSurfaceMeshLOD(vertices, faces, cullingChunkSize); });
   }
 
-  return 2 * std::sqrt(lengthScale);
+  // Keep frames coming until it is ready, then rebuild the programs with it
+  if (lodBuild.valid()) {
+    if (lodBuild.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+      requestViewRedraw();
+      return;
+    }
+    lod = lodBuild.get();
+    drawDataChanged();
+  }
 }
 
-std::tuple<glm::vec3, glm::vec3> SurfaceMesh::boundingBox() {
-  glm::vec3 min = glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
-  glm::vec3 max = -glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+void SurfaceMesh::updateLevelOfDetailRanges() {
+  lodDrawRanges.clear();
+  if (lod == nullptr) return;
+
+  // Pixels on screen per unit of length in world space, at unit depth (or any depth for an orthographic camera)
+  const glm::mat4& P = render::engine->getFrameUniforms().projMatrix;
+  bool perspective = P[3][3] == 0.;
+  double pixelsPerUnit = 0.5 * P[1][1] * view::bufferHeight;
+  glm::mat4 T = objectTransform.get();
+  double scale = std::max(std::max(glm::length(glm::vec3(T[0])), glm::length(glm::vec3(T[1]))),
+                          glm::length(glm::vec3(T[2])));
+  glm::mat4 modelView = view::viewMat * T;
+  double maxPixelError = options::lodPixelError;
+
+  size_t iVisible = 0;
+  for (const SurfaceMeshLOD::Chunk& chunk : lod->chunks) {
+    DrawRange range{static_cast<uint32_t>(3 * chunk.fullTriangleStart),
+                    static_cast<uint32_t>(3 * chunk.fullTriangleCount)};
+
+    // Skip chunks which were culled (if there are visible ranges, otherwise everything is visible)
+    if (!visibleDrawRanges.empty()) {
+      while (iVisible < visibleDrawRanges.size() &&
+             visibleDrawRanges[iVisible].start + visibleDrawRanges[iVisible].count <= range.start) {
+        iVisible++;
+      }
+      if (iVisible == visibleDrawRanges.size() || visibleDrawRanges[iVisible].start > range.start) continue;
+    }
+
+    // The coarsest version with a small enough error at the nearest depth of the chunk
+    glm::vec3 center = 0.5f * (chunk.bboxMin + chunk.bboxMax);
+    double radius = 0.5 * glm::length(chunk.bboxMax - chunk.bboxMin) * scale;
+    double depth = -(modelView * glm::vec4(center, 1.)).z - radius;
+    if (!perspective || depth > 0.) {
+      double pixelsPerError = scale * (perspective ? pixelsPerUnit / depth : pixelsPerUnit);
+      for (const SurfaceMeshLOD::Level& level : chunk.levels) {
+        if (level.error * pixelsPerError > maxPixelError) break;
+        range = DrawRange{static_cast<uint32_t>(3 * (nFacesTriangulationCount + level.triangleStart)),
+                          static_cast<uint32_t>(3 * level.triangleCount)};
+      }
+    }
 
-  for (glm::vec3 pOrig : vertices) {
-    glm::vec3 p = glm::vec3(objectTransform.get() * glm::vec4(pOrig, 1.0));
-    min = componentwiseMin(min, p);
-    max = componentwiseMax(max, p);
+    if (!lodDrawRanges.empty() && lodDrawRanges.back().start + lodDrawRanges.back().count == range.start) {
+      lodDrawRanges.back().count += range.count;
+    } else {
+      lodDrawRanges.push_back(range);
+    }
   }
+}
 
-  return std::make_tuple(min, max);
+void SurfaceMesh::drawDataChanged() {
+  geometryStaging.cancel();
+  program.reset();
+  preparingProgram.reset();
+  pickProgram.reset();
+  for (auto& q : quantities) {
+    q.second->refresh();
+  }
+  requestRedraw();
 }
 
 std::string SurfaceMesh::typeName() { return structureTypeName; }
@@ -1071,6 +1460,42 @@ SurfaceMesh* SurfaceMesh::setBackfacePolicy(BackfacePolicy newPolicy) {
 }
 BackfacePolicy SurfaceMesh::getBackfacePolicy() { return backfacePolicy.get(); }
 
+SurfaceMesh* SurfaceMesh::setLevelOfDetail(bool enabled) {
+  levelOfDetail = enabled;
+  if (enabled) {
+    updateLevelOfDetail();
+  } else {
+    if (lodBuild.valid()) {
+      lodBuild.wait();
+      lodBuild = std::future<std::shared_ptr<SurfaceMeshLOD>>();
+    }
+    if (lod != nullptr) {
+      lod.reset();
+      drawDataChanged();
+    }
+  }
+  requestRedraw();
+  return this;
+}
+
+bool SurfaceMesh::isLevelOfDetail() { return levelOfDetail.get(); }
+
+std::shared_ptr<const SurfaceMeshLOD> SurfaceMesh::getLevelOfDetailData() { return lod; }
+
+SurfaceMesh* SurfaceMesh::setDrawOrderOptimized(bool enabled) {
+  if (enabled == isDrawOrderOptimized()) return this;
+  cancelBackgroundPreparation();
+  if (enabled) {
+    faceDrawOrder = computeOptimizedFaceOrder(vertices, faces, cullingChunkSize);
+  } else {
+    faceDrawOrder.clear();
+  }
+  drawDataChanged();
+  return this;
+}
+
+bool SurfaceMesh::isDrawOrderOptimized() { return !faceDrawOrder.empty(); }
+
 // === Quantity adders
 
 
@@ -0,0 +1,211 @@
+// Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
+#include "polyscope/surface_mesh_draw_order.h"
+
+#include "polyscope/task_scheduler.h"
+
+#include "glm/glm.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+namespace polyscope {
+
+namespace {
+
+// The number of recently used vertices which are considered cheap to reuse while choosing the next vertex to fan around
+const size_t cacheSize = 16;
+
+// Clusters for sorting end where the fanning gets stuck, or once they have this many faces
+const size_t maxClusterFaces = 64;
+
+struct FaceRun {
+  size_t faceBegin, faceEnd;
+};
+
+void orderRun(const std::vector<glm::vec3>& vertices, const std::vector<std::vector<size_t>>& faces,
+              const FaceRun& run, glm::dvec3 meshCenter, std::vector<size_t>& orderOut) {
+
+  // Local vertex indices, in order of global index
+  std::vector<size_t> globalInds;
+  for (size_t iF = run.faceBegin; iF < run.faceEnd; iF++) {
+    if (faces[iF].size() < 3) continue;
+    globalInds.insert(globalInds.end(), faces[iF].begin(), faces[iF].end());
+  }
+  std::sort(globalInds.begin(), globalInds.end());
+  globalInds.erase(std::unique(globalInds.begin(), globalInds.end()), globalInds.end());
+  auto localInd = [&](size_t iV) {
+    return static_cast<uint32_t>(std::lower_bound(globalInds.begin(), globalInds.end(), iV) - globalInds.begin());
+  };
+  size_t nV = globalInds.size();
+
+  // Faces around each vertex, as offsets from the start of the run, and the number of them not yet ordered
+  std::vector<uint32_t> live(nV, 0);
+  for (size_t iF = run.faceBegin; iF < run.faceEnd; iF++) {
+    if (faces[iF].size() < 3) continue;
+    for (size_t iV : faces[iF]) live[localInd(iV)]++;
+  }
+  std::vector<size_t> adjacentStart(nV + 1, 0);
+  for (size_t i = 0; i < nV; i++) adjacentStart[i + 1] = adjacentStart[i] + live[i];
+  std::vector<uint32_t> adjacent(adjacentStart.back());
+  std::vector<size_t> adjacentFill(adjacentStart.begin(), adjacentStart.end() - 1);
+  for (size_t iF = run.faceBegin; iF < run.faceEnd; iF++) {
+    if (faces[iF].size() < 3) continue;
+    for (size_t iV : faces[iF]) adjacent[adjacentFill[localInd(iV)]++] = static_cast<uint32_t>(iF - run.faceBegin);
+  }
+
+  // == Fan around vertices, preferring ones which were used recently and have few faces left
+  const uint32_t noVertex = std::numeric_limits<uint32_t>::max();
+  std::vector<char> emitted(run.faceEnd - run.faceBegin, false);
+  std::vector<size_t> cacheTime(nV, 0);
+  size_t time = cacheSize + 1;
+  std::vector<uint32_t> deadEnds; // recently used vertices, to continue from when fanning gets stuck
+  std::vector<uint32_t> candidates;
+  size_t scanCursor = 0;
+
+  std::vector<size_t> order;
+  std::vector<size_t> clusterStarts;
+  bool stuck = true;
+  uint32_t fan = nV > 0 ? 0 : noVertex;
+  while (fan != noVertex) {
+    if (clusterStarts.empty() || (order.size() > clusterStarts.back() &&
+                                  (stuck || order.size() - clusterStarts.back() >= maxClusterFaces))) {
+      clusterStarts.push_back(order.size());
+    }
+
+    candidates.clear();
+    for (size_t i = adjacentStart[fan]; i < adjacentStart[fan + 1]; i++) {
+      uint32_t f = adjacent[i];
+      if (emitted[f]) continue;
+      emitted[f] = true;
+      order.push_back(run.faceBegin + f);
+      for (size_t iV : faces[run.faceBegin + f]) {
+        uint32_t v = localInd(iV);
+        deadEnds.push_back(v);
+        candidates.push_back(v);
+        live[v]--;
+        if (time - cacheTime[v] > cacheSize) {
+          cacheTime[v] = time;
+          time++;
+        }
+      }
+    }
+
+    // Next, the candidate which is still in the cache after its remaining faces are drawn, and oldest in it
+    uint32_t next = noVertex;
+    int64_t bestPriority = -1;
+    for (uint32_t v : candidates) {
+      if (live[v] == 0) continue;
+      int64_t priority = 0;
+      if (time - cacheTime[v] + 2 * live[v] <= cacheSize) {
+        priority = static_cast<int64_t>(time - cacheTime[v]);
+      }
+      if (priority > bestPriority) {
+        bestPriority = priority;
+        next = v;
+      }
+    }
+
+    // Otherwise, the most recently used vertex with faces left, or any vertex with faces left
+    stuck = next == noVertex;
+    while (next == noVertex && !deadEnds.empty()) {
+      uint32_t v = deadEnds.back();
+      deadEnds.pop_back();
+      if (live[v] > 0) next = v;
+    }
+    while (next == noVertex && scanCursor < nV) {
+      if (live[scanCursor] > 0) next = static_cast<uint32_t>(scanCursor);
+      scanCursor++;
+    }
+    fan = next;
+  }
+
+  // == Sort clusters so those facing outwards from the center of the mesh come first
+  struct Cluster {
+    size_t start, end;
+    double outwardness;
+  };
+  std::vector<Cluster> clusters;
+  for (size_t iC = 0; iC < clusterStarts.size(); iC++) {
+    Cluster cluster{clusterStarts[iC], iC + 1 < clusterStarts.size() ? clusterStarts[iC + 1] : order.size(), 0.};
+
+    // (area-weighted)
+    glm::dvec3 normalSum{0., 0., 0.};
+    glm::dvec3 centerSum{0., 0., 0.};
+    double areaSum = 0.;
+    for (size_t i = cluster.start; i < cluster.end; i++) {
+      const std::vector<size_t>& face = faces[order[i]];
+      glm::dvec3 pRoot = vertices[face[0]];
+      for (size_t j = 1; j + 1 < face.size(); j++) {
+        glm::dvec3 pB = vertices[face[j]];
+        glm::dvec3 pC = vertices[face[j + 1]];
+        glm::dvec3 areaNormal = glm::cross(pB - pRoot, pC - pRoot);
+        double area = glm::length(areaNormal);
+        normalSum += areaNormal;
+        centerSum += area * (pRoot + pB + pC) / 3.;
+        areaSum += area;
+      }
+    }
+    double normalLen = glm::length(normalSum);
+    if (areaSum > 0. && normalLen > 0.) {
+      cluster.outwardness = glm::dot(centerSum / areaSum - meshCenter, normalSum / normalLen);
+    }
+    clusters.push_back(cluster);
+  }
+  std::stable_sort(clusters.begin(), clusters.end(),
+                   [](const Cluster& a, const Cluster& b) { return a.outwardness > b.outwardness; });
+
+  orderOut.clear();
+  orderOut.reserve(run.faceEnd - run.faceBegin);
+  for (const Cluster& cluster : clusters) {
+    orderOut.insert(orderOut.end(), order.begin() + cluster.start, order.begin() + cluster.end);
+  }
+
+  // Faces with no triangles, which are not drawn
+  for (size_t iF = run.faceBegin; iF < run.faceEnd; iF++) {
+    if (faces[iF].size() < 3) orderOut.push_back(iF);
+  }
+}
+
+} // namespace
+
+std::vector<size_t> computeOptimizedFaceOrder(const std::vector<glm::vec3>& vertices,
+                                              const std::vector<std::vector<size_t>>& faces, size_t chunkTriangles) {
+
+  // Split the faces in to runs, the same way as SurfaceMesh::computeCullingChunks()
+  std::vector<FaceRun> runs;
+  FaceRun run{0, 0};
+  size_t runTriangles = 0;
+  for (size_t iF = 0; iF < faces.size(); iF++) {
+    if (faces[iF].size() >= 3) runTriangles += faces[iF].size() - 2;
+    run.faceEnd = iF + 1;
+    if (runTriangles >= chunkTriangles) {
+      runs.push_back(run);
+      run = FaceRun{iF + 1, iF + 1};
+      runTriangles = 0;
+    }
+  }
+  if (run.faceEnd > run.faceBegin) {
+    runs.push_back(run);
+  }
+
+  glm::dvec3 meshCenter{0., 0., 0.};
+  for (const glm::vec3& p : vertices) meshCenter += glm::dvec3(p);
+  if (!vertices.empty()) meshCenter /= static_cast<double>(vertices.size());
+
+  std::vector<std::vector<size_t>> runOrders(runs.size());
+  tasks::parallelFor(0, runs.size(), 1, [&](size_t begin, size_t end) {
+    for (size_t iR = begin; iR < end; iR++) {
+      orderRun(vertices, faces, runs[iR], meshCenter, runOrders[iR]);
+    }
+  });
+
+  std::vector<size_t> order;
+  order.reserve(faces.size());
+  for (const std::vector<size_t>& runOrder : runOrders) {
+    order.insert(order.end(), runOrder.begin(), runOrder.end());
+  }
+  return order;
+}
+
+} // namespace polyscope
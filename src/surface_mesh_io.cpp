@@ -2,10 +2,15 @@
 #include "polyscope/surface_mesh_io.h"
 
 #include "polyscope/messages.h"
+#include "polyscope/task_scheduler.h"
 
 #include "happly.h"
 
 #include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
 
 namespace polyscope {
 
@@ -14,44 +19,91 @@ namespace polyscope {
 // TODO factor this out in to something neat like happly
 namespace {
 
-class Index {
-public:
-  Index() {}
+// The file is split in to chunks of about this many bytes, which are parsed in parallel
+const size_t objChunkBytes = 1 << 20;
 
-  Index(int v, int vt, int vn) : position(v), uv(vt), normal(vn) {}
-
-  bool operator<(const Index& i) const {
-    if (position < i.position) return true;
-    if (position > i.position) return false;
-    if (uv < i.uv) return true;
-    if (uv > i.uv) return false;
-    if (normal < i.normal) return true;
-    if (normal > i.normal) return false;
+// Everything parsed from one chunk of an OBJ file
+struct OBJChunk {
+  std::vector<std::array<double, 3>> vertices;
+  std::vector<std::vector<long long>> faces; // indices as written in the file: 1-based, or negative to count backwards
+  std::vector<size_t> faceVertexCount;       // number of vertices in this chunk which precede each face
+};
 
-    return false;
-  }
+bool isOBJSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f'; }
 
-  int position;
-  int uv;
-  int normal;
-};
+// Find the end of the line starting at p, following backslash line continuations
+const char* findOBJLineEnd(const char* p, const char* end) {
+  while (true) {
+    const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    if (lineEnd == nullptr) return end;
 
-Index parseFaceIndex(const std::string& token) {
-  std::stringstream in(token);
-  std::string indexString;
-  int indices[3] = {1, 1, 1};
+    const char* last = lineEnd;
+    while (last > p && *(last - 1) == '\r') last--;
+    if (last == p || *(last - 1) != '\\') return lineEnd;
+    p = lineEnd + 1;
+  }
+}
 
-  int i = 0;
-  while (std::getline(in, indexString, '/')) {
-    if (indexString != "\\") {
-      std::stringstream ss(indexString);
-      ss >> indices[i++];
+// Parse one (logical) line, not including its final newline. Data is null-terminated somewhere after end.
+void parseOBJLine(const char* p, const char* end, OBJChunk& chunk) {
+
+  auto skipSpace = [&]() {
+    while (p < end && isOBJSpace(*p)) p++;
+  };
+  auto tokenEnd = [&]() {
+    const char* e = p;
+    while (e < end && !isOBJSpace(*e)) e++;
+    return e;
+  };
+
+  skipSpace();
+  const char* keywordEnd = tokenEnd();
+  std::string keyword(p, keywordEnd);
+  p = keywordEnd;
+
+  if (keyword == "v") {
+    std::array<double, 3> pos{{0., 0., 0.}};
+    for (int i = 0; i < 3; i++) {
+      skipSpace();
+      if (p == end) break;
+      char* next;
+      pos[i] = std::strtod(p, &next);
+      p = next;
     }
+    chunk.vertices.push_back(pos);
+
+  } else if (keyword == "f") {
+    std::vector<long long> face;
+    while (true) {
+      skipSpace();
+      if (p == end) break;
+      const char* tokEnd = tokenEnd();
+
+      // Only the position index matters; texture coordinate and normal indices after a '/' are ignored
+      if (!(tokEnd - p == 1 && *p == '\\')) {
+        char* next;
+        long long index = std::strtoll(p, &next, 10);
+        if (next == p) index = 1; // missing position index
+        face.push_back(index);
+      }
+      p = tokEnd;
+    }
+
+    chunk.faces.push_back(face);
+    chunk.faceVertexCount.push_back(chunk.vertices.size());
   }
 
-  // decrement since indices in OBJ files are 1-based
-  return Index(indices[0] - 1, indices[1] - 1, indices[2] - 1);
+  // "vt", "vn", and everything else: do nothing
+}
+
+void parseOBJChunk(const char* p, const char* end, OBJChunk& chunk) {
+  while (p < end) {
+    const char* lineEnd = findOBJLineEnd(p, end);
+    parseOBJLine(p, lineEnd, chunk);
+    p = lineEnd + 1;
+  }
 }
+
 } // namespace
 
 
@@ -63,43 +115,63 @@ void loadPolygonSoup_OBJ(std::string filename, std::vector<std::array<double, 3>
   vertexPositionsOut.clear();
 
   // Open the file
-  std::ifstream in(filename);
+  std::ifstream in(filename, std::ios::binary);
   if (!in) throw std::invalid_argument("Could not open mesh file " + filename);
 
-  // parse obj format
-  std::string line;
-  while (getline(in, line)) {
-    std::stringstream ss(line);
-    std::string token;
-
-    ss >> token;
-
-    if (token == "v") {
-      double x, y, z;
-      ss >> x >> y >> z;
-
-      vertexPositionsOut.push_back({{x, y, z}});
-
-    } else if (token == "vt") {
-      // Do nothing
-
-    } else if (token == "vn") {
-      // Do nothing
+  // Read it all at once
+  std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  const char* dataBegin = data.c_str();
+  const char* dataEnd = dataBegin + data.size();
+
+  // Split in to chunks at line boundaries
+  std::vector<const char*> chunkStarts;
+  for (const char* p = dataBegin; p < dataEnd;) {
+    chunkStarts.push_back(p);
+    if (static_cast<size_t>(dataEnd - p) <= objChunkBytes) break;
+
+    // Cut after the line containing the cut point. Search from the start of its physical line, so that a backslash
+    // continuation just before the cut point is followed.
+    const char* cut = p + objChunkBytes;
+    while (cut > p && *(cut - 1) != '\n') cut--;
+    p = findOBJLineEnd(cut, dataEnd) + 1;
+  }
 
-    } else if (token == "f") {
-      std::vector<size_t> face;
-      while (ss >> token) {
-        Index index = parseFaceIndex(token);
-        if (index.position < 0) {
-          getline(in, line);
-          size_t i = line.find_first_not_of("\t\n\v\f\r ");
-          index = parseFaceIndex(line.substr(i));
+  // Parse the chunks in parallel
+  std::vector<OBJChunk> chunks(chunkStarts.size());
+  tasks::parallelFor(0, chunks.size(), 1, [&](size_t begin, size_t end) {
+    for (size_t iC = begin; iC < end; iC++) {
+      const char* chunkEnd = iC + 1 < chunkStarts.size() ? chunkStarts[iC + 1] : dataEnd;
+      parseOBJChunk(chunkStarts[iC], chunkEnd, chunks[iC]);
+    }
+  });
+
+  // Gather the results, resolving indices to 0-based
+  size_t nVertices = 0;
+  size_t nFaces = 0;
+  for (const OBJChunk& chunk : chunks) {
+    nVertices += chunk.vertices.size();
+    nFaces += chunk.faces.size();
+  }
+  vertexPositionsOut.reserve(nVertices);
+  faceIndicesOut.reserve(nFaces);
+
+  for (OBJChunk& chunk : chunks) {
+    size_t nVerticesBefore = vertexPositionsOut.size();
+    vertexPositionsOut.insert(vertexPositionsOut.end(), chunk.vertices.begin(), chunk.vertices.end());
+
+    for (size_t iF = 0; iF < chunk.faces.size(); iF++) {
+      const std::vector<long long>& face = chunk.faces[iF];
+      long long nVerticesSoFar = nVerticesBefore + chunk.faceVertexCount[iF];
+
+      std::vector<size_t> faceOut(face.size());
+      for (size_t j = 0; j < face.size(); j++) {
+        long long index = face[j] > 0 ? face[j] - 1 : nVerticesSoFar + face[j];
+        if (face[j] == 0 || index < 0) {
+          throw std::invalid_argument("Invalid face index in mesh file " + filename);
         }
-
-        face.push_back(index.position);
+        faceOut[j] = index;
       }
-
-      faceIndicesOut.push_back(face);
+      faceIndicesOut.push_back(std::move(faceOut));
     }
   }
 }
@@ -0,0 +1,381 @@
+// Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
+#include "polyscope/surface_mesh_lod.h"
+
+#include "polyscope/task_scheduler.h"
+#include "polyscope/utilities.h"
+
+#include "glm/glm.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+
+namespace polyscope {
+
+namespace {
+
+// Chunks are not simplified past this many triangles
+const size_t minLevelTriangles = 32;
+
+// A sum of squared distances to planes, as a symmetric 4x4 matrix
+struct Quadric {
+  double a[10] = {0., 0., 0., 0., 0., 0., 0., 0., 0., 0.};
+
+  void addPlane(glm::dvec3 n, double d) {
+    a[0] += n.x * n.x;
+    a[1] += n.x * n.y;
+    a[2] += n.x * n.z;
+    a[3] += n.x * d;
+    a[4] += n.y * n.y;
+    a[5] += n.y * n.z;
+    a[6] += n.y * d;
+    a[7] += n.z * n.z;
+    a[8] += n.z * d;
+    a[9] += d * d;
+  }
+
+  Quadric& operator+=(const Quadric& other) {
+    for (int i = 0; i < 10; i++) a[i] += other.a[i];
+    return *this;
+  }
+
+  double evaluate(glm::dvec3 p) const {
+    double x = p.x, y = p.y, z = p.z;
+    return a[0] * x * x + 2. * a[1] * x * y + 2. * a[2] * x * z + 2. * a[3] * x + a[4] * y * y + 2. * a[5] * y * z +
+           2. * a[6] * y + a[7] * z * z + 2. * a[8] * z + a[9];
+  }
+};
+
+// Moving vertex `from` on to vertex `to`. Stale once either vertex has changed since.
+struct Collapse {
+  double cost;
+  uint32_t from, to;
+  uint32_t fromVersion, toVersion;
+  bool operator>(const Collapse& other) const { return cost > other.cost; }
+};
+
+// Edge collapse simplification of one chunk, in local vertex indices
+class ChunkSimplifier {
+public:
+  ChunkSimplifier(const std::vector<glm::dvec3>& positions_, std::vector<std::array<uint32_t, 3>> triangles_,
+                  const std::vector<char>& locked_)
+      : positions(positions_), triangles(std::move(triangles_)), locked(locked_), quadrics(positions.size()),
+        vertexTriangles(positions.size()), vertexAlive(positions.size(), true), vertexVersion(positions.size(), 0),
+        triangleAlive(triangles.size(), true), nLive(triangles.size()) {
+
+    for (uint32_t iT = 0; iT < triangles.size(); iT++) {
+      const std::array<uint32_t, 3>& tri = triangles[iT];
+      glm::dvec3 n = glm::cross(positions[tri[1]] - positions[tri[0]], positions[tri[2]] - positions[tri[0]]);
+      double len = glm::length(n);
+      if (len > 0.) n /= len;
+      double d = -glm::dot(n, positions[tri[0]]);
+      for (uint32_t iV : tri) {
+        quadrics[iV].addPlane(n, d);
+        vertexTriangles[iV].push_back(iT);
+      }
+    }
+
+    for (const std::array<uint32_t, 3>& tri : triangles) {
+      for (int j = 0; j < 3; j++) {
+        pushCandidate(tri[j], tri[(j + 1) % 3]);
+        pushCandidate(tri[(j + 1) % 3], tri[j]);
+      }
+    }
+  }
+
+  // Collapse edges in order of cost until at most targetCount triangles are left, or nothing more can be collapsed
+  void simplifyTo(size_t targetCount) {
+    while (nLive > targetCount && !candidates.empty()) {
+      Collapse c = candidates.top();
+      candidates.pop();
+      if (!vertexAlive[c.from] || !vertexAlive[c.to] || vertexVersion[c.from] != c.fromVersion ||
+          vertexVersion[c.to] != c.toVersion) {
+        continue;
+      }
+      if (!canCollapse(c.from, c.to)) continue;
+      collapse(c.from, c.to);
+      maxCost = std::max(maxCost, c.cost);
+    }
+  }
+
+  size_t triangleCount() const { return nLive; }
+  double error() const { return std::sqrt(maxCost); }
+
+  // Call f(original triangle index, current vertices) for each remaining triangle
+  void forEachTriangle(const std::function<void(size_t, const std::array<uint32_t, 3>&)>& f) const {
+    for (size_t iT = 0; iT < triangles.size(); iT++) {
+      if (triangleAlive[iT]) f(iT, triangles[iT]);
+    }
+  }
+
+private:
+  const std::vector<glm::dvec3>& positions;
+  std::vector<std::array<uint32_t, 3>> triangles;
+  const std::vector<char>& locked;
+
+  std::vector<Quadric> quadrics;
+  std::vector<std::vector<uint32_t>> vertexTriangles;
+  std::vector<char> vertexAlive;
+  std::vector<uint32_t> vertexVersion;
+  std::vector<char> triangleAlive;
+  size_t nLive;
+  double maxCost = 0.;
+
+  std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> candidates;
+  std::vector<uint32_t> neighborsFrom, neighborsTo; // (scratch space)
+
+  void pushCandidate(uint32_t from, uint32_t to) {
+    if (locked[from]) return;
+    Quadric q = quadrics[from];
+    q += quadrics[to];
+    candidates.push(Collapse{q.evaluate(positions[to]), from, to, vertexVersion[from], vertexVersion[to]});
+  }
+
+  void collectNeighbors(uint32_t iV, std::vector<uint32_t>& neighborsOut) {
+    neighborsOut.clear();
+    for (uint32_t iT : vertexTriangles[iV]) {
+      if (!triangleAlive[iT]) continue;
+      for (uint32_t iN : triangles[iT]) {
+        if (iN != iV) neighborsOut.push_back(iN);
+      }
+    }
+    std::sort(neighborsOut.begin(), neighborsOut.end());
+    neighborsOut.erase(std::unique(neighborsOut.begin(), neighborsOut.end()), neighborsOut.end());
+  }
+
+  bool triangleHas(uint32_t iT, uint32_t iV) const {
+    const std::array<uint32_t, 3>& tri = triangles[iT];
+    return tri[0] == iV || tri[1] == iV || tri[2] == iV;
+  }
+
+  bool canCollapse(uint32_t from, uint32_t to) {
+    collectNeighbors(from, neighborsFrom);
+    collectNeighbors(to, neighborsTo);
+    if (!std::binary_search(neighborsFrom.begin(), neighborsFrom.end(), to)) return false;
+
+    // The link condition: the only neighbors the two share are opposite the edge, so the surface stays manifold
+    size_t nShared = 0;
+    for (uint32_t iN : neighborsFrom) {
+      if (std::binary_search(neighborsTo.begin(), neighborsTo.end(), iN)) nShared++;
+    }
+    size_t nEdgeTriangles = 0;
+    for (uint32_t iT : vertexTriangles[from]) {
+      if (triangleAlive[iT] && triangleHas(iT, to)) nEdgeTriangles++;
+    }
+    if (nShared != nEdgeTriangles) return false;
+
+    // The triangles which move must not flip over or become degenerate
+    for (uint32_t iT : vertexTriangles[from]) {
+      if (!triangleAlive[iT] || triangleHas(iT, to)) continue;
+      std::array<glm::dvec3, 3> p;
+      for (int j = 0; j < 3; j++) p[j] = positions[triangles[iT][j]];
+      glm::dvec3 nOld = glm::cross(p[1] - p[0], p[2] - p[0]);
+      for (int j = 0; j < 3; j++) {
+        if (triangles[iT][j] == from) p[j] = positions[to];
+      }
+      glm::dvec3 nNew = glm::cross(p[1] - p[0], p[2] - p[0]);
+      if (glm::dot(nOld, nNew) <= 0.1 * glm::length(nOld) * glm::length(nNew)) return false;
+    }
+
+    return true;
+  }
+
+  void collapse(uint32_t from, uint32_t to) {
+    for (uint32_t iT : vertexTriangles[from]) {
+      if (!triangleAlive[iT]) continue;
+      if (triangleHas(iT, to)) {
+        triangleAlive[iT] = false;
+        nLive--;
+      } else {
+        for (uint32_t& iV : triangles[iT]) {
+          if (iV == from) iV = to;
+        }
+        vertexTriangles[to].push_back(iT);
+      }
+    }
+    vertexTriangles[from].clear();
+    vertexAlive[from] = false;
+
+    std::vector<uint32_t>& toTriangles = vertexTriangles[to];
+    toTriangles.erase(std::remove_if(toTriangles.begin(), toTriangles.end(),
+                                     [&](uint32_t iT) { return !triangleAlive[iT]; }),
+                      toTriangles.end());
+    quadrics[to] += quadrics[from];
+    vertexVersion[to]++;
+
+    collectNeighbors(to, neighborsTo);
+    for (uint32_t iN : neighborsTo) {
+      pushCandidate(to, iN);
+      pushCandidate(iN, to);
+    }
+  }
+};
+
+// A run of consecutive faces
+struct FaceRun {
+  size_t faceBegin, faceEnd;
+  size_t triangleStart, triangleCount;
+};
+
+// The levels of one chunk, before they are concatenated
+struct ChunkLevels {
+  glm::vec3 bboxMin, bboxMax;
+  std::vector<std::vector<std::array<size_t, 3>>> triangles;
+  std::vector<std::vector<size_t>> triangleFaces;
+  std::vector<double> errors;
+};
+
+void simplifyRun(const std::vector<glm::vec3>& vertices, const std::vector<std::vector<size_t>>& faces,
+                 const FaceRun& run, const std::vector<char>& vertexShared, ChunkLevels& out) {
+
+  // Local vertex indices, in order of global index
+  std::vector<size_t> globalInds;
+  for (size_t iF = run.faceBegin; iF < run.faceEnd; iF++) {
+    if (faces[iF].size() < 3) continue;
+    globalInds.insert(globalInds.end(), faces[iF].begin(), faces[iF].end());
+  }
+  std::sort(globalInds.begin(), globalInds.end());
+  globalInds.erase(std::unique(globalInds.begin(), globalInds.end()), globalInds.end());
+  auto localInd = [&](size_t iV) {
+    return static_cast<uint32_t>(std::lower_bound(globalInds.begin(), globalInds.end(), iV) - globalInds.begin());
+  };
+
+  std::vector<glm::dvec3> positions(globalInds.size());
+  out.bboxMin = glm::vec3{1., 1., 1.} * std::numeric_limits<float>::infinity();
+  out.bboxMax = -out.bboxMin;
+  for (size_t i = 0; i < globalInds.size(); i++) {
+    positions[i] = vertices[globalInds[i]];
+    out.bboxMin = componentwiseMin(out.bboxMin, vertices[globalInds[i]]);
+    out.bboxMax = componentwiseMax(out.bboxMax, vertices[globalInds[i]]);
+  }
+
+  // Triangulate as for drawing
+  std::vector<std::array<uint32_t, 3>> triangles;
+  std::vector<size_t> triangleFaces;
+  triangles.reserve(run.triangleCount);
+  triangleFaces.reserve(run.triangleCount);
+  for (size_t iF = run.faceBegin; iF < run.faceEnd; iF++) {
+    const std::vector<size_t>& face = faces[iF];
+    for (size_t j = 1; j + 1 < face.size(); j++) {
+      triangles.push_back({localInd(face[0]), localInd(face[j]), localInd(face[j + 1])});
+      triangleFaces.push_back(iF);
+    }
+  }
+
+  // Vertices on the chunk border or mesh boundary (or at non-manifold edges) stay put
+  std::vector<char> locked(positions.size(), false);
+  for (size_t i = 0; i < globalInds.size(); i++) {
+    locked[i] = vertexShared[globalInds[i]];
+  }
+  std::vector<std::pair<uint32_t, uint32_t>> edges;
+  edges.reserve(3 * triangles.size());
+  for (const std::array<uint32_t, 3>& tri : triangles) {
+    for (int j = 0; j < 3; j++) {
+      edges.emplace_back(std::min(tri[j], tri[(j + 1) % 3]), std::max(tri[j], tri[(j + 1) % 3]));
+    }
+  }
+  std::sort(edges.begin(), edges.end());
+  for (size_t i = 0; i < edges.size();) {
+    size_t j = i;
+    while (j < edges.size() && edges[j] == edges[i]) j++;
+    if (j - i != 2) {
+      locked[edges[i].first] = true;
+      locked[edges[i].second] = true;
+    }
+    i = j;
+  }
+
+  // Halve the triangle count for each level, until the chunk cannot be simplified any more
+  ChunkSimplifier simplifier(positions, std::move(triangles), locked);
+  size_t prevCount = simplifier.triangleCount();
+  while (prevCount / 2 >= minLevelTriangles) {
+    simplifier.simplifyTo(prevCount / 2);
+    size_t count = simplifier.triangleCount();
+    if (count > prevCount * 3 / 4) break; // (not worth another level)
+
+    out.triangles.emplace_back();
+    out.triangleFaces.emplace_back();
+    out.errors.push_back(simplifier.error());
+    std::vector<std::array<size_t, 3>>& levelTriangles = out.triangles.back();
+    std::vector<size_t>& levelFaces = out.triangleFaces.back();
+    levelTriangles.reserve(count);
+    levelFaces.reserve(count);
+    simplifier.forEachTriangle([&](size_t iT, const std::array<uint32_t, 3>& tri) {
+      levelTriangles.push_back({globalInds[tri[0]], globalInds[tri[1]], globalInds[tri[2]]});
+      levelFaces.push_back(triangleFaces[iT]);
+    });
+    prevCount = count;
+  }
+}
+
+} // namespace
+
+std::shared_ptr<SurfaceMeshLOD> buildSurfaceMeshLOD(const std::vector<glm::vec3>& vertices,
+                                                    const std::vector<std::vector<size_t>>& faces,
+                                                    size_t chunkTriangles) {
+
+  // Split the faces in to runs, the same way as SurfaceMesh::computeCullingChunks()
+  std::vector<FaceRun> runs;
+  FaceRun run{0, 0, 0, 0};
+  size_t iTri = 0;
+  for (size_t iF = 0; iF < faces.size(); iF++) {
+    if (faces[iF].size() >= 3) iTri += faces[iF].size() - 2;
+    run.faceEnd = iF + 1;
+    run.triangleCount = iTri - run.triangleStart;
+    if (run.triangleCount >= chunkTriangles) {
+      runs.push_back(run);
+      run = FaceRun{iF + 1, iF + 1, iTri, 0};
+    }
+  }
+  if (run.triangleCount > 0) {
+    runs.push_back(run);
+  }
+
+  // Vertices used by more than one chunk
+  const size_t noChunk = std::numeric_limits<size_t>::max();
+  std::vector<size_t> vertexChunk(vertices.size(), noChunk);
+  std::vector<char> vertexShared(vertices.size(), false);
+  for (size_t iC = 0; iC < runs.size(); iC++) {
+    for (size_t iF = runs[iC].faceBegin; iF < runs[iC].faceEnd; iF++) {
+      for (size_t iV : faces[iF]) {
+        if (vertexChunk[iV] == noChunk) {
+          vertexChunk[iV] = iC;
+        } else if (vertexChunk[iV] != iC) {
+          vertexShared[iV] = true;
+        }
+      }
+    }
+  }
+
+  std::vector<ChunkLevels> chunkLevels(runs.size());
+  tasks::parallelFor(0, runs.size(), 1, [&](size_t begin, size_t end) {
+    for (size_t iC = begin; iC < end; iC++) {
+      simplifyRun(vertices, faces, runs[iC], vertexShared, chunkLevels[iC]);
+    }
+  });
+
+  // Concatenate
+  std::shared_ptr<SurfaceMeshLOD> lod = std::make_shared<SurfaceMeshLOD>();
+  for (size_t iC = 0; iC < runs.size(); iC++) {
+    ChunkLevels& levels = chunkLevels[iC];
+    SurfaceMeshLOD::Chunk chunk;
+    chunk.bboxMin = levels.bboxMin;
+    chunk.bboxMax = levels.bboxMax;
+    chunk.fullTriangleStart = runs[iC].triangleStart;
+    chunk.fullTriangleCount = runs[iC].triangleCount;
+    for (size_t iL = 0; iL < levels.triangles.size(); iL++) {
+      chunk.levels.push_back(
+          SurfaceMeshLOD::Level{lod->triangles.size(), levels.triangles[iL].size(), levels.errors[iL]});
+      lod->triangles.insert(lod->triangles.end(), levels.triangles[iL].begin(), levels.triangles[iL].end());
+      lod->triangleFaces.insert(lod->triangleFaces.end(), levels.triangleFaces[iL].begin(),
+                                levels.triangleFaces[iL].end());
+    }
+    lod->chunks.push_back(std::move(chunk));
+  }
+
+  return lod;
+}
+
+} // namespace polyscope
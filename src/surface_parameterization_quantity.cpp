@@ -272,28 +272,36 @@ SurfaceCornerParameterizationQuantity::SurfaceCornerParameterizationQuantity(std
 
 std::string SurfaceCornerParameterizationQuantity::niceName() { return name + " (corner parameterization)"; }
 
+std::string SurfaceCornerParameterizationQuantity::snapshotKind() { return "cornerParameterization"; }
+
+void SurfaceCornerParameterizationQuantity::writeSnapshot(SnapshotWriter& writer) {
+  writer.write<ParamCoordsType>(coordsType);
+  writer.write<ParamVizStyle>(getStyle());
+  writer.writeArray(coords);
+}
+
 
 void SurfaceCornerParameterizationQuantity::fillColorBuffers(render::ShaderProgram& p) {
   std::vector<glm::vec2> coordVal;
   coordVal.reserve(3 * parent.nFacesTriangulation());
 
-  size_t cornerCount = 0;
-  for (size_t iF = 0; iF < parent.nFaces(); iF++) {
+  for (size_t iDraw = 0; iDraw < parent.nFaces(); iDraw++) {
+    size_t iF = parent.drawnFace(iDraw);
     auto& face = parent.faces[iF];
     size_t D = face.size();
+    if (D == 0) continue;
+    size_t cornerStart = parent.halfedgeIndices[iF][0]; // (a face's corners are numbered consecutively)
 
     // implicitly triangulate from root
-    size_t cRoot = cornerCount;
+    size_t cRoot = cornerStart;
     for (size_t j = 1; (j + 1) < D; j++) {
-      size_t cB = cornerCount + j;
-      size_t cC = cornerCount + ((j + 1) % D);
+      size_t cB = cornerStart + j;
+      size_t cC = cornerStart + ((j + 1) % D);
 
       coordVal.push_back(coords[cRoot]);
       coordVal.push_back(coords[cB]);
       coordVal.push_back(coords[cC]);
     }
-
-    cornerCount += D;
   }
 
   // Store data in buffers
@@ -321,11 +329,20 @@ SurfaceVertexParameterizationQuantity::SurfaceVertexParameterizationQuantity(std
 
 std::string SurfaceVertexParameterizationQuantity::niceName() { return name + " (vertex parameterization)"; }
 
+std::string SurfaceVertexParameterizationQuantity::snapshotKind() { return "vertexParameterization"; }
+
+void SurfaceVertexParameterizationQuantity::writeSnapshot(SnapshotWriter& writer) {
+  writer.write<ParamCoordsType>(coordsType);
+  writer.write<ParamVizStyle>(getStyle());
+  writer.writeArray(coords);
+}
+
 void SurfaceVertexParameterizationQuantity::fillColorBuffers(render::ShaderProgram& p) {
   std::vector<glm::vec2> coordVal;
   coordVal.reserve(3 * parent.nFacesTriangulation());
 
-  for (size_t iF = 0; iF < parent.nFaces(); iF++) {
+  for (size_t iDraw = 0; iDraw < parent.nFaces(); iDraw++) {
+    size_t iF = parent.drawnFace(iDraw);
     auto& face = parent.faces[iF];
     size_t D = face.size();
 
@@ -20,7 +20,8 @@ void SurfaceScalarQuantity::draw() {
   if (!isEnabled()) return;
 
   if (program == nullptr) {
-    createProgram();
+    prepareProgram();
+    if (program == nullptr) return; // buffers not ready yet
   }
 
   // Set uniforms
@@ -50,12 +51,50 @@ void SurfaceScalarQuantity::buildCustomUI() {
 }
 
 void SurfaceScalarQuantity::refresh() {
+  cancelBackgroundPreparation();
   program.reset();
+  preparingProgram.reset();
   Quantity::refresh();
 }
 
+void SurfaceScalarQuantity::cancelBackgroundPreparation() { colorStaging.cancel(); }
+
+void SurfaceScalarQuantity::prepareProgram() {
+
+  if (!colorStaging.started()) {
+    // Create the program to draw this quantity
+    preparingProgram = requestProgram();
+    bool wantsBary = preparingProgram->hasAttribute("a_barycoord");
+    bool wantsEdge = parent.getEdgeWidth() > 0;
+    bool smooth = parent.isSmoothShade();
+    std::shared_ptr<const SurfaceMeshLOD> lod = supportsLevelOfDetail() ? parent.getLevelOfDetailData() : nullptr;
+    colorStaging.start([=]() {
+      render::StagedAttributes attributes = parent.assembleGeometryBuffers(wantsBary, wantsEdge, smooth, lod.get());
+      assembleColorBuffers(attributes, lod.get());
+      return attributes;
+    });
+  }
+
+  if (!colorStaging.ready()) {
+    requestViewRedraw();
+    return;
+  }
+
+  // Fill color buffers
+  colorStaging.take().uploadTo(*preparingProgram);
+  preparingProgram->setTextureFromColormap("t_colormap", cMap.get());
+  render::engine->setMaterial(*preparingProgram, parent.getMaterial());
+  program = preparingProgram;
+  preparingProgram.reset();
+  requestRedraw();
+}
+
 std::string SurfaceScalarQuantity::niceName() { return name + " (" + definedOn + " scalar)"; }
 
+std::string SurfaceScalarQuantity::snapshotKind() { return definedOn + "Scalar"; }
+
+void SurfaceScalarQuantity::writeSnapshot(SnapshotWriter& writer) { writeScalarSnapshot(writer); }
+
 // ========================================================
 // ==========           Vertex Scalar            ==========
 // ========================================================
@@ -68,23 +107,21 @@ SurfaceVertexScalarQuantity::SurfaceVertexScalarQuantity(std::string name, const
   hist.buildHistogram(values, parent.vertexAreas); // rebuild to incorporate weights
 }
 
-void SurfaceVertexScalarQuantity::createProgram() {
-  // Create the program to draw this quantity
-  program =
-      render::engine->requestShader("MESH", parent.addStructureRules(addScalarRules({"MESH_PROPAGATE_VALUE"})));
+// the background job calls assembleColorBuffers(), so it must finish before this part of the object is destroyed
+SurfaceVertexScalarQuantity::~SurfaceVertexScalarQuantity() { cancelBackgroundPreparation(); }
 
-  // Fill color buffers
-  parent.fillGeometryBuffers(*program);
-  fillColorBuffers(*program);
-  render::engine->setMaterial(*program, parent.getMaterial());
+std::shared_ptr<render::ShaderProgram> SurfaceVertexScalarQuantity::requestProgram() {
+  return render::engine->requestShader("MESH", parent.addStructureRules(addScalarRules({"MESH_PROPAGATE_VALUE"})));
 }
 
 
-void SurfaceVertexScalarQuantity::fillColorBuffers(render::ShaderProgram& p) {
+void SurfaceVertexScalarQuantity::assembleColorBuffers(render::StagedAttributes& attributes,
+                                                       const SurfaceMeshLOD* lod) {
   std::vector<double> colorval;
   colorval.reserve(3 * parent.nFacesTriangulation());
 
-  for (size_t iF = 0; iF < parent.nFaces(); iF++) {
+  for (size_t iDraw = 0; iDraw < parent.nFaces(); iDraw++) {
+    size_t iF = parent.drawnFace(iDraw);
     auto& face = parent.faces[iF];
     size_t D = face.size();
 
@@ -99,10 +136,12 @@ void SurfaceVertexScalarQuantity::fillColorBuffers(render::ShaderProgram& p) {
       colorval.push_back(values[vC]);
     }
   }
+  if (lod != nullptr) {
+    lod->appendVertexValues(colorval, values);
+  }
 
   // Store data in buffers
-  p.setAttribute("a_value", colorval);
-  p.setTextureFromColormap("t_colormap", cMap.get());
+  attributes.add("a_value", std::move(colorval));
 }
 
 void SurfaceVertexScalarQuantity::buildVertexInfoGUI(size_t vInd) {
@@ -124,22 +163,19 @@ SurfaceFaceScalarQuantity::SurfaceFaceScalarQuantity(std::string name, const std
   hist.buildHistogram(values, parent.faceAreas); // rebuild to incorporate weights
 }
 
-void SurfaceFaceScalarQuantity::createProgram() {
-  // Create the program to draw this quantity
-  program =
-      render::engine->requestShader("MESH", parent.addStructureRules(addScalarRules({"MESH_PROPAGATE_VALUE"})));
+SurfaceFaceScalarQuantity::~SurfaceFaceScalarQuantity() { cancelBackgroundPreparation(); }
 
-    // Fill color buffers
-    parent.fillGeometryBuffers(*program);
-    fillColorBuffers(*program);
-    render::engine->setMaterial(*program, parent.getMaterial());
+std::shared_ptr<render::ShaderProgram> SurfaceFaceScalarQuantity::requestProgram() {
+  return render::engine->requestShader("MESH", parent.addStructureRules(addScalarRules({"MESH_PROPAGATE_VALUE"})));
 }
 
-void SurfaceFaceScalarQuantity::fillColorBuffers(render::ShaderProgram& p) {
+void SurfaceFaceScalarQuantity::assembleColorBuffers(render::StagedAttributes& attributes,
+                                                     const SurfaceMeshLOD* lod) {
     std::vector<double> colorval;
     colorval.reserve(3 * parent.nFacesTriangulation());
 
-    for (size_t iF = 0; iF < parent.nFaces(); iF++) {
+    for (size_t iDraw = 0; iDraw < parent.nFaces(); iDraw++) {
+      size_t iF = parent.drawnFace(iDraw);
       auto& face = parent.faces[iF];
       size_t D = face.size();
       size_t triDegree = std::max(0, static_cast<int>(D) - 2);
@@ -147,10 +183,12 @@ void SurfaceFaceScalarQuantity::fillColorBuffers(render::ShaderProgram& p) {
         colorval.push_back(values[iF]);
       }
     }
+    if (lod != nullptr) {
+      lod->appendFaceValues(colorval, values);
+    }
 
     // Store data in buffers
-    p.setAttribute("a_value", colorval);
-    p.setTextureFromColormap("t_colormap", cMap.get());
+    attributes.add("a_value", std::move(colorval));
 }
 
 void SurfaceFaceScalarQuantity::buildFaceInfoGUI(size_t fInd) {
@@ -173,24 +211,22 @@ SurfaceEdgeScalarQuantity::SurfaceEdgeScalarQuantity(std::string name, const std
     hist.buildHistogram(values, parent.edgeLengths); // rebuild to incorporate weights
 }
 
-void SurfaceEdgeScalarQuantity::createProgram() {
-    // Create the program to draw this quantity
-    program = render::engine->requestShader(
-        "MESH", parent.addStructureRules(addScalarRules({"MESH_PROPAGATE_HALFEDGE_VALUE"})));
+SurfaceEdgeScalarQuantity::~SurfaceEdgeScalarQuantity() { cancelBackgroundPreparation(); }
 
-    // Fill color buffers
-    parent.fillGeometryBuffers(*program);
-    fillColorBuffers(*program);
-    render::engine->setMaterial(*program, parent.getMaterial());
+std::shared_ptr<render::ShaderProgram> SurfaceEdgeScalarQuantity::requestProgram() {
+  return render::engine->requestShader("MESH",
+                                       parent.addStructureRules(addScalarRules({"MESH_PROPAGATE_HALFEDGE_VALUE"})));
 }
 
-void SurfaceEdgeScalarQuantity::fillColorBuffers(render::ShaderProgram& p) {
+void SurfaceEdgeScalarQuantity::assembleColorBuffers(render::StagedAttributes& attributes,
+                                                     const SurfaceMeshLOD* /*lod*/) {
     std::vector<glm::vec3> colorval;
     colorval.reserve(3 * parent.nFacesTriangulation());
 
     // Fill buffers as usual, but at edges introduced by triangulation substitute the average value.
     // TODO this still doesn't look too great on polygon meshes... perhaps compute an average value per edge?
-    for (size_t iF = 0; iF < parent.nFaces(); iF++) {
+    for (size_t iDraw = 0; iDraw < parent.nFaces(); iDraw++) {
+      size_t iF = parent.drawnFace(iDraw);
       auto& face = parent.faces[iF];
       size_t D = face.size();
 
@@ -220,8 +256,7 @@ void SurfaceEdgeScalarQuantity::fillColorBuffers(render::ShaderProgram& p) {
     }
 
     // Store data in buffers
-    p.setAttribute("a_value3", colorval);
-    p.setTextureFromColormap("t_colormap", cMap.get());
+    attributes.add("a_value3", std::move(colorval));
 }
 
 void SurfaceEdgeScalarQuantity::buildEdgeInfoGUI(size_t eInd) {
@@ -253,27 +288,26 @@ SurfaceHalfedgeScalarQuantity::SurfaceHalfedgeScalarQuantity(std::string name, c
     hist.buildHistogram(values, weightsVec); // rebuild to incorporate weights
 }
 
-void SurfaceHalfedgeScalarQuantity::createProgram() {
-    // Create the program to draw this quantity
-    program = render::engine->requestShader(
-        "MESH", parent.addStructureRules(addScalarRules({"MESH_PROPAGATE_HALFEDGE_VALUE"})));
+SurfaceHalfedgeScalarQuantity::~SurfaceHalfedgeScalarQuantity() { cancelBackgroundPreparation(); }
 
-    // Fill color buffers
-    parent.fillGeometryBuffers(*program);
-    fillColorBuffers(*program);
-    render::engine->setMaterial(*program, parent.getMaterial());
+std::shared_ptr<render::ShaderProgram> SurfaceHalfedgeScalarQuantity::requestProgram() {
+  return render::engine->requestShader("MESH",
+                                       parent.addStructureRules(addScalarRules({"MESH_PROPAGATE_HALFEDGE_VALUE"})));
 }
 
-void SurfaceHalfedgeScalarQuantity::fillColorBuffers(render::ShaderProgram& p) {
+void SurfaceHalfedgeScalarQuantity::assembleColorBuffers(render::StagedAttributes& attributes,
+                                                         const SurfaceMeshLOD* /*lod*/) {
     std::vector<glm::vec3> colorval;
     colorval.reserve(3 * parent.nFacesTriangulation());
 
     // Fill buffers as usual, but at edges introduced by triangulation substitute the average value.
     // TODO this still doesn't look too great on polygon meshes... perhaps compute an average value per edge?
-    size_t iHe = 0;
-    for (size_t iF = 0; iF < parent.nFaces(); iF++) {
+    for (size_t iDraw = 0; iDraw < parent.nFaces(); iDraw++) {
+      size_t iF = parent.drawnFace(iDraw);
       auto& face = parent.faces[iF];
       size_t D = face.size();
+      if (D == 0) continue;
+      size_t iHe = parent.halfedgeIndices[iF][0]; // (a face's halfedges are numbered consecutively)
 
       // First, compute an average value for the face
       double avgVal = 0.0;
@@ -307,8 +341,7 @@ void SurfaceHalfedgeScalarQuantity::fillColorBuffers(render::ShaderProgram& p) {
 
 
     // Store data in buffers
-    p.setAttribute("a_value3", colorval);
-    p.setTextureFromColormap("t_colormap", cMap.get());
+    attributes.add("a_value3", std::move(colorval));
 }
 
 void SurfaceHalfedgeScalarQuantity::buildHalfedgeInfoGUI(size_t heInd) {
@@ -22,11 +22,15 @@ SurfaceVectorQuantity::SurfaceVectorQuantity(std::string name, SurfaceMesh& mesh
     : SurfaceMeshQuantity(name, mesh_), vectorType(vectorType_),
       ribbonEnabled(uniquePrefix() + "#ribbonEnabled", false) {}
 
+SurfaceVectorQuantity::~SurfaceVectorQuantity() {}
+
 
 void SurfaceVectorQuantity::prepareVectorArtist() {
   vectorArtist.reset(new VectorArtist(parent, name + "#vectorartist", vectorRoots, vectors, vectorType));
 }
 
+double SurfaceVectorQuantity::drawMargin() { return vectorArtist ? vectorArtist->drawMargin() : 0.; }
+
 void SurfaceVectorQuantity::draw() {
   if (!isEnabled()) return;
   vectorArtist->draw();
@@ -40,6 +44,46 @@ void SurfaceVectorQuantity::buildCustomUI() {
 
 void SurfaceVectorQuantity::drawSubUI() {}
 
+SurfaceVectorQuantity* SurfaceVectorQuantity::setEnabled(bool newEnabled) {
+  SurfaceMeshQuantity::setEnabled(newEnabled);
+
+  // Don't leave workers tracing lines for a quantity that isn't shown; an unfinished ribbon gets restarted on enable
+  if (!newEnabled && ribbonTraceJob) {
+    clearRibbon();
+  }
+  return this;
+}
+
+void SurfaceVectorQuantity::startRibbonTrace(const std::vector<glm::vec2>& field, int nSym) {
+  ribbonTraceJob.reset(new FieldTraceJob(parent, field, nSym, 2500));
+  ribbonArtist.reset(new RibbonArtist(parent, {}));
+}
+
+void SurfaceVectorQuantity::drawRibbon() {
+
+  // Pull in any lines which have finished tracing since the last frame
+  if (ribbonTraceJob) {
+    std::vector<std::vector<std::array<glm::vec3, 2>>> newLines;
+    ribbonTraceJob->takeFinishedLines(newLines);
+    if (!newLines.empty()) {
+      ribbonArtist->addRibbons(newLines);
+    }
+
+    if (ribbonTraceJob->isFinished()) {
+      ribbonTraceJob.reset();
+    } else {
+      requestRedraw(); // keep drawing frames until all of the lines arrive
+    }
+  }
+
+  ribbonArtist->draw();
+}
+
+void SurfaceVectorQuantity::clearRibbon() {
+  ribbonTraceJob.reset();
+  ribbonArtist.reset();
+}
+
 SurfaceVectorQuantity* SurfaceVectorQuantity::setVectorLengthScale(double newLength, bool isRelative) {
   vectorArtist->setVectorLengthScale(newLength, isRelative);
   return this;
@@ -64,6 +108,9 @@ std::string SurfaceVectorQuantity::getMaterial() { return vectorArtist->getMater
 
 SurfaceVectorQuantity* SurfaceVectorQuantity::setRibbonEnabled(bool val) {
   ribbonEnabled = val;
+  if (!val && ribbonTraceJob) {
+    clearRibbon();
+  }
   requestRedraw();
   return this;
 }
@@ -128,6 +175,13 @@ void SurfaceVertexVectorQuantity::buildVertexInfoGUI(size_t iV) {
 
 std::string SurfaceVertexVectorQuantity::niceName() { return name + " (vertex vector)"; }
 
+std::string SurfaceVertexVectorQuantity::snapshotKind() { return "vertexVector"; }
+
+void SurfaceVertexVectorQuantity::writeSnapshot(SnapshotWriter& writer) {
+  writer.write<VectorType>(vectorType);
+  writer.writeArray(vectors);
+}
+
 // ========================================================
 // ==========            Face Vector             ==========
 // ========================================================
@@ -163,6 +217,13 @@ void SurfaceFaceVectorQuantity::buildFaceInfoGUI(size_t iF) {
 
 std::string SurfaceFaceVectorQuantity::niceName() { return name + " (face vector)"; }
 
+std::string SurfaceFaceVectorQuantity::snapshotKind() { return "faceVector"; }
+
+void SurfaceFaceVectorQuantity::writeSnapshot(SnapshotWriter& writer) {
+  writer.write<VectorType>(vectorType);
+  writer.writeArray(vectors);
+}
+
 // ========================================================
 // ==========        Intrinsic Face Vector       ==========
 // ========================================================
@@ -210,7 +271,7 @@ void SurfaceFaceIntrinsicVectorQuantity::refresh() {
   }
 
   prepareVectorArtist();
-  ribbonArtist.reset();
+  clearRibbon();
 }
 
 void SurfaceFaceIntrinsicVectorQuantity::buildFaceInfoGUI(size_t iF) {
@@ -234,12 +295,10 @@ void SurfaceFaceIntrinsicVectorQuantity::draw() {
 
     // Make sure we have a ribbon artist
     if (ribbonArtist == nullptr) {
-      // Warning: expensive... Creates noticeable UI lag
-      ribbonArtist.reset(new RibbonArtist(parent, traceField(parent, vectorField, nSym, 2500)));
+      startRibbonTrace(vectorField, nSym);
     }
 
-    // Update transform matrix from parent
-    ribbonArtist->draw();
+    drawRibbon();
   }
 }
 
@@ -296,7 +355,7 @@ void SurfaceVertexIntrinsicVectorQuantity::refresh() {
   }
 
   prepareVectorArtist();
-  ribbonArtist.reset();
+  clearRibbon();
 }
 
 void SurfaceVertexIntrinsicVectorQuantity::buildVertexInfoGUI(size_t iV) {
@@ -358,12 +417,10 @@ void SurfaceVertexIntrinsicVectorQuantity::draw() {
         unitFaceVecs[iF] = glm::normalize(sum);
       }
 
-      // Warning: expensive... Creates noticeable UI lag
-      ribbonArtist.reset(new RibbonArtist(parent, traceField(parent, unitFaceVecs, nSym, 2500)));
+      startRibbonTrace(unitFaceVecs, nSym);
     }
 
-    // Update transform matrix from parent
-    ribbonArtist->draw();
+    drawRibbon();
   }
 }
 
@@ -458,7 +515,7 @@ void SurfaceOneFormIntrinsicVectorQuantity::refresh() {
   }
 
   prepareVectorArtist();
-  ribbonArtist.reset();
+  clearRibbon();
 }
 
 void SurfaceOneFormIntrinsicVectorQuantity::buildEdgeInfoGUI(size_t iE) {
@@ -496,13 +553,10 @@ void SurfaceOneFormIntrinsicVectorQuantity::draw() {
       for (size_t iF = 0; iF < parent.nFaces(); iF++) {
         unitMappedField[iF] = glm::normalize(mappedVectorField[iF]);
       }
-      // Warning: expensive... Creates noticeable UI lag
-      ribbonArtist.reset(new RibbonArtist(parent, traceField(parent, unitMappedField, 1, 2500)));
+      startRibbonTrace(unitMappedField, 1);
     }
 
-
-    // Update transform matrix from parent
-    ribbonArtist->draw();
+    drawRibbon();
   }
 }
 
@@ -0,0 +1,239 @@
+// Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
+#include "polyscope/task_scheduler.h"
+
+#include "polyscope/options.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace polyscope {
+namespace tasks {
+
+namespace {
+
+// Each worker has its own queue. Workers take their own newest task first, and steal the oldest task from another queue
+// when theirs is empty. Tasks submitted from outside the pool are dealt out to the queues in turn.
+class ThreadPool {
+
+public:
+  explicit ThreadPool(size_t nWorkers) {
+    for (size_t iW = 0; iW < nWorkers; iW++) {
+      queues.emplace_back(new WorkerQueue());
+    }
+    for (size_t iW = 0; iW < nWorkers; iW++) {
+      threads.emplace_back(&ThreadPool::workerLoop, this, iW);
+    }
+  }
+
+  // Runs everything still queued before returning
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(sleepMutex);
+      stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& t : threads) {
+      t.join();
+    }
+  }
+
+  void push(std::function<void()> task) {
+    size_t iQ = currentPool == this ? currentWorker : (nextQueue++ % queues.size());
+    {
+      std::lock_guard<std::mutex> lock(queues[iQ]->mutex);
+      queues[iQ]->tasks.push_back(std::move(task));
+    }
+    nQueued++;
+    {
+      // lock so a worker cannot check nQueued and go to sleep between the increment and the notify
+      std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wake.notify_one();
+  }
+
+private:
+  struct WorkerQueue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  bool tryPop(size_t iW, std::function<void()>& task) {
+    for (size_t i = 0; i < queues.size(); i++) {
+      WorkerQueue& q = *queues[(iW + i) % queues.size()];
+      std::lock_guard<std::mutex> lock(q.mutex);
+      if (q.tasks.empty()) continue;
+      if (i == 0) {
+        task = std::move(q.tasks.back());
+        q.tasks.pop_back();
+      } else {
+        task = std::move(q.tasks.front());
+        q.tasks.pop_front();
+      }
+      nQueued--;
+      return true;
+    }
+    return false;
+  }
+
+  void workerLoop(size_t iW) {
+    currentPool = this;
+    currentWorker = iW;
+    std::function<void()> task;
+    while (true) {
+      if (tryPop(iW, task)) {
+        task();
+        task = nullptr;
+        continue;
+      }
+
+      std::unique_lock<std::mutex> lock(sleepMutex);
+      wake.wait(lock, [&]() { return stopping || nQueued > 0; });
+      if (stopping && nQueued == 0) {
+        return;
+      }
+    }
+  }
+
+  std::vector<std::unique_ptr<WorkerQueue>> queues;
+  std::vector<std::thread> threads;
+  std::atomic<size_t> nQueued{0};
+  std::atomic<size_t> nextQueue{0};
+  std::mutex sleepMutex;
+  std::condition_variable wake;
+  bool stopping = false;
+
+  static thread_local ThreadPool* currentPool;
+  static thread_local size_t currentWorker;
+};
+
+thread_local ThreadPool* ThreadPool::currentPool = nullptr;
+thread_local size_t ThreadPool::currentWorker = 0;
+
+std::mutex poolMutex; // guards the two below
+std::unique_ptr<ThreadPool> pool;
+std::function<void(std::function<void()>)> hostExecutor;
+
+// Shared between the threads working on one parallelFor()
+struct ParallelForState {
+  const std::function<void(size_t, size_t)>* body;
+  size_t begin, end, grainSize, nChunks;
+  std::atomic<size_t> nextChunk{0};
+  std::atomic<size_t> nChunksDone{0};
+  std::mutex doneMutex;
+  std::condition_variable done;
+  std::exception_ptr error;
+
+  // Run chunks until none are left. Once the last chunk is done, body may no longer be valid.
+  void runChunks() {
+    while (true) {
+      size_t iChunk = nextChunk++;
+      if (iChunk >= nChunks) return;
+
+      size_t chunkBegin = begin + iChunk * grainSize;
+      size_t chunkEnd = std::min(end, chunkBegin + grainSize);
+      try {
+        (*body)(chunkBegin, chunkEnd);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(doneMutex);
+        if (!error) error = std::current_exception();
+      }
+
+      if (++nChunksDone == nChunks) {
+        std::lock_guard<std::mutex> lock(doneMutex);
+        done.notify_all();
+      }
+    }
+  }
+};
+
+} // namespace
+
+size_t threadCount() {
+  if (options::nThreads > 0) {
+    return options::nThreads;
+  }
+  return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+void submit(std::function<void()> task) {
+  std::unique_lock<std::mutex> lock(poolMutex);
+
+  if (hostExecutor) {
+    std::function<void(std::function<void()>)> executor = hostExecutor;
+    lock.unlock();
+    executor(std::move(task));
+    return;
+  }
+
+  if (threadCount() == 1) {
+    lock.unlock();
+    task();
+    return;
+  }
+
+  if (!pool) {
+    pool.reset(new ThreadPool(threadCount() - 1));
+  }
+  pool->push(std::move(task));
+}
+
+void parallelFor(size_t begin, size_t end, size_t grainSize, const std::function<void(size_t, size_t)>& body) {
+  grainSize = std::max(grainSize, static_cast<size_t>(1));
+  size_t nChunks = chunkCount(begin, end, grainSize);
+  size_t nHelpers = std::min(nChunks, threadCount()) - (nChunks > 0 ? 1 : 0);
+
+  // Small ranges just run here
+  if (nHelpers == 0) {
+    for (size_t chunkBegin = begin; chunkBegin < end; chunkBegin += grainSize) {
+      body(chunkBegin, std::min(end, chunkBegin + grainSize));
+    }
+    return;
+  }
+
+  std::shared_ptr<ParallelForState> state = std::make_shared<ParallelForState>();
+  state->body = &body;
+  state->begin = begin;
+  state->end = end;
+  state->grainSize = grainSize;
+  state->nChunks = nChunks;
+
+  // Helpers which start after all chunks have been claimed return immediately, so it is fine if they never run before
+  // this call returns.
+  for (size_t iH = 0; iH < nHelpers; iH++) {
+    submit([state]() { state->runChunks(); });
+  }
+  state->runChunks();
+
+  {
+    std::unique_lock<std::mutex> lock(state->doneMutex);
+    state->done.wait(lock, [&]() { return state->nChunksDone == state->nChunks; });
+  }
+
+  if (state->error) {
+    std::rethrow_exception(state->error);
+  }
+}
+
+void setExecutor(std::function<void(std::function<void()>)> executor) {
+  shutdown();
+  std::lock_guard<std::mutex> lock(poolMutex);
+  hostExecutor = executor;
+}
+
+void shutdown() {
+  std::unique_ptr<ThreadPool> oldPool;
+  {
+    std::lock_guard<std::mutex> lock(poolMutex);
+    oldPool = std::move(pool);
+  }
+  oldPool.reset(); // joins the workers outside the lock, since tasks being drained may submit more
+}
+
+} // namespace tasks
+} // namespace polyscope
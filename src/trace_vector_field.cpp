@@ -1,293 +1,401 @@
 // Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
 #include "polyscope/trace_vector_field.h"
 
+#include "polyscope/task_scheduler.h"
+
 #include "glm/gtx/rotate_vector.hpp"
 
+#include <algorithm>
+#include <complex>
+#include <random>
+
 namespace polyscope {
 
 // Helpers for tracing
 namespace {
 
-struct PointNormal {
-  glm::vec3 p;
-  glm::vec3 n;
-};
-
-struct FacePoint {
-  size_t f;
-  glm::vec3 baryWeights;
-};
-
-struct IntersectionResult {
-  float tRay;
-  float tLine;
-};
-
-
-IntersectionResult rayLineIntersection(glm::vec2 rayStart, glm::vec2 rayDir, glm::vec2 lineA, glm::vec2 lineB) {
-
-  glm::vec2 v1 = rayStart - lineA;
-  glm::vec2 v2 = lineB - lineA;
-  glm::vec2 v3{-rayDir.y, rayDir.x};
-
-  float cross21 = v2.x * v1.y - v2.y * v1.x;
-  float tRay = cross21 / dot(v2, v3);
-  float tLine = glm::dot(v1, v3) / dot(v2, v3);
-
-  if (tRay < 0) {
-    tRay = std::numeric_limits<float>::infinity();
-  }
-
-
-  return IntersectionResult{tRay, tLine};
-}
-
-
 glm::vec3 unitSum(glm::vec3 v) {
   float sum = v.x + v.y + v.z;
   return v / sum;
 }
 
+float cross2(glm::vec2 a, glm::vec2 b) { return a.x * b.y - a.y * b.x; }
 
+// Number of lines traced by each task
+const size_t traceBatchSize = 16;
 
+// One edge of a tracing triangle. Edge k of a triangle runs from corner k to corner (k+1)%3.
+struct TraceEdge {
+  glm::vec2 outNormal;        // outward normal in the face's planar coordinates (not unit)
+  glm::mat2 transport;        // maps directions in this face's basis to the neighboring face's basis
+  size_t neighbor;            // triangle across this edge, or INVALID_IND on the boundary
+  unsigned char neighborEdge; // local index of this edge in the neighbor
+  bool reversed;              // true if the neighbor traverses the edge in the opposite direction (the usual case)
+  bool sameFace;              // true for interior diagonals of a polygon's fan triangulation
+};
+
+} // namespace
+
+
+// Traces lines over the implicit fan triangulation of the mesh. Everything needed for a tracing step (triangle corners
+// in the planar coordinates of their face, outward edge normals, adjacency, and the transport between neighboring face
+// bases) is precomputed in flat arrays, so tracing does no connectivity lookups or trigonometry.
 class FieldTracer {
 
 public:
-  // Core members
-  SurfaceMesh& mesh;
-  std::vector<glm::vec2> faceVectors; // disambiguated
   int nSym;
 
   // Parameters
   float maxLineLength;
   size_t maxFaceCount;
 
-  // Cached geometric quantities
-  std::vector<glm::vec2> vert1InFaceBasis, vert2InFaceBasis;
+  // == Per-face data (one entry per polygon)
+  std::vector<glm::vec2> faceVectors; // disambiguated
+  std::vector<glm::vec3> faceOrigin;  // position of the face's first vertex, the origin of its planar coordinates
+  std::vector<std::array<glm::vec3, 2>> faceBasis;
+  std::vector<glm::vec3> faceNormal;
+
+  // == Per-triangle data
+  std::vector<size_t> triFace;
+  std::vector<std::array<glm::vec2, 3>> triCorners; // in the planar coordinates of the face
+  std::vector<std::array<TraceEdge, 3>> triEdges;
+  std::vector<float> triArea;
   float totalArea;
 
-  // Cached connectivity data
+  // Rotation by 2*pi/nSym, for enumerating the symmetric directions of the field
+  glm::vec2 symRot;
+
+  // Starting triangle for each line, and a base seed from which per-line random streams are derived
+  std::vector<size_t> faceQueue;
+  unsigned int baseSeed = 0;
 
   // Input should be identified (raised to power), not disambiguated
-  FieldTracer(SurfaceMesh& mesh_, const std::vector<glm::vec2>& field, int nSym_ = 1) : mesh(mesh_), nSym(nSym_) {
+  FieldTracer(SurfaceMesh& mesh, const std::vector<glm::vec2>& field, int nSym_ = 1) : nSym(nSym_) {
 
     mesh.ensureHaveFaceTangentSpaces();
-    mesh.ensureHaveManifoldConnectivity();
-
-    // Prepare the field
-    faceVectors.resize(mesh.nFaces());
-    for (size_t iF = 0; iF < mesh.nFaces(); iF++) {
-      std::complex<float> c{field[iF].x, field[iF].y};
-      std::complex<float> cRoot = std::pow(c, 1.0f / nSym);
-      faceVectors[iF] = glm::vec2{cRoot.real(), cRoot.imag()};
-    }
 
-    // Cache geometry quantities
-    vert1InFaceBasis.resize(mesh.nFaces());
-    vert2InFaceBasis.resize(mesh.nFaces());
+    float deltaRot = 2.0 * PI / nSym;
+    symRot = glm::vec2{std::cos(deltaRot), std::sin(deltaRot)};
+
+    // Prepare the per-face data
+    size_t nFaces = mesh.nFaces();
+    faceVectors.resize(nFaces);
+    faceOrigin.resize(nFaces);
+    faceBasis.resize(nFaces);
+    faceNormal.resize(nFaces);
+    tasks::parallelFor(0, nFaces, 4096, [&](size_t begin, size_t end) {
+      for (size_t iF = begin; iF < end; iF++) {
+        std::complex<float> c{field[iF].x, field[iF].y};
+        std::complex<float> cRoot = std::pow(c, 1.0f / nSym);
+        faceVectors[iF] = glm::vec2{cRoot.real(), cRoot.imag()};
+
+        faceOrigin[iF] = mesh.vertices[mesh.faces[iF][0]];
+        faceBasis[iF] = mesh.faceTangentSpaces[iF];
+        faceNormal[iF] = mesh.faceNormals[iF];
+      }
+    });
+
+    // Fan-triangulate each face, as in the mesh's own rendering. For a face (f0, f1, ... fD-1) the j'th triangle is
+    // (f0, fj+1, fj+2), so each triangle's first corner is at the face origin.
+    struct EdgeRef {
+      size_t vMin, vMax;
+      size_t tri;
+      unsigned char k;
+      bool operator<(const EdgeRef& o) const { return vMin < o.vMin || (vMin == o.vMin && vMax < o.vMax); }
+    };
+    std::vector<EdgeRef> meshEdges;
+    std::vector<std::array<size_t, 3>> triVerts;
     totalArea = 0;
-    for (size_t iF = 0; iF < mesh.nFaces(); iF++) {
-      std::vector<size_t>& face = mesh.faces[iF];
-
-      totalArea += mesh.faceAreas[iF];
-
-      // Face basis
-      glm::vec3 X = mesh.faceTangentSpaces[iF][0];
-      glm::vec3 Y = mesh.faceTangentSpaces[iF][1];
-
-      // Find each of the vertices as a point in the basis
-      // The first vertex is implicitly at (0,0)
-      size_t v0 = face[0];
-      size_t v1 = face[1];
-      size_t v2 = face[2];
-      glm::vec3 pos1 = mesh.vertices[v1] - mesh.vertices[v0];
-      glm::vec3 pos2 = mesh.vertices[v2] - mesh.vertices[v0];
-      glm::vec2 p1{dot(X, pos1), dot(Y, pos1)};
-      glm::vec2 p2{dot(X, pos2), dot(Y, pos2)};
-
-      // Save data
-      vert1InFaceBasis[iF] = p1;
-      vert2InFaceBasis[iF] = p2;
+    for (size_t iF = 0; iF < nFaces; iF++) {
+      const std::vector<size_t>& face = mesh.faces[iF];
+      size_t D = face.size();
+      if (D < 3) continue;
+
+      glm::vec3 X = faceBasis[iF][0];
+      glm::vec3 Y = faceBasis[iF][1];
+      auto toPlanar = [&](size_t iV) {
+        glm::vec3 pos = mesh.vertices[iV] - faceOrigin[iF];
+        return glm::vec2{glm::dot(X, pos), glm::dot(Y, pos)};
+      };
+
+      for (size_t j = 1; j + 1 < D; j++) {
+        size_t iT = triFace.size();
+        std::array<size_t, 3> verts{{face[0], face[j], face[j + 1]}};
+        std::array<glm::vec2, 3> corners{{glm::vec2{0., 0.}, toPlanar(face[j]), toPlanar(face[j + 1])}};
+
+        // Outward normals depend on the winding of the triangle in the face's planar coordinates
+        float signedArea2 = cross2(corners[1] - corners[0], corners[2] - corners[0]);
+        float windSign = signedArea2 < 0 ? -1.f : 1.f;
+
+        std::array<TraceEdge, 3> edges;
+        for (unsigned char k = 0; k < 3; k++) {
+          glm::vec2 e = corners[(k + 1) % 3] - corners[k];
+          edges[k].outNormal = windSign * glm::vec2{e.y, -e.x};
+          edges[k].transport = glm::mat2(1.f);
+          edges[k].neighbor = INVALID_IND;
+          edges[k].neighborEdge = 0;
+          edges[k].reversed = true;
+          edges[k].sameFace = false;
+        }
+
+        // Interior diagonals connect consecutive triangles of the fan
+        if (j > 1) {
+          edges[0].neighbor = iT - 1;
+          edges[0].neighborEdge = 2;
+          edges[0].sameFace = true;
+        }
+        if (j + 2 < D) {
+          edges[2].neighbor = iT + 1;
+          edges[2].neighborEdge = 0;
+          edges[2].sameFace = true;
+        }
+
+        // Edges of the original polygon get matched up below
+        meshEdges.push_back(EdgeRef{std::min(face[j], face[j + 1]), std::max(face[j], face[j + 1]), iT, 1});
+        if (j == 1) {
+          meshEdges.push_back(EdgeRef{std::min(face[0], face[1]), std::max(face[0], face[1]), iT, 0});
+        }
+        if (j + 2 == D) {
+          meshEdges.push_back(EdgeRef{std::min(face[0], face[D - 1]), std::max(face[0], face[D - 1]), iT, 2});
+        }
+
+        triFace.push_back(iF);
+        triVerts.push_back(verts);
+        triCorners.push_back(corners);
+        triEdges.push_back(edges);
+        triArea.push_back(0.5f * std::abs(signedArea2));
+        totalArea += triArea.back();
+      }
+    }
+
+    // Match up mesh edges by sorting on their endpoints. Only edges shared by exactly two triangles are crossed;
+    // boundary and nonmanifold edges stop the line.
+    std::sort(meshEdges.begin(), meshEdges.end());
+    for (size_t i = 0; i < meshEdges.size();) {
+      size_t iEnd = i + 1;
+      while (iEnd < meshEdges.size() && meshEdges[iEnd].vMin == meshEdges[i].vMin &&
+             meshEdges[iEnd].vMax == meshEdges[i].vMax) {
+        iEnd++;
+      }
+
+      if (iEnd - i == 2) {
+        const EdgeRef& a = meshEdges[i];
+        const EdgeRef& b = meshEdges[i + 1];
+        size_t fA = triFace[a.tri];
+        size_t fB = triFace[b.tri];
+        TraceEdge& eA = triEdges[a.tri][a.k];
+        TraceEdge& eB = triEdges[b.tri][b.k];
+
+        // On a non-manifold / not oriented mesh, the triangles might traverse the edge in the same direction
+        bool reversed = triVerts[a.tri][a.k] != triVerts[b.tri][b.k];
+
+        eA.neighbor = b.tri;
+        eA.neighborEdge = b.k;
+        eA.reversed = reversed;
+        eA.transport = basisTransport(fA, fB);
+
+        eB.neighbor = a.tri;
+        eB.neighborEdge = a.k;
+        eB.reversed = reversed;
+        eB.transport = basisTransport(fB, fA);
+      }
+
+      i = iEnd;
     }
 
     maxLineLength = std::sqrt(totalArea) * .5;
-    maxFaceCount = static_cast<size_t>(std::ceil(std::sqrt(mesh.nFaces())));
+    maxFaceCount = static_cast<size_t>(std::ceil(std::sqrt(nFaces)));
   }
 
-  glm::vec3 facePointInR3(FacePoint p) {
+  // The (linear) map taking vectors in the tangent basis of face fA to the tangent basis of face fB
+  glm::mat2 basisTransport(size_t fA, size_t fB) {
+    glm::vec2 col0 = rotateToTangentBasis(glm::vec2{1., 0.}, faceBasis[fA][0], faceBasis[fA][1], faceBasis[fB][0],
+                                          faceBasis[fB][1]);
+    glm::vec2 col1 = rotateToTangentBasis(glm::vec2{0., 1.}, faceBasis[fA][0], faceBasis[fA][1], faceBasis[fB][0],
+                                          faceBasis[fB][1]);
+    return glm::mat2(col0, col1);
+  }
 
-    size_t v0 = mesh.faces[p.f][0];
-    size_t v1 = mesh.faces[p.f][1];
-    size_t v2 = mesh.faces[p.f][2];
+  size_t nTriangles() const { return triFace.size(); }
 
-    return p.baryWeights[0] * mesh.vertices[v0] + p.baryWeights[1] * mesh.vertices[v1] +
-           p.baryWeights[2] * mesh.vertices[v2];
+  glm::vec3 planarToR3(size_t iF, glm::vec2 p) {
+    return faceOrigin[iF] + p.x * faceBasis[iF][0] + p.y * faceBasis[iF][1];
   }
 
+  // Build the list of triangles to start lines in
+  void buildFaceQueue(size_t nLines) {
+
+    // Shuffle the list of triangles to get a reasonable distribution of starting points
+    // Build a list of triangles to start lines in. Unusually large triangles get listed multiple times so we start more
+    // lines in them. This roughly approximates a uniform sampling of the mesh. Small triangles get oversampled, but
+    // that's much less visually striking than large triangles getting undersampled.
+    faceQueue.clear();
+    if (nTriangles() == 0) return;
+    float meanArea = totalArea / nTriangles();
+    for (size_t iT = 0; iT < nTriangles(); iT++) {
+      faceQueue.push_back(iT);
+      float area = triArea[iT];
+      while (area > meanArea) {
+        faceQueue.push_back(iT);
+        area -= meanArea;
+      }
+    }
 
-  glm::vec2 barycentricToR2(FacePoint p) {
-    return p.baryWeights[1] * vert1InFaceBasis[p.f] + p.baryWeights[2] * vert2InFaceBasis[p.f];
+    // Shuffle the list (if we're tracing fewer lines than the size of the list, we want them to be distributed evenly)
+    auto randomEngine = std::default_random_engine{};
+    std::shuffle(faceQueue.begin(), faceQueue.end(), randomEngine);
+
+    // Make sure the queue of triangles to process is long enough by repeating it
+    size_t iAppend = 0;
+    while (faceQueue.size() < nLines) {
+      faceQueue.push_back(faceQueue[iAppend++]);
+    }
   }
 
-  // Trace a single line through the field
+  // Trace the i'th line from the face queue. Each line draws from its own random stream seeded by its index, so the
+  // result is the same no matter which thread traces it, or in what order.
+  std::vector<std::array<glm::vec3, 2>> traceSeededLine(size_t iLine) {
+
+    std::seed_seq seq{baseSeed, static_cast<unsigned int>(iLine)};
+    std::mt19937 mt(seq);
+    std::uniform_real_distribution<double> unitDist(0.0, 1.0);
+    auto unitRand = [&]() { return unitDist(mt); };
+
+    // Get the starting triangle
+    size_t startTri = faceQueue[iLine];
+
+    // Generate a random point in the triangle
+    float r1 = unitRand();
+    float r2 = unitRand();
+    glm::vec3 randPoint{1.0 - std::sqrt(r1), std::sqrt(r1) * (1.0 - r2),
+                        r2 * std::sqrt(r1)};                           // uniform sampling in triangle
+    randPoint = unitSum(10000.f * randPoint + glm::vec3{1, 1, 1} / 3.f); // pull slightly towards center
+    const std::array<glm::vec2, 3>& c = triCorners[startTri];
+    glm::vec2 startPoint = randPoint[0] * c[0] + randPoint[1] * c[1] + randPoint[2] * c[2];
+
+    // trace half of lines backwards through field, reduces concentration near areas of convergence
+    float traceSign = unitRand() > 0.5 ? 1.0 : -1.0;
+
+    // Generate a random direction
+    // (the tracing code snaps the velocity to the best-fitting direction, this just serves the role of picking
+    // a random direction in symmetric fields)
+    glm::vec2 randomDir = glm::normalize(glm::vec2{unitRand() - .5, unitRand() - .5});
+
+    return traceLine(startTri, startPoint, randomDir, traceSign);
+  }
+
+  // Trace a single line through the field, starting from a point in the planar coordinates of a triangle's face
   // traceSign should be 1.0 or -1.0, useful for tracing lines backwards through field
-  std::vector<std::array<glm::vec3, 2>> traceLine(FacePoint startPoint, glm::vec2 startDir, float traceSign = 1.0) {
+  std::vector<std::array<glm::vec3, 2>> traceLine(size_t startTri, glm::vec2 startPoint, glm::vec2 startDir,
+                                                  float traceSign = 1.0) {
 
     // Accumulate the result here
     std::vector<std::array<glm::vec3, 2>> points;
 
     // Add the initial point
-    glm::vec3 initPoint = facePointInR3(startPoint);
-    points.push_back({{initPoint, mesh.faceNormals[startPoint.f]}});
+    size_t startFace = triFace[startTri];
+    points.push_back({{planarToR3(startFace, startPoint), faceNormal[startFace]}});
 
     // Trace!
-    FacePoint currPoint = startPoint;
+    size_t currTri = startTri;
+    glm::vec2 pointPos = startPoint;
     glm::vec2 currDir = startDir;
-    size_t nFaces = 0;
+    size_t faceCount = 0;
     float lengthRemaining = maxLineLength;
-    size_t prevFace = INVALID_IND;
-	size_t prevPrevFace = INVALID_IND;
-    while (lengthRemaining > 0 && currPoint.f != prevPrevFace && nFaces < maxFaceCount) {
+    size_t prevTri = INVALID_IND;
+    size_t prevPrevTri = INVALID_IND;
+    while (lengthRemaining > 0 && currTri != prevPrevTri && faceCount < maxFaceCount) {
 
-      nFaces++;
-      size_t currFace = currPoint.f;
+      // Keep track of the last two triangles visited
+      prevPrevTri = prevTri;
+      prevTri = currTri;
 
-      // Keep track of the last two faces visited
-      prevPrevFace = prevFace;
-      prevFace = currFace;
-
-      // Get the data in the basis for this face
-      glm::vec2 v0{0, 0};
-      glm::vec2 v1 = vert1InFaceBasis[currFace];
-      glm::vec2 v2 = vert2InFaceBasis[currFace];
-      glm::vec2 pointPos = barycentricToR2(currPoint);
+      size_t currFace = triFace[currTri];
+      const std::array<glm::vec2, 3>& corners = triCorners[currTri];
+      const std::array<TraceEdge, 3>& edges = triEdges[currTri];
 
       // Pick the best symmetric direction in the face
-      glm::vec2 faceDir = faceVectors[currFace];
-      glm::vec2 traceDir{0., 0.};
+      glm::vec2 faceDir = traceSign * faceVectors[currFace];
+      glm::vec2 traceDir = faceDir;
       float bestAlign = -std::numeric_limits<float>::infinity();
-      float deltaRot = 2.0 * PI / nSym;
       for (int iSym = 0; iSym < nSym; iSym++) {
-
-        float alignScore = dot(traceSign * faceDir, currDir);
-
+        float alignScore = glm::dot(faceDir, currDir);
         if (alignScore > bestAlign) {
           bestAlign = alignScore;
-          traceDir = traceSign * faceDir;
+          traceDir = faceDir;
         }
-
-        faceDir = glm::rotate(faceDir, deltaRot);
+        faceDir = glm::vec2{symRot.x * faceDir.x - symRot.y * faceDir.y, symRot.y * faceDir.x + symRot.x * faceDir.y};
       }
 
-      // Find when we would exit each edge (if ever)
-      IntersectionResult hit0 = rayLineIntersection(pointPos, traceDir, v0, v1);
-      IntersectionResult hit1 = rayLineIntersection(pointPos, traceDir, v1, v2);
-      IntersectionResult hit2 = rayLineIntersection(pointPos, traceDir, v2, v0);
-
-      // Check which edge we would exit first
-      size_t nextFace;
-      size_t nextHe;
-      size_t exitHe;
-      unsigned int exitHeLocalIndex = -1;
-      float tCross, tRay;
-      if (hit0.tRay <= hit1.tRay && hit0.tRay <= hit2.tRay) {
-        exitHeLocalIndex = 0;
-        exitHe = mesh.halfedgeIndices[currFace][0];
-        nextHe = mesh.twinHalfedge[exitHe];
-        tCross = 1.0 - hit0.tLine;
-        tRay = hit0.tRay;
-      } else if (hit1.tRay <= hit0.tRay && hit1.tRay <= hit2.tRay) {
-        exitHeLocalIndex = 1;
-        exitHe = mesh.halfedgeIndices[currFace][1];
-        nextHe = mesh.twinHalfedge[exitHe];
-        tCross = 1.0 - hit1.tLine;
-        tRay = hit1.tRay;
-      } else if (hit2.tRay <= hit0.tRay && hit2.tRay <= hit1.tRay) {
-        exitHeLocalIndex = 2;
-        exitHe = mesh.halfedgeIndices[currFace][2];
-        nextHe = mesh.twinHalfedge[exitHe];
-        tCross = 1.0 - hit2.tLine;
-        tRay = hit2.tRay;
-      } else {
-        // cerr << "tracing failure :(" << endl;
+      // Find the edge we would exit first. Only edges whose outward normal points along the ray can be exited.
+      unsigned char exitEdge = 3;
+      float tRay = std::numeric_limits<float>::infinity();
+      for (unsigned char k = 0; k < 3; k++) {
+        float denom = glm::dot(traceDir, edges[k].outNormal);
+        if (denom <= 0) continue;
+        float t = glm::dot(corners[k] - pointPos, edges[k].outNormal) / denom;
+        if (t < tRay) {
+          tRay = std::fmax(t, 0.f);
+          exitEdge = k;
+        }
+      }
+      if (exitEdge == 3) {
+        // tracing failure (degenerate triangle or zero vector)
         return points;
       }
 
-
-      // If the ray would end before exiting the face, end it
+      // If the ray would end before exiting the triangle, end it
       if (tRay > lengthRemaining) {
-        tRay = lengthRemaining;
-        glm::vec2 endingPos = pointPos + tRay * traceDir;
-        glm::vec3 endingPosR3 = mesh.vertices[mesh.faces[currFace][0]] +
-                                endingPos.x * mesh.faceTangentSpaces[currFace][0] +
-                                endingPos.y * mesh.faceTangentSpaces[currFace][1];
-        points.push_back({{endingPosR3, mesh.faceNormals[currFace]}});
+        glm::vec2 endingPos = pointPos + lengthRemaining * traceDir;
+        points.push_back({{planarToR3(currFace, endingPos), faceNormal[currFace]}});
         break;
       }
 
-      // Generate a point for this intersection
-      glm::vec2 newPointLocal = pointPos + tRay * traceDir;
-      glm::vec3 newPointR3 = mesh.vertices[mesh.faces[currFace][0]] +
-                             newPointLocal.x * mesh.faceTangentSpaces[currFace][0] +
-                             newPointLocal.y * mesh.faceTangentSpaces[currFace][1];
-      glm::vec3 newNormal = mesh.faceNormals[currFace];
-      if (nextHe != INVALID_IND) {
-        nextFace = mesh.faceForHalfedge[nextHe];
-        newNormal = glm::normalize(newNormal + mesh.faceNormals[nextFace]);
-      }
-      points.push_back({{newPointR3, newNormal}});
+      // Where along the exit edge we cross
+      const TraceEdge& edge = edges[exitEdge];
+      glm::vec2 exitPos = pointPos + tRay * traceDir;
+      glm::vec2 edgeVec = corners[(exitEdge + 1) % 3] - corners[exitEdge];
+      float tLine = glm::dot(exitPos - corners[exitEdge], edgeVec) / glm::dot(edgeVec, edgeVec);
+      tLine = std::fmin(std::fmax(tLine, 0.f), 1.f);
 
+      lengthRemaining -= tRay;
 
       // Quit if we hit a boundary
-      if (nextHe == INVALID_IND) {
+      if (edge.neighbor == INVALID_IND) {
+        points.push_back({{planarToR3(currFace, exitPos), faceNormal[currFace]}});
         break;
       }
 
+      size_t nextTri = edge.neighbor;
+      size_t nextFace = triFace[nextTri];
 
-      // Subtract off the length expended in this face
-      lengthRemaining -= tRay;
-
-
-      // Find a direction of travel in the new face
-      currDir = rotateToTangentBasis(traceDir, mesh.faceTangentSpaces[currFace][0], mesh.faceTangentSpaces[currFace][1],
-                                     mesh.faceTangentSpaces[nextFace][0], mesh.faceTangentSpaces[nextFace][1]);
-
-      // Figure out which halfedge in the next face is nextHe
-      unsigned int nextHeLocalIndex = 0;
-      while (mesh.halfedgeIndices[nextFace][nextHeLocalIndex] != nextHe) {
-        nextHeLocalIndex++;
-      }
-
-      // On a non-manifold / not oriented mesh, the halfedges we're transitioning between might actually point the same
-      // way. If so, flip tCross.
-      size_t currTailVert = mesh.faces[currFace][exitHeLocalIndex];
-      size_t nextTailVert = mesh.faces[nextFace][nextHeLocalIndex];
-      if (currTailVert == nextTailVert) {
-        tCross = 1.0 - tCross;
+      // Generate a point when the line crosses between faces (the line is straight within a face, so crossing a
+      // diagonal of the fan needs no point)
+      if (!edge.sameFace) {
+        faceCount++;
+        glm::vec3 newNormal = glm::normalize(faceNormal[currFace] + faceNormal[nextFace]);
+        points.push_back({{planarToR3(currFace, exitPos), newNormal}});
+        currDir = edge.transport * traceDir;
+      } else {
+        currDir = traceDir;
       }
 
-      // Clamp for safety
-      tCross = std::fmin(tCross, 1.0);
-      tCross = std::fmax(tCross, 0.);
+      // Find the position on the shared edge in the next triangle
+      const std::array<glm::vec2, 3>& nextCorners = triCorners[nextTri];
+      unsigned char nk = edge.neighborEdge;
+      float tCross = edge.reversed ? 1.0f - tLine : tLine;
+      glm::vec2 nextPos = nextCorners[nk] + tCross * (nextCorners[(nk + 1) % 3] - nextCorners[nk]);
 
-      // Find barycentric coordinates in the new face
-      currPoint = FacePoint{nextFace, {0, 0, 0}};
-      currPoint.baryWeights[nextHeLocalIndex] = 1.0 - tCross;
-      currPoint.baryWeights[(nextHeLocalIndex + 1) % 3] = tCross;
-
-
-      // Pull the result slightly towards the center of the new face to minimize numerical difficulties
-      currPoint.baryWeights = unitSum(10000.f * currPoint.baryWeights + glm::vec3{1, 1, 1} / 3.f);
+      // Pull the result slightly towards the center of the new triangle to minimize numerical difficulties
+      glm::vec2 nextCenter = (nextCorners[0] + nextCorners[1] + nextCorners[2]) / 3.f;
+      pointPos = (10000.f * nextPos + nextCenter) / 10001.f;
+      currTri = nextTri;
     }
 
-
     return points;
   }
 };
 
-
-}; // namespace
-
 // Rotate in to a new basis in R3. Vector is rotated in to new tangent plane, then a change of basis is performed to
 // the new basis. Basis vectors MUST be unit and orthogonal -- this function doesn't check.
 glm::vec2 rotateToTangentBasis(glm::vec2 v, const glm::vec3& oldBasisX, const glm::vec3& oldBasisY,
@@ -326,94 +434,107 @@ glm::vec2 rotateToTangentBasis(glm::vec2 v, const glm::vec3& oldBasisX, const gl
   return glm::vec2{xComp, yComp};
 }
 
-std::vector<std::vector<std::array<glm::vec3, 2>>> traceField(SurfaceMesh& mesh, const std::vector<glm::vec2>& field,
-                                                              int nSym, size_t nLines) {
+namespace {
 
-  // Only works on triangle meshes
-  for (auto& face : mesh.faces) {
-    if (face.size() != 3) {
-      polyscope::warning("field tracing only supports triangular meshes");
-      return std::vector<std::vector<std::array<glm::vec3, 2>>>();
-    }
+size_t defaultLineCount(SurfaceMesh& mesh, size_t nLines) {
+  // Compute a reasonable number of lines if no count was specified
+  if (nLines == 0) {
+    float lineFactor = 10;
+    nLines = static_cast<size_t>(std::ceil(lineFactor * std::sqrt(mesh.nFaces())));
   }
+  return nLines;
+}
+
+} // namespace
+
+std::vector<std::vector<std::array<glm::vec3, 2>>> traceField(SurfaceMesh& mesh, const std::vector<glm::vec2>& field,
+                                                              int nSym, size_t nLines) {
 
   // Preliminaries
+  nLines = defaultLineCount(mesh, nLines);
 
   // Create a tracer
   FieldTracer tracer(mesh, field, nSym);
-
-  // Compute a reasonable number of lines if no count was specified
-  if (nLines == 0) {
-    float lineFactor = 10;
-    nLines = static_cast<size_t>(std::ceil(lineFactor * std::sqrt(mesh.nFaces())));
+  if (tracer.nTriangles() == 0) {
+    return std::vector<std::vector<std::array<glm::vec3, 2>>>();
   }
+  tracer.buildFaceQueue(nLines);
 
-  // Shuffle the list of faces to get a reasonable distribution of starting points
-  // Build a list of faces to start lines in. Unusually large faces get listed multiple times so we start more lines in
-  // them. This roughly approximates a uniform sampling of the mesh. Small faces get oversampled, but that's much less
-  // visually striking than large faces getting undersampled.
-  std::vector<size_t> faceQueue;
-  {
-    float meanArea = tracer.totalArea / mesh.nFaces();
-    for (size_t iF = 0; iF < mesh.nFaces(); iF++) {
-      faceQueue.push_back(iF);
-      float faceArea = mesh.faceAreas[iF];
-      while (faceArea > meanArea) {
-        faceQueue.push_back(iF);
-        faceArea -= meanArea;
-      }
+  // == Trace the lines
+  std::vector<std::vector<std::array<glm::vec3, 2>>> lineList(nLines);
+  tasks::parallelFor(0, nLines, traceBatchSize, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      lineList[i] = tracer.traceSeededLine(i);
     }
+  });
 
-    // Shuffle the list (if we're tracing fewer lines than the size of the list, we want them to be distributed evenly)
-    auto randomEngine = std::default_random_engine{};
-    std::shuffle(faceQueue.begin(), faceQueue.end(), randomEngine);
+  return lineList;
+}
 
-    // Make sure the queue of faces to process is long enough by repeating it
-    int iAppend = 0;
-    while (faceQueue.size() < nLines) {
-      faceQueue.push_back(faceQueue[iAppend++]);
-    }
-  }
+// ========================================================
+// ==========        Background Tracing          ==========
+// ========================================================
 
-  // Unit random numbers
-  std::random_device device;
-  std::mt19937 mt(device());
-  std::uniform_real_distribution<double> unitDist(0.0, 1.0);
-  auto unitRand = [&]() { return unitDist(mt); };
+FieldTraceJob::FieldTraceJob(SurfaceMesh& mesh, const std::vector<glm::vec2>& field, int nSym, size_t nLines) {
 
+  // All mesh data is copied here on the calling thread; tasks only touch the tracer
+  tracer.reset(new FieldTracer(mesh, field, nSym));
+  if (tracer->nTriangles() == 0) {
+    return;
+  }
 
-  // == Trace the lines
-  // cout << "Tracing lines through vector field... " << endl;
-  std::vector<std::vector<std::array<glm::vec3, 2>>> lineList;
-  for (size_t i = 0; i < nLines; i++) {
+  nLinesTotal = defaultLineCount(mesh, nLines);
+  tracer->buildFaceQueue(nLinesTotal);
 
+  // Many small tasks rather than one long one per thread, so other background work is not starved while tracing
+  nBatches = tasks::chunkCount(0, nLinesTotal, traceBatchSize);
+  for (size_t iBatch = 0; iBatch < nBatches; iBatch++) {
+    tasks::submit([this, iBatch]() { traceBatch(iBatch); });
+  }
+}
 
-    // Get the next starting face
-    size_t startFace = faceQueue.back();
-    faceQueue.pop_back();
+FieldTraceJob::~FieldTraceJob() { cancel(); }
 
-    // Generate a random point in the face
-    float r1 = unitRand();
-    float r2 = unitRand();
-    glm::vec3 randPoint{1.0 - std::sqrt(r1), std::sqrt(r1) * (1.0 - r2),
-                        r2 * std::sqrt(r1)};                           // uniform sampling in triangle
-    randPoint = unitSum(10000.f * randPoint + glm::vec3{1, 1, 1} / 3.f); // pull slightly towards center
+void FieldTraceJob::traceBatch(size_t iBatch) {
+  size_t iEnd = std::min(nLinesTotal, (iBatch + 1) * traceBatchSize);
+  for (size_t iLine = iBatch * traceBatchSize; iLine < iEnd && !cancelRequested; iLine++) {
 
-    // trace half of lines backwards through field, reduces concentration near areas of convergence
-    float traceSign = unitRand() > 0.5 ? 1.0 : -1.0;
+    std::vector<std::array<glm::vec3, 2>> line = tracer->traceSeededLine(iLine);
 
-    // Generate a random direction
-    // (the tracing code snaps the velocity to the best-fitting direction, this just serves the role of picking
-    // a random direction in symmetric fields)
-    glm::vec2 randomDir = glm::normalize(glm::vec2{unitRand() - .5, unitRand() - .5});
+    {
+      std::lock_guard<std::mutex> lock(finishedMutex);
+      finishedLines.push_back(std::move(line));
+    }
+    nLinesDone++;
+  }
 
-    // Trace
-    lineList.push_back(tracer.traceLine(FacePoint{startFace, randPoint}, randomDir, traceSign));
+  std::lock_guard<std::mutex> lock(batchMutex);
+  nBatchesDone++;
+  if (nBatchesDone == nBatches) {
+    batchesDone.notify_all();
   }
-  // cout << "    ... done tracing field." << endl;
+}
 
+void FieldTraceJob::cancel() {
+  cancelRequested = true;
 
-  return lineList;
+  // Queued batches still run, but return immediately
+  std::unique_lock<std::mutex> lock(batchMutex);
+  batchesDone.wait(lock, [&]() { return nBatchesDone == nBatches; });
 }
 
+size_t FieldTraceJob::takeFinishedLines(std::vector<std::vector<std::array<glm::vec3, 2>>>& out) {
+  std::lock_guard<std::mutex> lock(finishedMutex);
+  size_t nTaken = finishedLines.size();
+  for (std::vector<std::array<glm::vec3, 2>>& line : finishedLines) {
+    out.push_back(std::move(line));
+  }
+  finishedLines.clear();
+  return nTaken;
+}
+
+bool FieldTraceJob::isFinished() { return cancelRequested || nLinesDone == nLinesTotal; }
+
+size_t FieldTraceJob::nLinesFinished() { return nLinesDone; }
+
 } // namespace polyscope
@@ -85,11 +85,6 @@ void TransformationGizmo::draw() {
   arrowProgram->setUniform("u_modelView", glm::value_ptr(viewMat));
   sphereProgram->setUniform("u_modelView", glm::value_ptr(viewMat));
 
-  glm::mat4 projMat = view::getCameraPerspectiveMatrix();
-  ringProgram->setUniform("u_projMatrix", glm::value_ptr(projMat));
-  arrowProgram->setUniform("u_projMatrix", glm::value_ptr(projMat));
-  sphereProgram->setUniform("u_projMatrix", glm::value_ptr(projMat));
-
   ringProgram->setUniform("u_diskWidthRel", diskWidthObj);
 
   // set selections
@@ -108,16 +103,9 @@ void TransformationGizmo::draw() {
     sphereColor = glm::vec3(0.95);
   }
 
-  glm::mat4 P = view::getCameraPerspectiveMatrix();
-  glm::mat4 Pinv = glm::inverse(P);
-  arrowProgram->setUniform("u_invProjMatrix", glm::value_ptr(Pinv));
-  arrowProgram->setUniform("u_viewport", render::engine->getCurrentViewport());
   arrowProgram->setUniform("u_lengthMult", vecLength);
   arrowProgram->setUniform("u_radius", 0.2 * gizmoSize);
 
-  sphereProgram->setUniform("u_invProjMatrix", glm::value_ptr(Pinv));
-  sphereProgram->setUniform("u_viewport", render::engine->getCurrentViewport());
-
   sphereProgram->setUniform("u_pointRadius", sphereRad * gizmoSize);
   sphereProgram->setUniform("u_baseColor", sphereColor);
 
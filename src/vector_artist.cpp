@@ -47,14 +47,14 @@ void VectorArtist::draw() {
     program->setUniform("u_lengthMult", vectorLengthMult.get().asAbsolute() / maxLength);
   }
 
-  glm::mat4 P = view::getCameraPerspectiveMatrix();
-  glm::mat4 Pinv = glm::inverse(P);
-  program->setUniform("u_invProjMatrix", glm::value_ptr(Pinv));
-  program->setUniform("u_viewport", render::engine->getCurrentViewport());
-
   program->draw();
 }
 
+double VectorArtist::drawMargin() {
+  double length = vectorType == VectorType::AMBIENT ? maxLength : vectorLengthMult.get().asAbsolute();
+  return length + vectorRadius.get().asAbsolute();
+}
+
 void VectorArtist::createProgram() {
   program = render::engine->requestShader("RAYCAST_VECTOR", {"SHADE_BASECOLOR"});
 
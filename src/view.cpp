@@ -154,7 +154,7 @@ void processRotate(glm::vec2 startP, glm::vec2 endP) {
   }
 
 
-  requestRedraw();
+  requestViewRedraw();
   immediatelyEndFlight();
 }
 
@@ -165,7 +165,7 @@ void processRotateArcball(glm::vec2 startP, glm::vec2 endP) {
   }
 
 
-  requestRedraw();
+  requestViewRedraw();
   immediatelyEndFlight();
 }
 
@@ -178,7 +178,7 @@ void processTranslate(glm::vec2 delta) {
   glm::mat4x4 camSpaceT = glm::translate(glm::mat4x4(1.0), movementScale * glm::vec3(delta.x, delta.y, 0.0));
   viewMat = camSpaceT * viewMat;
 
-  requestRedraw();
+  requestViewRedraw();
   immediatelyEndFlight();
 }
 
@@ -186,7 +186,7 @@ void processClipPlaneShift(double amount) {
   if (amount == 0.0) return;
   // Adjust the near clipping plane
   nearClipRatio += .03 * amount * nearClipRatio;
-  requestRedraw();
+  requestViewRedraw();
 }
 
 void processZoom(double amount) {
@@ -198,7 +198,7 @@ void processZoom(double amount) {
   viewMat = camSpaceT * viewMat;
 
   immediatelyEndFlight();
-  requestRedraw();
+  requestViewRedraw();
 }
 
 void invalidateView() { viewMat = glm::mat4x4(std::numeric_limits<float>::quiet_NaN()); }
@@ -289,7 +289,7 @@ void resetCameraToHomeView() {
   nearClipRatio = defaultNearClipRatio;
   farClipRatio = defaultFarClipRatio;
 
-  requestRedraw();
+  requestViewRedraw();
 }
 
 void flyToHomeView() {
@@ -413,7 +413,7 @@ void updateFlight() {
       // linear spline
       fov = (1.0f - t) * flightInitialFov + t * flightTargetFov;
     }
-    requestRedraw(); // flight is still happening, draw again next frame
+    requestViewRedraw(); // flight is still happening, draw again next frame
   }
 }
 
@@ -488,7 +488,7 @@ void setCameraFromJson(std::string jsonData, bool flyTo) {
   } else {
     viewMat = newViewMat;
     fov = newFov;
-    requestRedraw();
+    requestViewRedraw();
   }
 }
 
@@ -595,7 +595,7 @@ void buildViewGui() {
     float fovF = fov;
     if (ImGui::SliderFloat(" Field of View", &fovF, 5.0, 160.0, "%.2f deg")) {
       fov = fovF;
-      requestRedraw();
+      requestViewRedraw();
     };
 
     // Clip planes
@@ -603,11 +603,11 @@ void buildViewGui() {
     float farClipRatioF = farClipRatio;
     if (ImGui::SliderFloat(" Clip Near", &nearClipRatioF, 0., 10., "%.5f", 3.)) {
       nearClipRatio = nearClipRatioF;
-      requestRedraw();
+      requestViewRedraw();
     }
     if (ImGui::SliderFloat(" Clip Far", &farClipRatioF, 1., 1000., "%.2f", 3.)) {
       farClipRatio = farClipRatioF;
-      requestRedraw();
+      requestViewRedraw();
     }
 
     // Move speed
@@ -0,0 +1,848 @@
+// Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
+#include "polyscope/volume_grid.h"
+
+#include "polyscope/file_helpers.h"
+#include "polyscope/polyscope.h"
+#include "polyscope/render/engine.h"
+#include "polyscope/surface_mesh.h"
+#include "polyscope/task_scheduler.h"
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace polyscope {
+
+// Initialize statics
+const std::string VolumeGrid::structureTypeName = "Volume Grid";
+
+namespace {
+
+// Texels per slab when uploading the volume texture, which bounds the size of the conversion buffer
+const size_t textureUploadSlabSize = 1 << 22;
+
+size_t bytesPerSample(VolumeDataType type) { return type == VolumeDataType::Float ? sizeof(float) : sizeof(uint16_t); }
+
+// Texels per side of a slot in the brick atlas: a brick, plus the samples just before its lower faces and past its
+// upper faces, so that interpolation within the slot matches the dense grid out to the neighboring bricks
+const unsigned int atlasSlotSize = VolumeGridBricks::brickSize + 2;
+const size_t atlasSlotTexels = atlasSlotSize * atlasSlotSize * atlasSlotSize;
+
+// The number of atlas slots along each side, with as many slots as possible but at most maxSlots in total (so the atlas
+// stays within its memory budget). There are few enough candidates to try them all.
+glm::uvec3 atlasSlotCounts(size_t maxSlots, size_t maxPerSide) {
+  glm::uvec3 best{1, 1, 1};
+  size_t bestSlots = 1;
+  for (size_t x = 1; x <= std::min(maxSlots, maxPerSide); x++) {
+    for (size_t y = 1; y <= std::min(maxSlots / x, maxPerSide); y++) {
+      size_t z = std::min(maxSlots / (x * y), maxPerSide);
+      if (x * y * z > bestSlots) {
+        best = glm::uvec3(x, y, z);
+        bestSlots = x * y * z;
+      }
+    }
+  }
+  return best;
+}
+
+// Bricks per upload batch, which bounds the size of the conversion buffer
+const size_t brickUploadBatchSize = 4096;
+
+// Range of the finite samples, in parallel over runs of samples (or over the stored bricks of sparse grids)
+std::pair<double, double> computeDataRange(const VolumeGridSamples& samples) {
+  size_t chunkSize = 1 << 16;
+  std::vector<std::pair<float, float>> chunkRanges;
+  auto accumulate = [](std::pair<float, float>& range, float v) {
+    if (!std::isfinite(v)) return;
+    range.first = std::min(range.first, v);
+    range.second = std::max(range.second, v);
+  };
+  std::pair<float, float> emptyRange{std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity()};
+
+  if (samples.bricks == nullptr) {
+    chunkRanges.resize(tasks::chunkCount(0, samples.size(), chunkSize), emptyRange);
+    tasks::parallelFor(0, samples.size(), chunkSize, [&](size_t begin, size_t end) {
+      std::pair<float, float>& range = chunkRanges[begin / chunkSize];
+      for (size_t i = begin; i < end; i++) {
+        accumulate(range, samples[i]);
+      }
+    });
+  } else {
+    const VolumeGridBricks& bricks = *samples.bricks;
+    const unsigned int B = VolumeGridBricks::brickSize;
+    chunkSize = 64;
+    chunkRanges.resize(tasks::chunkCount(0, bricks.nStoredBricks(), chunkSize), emptyRange);
+    tasks::parallelFor(0, bricks.nStoredBricks(), chunkSize, [&](size_t begin, size_t end) {
+      std::pair<float, float>& range = chunkRanges[begin / chunkSize];
+      for (size_t iB = begin; iB < end; iB++) {
+        glm::uvec3 start = bricks.brickCoords[iB] * B;
+        glm::uvec3 count = glm::min(glm::uvec3(B), bricks.dims - start);
+        for (unsigned int z = 0; z < count.z; z++) {
+          for (unsigned int y = 0; y < count.y; y++) {
+            for (unsigned int x = 0; x < count.x; x++) {
+              accumulate(range, bricks.sample(start.x + x, start.y + y, start.z + z));
+            }
+          }
+        }
+      }
+    });
+    if (bricks.nStoredBricks() < bricks.brickIndex.size()) {
+      chunkRanges.push_back(emptyRange);
+      accumulate(chunkRanges.back(), bricks.background);
+    }
+  }
+
+  std::pair<double, double> dataRange{std::numeric_limits<double>::infinity(),
+                                      -std::numeric_limits<double>::infinity()};
+  for (const std::pair<float, float>& range : chunkRanges) {
+    dataRange.first = std::min(dataRange.first, static_cast<double>(range.first));
+    dataRange.second = std::max(dataRange.second, static_cast<double>(range.second));
+  }
+  if (dataRange.first > dataRange.second) {
+    dataRange = std::make_pair(0., 1.); // no finite samples
+  }
+  return dataRange;
+}
+
+} // namespace
+
+// Constructor
+VolumeGrid::VolumeGrid(std::string name, VolumeGridSamples samples_, glm::vec3 origin_, glm::vec3 spacing_,
+                       std::shared_ptr<const void> dataOwner_)
+    : Structure(name, structureTypeName), dataOwner(std::move(dataOwner_)), samples(samples_), origin(origin_),
+      spacing(spacing_), dataRange(computeDataRange(samples)),
+      blockRanges(computeVolumeGridBlockRanges(samples)), sliceXEnabled(uniquePrefix() + "#sliceXEnabled", false),
+      sliceYEnabled(uniquePrefix() + "#sliceYEnabled", false), sliceZEnabled(uniquePrefix() + "#sliceZEnabled", true),
+      axisSlicePositions(uniquePrefix() + "#axisSlicePositions", glm::vec3{.5, .5, .5}),
+      planeSliceEnabled(uniquePrefix() + "#planeSliceEnabled", false),
+      planeSlicePoint(uniquePrefix() + "#planeSlicePoint", origin_ + .5f * spacing_ * glm::vec3(samples_.dims - 1u)),
+      planeSliceNormal(uniquePrefix() + "#planeSliceNormal", glm::vec3{1., 1., 1.}),
+      cMap(uniquePrefix() + "#cmap", "viridis"), vizRange(dataRange),
+      isosurfaceEnabled(uniquePrefix() + "#isosurfaceEnabled", false),
+      isoValue(uniquePrefix() + "#isoValue", .5 * (dataRange.first + dataRange.second)),
+      isosurfaceColor(uniquePrefix() + "#isosurfaceColor", getNextUniqueColor()),
+      material(uniquePrefix() + "#material", "clay") {}
+
+// === Drawing
+
+void VolumeGrid::draw() {
+  if (!isEnabled()) {
+    return;
+  }
+
+  // Slices
+  if (sliceXEnabled.get() || sliceYEnabled.get() || sliceZEnabled.get() || planeSliceEnabled.get()) {
+    if (volumeTexture == nullptr) {
+      prepareVolumeTexture();
+    }
+    if (sliceProgram == nullptr) {
+      prepareSlices();
+    }
+
+    setTransformUniforms(*sliceProgram);
+    sliceProgram->setUniform("u_rangeLow", vizRange.first);
+    sliceProgram->setUniform("u_rangeHigh", vizRange.second);
+    sliceProgram->draw();
+  }
+
+  // Isosurface
+  if (isosurfaceEnabled.get()) {
+    prepareIsosurface();
+
+    if (isosurfaceProgram != nullptr) {
+      setTransformUniforms(*isosurfaceProgram);
+      isosurfaceProgram->setUniform("u_baseColor", isosurfaceColor.get());
+      isosurfaceProgram->draw();
+    }
+  }
+}
+
+void VolumeGrid::drawPick() {
+  // Grids are not pickable
+}
+
+void VolumeGrid::prepareVolumeTexture() {
+  glm::uvec3 dims = samples.dims;
+
+  // Sparse grids get an empty atlas, which is filled as the slices need bricks
+  if (isSparse()) {
+    size_t slotBytes = atlasSlotTexels * sizeof(float);
+    size_t maxSlots = std::min(samples.bricks->nStoredBricks(), brickMemoryBudget / slotBytes);
+    size_t maxSlotsPerSide = std::max<size_t>(render::engine->getMax3DTextureSize() / atlasSlotSize, 1);
+    atlasSlots = atlasSlotCounts(std::max<size_t>(maxSlots, 1), maxSlotsPerSide);
+    size_t nSlots = static_cast<size_t>(atlasSlots.x) * atlasSlots.y * atlasSlots.z;
+
+    glm::uvec3 atlasDims = atlasSlots * atlasSlotSize;
+    volumeTexture = render::engine->generateTextureBuffer(TextureFormat::R32F, atlasDims.x, atlasDims.y, atlasDims.z,
+                                                          nullptr);
+    volumeTexture->setFilterMode(FilterMode::Linear);
+    brickCache.reset(new VolumeGridBrickCache(nSlots));
+    return;
+  }
+
+  // Half data stays half on the GPU, everything else is converted to floats
+  TextureFormat format = samples.type == VolumeDataType::Half ? TextureFormat::R16F : TextureFormat::R32F;
+  volumeTexture = render::engine->generateTextureBuffer(format, dims.x, dims.y, dims.z, nullptr);
+
+  // Upload a slab of z-layers at a time, so the samples are never all converted at once
+  size_t layerSize = static_cast<size_t>(dims.x) * dims.y;
+  size_t slabLayers = std::max<size_t>(1, textureUploadSlabSize / std::max<size_t>(1, layerSize));
+  std::vector<float> slab;
+  for (size_t zStart = 0; zStart < dims.z; zStart += slabLayers) {
+    size_t nLayers = std::min<size_t>(slabLayers, dims.z - zStart);
+    slab.resize(nLayers * layerSize);
+    size_t offset = zStart * layerSize;
+    tasks::parallelFor(0, slab.size(), 1 << 16, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        slab[i] = samples[offset + i];
+      }
+    });
+    volumeTexture->setSubData3D(0, 0, zStart, dims.x, dims.y, nLayers, slab.data());
+  }
+
+  volumeTexture->setFilterMode(FilterMode::Linear);
+}
+
+void VolumeGrid::uploadBricks(const std::vector<std::pair<uint32_t, uint32_t>>& bricksAndSlots) {
+  const VolumeGridBricks& bricks = *samples.bricks;
+  const unsigned int B = VolumeGridBricks::brickSize;
+  glm::uvec3 maxSample = bricks.dims - 1u;
+
+  std::vector<float> buffer;
+  for (size_t batchStart = 0; batchStart < bricksAndSlots.size(); batchStart += brickUploadBatchSize) {
+    size_t batchEnd = std::min(batchStart + brickUploadBatchSize, bricksAndSlots.size());
+    buffer.resize((batchEnd - batchStart) * atlasSlotTexels);
+
+    // Fill each slot from its brick, and the neighboring bricks just outside it (the slot starts one sample before
+    // the brick)
+    tasks::parallelFor(batchStart, batchEnd, 64, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        glm::ivec3 start = glm::ivec3(bricks.brickCoords[bricksAndSlots[i].first] * B) - 1;
+        float* slot = &buffer[(i - batchStart) * atlasSlotTexels];
+        for (unsigned int z = 0; z < atlasSlotSize; z++) {
+          for (unsigned int y = 0; y < atlasSlotSize; y++) {
+            for (unsigned int x = 0; x < atlasSlotSize; x++) {
+              glm::uvec3 p = glm::min(glm::uvec3(glm::max(start + glm::ivec3(x, y, z), 0)), maxSample);
+              slot[x + atlasSlotSize * (y + atlasSlotSize * z)] = bricks.sample(p.x, p.y, p.z);
+            }
+          }
+        }
+      }
+    });
+
+    for (size_t i = batchStart; i < batchEnd; i++) {
+      uint32_t iSlot = bricksAndSlots[i].second;
+      glm::uvec3 slotCoord{iSlot % atlasSlots.x, (iSlot / atlasSlots.x) % atlasSlots.y,
+                           iSlot / (atlasSlots.x * atlasSlots.y)};
+      glm::uvec3 offset = slotCoord * atlasSlotSize;
+      volumeTexture->setSubData3D(offset.x, offset.y, offset.z, atlasSlotSize, atlasSlotSize, atlasSlotSize,
+                                  &buffer[(i - batchStart) * atlasSlotTexels]);
+    }
+  }
+}
+
+void VolumeGrid::prepareSlices() {
+  std::vector<std::string> rules = {"MESH_SAMPLE_VOLUME_VALUE", "SHADE_COLORMAP_VALUE", "MESH_BACKFACE_NORMAL_FLIP"};
+  sliceProgram = render::engine->requestShader("MESH", rules);
+  bool wantsBary = sliceProgram->hasAttribute("a_barycoord");
+  if (isSparse()) {
+    assembleSparseSliceBuffers(wantsBary).uploadTo(*sliceProgram);
+  } else {
+    assembleSliceBuffers(wantsBary).uploadTo(*sliceProgram);
+  }
+  sliceProgram->setTextureFromBuffer("t_volume", volumeTexture.get());
+  sliceProgram->setTextureFromColormap("t_colormap", cMap.get());
+  render::engine->setMaterial(*sliceProgram, getMaterial());
+}
+
+// A slice plane, in the coordinates of the samples
+struct VolumeGrid::SlicePlane {
+  glm::vec3 point;
+  glm::vec3 normal;
+  glm::vec3 worldNormal; // for shading
+};
+
+namespace {
+
+// The polygon where a plane cuts a box, with its corners in counter-clockwise order around the normal, or nothing
+std::vector<glm::vec3> planeBoxPolygon(glm::vec3 boxMin, glm::vec3 boxMax, glm::vec3 point, glm::vec3 normal) {
+  auto corner = [&](int i) {
+    return glm::vec3{(i & 1) ? boxMax.x : boxMin.x, (i & 2) ? boxMax.y : boxMin.y, (i & 4) ? boxMax.z : boxMin.z};
+  };
+
+  std::vector<glm::vec3> poly;
+  for (int i = 0; i < 8; i++) {
+    for (int bit : {1, 2, 4}) {
+      if (i & bit) continue;
+      glm::vec3 pA = corner(i);
+      glm::vec3 pB = corner(i | bit);
+      float dA = glm::dot(pA - point, normal);
+      float dB = glm::dot(pB - point, normal);
+      if ((dA < 0) == (dB < 0)) continue;
+      poly.push_back(pA + (dA / (dA - dB)) * (pB - pA));
+    }
+  }
+  if (poly.size() < 3) return std::vector<glm::vec3>();
+
+  // Order the points around their center
+  glm::vec3 center{0., 0., 0.};
+  for (glm::vec3 p : poly) center += p;
+  center /= static_cast<float>(poly.size());
+  glm::vec3 basisX = poly[0] - center;
+  glm::vec3 basisY = glm::cross(normal, basisX);
+  std::sort(poly.begin(), poly.end(), [&](glm::vec3 a, glm::vec3 b) {
+    return std::atan2(glm::dot(a - center, basisY), glm::dot(a - center, basisX)) <
+           std::atan2(glm::dot(b - center, basisY), glm::dot(b - center, basisX));
+  });
+  return poly;
+}
+
+// Triangles of slice polygons, with a texture coordinate for each corner
+struct SliceTriangles {
+  bool wantsBary;
+  std::vector<glm::vec3> positions;
+  std::vector<glm::vec3> normals;
+  std::vector<glm::vec3> bcoord;
+  std::vector<glm::vec3> volumeCoords;
+
+  // Add a convex polygon as a fan of triangles
+  template <typename F>
+  void addPolygon(const std::vector<glm::vec3>& poly, glm::vec3 normal, glm::vec3 origin, glm::vec3 spacing,
+                  F volumeCoord) {
+    for (size_t j = 1; j + 1 < poly.size(); j++) {
+      for (glm::vec3 p : {poly[0], poly[j], poly[j + 1]}) {
+        positions.push_back(origin + spacing * p);
+        normals.push_back(normal);
+        volumeCoords.push_back(volumeCoord(p));
+      }
+      if (wantsBary) {
+        bcoord.push_back(glm::vec3{1., 0., 0.});
+        bcoord.push_back(glm::vec3{0., 1., 0.});
+        bcoord.push_back(glm::vec3{0., 0., 1.});
+      }
+    }
+  }
+
+  render::StagedAttributes toAttributes() {
+    render::StagedAttributes attributes;
+    attributes.add("a_position", std::move(positions));
+    attributes.add("a_normal", std::move(normals));
+    attributes.add("a_volumeCoord", std::move(volumeCoords));
+    if (wantsBary) {
+      attributes.add("a_barycoord", std::move(bcoord));
+    }
+    return attributes;
+  }
+};
+
+} // namespace
+
+std::vector<VolumeGrid::SlicePlane> VolumeGrid::slicePlanes() {
+  std::vector<SlicePlane> planes;
+  glm::vec3 maxSample(samples.dims - 1u);
+
+  // Axis slices, kept just inside the grid so that slices on its faces still cut it
+  for (int axis = 0; axis < 3; axis++) {
+    if (!axisSliceEnabled(axis).get() || samples.dims[axis] < 2) continue;
+    SlicePlane plane;
+    plane.point = glm::vec3{0., 0., 0.};
+    float inset = 1e-3 * maxSample[axis];
+    plane.point[axis] = glm::clamp(axisSlicePositions.get()[axis] * maxSample[axis], inset, maxSample[axis] - inset);
+    plane.normal = glm::vec3{0., 0., 0.};
+    plane.normal[axis] = 1.;
+    plane.worldNormal = plane.normal;
+    planes.push_back(plane);
+  }
+
+  // The plane slice is given in the grid's coordinates
+  if (planeSliceEnabled.get() && glm::length(planeSliceNormal.get()) > 0) {
+    SlicePlane plane;
+    plane.point = (planeSlicePoint.get() - origin) / spacing;
+    plane.normal = planeSliceNormal.get() * spacing;
+    plane.worldNormal = glm::normalize(planeSliceNormal.get());
+    planes.push_back(plane);
+  }
+
+  return planes;
+}
+
+render::StagedAttributes VolumeGrid::assembleSliceBuffers(bool wantsBary) {
+  SliceTriangles triangles;
+  triangles.wantsBary = wantsBary;
+
+  // Texture coordinates at the centers of the texels, so the first and last samples are hit exactly
+  glm::vec3 dimsF(samples.dims);
+  auto volumeCoord = [&](glm::vec3 p) { return (p + .5f) / dimsF; };
+
+  for (const SlicePlane& plane : slicePlanes()) {
+    std::vector<glm::vec3> poly = planeBoxPolygon(glm::vec3{0., 0., 0.}, dimsF - 1.f, plane.point, plane.normal);
+    triangles.addPolygon(poly, plane.worldNormal, origin, spacing, volumeCoord);
+  }
+
+  return triangles.toAttributes();
+}
+
+render::StagedAttributes VolumeGrid::assembleSparseSliceBuffers(bool wantsBary) {
+  const VolumeGridBricks& bricks = *samples.bricks;
+  const unsigned int B = VolumeGridBricks::brickSize;
+  glm::vec3 maxSample(samples.dims - 1u);
+  std::vector<SlicePlane> planes = slicePlanes();
+
+  // The part of each slice in each stored brick. Empty bricks are skipped, except for their cells next to stored
+  // bricks: the samples of those cells interpolate towards the stored brick, so each stored brick also draws the last
+  // layer of cells of the empty bricks below it. (Where several stored bricks border the same empty cells, such as
+  // along an edge, they draw the same values there.)
+  struct BrickPolygon {
+    uint32_t brick;
+    const SlicePlane* plane;
+    std::vector<glm::vec3> poly;
+  };
+  size_t chunkSize = 1024;
+  std::vector<std::vector<BrickPolygon>> chunkPolygons(tasks::chunkCount(0, bricks.nStoredBricks(), chunkSize));
+  tasks::parallelFor(0, bricks.nStoredBricks(), chunkSize, [&](size_t begin, size_t end) {
+    std::vector<BrickPolygon>& polygons = chunkPolygons[begin / chunkSize];
+    for (size_t iB = begin; iB < end; iB++) {
+      glm::uvec3 coord = bricks.brickCoords[iB];
+      glm::vec3 boxMin(coord * B);
+      glm::vec3 boxMax = glm::min(boxMin + static_cast<float>(B), maxSample);
+      for (int axis = 0; axis < 3; axis++) {
+        if (coord[axis] == 0) continue;
+        glm::uvec3 below = coord;
+        below[axis]--;
+        uint32_t iBelow = bricks.brickIndex[below.x + bricks.nBricks.x * (below.y + bricks.nBricks.y * below.z)];
+        if (iBelow == VolumeGridBricks::emptyBrick) boxMin[axis] -= 1.;
+      }
+      for (const SlicePlane& plane : planes) {
+        std::vector<glm::vec3> poly = planeBoxPolygon(boxMin, boxMax, plane.point, plane.normal);
+        if (poly.empty()) continue;
+        polygons.push_back(BrickPolygon{static_cast<uint32_t>(iB), &plane, std::move(poly)});
+      }
+    }
+  });
+
+  // Page in the bricks, which are listed in order
+  std::vector<uint32_t> neededBricks;
+  for (const std::vector<BrickPolygon>& polygons : chunkPolygons) {
+    for (const BrickPolygon& p : polygons) {
+      if (neededBricks.empty() || neededBricks.back() != p.brick) neededBricks.push_back(p.brick);
+    }
+  }
+  std::vector<std::pair<uint32_t, uint32_t>> toUpload;
+  std::vector<uint32_t> slots = brickCache->request(neededBricks, toUpload);
+  uploadBricks(toUpload);
+  // (only warn when the slices start to exceed the budget, rather than on every rebuild)
+  bool budgetExceeded = neededBricks.size() > brickCache->nSlots();
+  if (budgetExceeded && !brickBudgetExceeded) {
+    warning("volume grid [" + name + "] slices pass through more bricks than fit in its memory budget",
+            "needed " + std::to_string(neededBricks.size()) + " bricks, but only " +
+                std::to_string(brickCache->nSlots()) + " fit. Some parts of the slices are not drawn.");
+  }
+  brickBudgetExceeded = budgetExceeded;
+
+  // Triangulate the polygons, with texture coordinates in the slots of their bricks
+  SliceTriangles triangles;
+  triangles.wantsBary = wantsBary;
+  glm::vec3 atlasDims(atlasSlots * atlasSlotSize);
+  size_t iNeeded = 0;
+  for (const std::vector<BrickPolygon>& polygons : chunkPolygons) {
+    for (const BrickPolygon& p : polygons) {
+      while (neededBricks[iNeeded] != p.brick) iNeeded++;
+      uint32_t iSlot = slots[iNeeded];
+      if (iSlot == VolumeGridBrickCache::noSlot) continue;
+
+      glm::vec3 slotStart(glm::uvec3{iSlot % atlasSlots.x, (iSlot / atlasSlots.x) % atlasSlots.y,
+                                     iSlot / (atlasSlots.x * atlasSlots.y)} *
+                          atlasSlotSize);
+      glm::vec3 brickStart(bricks.brickCoords[p.brick] * B);
+      auto volumeCoord = [&](glm::vec3 q) { return (slotStart + (q - brickStart) + 1.5f) / atlasDims; };
+      triangles.addPolygon(p.poly, p.plane->worldNormal, origin, spacing, volumeCoord);
+    }
+  }
+
+  return triangles.toAttributes();
+}
+
+void VolumeGrid::prepareIsosurface() {
+
+  // Swap in a finished surface
+  if (isosurfaceStaging.started()) {
+    if (!isosurfaceStaging.ready()) {
+      requestViewRedraw();
+      return;
+    }
+    isosurfaceStaging.take().uploadTo(*preparingIsosurfaceProgram);
+    render::engine->setMaterial(*preparingIsosurfaceProgram, getMaterial());
+    isosurfaceProgram = preparingIsosurfaceProgram;
+    preparingIsosurfaceProgram.reset();
+    isosurface = pendingIsosurface;
+    isosurfaceValue = pendingIsoValue;
+    pendingIsosurface.reset();
+    requestRedraw();
+  }
+
+  // If the iso-value moved while that job was running, start again at the new value
+  bool current = isosurface != nullptr && isosurfaceValue == isoValue.get();
+  if (!current || isosurfaceProgram == nullptr) {
+    startIsosurfaceExtraction();
+  }
+}
+
+void VolumeGrid::startIsosurfaceExtraction() {
+  preparingIsosurfaceProgram =
+      render::engine->requestShader("MESH", {"SHADE_BASECOLOR", "MESH_BACKFACE_NORMAL_FLIP"});
+  bool wantsBary = preparingIsosurfaceProgram->hasAttribute("a_barycoord");
+
+  // Re-use the surface if only the program is missing
+  float value = isoValue.get();
+  std::shared_ptr<VolumeGridIsosurface> target;
+  std::shared_ptr<const VolumeGridIsosurface> source;
+  if (isosurface != nullptr && isosurfaceValue == value) {
+    source = isosurface;
+  } else {
+    target = std::make_shared<VolumeGridIsosurface>();
+    source = target;
+  }
+  pendingIsosurface = source;
+  pendingIsoValue = value;
+
+  isosurfaceStaging.start([=]() {
+    if (target != nullptr) {
+      *target = extractIsosurface(samples, blockRanges, origin, spacing, value);
+    }
+    return assembleIsosurfaceBuffers(*source, wantsBary);
+  });
+  requestViewRedraw();
+}
+
+render::StagedAttributes VolumeGrid::assembleIsosurfaceBuffers(const VolumeGridIsosurface& surface, bool wantsBary) {
+  std::vector<glm::vec3> positions(3 * surface.triangles.size());
+  std::vector<glm::vec3> normals(3 * surface.triangles.size());
+  std::vector<glm::vec3> bcoord;
+  if (wantsBary) {
+    bcoord.resize(3 * surface.triangles.size());
+  }
+
+  tasks::parallelFor(0, surface.triangles.size(), 1 << 14, [&](size_t begin, size_t end) {
+    for (size_t iT = begin; iT < end; iT++) {
+      for (size_t j = 0; j < 3; j++) {
+        uint32_t iV = surface.triangles[iT][j];
+        positions[3 * iT + j] = surface.vertices[iV];
+        normals[3 * iT + j] = surface.normals[iV];
+        if (wantsBary) {
+          bcoord[3 * iT + j] = glm::vec3{j == 0, j == 1, j == 2};
+        }
+      }
+    }
+  });
+
+  render::StagedAttributes attributes;
+  attributes.add("a_position", std::move(positions));
+  attributes.add("a_normal", std::move(normals));
+  if (wantsBary) {
+    attributes.add("a_barycoord", std::move(bcoord));
+  }
+  return attributes;
+}
+
+const VolumeGridIsosurface& VolumeGrid::getIsosurface() {
+  if (isosurface == nullptr || isosurfaceValue != isoValue.get()) {
+    isosurfaceStaging.cancel();
+    preparingIsosurfaceProgram.reset();
+    pendingIsosurface.reset();
+    isosurface = std::make_shared<const VolumeGridIsosurface>(
+        extractIsosurface(samples, blockRanges, origin, spacing, isoValue.get()));
+    isosurfaceValue = isoValue.get();
+    isosurfaceProgram.reset();
+    requestRedraw();
+  }
+  return *isosurface;
+}
+
+SurfaceMesh* VolumeGrid::registerIsosurfaceAsMesh(std::string meshName) {
+  if (meshName == "") {
+    meshName = name + " isosurface";
+  }
+  const VolumeGridIsosurface& surface = getIsosurface();
+  return registerSurfaceMesh(meshName, surface.vertices, surface.triangles);
+}
+
+// === UI
+
+void VolumeGrid::buildPickUI(size_t localPickID) {
+  // Grids are not pickable
+}
+
+void VolumeGrid::buildCustomUI() {
+  glm::uvec3 dims = samples.dims;
+  ImGui::Text("dims: %u x %u x %u", dims.x, dims.y, dims.z);
+  if (isSparse()) {
+    ImGui::Text("# bricks: %lld of %lld stored", static_cast<long long int>(samples.bricks->nStoredBricks()),
+                static_cast<long long int>(samples.bricks->brickIndex.size()));
+    if (brickCache != nullptr) {
+      ImGui::Text("# resident: %lld of %lld slots", static_cast<long long int>(brickCache->nResident()),
+                  static_cast<long long int>(brickCache->nSlots()));
+    }
+  }
+
+  // Slices
+  const char* axisNames[3] = {"x", "y", "z"};
+  for (int axis = 0; axis < 3; axis++) {
+    if (ImGui::Checkbox(axisNames[axis], &axisSliceEnabled(axis).get())) {
+      setAxisSliceEnabled(axis, getAxisSliceEnabled(axis));
+    }
+    ImGui::SameLine();
+    ImGui::PushItemWidth(150);
+    std::string label = std::string("##slice_") + axisNames[axis];
+    if (ImGui::SliderFloat(label.c_str(), &axisSlicePositions.get()[axis], 0., 1., "%.3f")) {
+      setAxisSlicePosition(axis, getAxisSlicePosition(axis));
+    }
+    ImGui::PopItemWidth();
+  }
+  if (ImGui::Checkbox("Plane slice", &planeSliceEnabled.get())) {
+    setPlaneSliceEnabled(getPlaneSliceEnabled());
+  }
+  if (planeSliceEnabled.get()) {
+    bool changed = ImGui::InputFloat3("Point", &planeSlicePoint.get()[0]);
+    changed |= ImGui::SliderFloat3("Normal", &planeSliceNormal.get()[0], -1., 1.);
+    if (changed) {
+      setPlaneSlice(planeSlicePoint.get(), planeSliceNormal.get());
+    }
+  }
+
+  // Color map
+  if (render::buildColormapSelector(cMap.get())) {
+    setColorMap(getColorMap());
+  }
+  ImGui::SameLine();
+  if (ImGui::Button("Reset")) {
+    resetMapRange();
+  }
+  if (ImGui::DragFloatRange2("##range", &vizRange.first, &vizRange.second, (dataRange.second - dataRange.first) / 100.,
+                             dataRange.first, dataRange.second, "Min: %.3e", "Max: %.3e")) {
+    requestRedraw();
+  }
+
+  // Isosurface
+  if (ImGui::Checkbox("Isosurface", &isosurfaceEnabled.get())) {
+    setIsosurfaceEnabled(getIsosurfaceEnabled());
+  }
+  ImGui::SameLine();
+  if (ImGui::ColorEdit3("Color", &isosurfaceColor.get()[0], ImGuiColorEditFlags_NoInputs)) {
+    setIsosurfaceColor(getIsosurfaceColor());
+  }
+  ImGui::PushItemWidth(200);
+  if (ImGui::SliderFloat("Iso value", &isoValue.get(), dataRange.first, dataRange.second, "%.4g")) {
+    setIsoValue(getIsoValue());
+  }
+  ImGui::PopItemWidth();
+}
+
+void VolumeGrid::buildCustomOptionsUI() {
+  if (render::buildMaterialOptionsGui(material.get())) {
+    material.manuallyChanged();
+    setMaterial(material.get()); // trigger the other updates that happen on set()
+  }
+
+  if (ImGui::MenuItem("Register isosurface as mesh")) {
+    registerIsosurfaceAsMesh();
+  }
+}
+
+// === Misc
+
+void VolumeGrid::computeExtents(std::tuple<glm::vec3, glm::vec3>& bboxOut, double& lengthScaleOut) {
+  glm::vec3 far = origin + spacing * (glm::vec3(samples.dims) - 1.f);
+  glm::vec3 bboxMin = componentwiseMin(origin, far);
+  glm::vec3 bboxMax = componentwiseMax(origin, far);
+  bboxOut = std::make_tuple(bboxMin, bboxMax);
+  lengthScaleOut = glm::length(bboxMax - bboxMin);
+}
+
+std::string VolumeGrid::typeName() { return structureTypeName; }
+
+void VolumeGrid::refresh() {
+  isosurfaceStaging.cancel();
+  sliceProgram.reset();
+  isosurfaceProgram.reset();
+  preparingIsosurfaceProgram.reset();
+  pendingIsosurface.reset();
+  Structure::refresh(); // call base class version
+}
+
+// === Getters and setters
+
+PersistentValue<bool>& VolumeGrid::axisSliceEnabled(int axis) {
+  switch (axis) {
+  case 0:
+    return sliceXEnabled;
+  case 1:
+    return sliceYEnabled;
+  default:
+    return sliceZEnabled;
+  }
+}
+
+VolumeGrid* VolumeGrid::setAxisSliceEnabled(int axis, bool newVal) {
+  axisSliceEnabled(axis) = newVal;
+  sliceProgram.reset();
+  requestRedraw();
+  return this;
+}
+bool VolumeGrid::getAxisSliceEnabled(int axis) { return axisSliceEnabled(axis).get(); }
+
+VolumeGrid* VolumeGrid::setAxisSlicePosition(int axis, double newVal) {
+  glm::vec3 positions = axisSlicePositions.get();
+  positions[axis] = glm::clamp(static_cast<float>(newVal), 0.f, 1.f);
+  axisSlicePositions = positions;
+  sliceProgram.reset();
+  requestRedraw();
+  return this;
+}
+double VolumeGrid::getAxisSlicePosition(int axis) { return axisSlicePositions.get()[axis]; }
+
+VolumeGrid* VolumeGrid::setPlaneSliceEnabled(bool newVal) {
+  planeSliceEnabled = newVal;
+  sliceProgram.reset();
+  requestRedraw();
+  return this;
+}
+bool VolumeGrid::getPlaneSliceEnabled() { return planeSliceEnabled.get(); }
+
+VolumeGrid* VolumeGrid::setPlaneSlice(glm::vec3 point, glm::vec3 normal) {
+  planeSlicePoint = point;
+  planeSliceNormal = normal;
+  sliceProgram.reset();
+  requestRedraw();
+  return this;
+}
+
+VolumeGrid* VolumeGrid::setColorMap(std::string val) {
+  cMap = val;
+  sliceProgram.reset();
+  requestRedraw();
+  return this;
+}
+std::string VolumeGrid::getColorMap() { return cMap.get(); }
+
+VolumeGrid* VolumeGrid::setMapRange(std::pair<double, double> val) {
+  vizRange = val;
+  requestRedraw();
+  return this;
+}
+std::pair<double, double> VolumeGrid::getMapRange() { return vizRange; }
+
+VolumeGrid* VolumeGrid::resetMapRange() {
+  vizRange = dataRange;
+  requestRedraw();
+  return this;
+}
+
+VolumeGrid* VolumeGrid::setBrickMemoryBudget(size_t bytes) {
+  brickMemoryBudget = bytes;
+  if (isSparse()) {
+    volumeTexture.reset();
+    brickCache.reset();
+    sliceProgram.reset();
+  }
+  requestRedraw();
+  return this;
+}
+size_t VolumeGrid::getBrickMemoryBudget() { return brickMemoryBudget; }
+
+VolumeGrid* VolumeGrid::setIsosurfaceEnabled(bool newVal) {
+  isosurfaceEnabled = newVal;
+  requestRedraw();
+  return this;
+}
+bool VolumeGrid::getIsosurfaceEnabled() { return isosurfaceEnabled.get(); }
+
+VolumeGrid* VolumeGrid::setIsoValue(double newVal) {
+  isoValue = newVal;
+  requestRedraw();
+  return this;
+}
+double VolumeGrid::getIsoValue() { return isoValue.get(); }
+
+VolumeGrid* VolumeGrid::setIsosurfaceColor(glm::vec3 newVal) {
+  isosurfaceColor = newVal;
+  requestRedraw();
+  return this;
+}
+glm::vec3 VolumeGrid::getIsosurfaceColor() { return isosurfaceColor.get(); }
+
+VolumeGrid* VolumeGrid::setMaterial(std::string m) {
+  material = m;
+  refresh();
+  requestRedraw();
+  return this;
+}
+std::string VolumeGrid::getMaterial() { return material.get(); }
+
+// === Registration
+
+VolumeGrid* registerVolumeGrid(std::string name, glm::uvec3 dims, glm::vec3 origin, glm::vec3 spacing,
+                               std::vector<uint16_t> values, VolumeDataType type) {
+  validateSize(values, static_cast<size_t>(dims.x) * dims.y * dims.z, "volume grid " + name);
+  if (type == VolumeDataType::Float) {
+    error("volume grid [" + name + "] of 16 bit samples must have type Half or UInt16");
+    return nullptr;
+  }
+  std::shared_ptr<std::vector<uint16_t>> data = std::make_shared<std::vector<uint16_t>>(std::move(values));
+  VolumeGrid* s = new VolumeGrid(name, VolumeGridSamples(data->data(), type, dims), origin, spacing, data);
+  bool success = registerStructure(s);
+  if (!success) {
+    safeDelete(s);
+  }
+  return s;
+}
+
+VolumeGrid* registerSparseVolumeGrid(std::string name, glm::vec3 origin, glm::vec3 spacing, VolumeGridBricks bricks) {
+  std::shared_ptr<VolumeGridBricks> data = std::make_shared<VolumeGridBricks>(std::move(bricks));
+  VolumeGrid* s = new VolumeGrid(name, VolumeGridSamples(data.get()), origin, spacing, data);
+  bool success = registerStructure(s);
+  if (!success) {
+    safeDelete(s);
+  }
+  return s;
+}
+
+VolumeGrid* registerVolumeGridView(std::string name, glm::uvec3 dims, glm::vec3 origin, glm::vec3 spacing,
+                                   const void* data, VolumeDataType type) {
+  VolumeGrid* s = new VolumeGrid(name, VolumeGridSamples(data, type, dims), origin, spacing, nullptr);
+  bool success = registerStructure(s);
+  if (!success) {
+    safeDelete(s);
+  }
+  return s;
+}
+
+VolumeGrid* registerVolumeGridFromRawFile(std::string name, std::string filename, glm::uvec3 dims, glm::vec3 origin,
+                                          glm::vec3 spacing, VolumeDataType type, size_t headerBytes) {
+  std::shared_ptr<MappedFile> file;
+  try {
+    file = std::make_shared<MappedFile>(filename);
+  } catch (const std::runtime_error& e) {
+    error("could not load volume grid [" + name + "]: " + e.what());
+    return nullptr;
+  }
+
+  size_t expectedBytes = headerBytes + static_cast<size_t>(dims.x) * dims.y * dims.z * bytesPerSample(type);
+  if (file->size() < expectedBytes) {
+    error("could not load volume grid [" + name + "]: file " + filename + " has " + std::to_string(file->size()) +
+          " bytes, but " + std::to_string(expectedBytes) + " are needed");
+    return nullptr;
+  }
+
+  const char* data = static_cast<const char*>(file->data()) + headerBytes;
+  VolumeGrid* s = new VolumeGrid(name, VolumeGridSamples(data, type, dims), origin, spacing, file);
+  bool success = registerStructure(s);
+  if (!success) {
+    safeDelete(s);
+  }
+  return s;
+}
+
+} // namespace polyscope
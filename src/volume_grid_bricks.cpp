@@ -0,0 +1,199 @@
+// Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
+#include "polyscope/volume_grid_bricks.h"
+
+#include "polyscope/task_scheduler.h"
+#include "polyscope/volume_grid_isosurface.h"
+
+#include "glm/glm.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace polyscope {
+
+// Storage for statics which are used by reference
+const unsigned int VolumeGridBricks::brickSize;
+const uint32_t VolumeGridBricks::emptyBrick;
+const size_t VolumeGridBricks::brickSamplesCount;
+const uint32_t VolumeGridBrickCache::noSlot;
+
+namespace {
+
+inline bool isBackground(float v, float background) {
+  return v == background || (std::isnan(v) && std::isnan(background));
+}
+
+void allocateBrickIndex(VolumeGridBricks& bricks, glm::uvec3 dims) {
+  const unsigned int B = VolumeGridBricks::brickSize;
+  bricks.dims = dims;
+  for (int a = 0; a < 3; a++) {
+    bricks.nBricks[a] = (dims[a] + B - 1) / B;
+  }
+  bricks.brickIndex.assign(static_cast<size_t>(bricks.nBricks.x) * bricks.nBricks.y * bricks.nBricks.z,
+                           VolumeGridBricks::emptyBrick);
+}
+
+// Ranges of the stored bricks, over their samples which are inside the grid
+void computeBrickRanges(VolumeGridBricks& bricks) {
+  const unsigned int B = VolumeGridBricks::brickSize;
+  bricks.brickRanges.resize(bricks.nStoredBricks());
+  tasks::parallelFor(0, bricks.nStoredBricks(), 64, [&](size_t begin, size_t end) {
+    for (size_t iB = begin; iB < end; iB++) {
+      glm::uvec3 start = bricks.brickCoords[iB] * B;
+      glm::uvec3 count = glm::min(glm::uvec3(B), bricks.dims - start);
+      const float* brick = &bricks.brickSamples[iB * VolumeGridBricks::brickSamplesCount];
+      glm::vec2 range{std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity()};
+      for (unsigned int z = 0; z < count.z; z++) {
+        for (unsigned int y = 0; y < count.y; y++) {
+          for (unsigned int x = 0; x < count.x; x++) {
+            float v = brick[x + B * (y + B * z)];
+            if (!std::isfinite(v)) v = -std::numeric_limits<float>::infinity();
+            range.x = std::min(range.x, v);
+            range.y = std::max(range.y, v);
+          }
+        }
+      }
+      bricks.brickRanges[iB] = range;
+    }
+  });
+}
+
+} // namespace
+
+VolumeGridBricks makeVolumeGridBricks(glm::uvec3 dims, const std::vector<glm::uvec3>& brickCoords,
+                                      const std::vector<float>& brickSamples, float background) {
+  if (brickSamples.size() != brickCoords.size() * VolumeGridBricks::brickSamplesCount) {
+    throw std::runtime_error("volume grid bricks: expected " +
+                             std::to_string(brickCoords.size() * VolumeGridBricks::brickSamplesCount) +
+                             " samples for " + std::to_string(brickCoords.size()) + " bricks, but got " +
+                             std::to_string(brickSamples.size()));
+  }
+
+  VolumeGridBricks bricks;
+  allocateBrickIndex(bricks, dims);
+  bricks.background = background;
+
+  for (size_t iB = 0; iB < brickCoords.size(); iB++) {
+    glm::uvec3 c = brickCoords[iB];
+    if (c.x >= bricks.nBricks.x || c.y >= bricks.nBricks.y || c.z >= bricks.nBricks.z) {
+      throw std::runtime_error("volume grid bricks: brick " + std::to_string(iB) + " is outside of the grid");
+    }
+    uint32_t& index = bricks.brickIndex[c.x + bricks.nBricks.x * (c.y + bricks.nBricks.y * static_cast<size_t>(c.z))];
+    if (index != VolumeGridBricks::emptyBrick) {
+      throw std::runtime_error("volume grid bricks: brick " + std::to_string(iB) + " is given twice");
+    }
+    index = static_cast<uint32_t>(iB);
+  }
+
+  bricks.brickCoords = brickCoords;
+  bricks.brickSamples = brickSamples;
+  computeBrickRanges(bricks);
+  return bricks;
+}
+
+VolumeGridBricks makeVolumeGridBricks(const VolumeGridSamples& samples, float background) {
+  const unsigned int B = VolumeGridBricks::brickSize;
+  const size_t brickSamplesCount = VolumeGridBricks::brickSamplesCount;
+
+  VolumeGridBricks bricks;
+  allocateBrickIndex(bricks, samples.dims);
+  bricks.background = background;
+  glm::uvec3 nBricks = bricks.nBricks;
+
+  // Find and copy the occupied bricks, one slab of bricks at a time
+  struct Slab {
+    std::vector<glm::uvec3> coords;
+    std::vector<float> samples;
+  };
+  std::vector<Slab> slabs(nBricks.z);
+  tasks::parallelFor(0, nBricks.z, 1, [&](size_t begin, size_t end) {
+    std::vector<float> brick(brickSamplesCount);
+    for (unsigned int bz = begin; bz < end; bz++) {
+      for (unsigned int by = 0; by < nBricks.y; by++) {
+        for (unsigned int bx = 0; bx < nBricks.x; bx++) {
+          glm::uvec3 start = glm::uvec3{bx, by, bz} * B;
+          glm::uvec3 count = glm::min(glm::uvec3(B), samples.dims - start);
+          std::fill(brick.begin(), brick.end(), background);
+          bool occupied = false;
+          for (unsigned int z = 0; z < count.z; z++) {
+            for (unsigned int y = 0; y < count.y; y++) {
+              for (unsigned int x = 0; x < count.x; x++) {
+                float v = samples.at(start.x + x, start.y + y, start.z + z);
+                brick[x + B * (y + B * z)] = v;
+                occupied = occupied || !isBackground(v, background);
+              }
+            }
+          }
+          if (occupied) {
+            slabs[bz].coords.push_back(glm::uvec3{bx, by, bz});
+            slabs[bz].samples.insert(slabs[bz].samples.end(), brick.begin(), brick.end());
+          }
+        }
+      }
+    }
+  });
+
+  // Gather them in order
+  for (Slab& slab : slabs) {
+    for (glm::uvec3 c : slab.coords) {
+      bricks.brickIndex[c.x + nBricks.x * (c.y + nBricks.y * static_cast<size_t>(c.z))] =
+          static_cast<uint32_t>(bricks.brickCoords.size());
+      bricks.brickCoords.push_back(c);
+    }
+    bricks.brickSamples.insert(bricks.brickSamples.end(), slab.samples.begin(), slab.samples.end());
+    slab = Slab();
+  }
+
+  computeBrickRanges(bricks);
+  return bricks;
+}
+
+VolumeGridBrickCache::VolumeGridBrickCache(size_t nSlots)
+    : slotBrick(nSlots, VolumeGridBricks::emptyBrick), slotLastUse(nSlots, 0) {}
+
+std::vector<uint32_t> VolumeGridBrickCache::request(const std::vector<uint32_t>& bricks,
+                                                    std::vector<std::pair<uint32_t, uint32_t>>& toUpload) {
+  requestCount++;
+  std::vector<uint32_t> slots(bricks.size(), noSlot);
+
+  // Resident bricks stay where they are
+  std::vector<size_t> missing;
+  for (size_t i = 0; i < bricks.size(); i++) {
+    auto it = brickSlot.find(bricks[i]);
+    if (it == brickSlot.end()) {
+      missing.push_back(i);
+      continue;
+    }
+    slots[i] = it->second;
+    slotLastUse[it->second] = requestCount;
+  }
+
+  // The others evict the bricks which were used least recently (slots which were never used come first)
+  std::vector<uint32_t> candidates;
+  for (uint32_t s = 0; s < slotBrick.size(); s++) {
+    if (slotLastUse[s] != requestCount) candidates.push_back(s);
+  }
+  size_t nAssign = std::min(missing.size(), candidates.size());
+  std::partial_sort(candidates.begin(), candidates.begin() + nAssign, candidates.end(),
+                    [&](uint32_t a, uint32_t b) { return slotLastUse[a] < slotLastUse[b]; });
+
+  for (size_t k = 0; k < nAssign; k++) {
+    uint32_t s = candidates[k];
+    uint32_t brick = bricks[missing[k]];
+    if (slotBrick[s] != VolumeGridBricks::emptyBrick) {
+      brickSlot.erase(slotBrick[s]);
+    }
+    slotBrick[s] = brick;
+    slotLastUse[s] = requestCount;
+    brickSlot[brick] = s;
+    slots[missing[k]] = s;
+    toUpload.emplace_back(brick, s);
+  }
+
+  return slots;
+}
+
+} // namespace polyscope
@@ -0,0 +1,399 @@
+// Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
+#include "polyscope/volume_grid_isosurface.h"
+
+#include "polyscope/task_scheduler.h"
+
+#include "glm/glm.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+
+namespace polyscope {
+
+float halfToFloat(uint16_t h) {
+  uint32_t sign = static_cast<uint32_t>(h & 0x8000) << 16;
+  uint32_t exponent = (h >> 10) & 0x1f;
+  uint32_t mantissa = h & 0x3ff;
+
+  uint32_t bits;
+  if (exponent == 0x1f) { // inf and nan
+    bits = sign | 0x7f800000 | (mantissa << 13);
+  } else if (exponent != 0) {
+    bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+  } else if (mantissa == 0) {
+    bits = sign;
+  } else {
+    // subnormal halfs are normal floats
+    exponent = 127 - 15 + 1;
+    while (!(mantissa & 0x400)) {
+      mantissa <<= 1;
+      exponent--;
+    }
+    bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+  }
+
+  float f;
+  std::memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+namespace {
+
+const float negInf = -std::numeric_limits<float>::infinity();
+
+// A sample, with non-finite values treated as -infinity
+inline float sampleValue(const VolumeGridSamples& samples, size_t x, size_t y, size_t z) {
+  float v = samples.at(x, y, z);
+  return std::isfinite(v) ? v : negInf;
+}
+
+inline size_t sampleIndex(const glm::uvec3& dims, size_t x, size_t y, size_t z) {
+  return x + dims.x * (y + dims.y * z);
+}
+
+// Gradient at a sample by central differences, falling back to one-sided differences at the boundary of the grid and
+// next to non-finite samples
+glm::vec3 sampleGradient(const VolumeGridSamples& samples, glm::uvec3 p, glm::vec3 spacing) {
+  float center = sampleValue(samples, p.x, p.y, p.z);
+  if (!std::isfinite(center)) return glm::vec3{0., 0., 0.};
+
+  glm::vec3 grad;
+  for (int a = 0; a < 3; a++) {
+    float lo = center;
+    float hi = center;
+    float dist = 0.;
+    glm::uvec3 step{0, 0, 0};
+    step[a] = 1;
+    if (p[a] > 0) {
+      glm::uvec3 q = p - step;
+      float v = sampleValue(samples, q.x, q.y, q.z);
+      if (std::isfinite(v)) {
+        lo = v;
+        dist += 1.;
+      }
+    }
+    if (p[a] + 1 < samples.dims[a]) {
+      glm::uvec3 q = p + step;
+      float v = sampleValue(samples, q.x, q.y, q.z);
+      if (std::isfinite(v)) {
+        hi = v;
+        dist += 1.;
+      }
+    }
+    grad[a] = dist > 0. ? (hi - lo) / (dist * spacing[a]) : 0.f;
+  }
+  return grad;
+}
+
+// The six tetrahedra of a cell, as corners of the cell (bit 0: +x, bit 1: +y, bit 2: +z). Each is a path from corner 0
+// to corner 7 along the axes in some order, so the corners of each tetrahedron are nested (every corner's bits include
+// the previous one's), and neighboring cells split their shared faces along the same diagonal.
+const int cellTets[6][4] = {{0, 1, 3, 7}, {0, 1, 5, 7}, {0, 2, 3, 7}, {0, 2, 6, 7}, {0, 4, 5, 7}, {0, 4, 6, 7}};
+
+inline glm::uvec3 cornerOffset(int c) {
+  return glm::uvec3{static_cast<unsigned int>(c & 1), static_cast<unsigned int>((c >> 1) & 1),
+                    static_cast<unsigned int>((c >> 2) & 1)};
+}
+
+// The part of the surface in one slab of blocks
+struct SlabSurface {
+  // Vertices are identified by the edge they lie on: the index of the edge's lower sample times 8, plus the corner
+  // bits of the edge's direction
+  std::unordered_map<uint64_t, uint32_t> edgeVertices;
+  std::vector<glm::vec3> vertices;
+  std::vector<glm::vec3> gradients;
+  std::vector<char> owned; // false for vertices on the top of the slab, which the next slab also creates
+  std::vector<std::array<uint32_t, 3>> triangles;
+
+  // Filled in while merging
+  std::vector<uint32_t> globalIndex;
+  size_t vertexStart = 0;
+  size_t triangleStart = 0;
+};
+
+void extractSlab(const VolumeGridSamples& samples, const VolumeGridBlockRanges& blockRanges, glm::vec3 origin,
+                 glm::vec3 spacing, float isoValue, unsigned int bz, SlabSurface& slab) {
+
+  const glm::uvec3& dims = samples.dims;
+  const unsigned int B = VolumeGridBlockRanges::blockSize;
+  const glm::uvec3& nBlocks = blockRanges.nBlocks;
+  unsigned int zStart = bz * B;
+  unsigned int zEnd = std::min(zStart + B, dims.z - 1);
+  bool lastSlab = bz + 1 == nBlocks.z;
+
+  glm::uvec3 cellBase;
+  float values[8];
+
+  // Get the vertex on the edge between two corners of a tetrahedron, creating it if needed
+  auto edgeVertex = [&](int cLow, int cHigh) -> uint32_t {
+    glm::uvec3 pLow = cellBase + cornerOffset(cLow);
+    glm::uvec3 pHigh = cellBase + cornerOffset(cHigh);
+    int dir = cLow ^ cHigh;
+    uint64_t key = static_cast<uint64_t>(sampleIndex(dims, pLow.x, pLow.y, pLow.z)) * 8 + dir;
+
+    auto it = slab.edgeVertices.find(key);
+    if (it != slab.edgeVertices.end()) return it->second;
+
+    float vLow = values[cLow];
+    float vHigh = values[cHigh];
+    float t;
+    if (vLow == negInf) {
+      t = 1.;
+    } else if (vHigh == negInf) {
+      t = 0.;
+    } else {
+      t = glm::clamp((isoValue - vLow) / (vHigh - vLow), 0.f, 1.f);
+    }
+
+    glm::vec3 pos = glm::mix(glm::vec3(pLow), glm::vec3(pHigh), t);
+    glm::vec3 grad = glm::mix(sampleGradient(samples, pLow, spacing), sampleGradient(samples, pHigh, spacing), t);
+
+    uint32_t iV = static_cast<uint32_t>(slab.vertices.size());
+    slab.vertices.push_back(origin + spacing * pos);
+    slab.gradients.push_back(grad);
+    slab.owned.push_back(lastSlab || pLow.z != zEnd || (dir & 4));
+    slab.edgeVertices[key] = iV;
+    return iV;
+  };
+
+  for (unsigned int by = 0; by < nBlocks.y; by++) {
+    for (unsigned int bx = 0; bx < nBlocks.x; bx++) {
+      glm::vec2 range = blockRanges.range(bx, by, bz);
+      if (!(range.x < isoValue && range.y >= isoValue)) continue;
+
+      unsigned int yEnd = std::min((by + 1) * B, dims.y - 1);
+      unsigned int xEnd = std::min((bx + 1) * B, dims.x - 1);
+      for (unsigned int z = zStart; z < zEnd; z++) {
+        for (unsigned int y = by * B; y < yEnd; y++) {
+          for (unsigned int x = bx * B; x < xEnd; x++) {
+
+            int nInside = 0;
+            for (int c = 0; c < 8; c++) {
+              glm::uvec3 p = glm::uvec3{x, y, z} + cornerOffset(c);
+              values[c] = sampleValue(samples, p.x, p.y, p.z);
+              if (values[c] >= isoValue) nInside++;
+            }
+            if (nInside == 0 || nInside == 8) continue;
+            cellBase = glm::uvec3{x, y, z};
+
+            for (const int* tet : cellTets) {
+              // Split the corners by side, keeping their order along the tetrahedron's path
+              int inside[4], outside[4];
+              int nIn = 0, nOut = 0;
+              for (int i = 0; i < 4; i++) {
+                if (values[tet[i]] >= isoValue) {
+                  inside[nIn++] = tet[i];
+                } else {
+                  outside[nOut++] = tet[i];
+                }
+              }
+              if (nIn == 0 || nOut == 0) continue;
+
+              // The crossed edges, in order around the polygon which separates the two sides
+              std::array<std::array<int, 2>, 4> poly;
+              int nPoly;
+              if (nIn == 1) {
+                poly = {{{{inside[0], outside[0]}}, {{inside[0], outside[1]}}, {{inside[0], outside[2]}}}};
+                nPoly = 3;
+              } else if (nOut == 1) {
+                poly = {{{{inside[0], outside[0]}}, {{inside[1], outside[0]}}, {{inside[2], outside[0]}}}};
+                nPoly = 3;
+              } else {
+                poly = {{{{inside[0], outside[0]}},
+                         {{inside[0], outside[1]}},
+                         {{inside[1], outside[1]}},
+                         {{inside[1], outside[0]}}}};
+                nPoly = 4;
+              }
+
+              // Orient the polygon to face the outside corners. This is decided with the polygon through the midpoints
+              // of the edges, which is never degenerate, unlike the interpolated one.
+              glm::vec3 inMean{0., 0., 0.};
+              glm::vec3 outMean{0., 0., 0.};
+              for (int i = 0; i < nIn; i++) inMean += glm::vec3(cornerOffset(inside[i])) / static_cast<float>(nIn);
+              for (int i = 0; i < nOut; i++) outMean += glm::vec3(cornerOffset(outside[i])) / static_cast<float>(nOut);
+              glm::vec3 mid[3];
+              for (int i = 0; i < 3; i++) {
+                mid[i] = 0.5f * glm::vec3(cornerOffset(poly[i][0]) + cornerOffset(poly[i][1]));
+              }
+              bool flip = glm::dot(glm::cross(mid[1] - mid[0], mid[2] - mid[0]), outMean - inMean) < 0.;
+
+              // Corners earlier on the path are the low end of an edge
+              uint32_t polyVerts[4];
+              for (int i = 0; i < nPoly; i++) {
+                int cA = std::min(poly[i][0], poly[i][1]);
+                int cB = std::max(poly[i][0], poly[i][1]);
+                polyVerts[i] = edgeVertex(cA, cB);
+              }
+              for (int i = 1; i + 1 < nPoly; i++) {
+                if (flip) {
+                  slab.triangles.push_back({{polyVerts[0], polyVerts[i + 1], polyVerts[i]}});
+                } else {
+                  slab.triangles.push_back({{polyVerts[0], polyVerts[i], polyVerts[i + 1]}});
+                }
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+} // namespace
+
+glm::vec2 VolumeGridBlockRanges::range(unsigned int bx, unsigned int by, unsigned int bz) const {
+  if (bricks == nullptr) {
+    return ranges[bx + nBlocks.x * (by + nBlocks.y * static_cast<size_t>(bz))];
+  }
+
+  // A block's cells are in its brick, except for the samples on its upper faces, which are in the next bricks
+  float backgroundValue = std::isfinite(bricks->background) ? bricks->background : negInf;
+  glm::vec2 result{std::numeric_limits<float>::infinity(), negInf};
+  glm::uvec3 b{bx, by, bz};
+  for (int c = 0; c < 8; c++) {
+    glm::uvec3 n = b + cornerOffset(c);
+    if (n.x >= bricks->nBricks.x || n.y >= bricks->nBricks.y || n.z >= bricks->nBricks.z) continue;
+    uint32_t iB = bricks->brickIndex[n.x + bricks->nBricks.x * (n.y + bricks->nBricks.y * static_cast<size_t>(n.z))];
+    glm::vec2 brickRange = iB == VolumeGridBricks::emptyBrick ? glm::vec2{backgroundValue, backgroundValue}
+                                                               : bricks->brickRanges[iB];
+    result.x = std::min(result.x, brickRange.x);
+    result.y = std::max(result.y, brickRange.y);
+  }
+  return result;
+}
+
+VolumeGridBlockRanges computeVolumeGridBlockRanges(const VolumeGridSamples& samples) {
+  VolumeGridBlockRanges result;
+  const glm::uvec3& dims = samples.dims;
+  if (dims.x < 2 || dims.y < 2 || dims.z < 2) return result;
+
+  const unsigned int B = VolumeGridBlockRanges::blockSize;
+  for (int a = 0; a < 3; a++) {
+    result.nBlocks[a] = (dims[a] - 1 + B - 1) / B;
+  }
+  glm::uvec3 nBlocks = result.nBlocks;
+
+  // Sparse grids look up the ranges of their bricks instead
+  if (samples.bricks != nullptr) {
+    result.bricks = samples.bricks;
+    return result;
+  }
+
+  result.ranges.resize(static_cast<size_t>(nBlocks.x) * nBlocks.y * nBlocks.z);
+
+  tasks::parallelFor(0, nBlocks.z, 1, [&](size_t begin, size_t end) {
+    for (unsigned int bz = begin; bz < end; bz++) {
+      for (unsigned int by = 0; by < nBlocks.y; by++) {
+        for (unsigned int bx = 0; bx < nBlocks.x; bx++) {
+          float lo = std::numeric_limits<float>::infinity();
+          float hi = negInf;
+          // Blocks share their boundary samples
+          unsigned int zEnd = std::min((bz + 1) * B, dims.z - 1);
+          unsigned int yEnd = std::min((by + 1) * B, dims.y - 1);
+          unsigned int xEnd = std::min((bx + 1) * B, dims.x - 1);
+          for (unsigned int z = bz * B; z <= zEnd; z++) {
+            for (unsigned int y = by * B; y <= yEnd; y++) {
+              for (unsigned int x = bx * B; x <= xEnd; x++) {
+                float v = sampleValue(samples, x, y, z);
+                lo = std::min(lo, v);
+                hi = std::max(hi, v);
+              }
+            }
+          }
+          result.ranges[bx + nBlocks.x * (by + nBlocks.y * bz)] = glm::vec2{lo, hi};
+        }
+      }
+    }
+  });
+
+  return result;
+}
+
+VolumeGridIsosurface extractIsosurface(const VolumeGridSamples& samples, const VolumeGridBlockRanges& blockRanges,
+                                       glm::vec3 origin, glm::vec3 spacing, float isoValue) {
+  VolumeGridIsosurface result;
+  size_t nSlabs = blockRanges.nBlocks.z;
+  if (nSlabs == 0) return result;
+
+  std::vector<SlabSurface> slabs(nSlabs);
+  tasks::parallelFor(0, nSlabs, 1, [&](size_t begin, size_t end) {
+    for (size_t bz = begin; bz < end; bz++) {
+      extractSlab(samples, blockRanges, origin, spacing, isoValue, bz, slabs[bz]);
+    }
+  });
+
+  // Number the vertices each slab owns, in slab order
+  size_t nVertices = 0;
+  size_t nTriangles = 0;
+  for (SlabSurface& slab : slabs) {
+    slab.vertexStart = nVertices;
+    slab.triangleStart = nTriangles;
+    nVertices += std::count(slab.owned.begin(), slab.owned.end(), 1);
+    nTriangles += slab.triangles.size();
+  }
+  result.vertices.resize(nVertices);
+  result.normals.resize(nVertices);
+  result.triangles.resize(nTriangles);
+
+  std::vector<char> needsNormal(nVertices, false);
+  tasks::parallelFor(0, nSlabs, 1, [&](size_t begin, size_t end) {
+    for (size_t iS = begin; iS < end; iS++) {
+      SlabSurface& slab = slabs[iS];
+      slab.globalIndex.resize(slab.vertices.size());
+      uint32_t iG = static_cast<uint32_t>(slab.vertexStart);
+      for (size_t iV = 0; iV < slab.vertices.size(); iV++) {
+        if (!slab.owned[iV]) continue;
+        slab.globalIndex[iV] = iG;
+        result.vertices[iG] = slab.vertices[iV];
+        float gradLen = glm::length(slab.gradients[iV]);
+        if (gradLen > 0. && std::isfinite(gradLen)) {
+          result.normals[iG] = -slab.gradients[iV] / gradLen;
+        } else {
+          needsNormal[iG] = true;
+        }
+        iG++;
+      }
+    }
+  });
+
+  // Vertices on the top of a slab are the ones the next slab created on its bottom
+  tasks::parallelFor(0, nSlabs, 1, [&](size_t begin, size_t end) {
+    for (size_t iS = begin; iS < end; iS++) {
+      SlabSurface& slab = slabs[iS];
+      for (const std::pair<const uint64_t, uint32_t>& entry : slab.edgeVertices) {
+        if (slab.owned[entry.second]) continue;
+        const SlabSurface& next = slabs[iS + 1];
+        slab.globalIndex[entry.second] = next.globalIndex[next.edgeVertices.at(entry.first)];
+      }
+      for (size_t iT = 0; iT < slab.triangles.size(); iT++) {
+        for (int j = 0; j < 3; j++) {
+          result.triangles[slab.triangleStart + iT][j] = slab.globalIndex[slab.triangles[iT][j]];
+        }
+      }
+    }
+  });
+
+  // Where the gradient vanishes, fall back on the normals of the surrounding triangles
+  if (std::find(needsNormal.begin(), needsNormal.end(), true) != needsNormal.end()) {
+    for (const std::array<uint32_t, 3>& tri : result.triangles) {
+      glm::vec3 n = glm::cross(result.vertices[tri[1]] - result.vertices[tri[0]],
+                               result.vertices[tri[2]] - result.vertices[tri[0]]);
+      for (uint32_t iV : tri) {
+        if (needsNormal[iV]) result.normals[iV] += n;
+      }
+    }
+    for (size_t iV = 0; iV < nVertices; iV++) {
+      if (!needsNormal[iV]) continue;
+      float len = glm::length(result.normals[iV]);
+      result.normals[iV] = len > 0. ? result.normals[iV] / len : glm::vec3{0., 0., 1.};
+    }
+  }
+
+  return result;
+}
+
+} // namespace polyscope
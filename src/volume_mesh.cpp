@@ -0,0 +1,330 @@
+// Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
+#include "polyscope/volume_mesh.h"
+
+#include "polyscope/polyscope.h"
+#include "polyscope/render/engine.h"
+
+#include "imgui.h"
+
+#include <string>
+
+namespace polyscope {
+
+// Initialize statics
+const std::string VolumeMesh::structureTypeName = "Volume Mesh";
+
+namespace {
+
+// The default slice point (a persisted point from an earlier mesh with the same name is used instead, if there is one)
+glm::vec3 boundingBoxCenter(const std::vector<glm::vec3>& points) {
+  if (points.empty()) return glm::vec3{0., 0., 0.};
+  glm::vec3 min = points[0];
+  glm::vec3 max = points[0];
+  for (const glm::vec3& p : points) {
+    min = glm::min(min, p);
+    max = glm::max(max, p);
+  }
+  return .5f * (min + max);
+}
+
+} // namespace
+
+// Constructor
+VolumeMesh::VolumeMesh(std::string name, std::vector<glm::vec3> vertices_, VolumeMeshCells cells_)
+    : QuantityStructure<VolumeMesh>(name, typeName()), vertices(std::move(vertices_)), cells(std::move(cells_)),
+      planeSliceEnabled(uniquePrefix() + "#planeSliceEnabled", false),
+      planeSlicePoint(uniquePrefix() + "#planeSlicePoint", boundingBoxCenter(vertices)), // through the middle
+      planeSliceNormal(uniquePrefix() + "#planeSliceNormal", glm::vec3{1., 0., 0.}),
+      color(uniquePrefix() + "#color", getNextUniqueColor()),
+      edgeColor(uniquePrefix() + "#edgeColor", glm::vec3{0., 0., 0.}), edgeWidth(uniquePrefix() + "#edgeWidth", 0.),
+      material(uniquePrefix() + "#material", "clay") {
+
+  // Make sure there are no bad cells
+  size_t badCell = validateVolumeMeshCells(cells, nVertices());
+  if (badCell < nCells()) {
+    polyscope::error("VolumeMesh [" + name + "] cell " + std::to_string(badCell) + " has " +
+                     std::to_string(cells.cellSize(badCell)) +
+                     " vertices (must be 4 or 8), or a vertex index which is out of bounds. There are " +
+                     std::to_string(nVertices()) + " vertices.");
+    cells = VolumeMeshCells();
+  }
+
+  for (size_t c = 0; c < nCells(); c++) {
+    if (cells.cellSize(c) == 4) nTetCells++;
+  }
+
+  exterior = computeVolumeMeshExterior(vertices, cells);
+}
+
+VolumeMesh::~VolumeMesh() {
+  // quantity preparation reads the mesh data, which is destroyed before the quantities are
+  cancelBackgroundPreparation();
+}
+
+// === Drawing
+
+void VolumeMesh::draw() {
+  if (!isEnabled()) {
+    return;
+  }
+
+  // If there is no dominant quantity, then this class is responsible for drawing the mesh
+  if (dominantQuantity == nullptr) {
+    prepare();
+
+    if (program != nullptr) {
+      // Set uniforms
+      setTransformUniforms(*program);
+      setStructureUniforms(*program);
+      program->setUniform("u_baseColor", getColor());
+
+      program->draw();
+    }
+  }
+
+  // Draw the quantities
+  for (auto& x : quantities) {
+    x.second->draw();
+  }
+}
+
+void VolumeMesh::drawPick() {
+  // Volume meshes are not pickable
+}
+
+void VolumeMesh::prepare() {
+
+  // Swap in the program once its buffers are ready
+  if (geometryStaging.ready()) {
+    geometryStaging.take().uploadTo(*preparingProgram);
+    render::engine->setMaterial(*preparingProgram, getMaterial());
+    program = preparingProgram;
+    programSliceVersion = preparingSliceVersion;
+    preparingProgram.reset();
+    requestRedraw();
+  }
+
+  // Start assembling buffers on a worker thread if there are none, or they are for an old slice
+  if (!geometryStaging.started() && (program == nullptr || programSliceVersion != sliceVersion)) {
+    preparingProgram = render::engine->requestShader("MESH", addStructureRules({"SHADE_BASECOLOR"}));
+    preparingSliceVersion = sliceVersion;
+    bool wantsBary = preparingProgram->hasAttribute("a_barycoord");
+    bool wantsEdge = getEdgeWidth() > 0;
+    VolumeMeshSlicePlane slice = getSlicePlane();
+    geometryStaging.start([=]() { return assembleGeometryBuffers(wantsBary, wantsEdge, slice, nullptr, false); });
+  }
+
+  // Keep frames coming until the buffers are ready
+  if (geometryStaging.started()) {
+    requestViewRedraw();
+  }
+}
+
+std::vector<std::string> VolumeMesh::addStructureRules(std::vector<std::string> initRules) {
+  if (getEdgeWidth() > 0) {
+    initRules.push_back("MESH_WIREFRAME");
+  }
+  // cells may be oriented either way, and slices show the inside of the exterior faces
+  initRules.push_back("MESH_BACKFACE_NORMAL_FLIP");
+  return initRules;
+}
+
+void VolumeMesh::setStructureUniforms(render::ShaderProgram& p) {
+  if (getEdgeWidth() > 0) {
+    p.setUniform("u_edgeWidth", getEdgeWidth() * render::engine->getCurrentPixelScaling());
+    p.setUniform("u_edgeColor", getEdgeColor());
+  }
+}
+
+render::StagedAttributes VolumeMesh::assembleGeometryBuffers(bool wantsBary, bool wantsEdge, VolumeMeshSlicePlane slice,
+                                                             const std::vector<double>* values, bool valuesOnCells) {
+  VolumeMeshTriangles triangles = triangulateVolumeMesh(vertices, cells, exterior, slice, values, valuesOnCells);
+
+  // Store data in buffers
+  render::StagedAttributes attributes;
+  if (wantsBary) {
+    std::vector<glm::vec3> bcoord;
+    bcoord.reserve(3 * triangles.nTriangles());
+    for (size_t iT = 0; iT < triangles.nTriangles(); iT++) {
+      bcoord.push_back(glm::vec3{1., 0., 0.});
+      bcoord.push_back(glm::vec3{0., 1., 0.});
+      bcoord.push_back(glm::vec3{0., 0., 1.});
+    }
+    attributes.add("a_barycoord", std::move(bcoord));
+  }
+  attributes.add("a_position", std::move(triangles.positions));
+  attributes.add("a_normal", std::move(triangles.normals));
+  if (wantsEdge) {
+    attributes.add("a_edgeIsReal", std::move(triangles.edgeIsReal));
+  }
+  if (values != nullptr) {
+    attributes.add("a_value", std::move(triangles.values));
+  }
+  return attributes;
+}
+
+VolumeMeshSlicePlane VolumeMesh::getSlicePlane() {
+  VolumeMeshSlicePlane slice;
+  slice.enabled = planeSliceEnabled.get();
+  slice.point = planeSlicePoint.get();
+  slice.normal = planeSliceNormal.get();
+  return slice;
+}
+
+void VolumeMesh::slicePlaneChanged() {
+  // The current programs are drawn until ones for the new slice are ready
+  sliceVersion++;
+  requestRedraw();
+}
+
+void VolumeMesh::cancelBackgroundPreparation() {
+  geometryStaging.cancel();
+  for (auto& q : quantities) {
+    q.second->cancelBackgroundPreparation();
+  }
+}
+
+void VolumeMesh::refresh() {
+  cancelBackgroundPreparation();
+  program.reset();
+  preparingProgram.reset();
+  requestRedraw();
+  QuantityStructure<VolumeMesh>::refresh(); // call base class version, which refreshes quantities
+}
+
+// === UI
+
+void VolumeMesh::buildPickUI(size_t localPickID) {
+  // Volume meshes are not pickable
+}
+
+void VolumeMesh::buildCustomUI() {
+
+  // Print stats
+  ImGui::Text("#verts: %lld  #tets: %lld  #hexes: %lld", static_cast<long long int>(nVertices()),
+              static_cast<long long int>(nTets()), static_cast<long long int>(nHexes()));
+
+  if (ImGui::ColorEdit3("Color", &color.get()[0], ImGuiColorEditFlags_NoInputs)) {
+    setColor(getColor());
+  }
+  ImGui::SameLine();
+
+  { // Edge options
+    ImGui::PushItemWidth(100);
+    bool showEdges = edgeWidth.get() > 0.;
+    if (ImGui::Checkbox("Edges", &showEdges)) {
+      setEdgeWidth(showEdges ? 1. : 0.);
+    }
+    if (showEdges) {
+      ImGui::SameLine();
+      if (ImGui::ColorEdit3("Edge Color", &edgeColor.get()[0], ImGuiColorEditFlags_NoInputs)) {
+        setEdgeColor(getEdgeColor());
+      }
+      ImGui::SameLine();
+      ImGui::PushItemWidth(60);
+      if (ImGui::SliderFloat("Width", &edgeWidth.get(), 0.001, 2.)) {
+        // the width is only a uniform, so the buffers do not need to be rebuilt
+        edgeWidth.manuallyChanged();
+        requestRedraw();
+      }
+      ImGui::PopItemWidth();
+    }
+    ImGui::PopItemWidth();
+  }
+
+  // Slice
+  if (ImGui::Checkbox("Plane slice", &planeSliceEnabled.get())) {
+    setPlaneSliceEnabled(getPlaneSliceEnabled());
+  }
+  if (planeSliceEnabled.get()) {
+    bool changed = ImGui::InputFloat3("Point", &planeSlicePoint.get()[0]);
+    changed |= ImGui::SliderFloat3("Normal", &planeSliceNormal.get()[0], -1., 1.);
+    if (changed) {
+      setPlaneSlice(planeSlicePoint.get(), planeSliceNormal.get());
+    }
+  }
+}
+
+void VolumeMesh::buildCustomOptionsUI() {
+  if (render::buildMaterialOptionsGui(material.get())) {
+    material.manuallyChanged();
+    setMaterial(material.get()); // trigger the other updates that happen on set()
+  }
+}
+
+// === Misc
+
+void VolumeMesh::computeExtents(std::tuple<glm::vec3, glm::vec3>& bboxOut, double& lengthScaleOut) {
+  computePointExtents(vertices, bboxOut, lengthScaleOut);
+}
+
+std::string VolumeMesh::typeName() { return structureTypeName; }
+
+// === Setters and getters
+
+VolumeMesh* VolumeMesh::setPlaneSliceEnabled(bool newVal) {
+  planeSliceEnabled = newVal;
+  slicePlaneChanged();
+  return this;
+}
+bool VolumeMesh::getPlaneSliceEnabled() { return planeSliceEnabled.get(); }
+
+VolumeMesh* VolumeMesh::setPlaneSlice(glm::vec3 point, glm::vec3 normal) {
+  planeSlicePoint = point;
+  planeSliceNormal = normal;
+  slicePlaneChanged();
+  return this;
+}
+
+VolumeMesh* VolumeMesh::setColor(glm::vec3 newVal) {
+  color = newVal;
+  requestRedraw();
+  return this;
+}
+glm::vec3 VolumeMesh::getColor() { return color.get(); }
+
+VolumeMesh* VolumeMesh::setEdgeWidth(double newVal) {
+  edgeWidth = newVal;
+  refresh();
+  requestRedraw();
+  return this;
+}
+double VolumeMesh::getEdgeWidth() { return edgeWidth.get(); }
+
+VolumeMesh* VolumeMesh::setEdgeColor(glm::vec3 newVal) {
+  edgeColor = newVal;
+  requestRedraw();
+  return this;
+}
+glm::vec3 VolumeMesh::getEdgeColor() { return edgeColor.get(); }
+
+VolumeMesh* VolumeMesh::setMaterial(std::string m) {
+  material = m;
+  refresh(); // (serves the purpose of re-initializing everything, though this is a bit overkill)
+  requestRedraw();
+  return this;
+}
+std::string VolumeMesh::getMaterial() { return material.get(); }
+
+// === Quantities
+
+VolumeMeshQuantity::VolumeMeshQuantity(std::string name_, VolumeMesh& volumeMesh_, bool dominates_)
+    : Quantity<VolumeMesh>(name_, volumeMesh_, dominates_) {}
+
+// === Quantity adders
+
+VolumeMeshVertexScalarQuantity*
+VolumeMesh::addVertexScalarQuantityImpl(std::string name, const std::vector<double>& data, DataType type) {
+  VolumeMeshVertexScalarQuantity* q = new VolumeMeshVertexScalarQuantity(name, data, *this, type);
+  addQuantity(q);
+  return q;
+}
+
+VolumeMeshCellScalarQuantity* VolumeMesh::addCellScalarQuantityImpl(std::string name, const std::vector<double>& data,
+                                                                    DataType type) {
+  VolumeMeshCellScalarQuantity* q = new VolumeMeshCellScalarQuantity(name, data, *this, type);
+  addQuantity(q);
+  return q;
+}
+
+} // namespace polyscope
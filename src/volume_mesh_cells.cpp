@@ -0,0 +1,399 @@
+// Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
+#include "polyscope/volume_mesh_cells.h"
+
+#include "polyscope/task_scheduler.h"
+
+#include "glm/glm.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace polyscope {
+
+// Storage for statics which are used by reference
+const uint32_t VolumeMeshCells::noVertex;
+
+namespace {
+
+// Faces of each cell type, outward-facing if the cell is positively oriented. Triangles end with -1.
+const int tetFaces[4][4] = {{0, 2, 1, -1}, {0, 1, 3, -1}, {1, 2, 3, -1}, {0, 3, 2, -1}};
+const int hexFaces[6][4] = {{0, 3, 2, 1}, {4, 5, 6, 7}, {0, 1, 5, 4}, {1, 2, 6, 5}, {2, 3, 7, 6}, {3, 0, 4, 7}};
+
+const int tetEdges[6][2] = {{0, 1}, {0, 2}, {0, 3}, {1, 2}, {1, 3}, {2, 3}};
+const int hexEdges[12][2] = {{0, 1}, {1, 2}, {2, 3}, {3, 0}, {4, 5}, {5, 6},
+                             {6, 7}, {7, 4}, {0, 4}, {1, 5}, {2, 6}, {3, 7}};
+
+const int (*cellFaceTable(size_t cellSize))[4] { return cellSize == 4 ? tetFaces : hexFaces; }
+
+// Faces are handled in chunks of this many
+const size_t faceChunkSize = 1 << 14;
+const size_t cellChunkSize = 4096;
+
+// Sorted faces are hashed into this many partitions, which are processed in parallel
+const size_t facePartitionCount = 256;
+
+typedef std::array<uint32_t, 4> FaceKey;
+
+struct FaceRecord {
+  FaceKey key; // the face's vertices, sorted
+  size_t face; // index among the faces of all cells, which may be more than fit in 32 bits
+};
+
+size_t facePartition(const FaceKey& key) {
+  uint64_t h = 0x9e3779b97f4a7c15ull;
+  for (uint32_t v : key) {
+    h = (h ^ v) * 0xff51afd7ed558ccdull;
+    h ^= h >> 29;
+  }
+  return static_cast<size_t>(h >> 56) % facePartitionCount;
+}
+
+glm::vec3 polygonNormal(const glm::vec3* points, size_t n) {
+  // Newell's method, which is also sensible for non-planar quads
+  glm::vec3 normal{0., 0., 0.};
+  for (size_t i = 0; i < n; i++) {
+    glm::vec3 a = points[i];
+    glm::vec3 b = points[(i + 1) % n];
+    normal += glm::cross(a, b);
+  }
+  float len = glm::length(normal);
+  return len > 0 ? normal / len : normal;
+}
+
+// A point on a clipped polygon, with the value interpolated to it
+struct PolygonPoint {
+  glm::vec3 position;
+  double value;
+  float dist; // signed distance to the slice plane
+};
+
+PolygonPoint interpolate(const PolygonPoint& a, const PolygonPoint& b) {
+  float t = a.dist / (a.dist - b.dist);
+  return PolygonPoint{a.position + t * (b.position - a.position), a.value + t * (b.value - a.value), 0.};
+}
+
+// Fan-triangulate a convex polygon into the output
+void emitPolygon(const std::vector<PolygonPoint>& polygon, glm::vec3 normal, bool hasValues,
+                 VolumeMeshTriangles& out) {
+  size_t D = polygon.size();
+  for (size_t j = 1; j + 1 < D; j++) {
+    const PolygonPoint* corners[3] = {&polygon[0], &polygon[j], &polygon[j + 1]};
+    glm::vec3 edgeReal{j == 1 ? 1.f : 0.f, 1.f, j + 2 == D ? 1.f : 0.f};
+    for (const PolygonPoint* p : corners) {
+      out.positions.push_back(p->position);
+      out.normals.push_back(normal);
+      out.edgeIsReal.push_back(edgeReal);
+      if (hasValues) {
+        out.values.push_back(p->value);
+      }
+    }
+  }
+}
+
+// Keep the part of a polygon on the negative side of the plane
+void clipPolygon(const std::vector<PolygonPoint>& polygon, std::vector<PolygonPoint>& clipped) {
+  clipped.clear();
+  for (size_t i = 0; i < polygon.size(); i++) {
+    const PolygonPoint& a = polygon[i];
+    const PolygonPoint& b = polygon[(i + 1) % polygon.size()];
+    bool aIn = a.dist <= 0;
+    bool bIn = b.dist <= 0;
+    if (aIn) {
+      clipped.push_back(a);
+    }
+    if (aIn != bIn) {
+      clipped.push_back(interpolate(a, b));
+    }
+  }
+}
+
+} // namespace
+
+VolumeMeshCells makeVolumeMeshCells(const std::vector<std::vector<size_t>>& cells) {
+  VolumeMeshCells result;
+  result.cellStart.reserve(cells.size() + 1);
+  for (const std::vector<size_t>& c : cells) {
+    for (size_t v : c) {
+      result.cellVertices.push_back(volumeMeshIndex(v));
+    }
+    result.cellStart.push_back(static_cast<uint32_t>(result.cellVertices.size()));
+  }
+  return result;
+}
+
+size_t validateVolumeMeshCells(const VolumeMeshCells& cells, size_t nVertices) {
+  for (size_t c = 0; c < cells.nCells(); c++) {
+    size_t D = cells.cellSize(c);
+    if (D != 4 && D != 8) {
+      return c;
+    }
+    const uint32_t* cell = cells.cell(c);
+    for (size_t j = 0; j < D; j++) {
+      if (cell[j] >= nVertices) {
+        return c;
+      }
+    }
+  }
+  return cells.nCells();
+}
+
+size_t volumeMeshCellFaceCount(size_t cellSize) { return cellSize == 4 ? 4 : 6; }
+
+VolumeMeshExterior computeVolumeMeshExterior(const std::vector<glm::vec3>& vertices, const VolumeMeshCells& cells) {
+  size_t nCells = cells.nCells();
+
+  // Number all of the faces of all of the cells
+  std::vector<size_t> faceStart(nCells + 1, 0);
+  for (size_t c = 0; c < nCells; c++) {
+    faceStart[c + 1] = faceStart[c] + volumeMeshCellFaceCount(cells.cellSize(c));
+  }
+  size_t nFaces = faceStart[nCells];
+
+  // Sort the vertices of each face, so that the faces shared by two cells have the same key
+  std::vector<FaceRecord> records(nFaces);
+  tasks::parallelFor(0, nCells, cellChunkSize, [&](size_t begin, size_t end) {
+    for (size_t c = begin; c < end; c++) {
+      const uint32_t* cell = cells.cell(c);
+      const int(*faces)[4] = cellFaceTable(cells.cellSize(c));
+      for (size_t f = 0; f < faceStart[c + 1] - faceStart[c]; f++) {
+        FaceRecord& record = records[faceStart[c] + f];
+        for (int j = 0; j < 4; j++) {
+          record.key[j] = faces[f][j] < 0 ? VolumeMeshCells::noVertex : cell[faces[f][j]];
+        }
+        std::sort(record.key.begin(), record.key.end());
+        record.face = faceStart[c] + f;
+      }
+    }
+  });
+
+  // Scatter the faces into partitions by their hash. Each chunk of faces writes to its own range of each partition,
+  // so the partitions come out in the same order for any number of threads.
+  size_t nChunks = tasks::chunkCount(0, nFaces, faceChunkSize);
+  std::vector<size_t> chunkOffsets(nChunks * facePartitionCount, 0);
+  tasks::parallelFor(0, nFaces, faceChunkSize, [&](size_t begin, size_t end) {
+    size_t* counts = &chunkOffsets[(begin / faceChunkSize) * facePartitionCount];
+    for (size_t i = begin; i < end; i++) {
+      counts[facePartition(records[i].key)]++;
+    }
+  });
+  std::vector<size_t> partitionStart(facePartitionCount + 1, 0);
+  size_t offset = 0;
+  for (size_t p = 0; p < facePartitionCount; p++) {
+    partitionStart[p] = offset;
+    for (size_t chunk = 0; chunk < nChunks; chunk++) {
+      size_t count = chunkOffsets[chunk * facePartitionCount + p];
+      chunkOffsets[chunk * facePartitionCount + p] = offset;
+      offset += count;
+    }
+  }
+  partitionStart[facePartitionCount] = offset;
+
+  std::vector<FaceRecord> partitioned(nFaces);
+  tasks::parallelFor(0, nFaces, faceChunkSize, [&](size_t begin, size_t end) {
+    size_t* offsets = &chunkOffsets[(begin / faceChunkSize) * facePartitionCount];
+    for (size_t i = begin; i < end; i++) {
+      partitioned[offsets[facePartition(records[i].key)]++] = records[i];
+    }
+  });
+  records = std::vector<FaceRecord>();
+
+  // Sort each partition, and mark the faces whose key appears only once
+  std::vector<uint8_t> isExterior(nFaces, 0);
+  tasks::parallelFor(0, facePartitionCount, 1, [&](size_t begin, size_t end) {
+    for (size_t p = begin; p < end; p++) {
+      FaceRecord* first = partitioned.data() + partitionStart[p];
+      FaceRecord* last = partitioned.data() + partitionStart[p + 1];
+      std::sort(first, last, [](const FaceRecord& a, const FaceRecord& b) { return a.key < b.key; });
+      for (FaceRecord* run = first; run != last;) {
+        FaceRecord* runEnd = run + 1;
+        while (runEnd != last && runEnd->key == run->key) runEnd++;
+        if (runEnd - run == 1) {
+          isExterior[run->face] = 1;
+        }
+        run = runEnd;
+      }
+    }
+  });
+  partitioned = std::vector<FaceRecord>();
+
+  // Gather the exterior faces by cell, oriented away from the cell's center
+  VolumeMeshExterior exterior;
+  exterior.cellFaceStart.assign(nCells + 1, 0);
+  for (size_t c = 0; c < nCells; c++) {
+    size_t count = 0;
+    for (size_t f = faceStart[c]; f < faceStart[c + 1]; f++) {
+      count += isExterior[f];
+    }
+    exterior.cellFaceStart[c + 1] = exterior.cellFaceStart[c] + count;
+  }
+  exterior.faces.resize(exterior.cellFaceStart[nCells]);
+  exterior.faceCells.resize(exterior.cellFaceStart[nCells]);
+
+  tasks::parallelFor(0, nCells, cellChunkSize, [&](size_t begin, size_t end) {
+    for (size_t c = begin; c < end; c++) {
+      const uint32_t* cell = cells.cell(c);
+      size_t D = cells.cellSize(c);
+      const int(*faces)[4] = cellFaceTable(D);
+      glm::vec3 cellCenter{0., 0., 0.};
+      for (size_t j = 0; j < D; j++) {
+        cellCenter += vertices[cell[j]];
+      }
+      cellCenter /= static_cast<float>(D);
+
+      size_t iOut = exterior.cellFaceStart[c];
+      for (size_t f = 0; f < faceStart[c + 1] - faceStart[c]; f++) {
+        if (!isExterior[faceStart[c] + f]) continue;
+
+        FaceKey face;
+        glm::vec3 points[4];
+        size_t n = faces[f][3] < 0 ? 3 : 4;
+        glm::vec3 faceCenter{0., 0., 0.};
+        for (size_t j = 0; j < 4; j++) {
+          face[j] = j < n ? cell[faces[f][j]] : VolumeMeshCells::noVertex;
+          if (j < n) {
+            points[j] = vertices[face[j]];
+            faceCenter += points[j];
+          }
+        }
+        faceCenter /= static_cast<float>(n);
+        if (glm::dot(polygonNormal(points, n), faceCenter - cellCenter) < 0) {
+          std::reverse(face.begin(), face.begin() + n);
+        }
+
+        exterior.faces[iOut] = face;
+        exterior.faceCells[iOut] = static_cast<uint32_t>(c);
+        iOut++;
+      }
+    }
+  });
+
+  return exterior;
+}
+
+VolumeMeshTriangles triangulateVolumeMesh(const std::vector<glm::vec3>& vertices, const VolumeMeshCells& cells,
+                                          const VolumeMeshExterior& exterior, const VolumeMeshSlicePlane& slice,
+                                          const std::vector<double>* values, bool valuesOnCells) {
+  bool hasValues = values != nullptr;
+  glm::vec3 sliceNormal = slice.normal;
+  bool sliced = slice.enabled && glm::length(sliceNormal) > 0;
+  if (sliced) {
+    sliceNormal = glm::normalize(sliceNormal);
+  }
+
+  // Each chunk of cells is triangulated separately, then the chunks are concatenated in order
+  size_t nCells = cells.nCells();
+  std::vector<VolumeMeshTriangles> chunks(tasks::chunkCount(0, nCells, cellChunkSize));
+  tasks::parallelFor(0, nCells, cellChunkSize, [&](size_t begin, size_t end) {
+    VolumeMeshTriangles& out = chunks[begin / cellChunkSize];
+    std::vector<PolygonPoint> polygon;
+    std::vector<PolygonPoint> clipped;
+    std::vector<glm::vec3> points;
+
+    for (size_t c = begin; c < end; c++) {
+      const uint32_t* cell = cells.cell(c);
+      size_t D = cells.cellSize(c);
+      double cellValue = hasValues && valuesOnCells ? (*values)[c] : 0.;
+      auto vertexPoint = [&](uint32_t v) {
+        double value = hasValues ? (valuesOnCells ? cellValue : (*values)[v]) : 0.;
+        float dist = sliced ? glm::dot(vertices[v] - slice.point, sliceNormal) : -1.f;
+        return PolygonPoint{vertices[v], value, dist};
+      };
+
+      // Which side of the slice is the cell on?
+      bool anyIn = !sliced;
+      bool anyOut = false;
+      if (sliced) {
+        for (size_t j = 0; j < D; j++) {
+          bool in = glm::dot(vertices[cell[j]] - slice.point, sliceNormal) <= 0;
+          anyIn = anyIn || in;
+          anyOut = anyOut || !in;
+        }
+      }
+      if (!anyIn) continue;
+
+      // Exterior faces, clipped if the slice cuts the cell
+      for (size_t iF = exterior.cellFaceStart[c]; iF < exterior.cellFaceStart[c + 1]; iF++) {
+        const std::array<uint32_t, 4>& face = exterior.faces[iF];
+        polygon.clear();
+        points.clear();
+        for (uint32_t v : face) {
+          if (v == VolumeMeshCells::noVertex) break;
+          polygon.push_back(vertexPoint(v));
+          points.push_back(vertices[v]);
+        }
+        glm::vec3 normal = polygonNormal(points.data(), points.size());
+        if (anyOut) {
+          clipPolygon(polygon, clipped);
+          emitPolygon(clipped, normal, hasValues, out);
+        } else {
+          emitPolygon(polygon, normal, hasValues, out);
+        }
+      }
+
+      // The cross-section, from the cell's edges which cross the plane. Cells are convex, so the crossings are ordered
+      // by their angle around the plane's normal.
+      if (!anyOut) continue;
+      const int(*edges)[2] = D == 4 ? tetEdges : hexEdges;
+      size_t nEdges = D == 4 ? 6 : 12;
+      polygon.clear();
+      glm::vec3 center{0., 0., 0.};
+      for (size_t iE = 0; iE < nEdges; iE++) {
+        PolygonPoint a = vertexPoint(cell[edges[iE][0]]);
+        PolygonPoint b = vertexPoint(cell[edges[iE][1]]);
+        if ((a.dist <= 0) != (b.dist <= 0)) {
+          polygon.push_back(interpolate(a, b));
+          center += polygon.back().position;
+        }
+      }
+      if (polygon.size() < 3) continue;
+      center /= static_cast<float>(polygon.size());
+
+      glm::vec3 u = polygon[0].position - center;
+      u = u - glm::dot(u, sliceNormal) * sliceNormal;
+      if (glm::length(u) == 0) continue;
+      u = glm::normalize(u);
+      glm::vec3 v = glm::cross(sliceNormal, u);
+      std::vector<std::pair<float, size_t>> angles(polygon.size());
+      for (size_t j = 0; j < polygon.size(); j++) {
+        glm::vec3 d = polygon[j].position - center;
+        angles[j] = std::make_pair(std::atan2(glm::dot(d, v), glm::dot(d, u)), j);
+      }
+      std::sort(angles.begin(), angles.end());
+
+      // Drop repeated points, from crossings at a vertex
+      clipped.clear();
+      for (const std::pair<float, size_t>& a : angles) {
+        const PolygonPoint& p = polygon[a.second];
+        if (!clipped.empty() && glm::length(p.position - clipped.back().position) == 0) continue;
+        clipped.push_back(p);
+      }
+      while (clipped.size() > 1 && glm::length(clipped.front().position - clipped.back().position) == 0) {
+        clipped.pop_back();
+      }
+      emitPolygon(clipped, sliceNormal, hasValues, out);
+    }
+  });
+
+  // Concatenate
+  VolumeMeshTriangles triangles;
+  size_t nCorners = 0;
+  for (const VolumeMeshTriangles& chunk : chunks) {
+    nCorners += chunk.positions.size();
+  }
+  triangles.positions.reserve(nCorners);
+  triangles.normals.reserve(nCorners);
+  triangles.edgeIsReal.reserve(nCorners);
+  if (hasValues) {
+    triangles.values.reserve(nCorners);
+  }
+  for (VolumeMeshTriangles& chunk : chunks) {
+    triangles.positions.insert(triangles.positions.end(), chunk.positions.begin(), chunk.positions.end());
+    triangles.normals.insert(triangles.normals.end(), chunk.normals.begin(), chunk.normals.end());
+    triangles.edgeIsReal.insert(triangles.edgeIsReal.end(), chunk.edgeIsReal.begin(), chunk.edgeIsReal.end());
+    triangles.values.insert(triangles.values.end(), chunk.values.begin(), chunk.values.end());
+    chunk = VolumeMeshTriangles();
+  }
+  return triangles;
+}
+
+} // namespace polyscope
@@ -0,0 +1,104 @@
+// Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
+#include "polyscope/volume_mesh_scalar_quantity.h"
+
+#include "polyscope/polyscope.h"
+#include "polyscope/render/engine.h"
+
+#include "imgui.h"
+
+namespace polyscope {
+
+VolumeMeshScalarQuantity::VolumeMeshScalarQuantity(std::string name, VolumeMesh& mesh_, std::string definedOn_,
+                                                   const std::vector<double>& values_, DataType dataType_)
+    : VolumeMeshQuantity(name, mesh_, true), ScalarQuantity(*this, values_, dataType_), definedOn(definedOn_) {}
+
+void VolumeMeshScalarQuantity::draw() {
+  if (!isEnabled()) return;
+
+  prepareProgram();
+  if (program == nullptr) return; // buffers not ready yet
+
+  // Set uniforms
+  parent.setTransformUniforms(*program);
+  parent.setStructureUniforms(*program);
+  setScalarUniforms(*program);
+
+  program->draw();
+}
+
+void VolumeMeshScalarQuantity::buildCustomUI() {
+  ImGui::SameLine();
+
+  // == Options popup
+  if (ImGui::Button("Options")) {
+    ImGui::OpenPopup("OptionsPopup");
+  }
+  if (ImGui::BeginPopup("OptionsPopup")) {
+
+    buildScalarOptionsUI();
+
+    ImGui::EndPopup();
+  }
+
+  buildScalarUI();
+}
+
+void VolumeMeshScalarQuantity::refresh() {
+  cancelBackgroundPreparation();
+  program.reset();
+  preparingProgram.reset();
+  Quantity::refresh();
+}
+
+void VolumeMeshScalarQuantity::cancelBackgroundPreparation() { colorStaging.cancel(); }
+
+void VolumeMeshScalarQuantity::prepareProgram() {
+
+  // Swap in the program once its buffers are ready
+  if (colorStaging.ready()) {
+    colorStaging.take().uploadTo(*preparingProgram);
+    preparingProgram->setTextureFromColormap("t_colormap", cMap.get());
+    render::engine->setMaterial(*preparingProgram, parent.getMaterial());
+    program = preparingProgram;
+    programSliceVersion = preparingSliceVersion;
+    preparingProgram.reset();
+    requestRedraw();
+  }
+
+  // Start assembling buffers on a worker thread if there are none, or they are for an old slice
+  if (!colorStaging.started() && (program == nullptr || programSliceVersion != parent.getSliceVersion())) {
+    preparingProgram =
+        render::engine->requestShader("MESH", parent.addStructureRules(addScalarRules({"MESH_PROPAGATE_VALUE"})));
+    preparingSliceVersion = parent.getSliceVersion();
+    bool wantsBary = preparingProgram->hasAttribute("a_barycoord");
+    bool wantsEdge = parent.getEdgeWidth() > 0;
+    bool onCells = definedOn == "cell";
+    VolumeMeshSlicePlane slice = parent.getSlicePlane();
+    colorStaging.start([=]() { return parent.assembleGeometryBuffers(wantsBary, wantsEdge, slice, &values, onCells); });
+  }
+
+  // Keep frames coming until the buffers are ready
+  if (colorStaging.started()) {
+    requestViewRedraw();
+  }
+}
+
+std::string VolumeMeshScalarQuantity::niceName() { return name + " (" + definedOn + " scalar)"; }
+
+// ========================================================
+// ==========           Vertex Scalar            ==========
+// ========================================================
+
+VolumeMeshVertexScalarQuantity::VolumeMeshVertexScalarQuantity(std::string name, const std::vector<double>& values_,
+                                                               VolumeMesh& mesh_, DataType dataType_)
+    : VolumeMeshScalarQuantity(name, mesh_, "vertex", values_, dataType_) {}
+
+// ========================================================
+// ==========             Cell Scalar            ==========
+// ========================================================
+
+VolumeMeshCellScalarQuantity::VolumeMeshCellScalarQuantity(std::string name, const std::vector<double>& values_,
+                                                           VolumeMesh& mesh_, DataType dataType_)
+    : VolumeMeshScalarQuantity(name, mesh_, "cell", values_, dataType_) {}
+
+} // namespace polyscope
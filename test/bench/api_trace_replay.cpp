@@ -0,0 +1,79 @@
+// Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
+
+#include "polyscope/api_trace.h"
+#include "polyscope/polyscope.h"
+#include "polyscope/render/engine.h"
+
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+// Replays a trace recorded with polyscope::startTrace(), so that a program's workload can be profiled (with perf,
+// valgrind, etc) without the program itself. Uses the mock backend unless another is given. Optionally writes the
+// shader permutations the workload used, for Engine::loadShaderPermutations().
+//
+//   polyscope-trace-replay trace_file [backend=openGL_mock] [repeat=1] [shaders=permutations_file]
+
+int main(int argc, char** argv) {
+
+  std::string backend = "openGL_mock";
+  std::string traceFile;
+  size_t nRepeat = 1;
+  std::string shadersFile;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg(argv[i]);
+
+    { // look for a backend setting
+      std::string prefix = "backend=";
+      if (arg.rfind(prefix, 0) == 0) {
+        backend = arg.substr(prefix.size(), std::string::npos);
+        continue;
+      }
+    }
+
+    { // look for a repeat count
+      std::string prefix = "repeat=";
+      if (arg.rfind(prefix, 0) == 0) {
+        nRepeat = std::stoul(arg.substr(prefix.size(), std::string::npos));
+        continue;
+      }
+    }
+
+    { // look for a shader permutation output file
+      std::string prefix = "shaders=";
+      if (arg.rfind(prefix, 0) == 0) {
+        shadersFile = arg.substr(prefix.size(), std::string::npos);
+        continue;
+      }
+    }
+
+    if (traceFile.empty()) {
+      traceFile = arg;
+      continue;
+    }
+
+    throw std::runtime_error("unrecognized argument " + arg);
+  }
+  if (traceFile.empty()) {
+    std::cerr << "usage: polyscope-trace-replay trace_file [backend=openGL_mock] [repeat=1] "
+                 "[shaders=permutations_file]"
+              << std::endl;
+    return 1;
+  }
+
+  polyscope::init(backend);
+
+  for (size_t iRep = 0; iRep < nRepeat; iRep++) {
+    auto start = std::chrono::steady_clock::now();
+    size_t nFrames = polyscope::replayTrace(traceFile);
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << traceFile << ": " << nFrames << " frames in " << sec << " sec" << std::endl;
+  }
+
+  if (!shadersFile.empty()) {
+    polyscope::render::engine->saveShaderPermutations(shadersFile);
+  }
+
+  return 0;
+}
@@ -0,0 +1,138 @@
+// Copyright 2017-2019, Nicholas Sharp and the Polyscope contributors. http://polyscope.run.
+
+#include "polyscope/polyscope.h"
+#include "polyscope/surface_mesh.h"
+#include "polyscope/trace_vector_field.h"
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Measures vector field tracing throughput, in lines per second, on a torus. The torus is closed and curved, so lines
+// cross many faces and every crossing transports the direction in to a new tangent basis.
+
+namespace {
+
+struct BenchMesh {
+  std::vector<glm::vec3> points;
+  std::vector<std::vector<size_t>> faces;
+  std::vector<glm::vec3> basisX;
+  std::vector<glm::vec2> field;
+};
+
+// A torus of nU x nV faces. If `quads` is false, each quad is split in to two triangles.
+BenchMesh buildTorus(size_t nU, size_t nV, bool quads) {
+  BenchMesh mesh;
+  float R = 1.0;
+  float r = 0.35;
+
+  auto vertAt = [&](size_t i, size_t j) { return (i % nU) * nV + (j % nV); };
+  for (size_t i = 0; i < nU; i++) {
+    for (size_t j = 0; j < nV; j++) {
+      float u = 2. * polyscope::PI * i / nU;
+      float v = 2. * polyscope::PI * j / nV;
+      mesh.points.push_back(glm::vec3{(R + r * std::cos(v)) * std::cos(u), (R + r * std::cos(v)) * std::sin(u),
+                                      r * std::sin(v)});
+    }
+  }
+
+  for (size_t i = 0; i < nU; i++) {
+    for (size_t j = 0; j < nV; j++) {
+      size_t a = vertAt(i, j);
+      size_t b = vertAt(i + 1, j);
+      size_t c = vertAt(i + 1, j + 1);
+      size_t d = vertAt(i, j + 1);
+      if (quads) {
+        mesh.faces.push_back({a, b, c, d});
+      } else {
+        mesh.faces.push_back({a, b, c});
+        mesh.faces.push_back({a, c, d});
+      }
+    }
+  }
+
+  // Use the first edge of each face as its tangent basis, and a field which winds around the torus at an angle
+  for (const std::vector<size_t>& face : mesh.faces) {
+    mesh.basisX.push_back(mesh.points[face[1]] - mesh.points[face[0]]);
+    mesh.field.push_back(glm::vec2{1., 0.5});
+  }
+
+  return mesh;
+}
+
+void runBench(std::string name, const BenchMesh& mesh, int nSym, size_t nLines) {
+
+  polyscope::SurfaceMesh* psMesh = polyscope::registerSurfaceMesh(name, mesh.points, mesh.faces);
+  psMesh->setFaceTangentBasisX(mesh.basisX);
+
+  // Synchronous tracing, on the calling thread
+  auto tStart = std::chrono::steady_clock::now();
+  std::vector<std::vector<std::array<glm::vec3, 2>>> lines = polyscope::traceField(*psMesh, mesh.field, nSym, nLines);
+  auto tEnd = std::chrono::steady_clock::now();
+  double syncSec = std::chrono::duration<double>(tEnd - tStart).count();
+
+  size_t nPoints = 0;
+  for (const std::vector<std::array<glm::vec3, 2>>& line : lines) {
+    nPoints += line.size();
+  }
+
+  // Background tracing, on all worker threads
+  tStart = std::chrono::steady_clock::now();
+  {
+    polyscope::FieldTraceJob job(*psMesh, mesh.field, nSym, nLines);
+    while (!job.isFinished()) {
+      std::this_thread::yield();
+    }
+  }
+  tEnd = std::chrono::steady_clock::now();
+  double jobSec = std::chrono::duration<double>(tEnd - tStart).count();
+
+  std::cout << name << " (" << mesh.faces.size() << " faces, nSym = " << nSym << "): " << nLines << " lines, "
+            << static_cast<double>(nPoints) / nLines << " points/line" << std::endl;
+  std::cout << "    sync:       " << nLines / syncSec << " lines/sec" << std::endl;
+  std::cout << "    background: " << nLines / jobSec << " lines/sec" << std::endl;
+
+  polyscope::removeStructure(psMesh);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+
+  std::string backend = "openGL_mock";
+  size_t nLines = 50000;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg(argv[i]);
+
+    { // look for a backend setting
+      std::string prefix = "backend=";
+      if (arg.rfind(prefix, 0) == 0) {
+        backend = arg.substr(prefix.size(), std::string::npos);
+        continue;
+      }
+    }
+
+    { // look for a line count
+      std::string prefix = "lines=";
+      if (arg.rfind(prefix, 0) == 0) {
+        nLines = std::stoul(arg.substr(prefix.size(), std::string::npos));
+        continue;
+      }
+    }
+
+    throw std::runtime_error("unrecognized argument " + arg);
+  }
+
+  polyscope::init(backend);
+
+  runBench("torus triangles", buildTorus(400, 150, false), 1, nLines);
+  runBench("torus quads", buildTorus(400, 150, true), 1, nLines);
+  runBench("torus quads cross field", buildTorus(400, 150, true), 4, nLines);
+
+  return 0;
+}
@@ -1,18 +1,39 @@
 
 #include "polyscope_test.h"
 
+#include "polyscope/api_trace.h"
+#include "polyscope/camera_path.h"
 #include "polyscope/curve_network.h"
+#include "polyscope/persistent_value.h"
 #include "polyscope/pick.h"
 #include "polyscope/point_cloud.h"
+#include "polyscope/render/shader_builder.h"
+#include "polyscope/snapshot.h"
 #include "polyscope/polyscope.h"
 #include "polyscope/surface_mesh.h"
+#include "polyscope/surface_mesh_draw_order.h"
+#include "polyscope/surface_mesh_io.h"
+#include "polyscope/surface_mesh_lod.h"
+#include "polyscope/task_scheduler.h"
+#include "polyscope/trace_vector_field.h"
+#include "polyscope/volume_grid.h"
+#include "polyscope/volume_mesh.h"
 
 #include "gtest/gtest.h"
+#include "imgui.h"
 
+#include <algorithm>
 #include <array>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <limits>
 #include <list>
+#include <random>
 #include <string>
+#include <thread>
 #include <vector>
 
 
@@ -65,6 +86,278 @@ TEST_F(PolyscopeTest, NestedShow) {
   polyscope::state::userCallback = nullptr;
 }
 
+// The main loop should still run frames (and the callback) when idling
+TEST_F(PolyscopeTest, SleepWhenIdle) {
+  polyscope::options::sleepWhenIdle = true;
+  polyscope::options::idleTimeout = 0.01;
+  int nCallbacks = 0;
+  polyscope::state::userCallback = [&]() { nCallbacks++; };
+  polyscope::show(8);
+  EXPECT_GE(nCallbacks, 8);
+
+  polyscope::state::userCallback = nullptr;
+  polyscope::options::sleepWhenIdle = false;
+  polyscope::options::idleTimeout = 0.5;
+}
+
+// Options take effect as soon as they are assigned
+TEST_F(PolyscopeTest, OptionsApplyImmediately) {
+  polyscope::options::ssaaFactor = 2;
+  EXPECT_EQ(polyscope::render::engine->getSSAAFactor(), 2);
+  polyscope::show(3);
+  polyscope::options::ssaaFactor = 1;
+  EXPECT_EQ(polyscope::render::engine->getSSAAFactor(), 1);
+
+  polyscope::options::transparencyMode = polyscope::TransparencyMode::Simple;
+  EXPECT_EQ(polyscope::render::engine->getTransparencyMode(), polyscope::TransparencyMode::Simple);
+  polyscope::options::transparencyMode = polyscope::TransparencyMode::None;
+
+  size_t version = polyscope::sceneContentVersion();
+  polyscope::options::shadowDarkness = 0.4; // unchanged, no redraw
+  EXPECT_EQ(version, polyscope::sceneContentVersion());
+  polyscope::options::shadowDarkness = 0.5;
+  EXPECT_NE(version, polyscope::sceneContentVersion());
+  polyscope::options::shadowDarkness = 0.4;
+
+  polyscope::options::groundPlaneEnabled = false;
+  EXPECT_EQ(polyscope::options::groundPlaneMode.get(), polyscope::GroundPlaneMode::None);
+  polyscope::show(3);
+  polyscope::options::groundPlaneEnabled = true;
+  polyscope::options::groundPlaneMode = polyscope::GroundPlaneMode::TileReflection;
+  polyscope::show(3);
+
+  // The scaled ground height keeps the methods it had as a plain ScaledValue
+  version = polyscope::sceneContentVersion();
+  polyscope::options::groundPlaneHeightFactor.set(0.25, false);
+  EXPECT_NE(version, polyscope::sceneContentVersion());
+  EXPECT_FALSE(polyscope::options::groundPlaneHeightFactor.isRelative());
+  EXPECT_EQ(polyscope::options::groundPlaneHeightFactor.asAbsolute(), 0.25f);
+  polyscope::options::groundPlaneHeightFactor = 0.;
+  EXPECT_TRUE(polyscope::options::groundPlaneHeightFactor.isRelative());
+  polyscope::show(3);
+}
+
+TEST_F(PolyscopeTest, TaskSchedulerParallelFor) {
+  // Per-chunk sums combined in order should not depend on the thread count
+  std::vector<double> vals(100000);
+  for (size_t i = 0; i < vals.size(); i++) {
+    vals[i] = 1. / (i + 1);
+  }
+  auto chunkedSum = [&]() {
+    std::vector<double> chunkSums(polyscope::tasks::chunkCount(0, vals.size(), 1000), 0.);
+    polyscope::tasks::parallelFor(0, vals.size(), 1000, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        chunkSums[begin / 1000] += vals[i];
+      }
+    });
+    double sum = 0.;
+    for (double s : chunkSums) sum += s;
+    return sum;
+  };
+
+  polyscope::options::nThreads = 1;
+  EXPECT_EQ(polyscope::tasks::threadCount(), 1u);
+  double serialSum = chunkedSum();
+  polyscope::options::nThreads = 4;
+  EXPECT_EQ(polyscope::tasks::threadCount(), 4u);
+  EXPECT_EQ(serialSum, chunkedSum());
+  EXPECT_EQ(polyscope::tasks::async([]() { return 7; }).get(), 7);
+
+  // Exceptions are passed back to the caller
+  EXPECT_THROW(polyscope::tasks::parallelFor(0, 100, 1,
+                                             [](size_t begin, size_t end) {
+                                               if (begin == 42) throw std::runtime_error("fail");
+                                             }),
+               std::runtime_error);
+
+  // A host executor gets all the tasks
+  size_t nHostTasks = 0;
+  polyscope::tasks::setExecutor([&](std::function<void()> task) {
+    nHostTasks++;
+    task();
+  });
+  EXPECT_EQ(serialSum, chunkedSum());
+  EXPECT_EQ(nHostTasks, 3u);
+  polyscope::tasks::setExecutor(nullptr);
+
+  polyscope::options::nThreads = 0;
+}
+
+// The shared per-frame uniforms should track the camera
+TEST_F(PolyscopeTest, FrameUniformsTrackCamera) {
+  polyscope::show(3);
+  const polyscope::render::FrameUniforms& frame = polyscope::render::engine->getFrameUniforms();
+  glm::mat4 P = polyscope::view::getCameraPerspectiveMatrix();
+  EXPECT_EQ(frame.projMatrix, P);
+  EXPECT_EQ(frame.invProjMatrix, glm::inverse(P));
+}
+
+// Persistent values can be snapshotted and restored in bulk
+TEST_F(PolyscopeTest, PersistentValueSnapshot) {
+  {
+    polyscope::PersistentValue<float> val("test_persistent", 1.);
+    polyscope::PersistentValue<bool> sameNameVal("test_persistent", false);
+    val = 2.;
+    sameNameVal = true;
+  }
+  polyscope::PersistentValueSnapshot snapshot = polyscope::snapshotPersistentValues();
+  {
+    polyscope::PersistentValue<float> val("test_persistent", 1.);
+    polyscope::PersistentValue<bool> sameNameVal("test_persistent", false);
+    EXPECT_EQ(val.get(), 2.);
+    EXPECT_TRUE(sameNameVal.get());
+    val = 3.;
+  }
+  polyscope::restorePersistentValues(snapshot);
+  {
+    polyscope::PersistentValue<float> val("test_persistent", 1.);
+    EXPECT_EQ(val.get(), 2.);
+  }
+}
+
+TEST_F(PolyscopeTest, GroundShadowViewChanges) {
+  polyscope::options::groundPlaneMode = polyscope::GroundPlaneMode::ShadowOnly;
+  polyscope::show(3);
+  polyscope::render::GroundPlane& ground = polyscope::render::engine->groundPlane;
+  size_t shadowRenders = ground.shadowMapRenderCount;
+  EXPECT_GT(shadowRenders, 0u);
+
+  // Scrolling moves the camera and redraws, but the cached shadow is reused
+  size_t version = polyscope::sceneContentVersion();
+  glm::mat4 viewMat = polyscope::view::viewMat;
+  ImGui::GetIO().MouseWheel = 1.; // read by the input handling at the start of the next frame
+  polyscope::show(1);
+  ImGui::GetIO().MouseWheel = 0.;
+  EXPECT_NE(viewMat, polyscope::view::viewMat);
+  polyscope::view::processTranslate(glm::vec2{0.1, 0.});
+  polyscope::show(3);
+  EXPECT_EQ(version, polyscope::sceneContentVersion());
+  EXPECT_EQ(shadowRenders, ground.shadowMapRenderCount);
+
+  // Changing the scene renders it again
+  polyscope::requestRedraw();
+  EXPECT_NE(version, polyscope::sceneContentVersion());
+  polyscope::show(3);
+  EXPECT_EQ(shadowRenders + 1, ground.shadowMapRenderCount);
+
+  polyscope::options::groundPlaneMode = polyscope::GroundPlaneMode::TileReflection;
+  polyscope::show(3);
+}
+
+TEST_F(PolyscopeTest, ProgressiveAA) {
+  polyscope::options::progressiveAA = true;
+  polyscope::options::progressiveAASamples = 4;
+  polyscope::show(6);
+  EXPECT_EQ(polyscope::render::engine->getSSAAFactor(), 1);
+  EXPECT_GE(polyscope::render::engine->getProgressiveSampleCount(), 4);
+
+  // moving the camera restarts accumulation
+  polyscope::view::processZoom(1.);
+  polyscope::show(0);
+  EXPECT_EQ(polyscope::render::engine->getProgressiveSampleCount(), 1);
+
+  polyscope::options::progressiveAA = false;
+  polyscope::options::progressiveAASamples = 16;
+  polyscope::show(3);
+}
+
+TEST_F(PolyscopeTest, ColorMapBatch) {
+  const polyscope::render::ValueColorMap& cmap = polyscope::render::engine->getColorMap("viridis");
+  std::vector<double> vals = {-3., -1., -0.5, 0., 0.3, 0.999, 1., 7., std::nan(""),
+                              std::numeric_limits<double>::infinity()};
+  std::vector<float> valsFloat(vals.begin(), vals.end());
+
+  std::vector<glm::vec3> colors(vals.size());
+  std::vector<glm::vec3> colorsFromFloat(vals.size());
+  std::vector<uint8_t> bytes(3 * vals.size());
+  cmap.getValues(vals.data(), vals.size(), -1., 1., colors.data());
+  cmap.getValues(valsFloat.data(), vals.size(), -1., 1., colorsFromFloat.data());
+  cmap.getValues(vals.data(), vals.size(), -1., 1., bytes.data());
+  for (size_t i = 0; i < vals.size(); i++) {
+    glm::vec3 expected = cmap.getValue((vals[i] + 1.) / 2.);
+    for (int j = 0; j < 3; j++) {
+      EXPECT_NEAR(colors[i][j], expected[j], 1e-5);
+      EXPECT_NEAR(colorsFromFloat[i][j], expected[j], 1e-5);
+      EXPECT_NEAR(bytes[3 * i + j], expected[j] * 255., 0.51);
+    }
+  }
+
+  // Large values in a narrow range keep their precision
+  std::vector<double> offsetVals = {1e9 + 0.25, 1e9 + 0.5, 1e9 + 0.75};
+  std::vector<glm::vec3> offsetColors(offsetVals.size());
+  cmap.getValues(offsetVals.data(), offsetVals.size(), 1e9, 1e9 + 1., offsetColors.data());
+  for (size_t i = 0; i < offsetVals.size(); i++) {
+    glm::vec3 expected = cmap.getValue(offsetVals[i] - 1e9);
+    for (int j = 0; j < 3; j++) {
+      EXPECT_NEAR(offsetColors[i][j], expected[j], 1e-5);
+    }
+  }
+
+  // Large arrays are split in to parallel chunks
+  std::vector<float> many(1000000);
+  for (size_t i = 0; i < many.size(); i++) many[i] = static_cast<float>(i % 1000) / 999.f;
+  std::vector<glm::vec3> manyColors(many.size());
+  cmap.getValues(many.data(), many.size(), 0., 1., manyColors.data());
+  for (size_t i = 0; i < many.size(); i += 9973) {
+    glm::vec3 expected = cmap.getValue(many[i]);
+    EXPECT_NEAR(manyColors[i].x, expected.x, 1e-5);
+    EXPECT_NEAR(manyColors[i].z, expected.z, 1e-5);
+  }
+}
+
+TEST_F(PolyscopeTest, ShaderReplacements) {
+  using namespace polyscope::render;
+  ShaderStageSpecification stage{ShaderStageType::Fragment, {}, {}, {}, "A ${ ONE }$ B ${ TWO }$ C"};
+  ShaderReplacementRule ruleX("X", {{"ONE", "x1"}, {"TWO", "x2"}});
+  ShaderReplacementRule ruleY("Y", {{"TWO", "y2"}});
+
+  std::vector<ShaderStageSpecification> result = applyShaderReplacements({stage}, {ruleX, ruleY});
+  ASSERT_EQ(result.size(), 1u);
+  EXPECT_EQ(result[0].src, "A \n// tag ${ ONE }$\n// from rule: X\nx1\n B \n// tag ${ TWO }$\n// from rule: X\nx2\n"
+                           "// from rule: Y\ny2\n C");
+
+  // Parsed once, applied many times
+  ParsedShaderStage parsed(stage);
+  EXPECT_EQ(parsed.tags, (std::vector<std::string>{"ONE", "TWO"}));
+  EXPECT_EQ(parsed.segments, (std::vector<std::string>{"A ", " B ", " C"}));
+  EXPECT_EQ(applyShaderReplacements({parsed}, {&ruleY})[0].src, "A \n// tag ${ ONE }$\n B \n// tag ${ TWO }$\n// "
+                                                                "from rule: Y\ny2\n C");
+
+  ShaderStageSpecification unmatched{ShaderStageType::Fragment, {}, {}, {}, "A ${ ONE B"};
+  EXPECT_THROW(ParsedShaderStage{unmatched}, std::runtime_error);
+}
+
+TEST_F(PolyscopeTest, CameraPathRecordAndReplay) {
+  polyscope::startRecordingCameraPath();
+  polyscope::show(2);
+  polyscope::view::processZoom(1.);
+  polyscope::show(2);
+  polyscope::CameraPath path = polyscope::stopRecordingCameraPath();
+  EXPECT_FALSE(polyscope::isRecordingCameraPath());
+  ASSERT_GE(path.keyframes.size(), 2u);
+
+  // build a path of known length, then save and load it
+  path = polyscope::CameraPath();
+  glm::mat4 startView = polyscope::view::getCameraViewMatrix();
+  path.addKeyframe(0., startView, 45.);
+  path.addKeyframe(1., glm::translate(startView, glm::vec3{0., 0., -1.}), 60.);
+  path.save("test_camera_path.json");
+  polyscope::CameraPath loaded = polyscope::CameraPath::load("test_camera_path.json");
+  std::remove("test_camera_path.json");
+  ASSERT_EQ(loaded.keyframes.size(), 2u);
+  EXPECT_EQ(loaded.duration(), 1.);
+
+  glm::mat4 midView;
+  double midFov;
+  loaded.evaluate(0.5, midView, midFov);
+  EXPECT_NEAR(midFov, 52.5, 1e-5);
+
+  polyscope::CameraPathTimings timings = polyscope::replayCameraPath(loaded, 0.25);
+  EXPECT_EQ(timings.frameTimes.size(), 5u);
+  EXPECT_LE(timings.median, timings.max);
+  EXPECT_EQ(polyscope::view::getCameraViewMatrix(), startView);
+}
+
 
 // ============================================================
 // =============== Point cloud tests
@@ -115,6 +408,205 @@ TEST_F(PolyscopeTest, PointCloudAppearance) {
   polyscope::removeAllStructures();
 }
 
+TEST_F(PolyscopeTest, PointCloudExtents) {
+  auto psPoints = registerPointCloud();
+  EXPECT_EQ(std::get<1>(psPoints->boundingBox()), glm::vec3(1, 1, 1));
+  EXPECT_EQ(std::get<1>(polyscope::state::boundingBox), glm::vec3(1, 1, 1));
+
+  // Cached extents follow geometry updates and transforms
+  std::vector<glm::vec3> points = getPoints();
+  for (glm::vec3& p : points) p *= 2.f;
+  psPoints->updatePointPositions(points);
+  EXPECT_EQ(std::get<1>(psPoints->boundingBox()), glm::vec3(2, 2, 2));
+  double scale = psPoints->lengthScale();
+  psPoints->rescaleToUnit();
+  EXPECT_NEAR(psPoints->lengthScale(), 1., 1e-5);
+  EXPECT_NEAR(std::get<1>(psPoints->boundingBox()).x, 2. / scale, 1e-5);
+
+  // Scene extents are the union over structures
+  auto psPoints2 = registerPointCloud("test2");
+  EXPECT_EQ(std::get<1>(polyscope::state::boundingBox), glm::vec3(1, 1, 1));
+  psPoints2->remove();
+  EXPECT_NEAR(std::get<1>(polyscope::state::boundingBox).x, 2. / scale, 1e-5);
+
+  psPoints->resetTransform(); // (the transform is a persistent value)
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, ShaderPermutations) {
+  auto psPoints = registerPointCloud();
+  polyscope::show(3);
+
+  // Everything drawn so far was assembled once and kept
+  std::vector<std::string> permutations = polyscope::render::engine->getShaderPermutations();
+  EXPECT_FALSE(permutations.empty());
+  EXPECT_TRUE(std::is_sorted(permutations.begin(), permutations.end()));
+  polyscope::render::engine->precomputeShaderPermutations(permutations);
+  EXPECT_EQ(polyscope::render::engine->getShaderPermutations(), permutations);
+
+  // Permutations which were not used yet
+  polyscope::render::engine->precomputeShaderPermutations({"MESH GLSL_VERSION FRAME_UNIFORMS SHADE_BASECOLOR"});
+  EXPECT_EQ(polyscope::render::engine->getShaderPermutations().size(), permutations.size() + 1);
+  EXPECT_THROW(polyscope::render::engine->precomputeShaderPermutations({"NOT_A_PROGRAM"}), std::runtime_error);
+  EXPECT_THROW(polyscope::render::engine->precomputeShaderPermutations({"MESH NOT_A_RULE"}), std::runtime_error);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudCulling) {
+  // (enough points for several culling chunks)
+  std::vector<glm::vec3> points;
+  for (size_t i = 0; i < 20000; i++) {
+    points.push_back(glm::vec3{i / 10000. - 1., 0., 0.});
+  }
+  auto psPoints = polyscope::registerPointCloud("culled", points);
+  polyscope::view::resetCameraToHomeView();
+  polyscope::show(3);
+  EXPECT_TRUE(psPoints->updateCulling());
+
+  // Nothing is drawn when the points are behind the camera
+  glm::mat4 viewMatBefore = polyscope::view::viewMat;
+  polyscope::view::viewMat = glm::translate(viewMatBefore, glm::vec3{0., 0., 1000.});
+  EXPECT_FALSE(psPoints->updateCulling());
+  polyscope::options::frustumCulling = false;
+  EXPECT_TRUE(psPoints->updateCulling());
+  polyscope::options::frustumCulling = true;
+
+  // Look closely at one end of the line, so that most of the chunks are off screen
+  polyscope::view::viewMat = glm::lookAt(glm::vec3{1., 0., .5}, glm::vec3{1., 0., 0.}, glm::vec3{0., 1., 0.});
+  polyscope::show(3);
+  EXPECT_TRUE(psPoints->updateCulling());
+  const std::vector<polyscope::DrawRange>& ranges = psPoints->getVisibleDrawRanges();
+  ASSERT_FALSE(ranges.empty());
+  size_t nDrawn = 0;
+  for (const polyscope::DrawRange& range : ranges) {
+    nDrawn += range.count;
+  }
+  EXPECT_GT(nDrawn, 0u);
+  EXPECT_LT(nDrawn, points.size());
+  EXPECT_EQ(ranges.back().start + ranges.back().count, points.size()); // the end being looked at is drawn
+
+  polyscope::view::viewMat = viewMatBefore;
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudCullingShuffled) {
+  // A grid of points given in random order; culling chunks still have to be spatially compact
+  std::vector<glm::vec3> points;
+  for (int i = 0; i < 40; i++) {
+    for (int j = 0; j < 40; j++) {
+      for (int k = 0; k < 40; k++) {
+        points.push_back(glm::vec3{i / 19.5 - 1., j / 19.5 - 1., k / 19.5 - 1.});
+      }
+    }
+  }
+  std::mt19937 rng(0);
+  std::shuffle(points.begin(), points.end(), rng);
+  auto psPoints = polyscope::registerPointCloud("shuffled", points);
+  polyscope::view::resetCameraToHomeView();
+  polyscope::show(3);
+
+  // The draw order is a permutation of the points
+  std::vector<size_t> order = psPoints->getPointDrawOrder();
+  ASSERT_EQ(order.size(), points.size());
+  std::sort(order.begin(), order.end());
+  for (size_t i = 0; i < order.size(); i++) {
+    EXPECT_EQ(order[i], i);
+  }
+
+  // Look out of the cloud from near one corner, so that most of the chunks are off screen
+  glm::mat4 viewMatBefore = polyscope::view::viewMat;
+  polyscope::view::viewMat = glm::lookAt(glm::vec3{.9, .9, .9}, glm::vec3{2., 2., 2.}, glm::vec3{0., 1., 0.});
+  polyscope::show(3);
+  EXPECT_TRUE(psPoints->updateCulling());
+  size_t nDrawn = 0;
+  for (const polyscope::DrawRange& range : psPoints->getVisibleDrawRanges()) {
+    nDrawn += range.count;
+  }
+  EXPECT_GT(nDrawn, 0u);
+  EXPECT_LT(nDrawn, points.size() / 2);
+
+  // Per-point data is uploaded in the same order as the positions
+  psPoints->addScalarQuantity("x", std::vector<double>(points.size(), 1.))->setEnabled(true);
+  polyscope::show(3);
+
+  polyscope::view::viewMat = viewMatBefore;
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, OcclusionCulling) {
+  polyscope::render::Engine& engine = *polyscope::render::engine;
+
+  // A wall at z = 0, seen from z = 5
+  glm::mat4 viewProj = glm::perspective(glm::radians(45.f), 1.f, 0.1f, 10.f) *
+                       glm::lookAt(glm::vec3{0., 0., 5.}, glm::vec3{0., 0., 0.}, glm::vec3{0., 1., 0.});
+  glm::vec4 wallClip = viewProj * glm::vec4{0., 0., 0., 1.};
+  float wallDepth = 0.5f * wallClip.z / wallClip.w + 0.5f;
+  std::vector<float> depth(64 * 64, wallDepth);
+  engine.buildOcclusionPyramid(depth, 64, 64, viewProj);
+
+  glm::mat4 I(1.);
+  EXPECT_TRUE(engine.boxIsOccluded(viewProj, I, glm::vec3{-1., -1., -2.}, glm::vec3{1., 1., -1.}));
+  EXPECT_FALSE(engine.boxIsOccluded(viewProj, I, glm::vec3{-1., -1., 1.}, glm::vec3{1., 1., 2.}));
+  EXPECT_FALSE(engine.boxIsOccluded(viewProj, I, glm::vec3{-1., -1., -1.}, glm::vec3{1., 1., 1.}));
+  EXPECT_TRUE(engine.boxIsOccluded(viewProj, glm::translate(I, glm::vec3{0., 0., -3.}), glm::vec3{-1., -1., 1.},
+                                   glm::vec3{1., 1., 2.}));
+  EXPECT_EQ(engine.occlusionStats.nTested, 4u);
+  EXPECT_EQ(engine.occlusionStats.nOccluded, 2u);
+
+  // Not for some other camera
+  EXPECT_FALSE(engine.boxIsOccluded(glm::translate(viewProj, glm::vec3{0., 0., 0.1}), I, glm::vec3{-1., -1., -2.},
+                                    glm::vec3{1., 1., -1.}));
+
+  // Seen through a hole in the middle of the wall
+  for (size_t y = 28; y < 36; y++) {
+    for (size_t x = 28; x < 36; x++) {
+      depth[64 * y + x] = 1.;
+    }
+  }
+  engine.buildOcclusionPyramid(depth, 64, 64, viewProj);
+  EXPECT_FALSE(engine.boxIsOccluded(viewProj, I, glm::vec3{-0.1, -0.1, -2.}, glm::vec3{0.1, 0.1, -1.}));
+  EXPECT_TRUE(engine.boxIsOccluded(viewProj, I, glm::vec3{1.5, 1.5, -2.}, glm::vec3{1.7, 1.7, -1.}));
+
+  // Draw with the pre-pass
+  polyscope::options::occlusionCulling = true;
+  registerPointCloud("occluder");
+  registerPointCloud("occludee");
+  polyscope::show(3);
+  EXPECT_GT(engine.occlusionStats.nOccluders, 0u);
+  polyscope::options::transparencyMode = polyscope::TransparencyMode::Pretty;
+  polyscope::show(3);
+  polyscope::options::transparencyMode = polyscope::TransparencyMode::None;
+
+  polyscope::options::occlusionCulling = false;
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, StructureBatch) {
+  glm::vec3 centerBefore = polyscope::state::center;
+  {
+    polyscope::StructureBatch batch;
+    for (int i = 0; i < 100; i++) {
+      std::vector<glm::vec3> points = getPoints();
+      for (glm::vec3& p : points) p += glm::vec3{10., 0., 0.};
+      polyscope::registerPointCloud("batch" + std::to_string(i), points);
+    }
+    polyscope::removeStructure("batch7");
+
+    // Nested batches only commit at the outermost one
+    polyscope::beginBatch();
+    polyscope::registerPointCloud("batch7", getPoints());
+    polyscope::endBatch();
+    EXPECT_EQ(polyscope::state::center, centerBefore);
+  }
+  EXPECT_NEAR(polyscope::state::center.x, 5.5, 1e-5);
+  EXPECT_EQ(polyscope::state::structures[polyscope::PointCloud::structureTypeName].size(), 100u);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+  EXPECT_EQ(polyscope::state::center, glm::vec3(0., 0., 0.));
+}
+
 TEST_F(PolyscopeTest, PointCloudPick) {
   auto psPoints = registerPointCloud();
 
@@ -155,6 +647,14 @@ TEST_F(PolyscopeTest, PointCloudScalar) {
   auto q1 = psPoints->addScalarQuantity("vScalar", vScalar);
   q1->setEnabled(true);
   polyscope::show(3);
+
+  // Colors for export
+  q1->setMapRange(std::make_pair(6., 8.));
+  std::vector<glm::vec3> colors = q1->getColors();
+  ASSERT_EQ(colors.size(), psPoints->nPoints());
+  glm::vec3 expected = polyscope::render::engine->getColorMap(q1->getColorMap()).getValue(0.5);
+  EXPECT_NEAR(colors[0].y, expected.y, 1e-5);
+
   polyscope::removeAllStructures();
 }
 
@@ -262,6 +762,130 @@ TEST_F(PolyscopeTest, SurfaceMeshAppearance) {
   polyscope::removeAllStructures();
 }
 
+TEST_F(PolyscopeTest, SurfaceMeshLevelOfDetail) {
+  // A bumpy grid, with two culling chunks
+  const size_t N = 64;
+  std::vector<glm::vec3> points;
+  std::vector<std::vector<size_t>> faces;
+  for (size_t i = 0; i < N; i++) {
+    for (size_t j = 0; j < N; j++) {
+      float x = static_cast<float>(i);
+      float y = static_cast<float>(j);
+      points.push_back(glm::vec3{x, y, 0.1f * std::sin(0.3f * x) * std::cos(0.2f * y)});
+      if (i + 1 < N && j + 1 < N) {
+        faces.push_back({i * N + j, (i + 1) * N + j, (i + 1) * N + j + 1});
+        faces.push_back({i * N + j, (i + 1) * N + j + 1, i * N + j + 1});
+      }
+    }
+  }
+
+  std::shared_ptr<polyscope::SurfaceMeshLOD> lod = polyscope::buildSurfaceMeshLOD(points, faces, 4096);
+  ASSERT_EQ(lod->chunks.size(), 2u);
+  EXPECT_EQ(lod->triangles.size(), lod->triangleFaces.size());
+  size_t nFullTriangles = 0;
+  for (const polyscope::SurfaceMeshLOD::Chunk& chunk : lod->chunks) {
+    EXPECT_EQ(chunk.fullTriangleStart, nFullTriangles);
+    nFullTriangles += chunk.fullTriangleCount;
+    ASSERT_FALSE(chunk.levels.empty());
+    size_t prevCount = chunk.fullTriangleCount;
+    double prevError = 0.;
+    for (const polyscope::SurfaceMeshLOD::Level& level : chunk.levels) {
+      EXPECT_LT(level.triangleCount, prevCount);
+      EXPECT_GE(level.error, prevError);
+      prevCount = level.triangleCount;
+      prevError = level.error;
+    }
+  }
+  EXPECT_EQ(nFullTriangles, faces.size());
+  for (size_t iT = 0; iT < lod->triangles.size(); iT++) {
+    for (size_t iV : lod->triangles[iT]) {
+      EXPECT_LT(iV, points.size());
+    }
+    EXPECT_LT(lod->triangleFaces[iT], faces.size());
+  }
+
+  // A flat grid simplifies with no error
+  std::vector<glm::vec3> flatPoints = points;
+  for (glm::vec3& p : flatPoints) p.z = 0.;
+  std::shared_ptr<polyscope::SurfaceMeshLOD> flatLod = polyscope::buildSurfaceMeshLOD(flatPoints, faces, 4096);
+  for (const polyscope::SurfaceMeshLOD::Chunk& chunk : flatLod->chunks) {
+    for (const polyscope::SurfaceMeshLOD::Level& level : chunk.levels) {
+      EXPECT_NEAR(level.error, 0., 1e-5);
+    }
+  }
+
+  // Drawing, with quantities which do and don't use the simplified triangles
+  auto psMesh = polyscope::registerSurfaceMesh("lod", points, faces);
+  psMesh->setLevelOfDetail(true);
+  EXPECT_TRUE(psMesh->isLevelOfDetail());
+  std::vector<double> vScalar(psMesh->nVertices(), 7.);
+  std::vector<glm::vec3> fColors(psMesh->nFaces(), glm::vec3{.2, .3, .4});
+  psMesh->addVertexScalarQuantity("vScalar", vScalar)->setEnabled(true);
+  psMesh->addFaceColorQuantity("fColor", fColors)->setEnabled(true);
+  polyscope::show(10);
+  ASSERT_NE(psMesh->getLevelOfDetailData(), nullptr);
+  EXPECT_EQ(psMesh->getLevelOfDetailData()->chunks.size(), 2u);
+  psMesh->setEdgeWidth(1.);
+  psMesh->setSmoothShade(true);
+  polyscope::show(3);
+
+  psMesh->setLevelOfDetail(false);
+  EXPECT_EQ(psMesh->getLevelOfDetailData(), nullptr);
+  polyscope::show(3);
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshDrawOrder) {
+  // A grid, with two culling chunks
+  const size_t N = 64;
+  std::vector<glm::vec3> points;
+  std::vector<std::vector<size_t>> faces;
+  for (size_t i = 0; i < N; i++) {
+    for (size_t j = 0; j < N; j++) {
+      points.push_back(glm::vec3{static_cast<float>(i), static_cast<float>(j), 0.f});
+      if (i + 1 < N && j + 1 < N) {
+        faces.push_back({i * N + j, (i + 1) * N + j, (i + 1) * N + j + 1});
+        faces.push_back({i * N + j, (i + 1) * N + j + 1, i * N + j + 1});
+      }
+    }
+  }
+
+  // A permutation, which only moves faces within their chunk
+  std::vector<size_t> order = polyscope::computeOptimizedFaceOrder(points, faces, 4096);
+  ASSERT_EQ(order.size(), faces.size());
+  std::vector<size_t> identity(faces.size());
+  for (size_t i = 0; i < identity.size(); i++) identity[i] = i;
+  EXPECT_NE(order, identity);
+  for (size_t iStart = 0; iStart < order.size(); iStart += 4096) {
+    size_t iEnd = std::min(iStart + 4096, order.size());
+    std::vector<size_t> chunkFaces(order.begin() + iStart, order.begin() + iEnd);
+    std::sort(chunkFaces.begin(), chunkFaces.end());
+    for (size_t i = iStart; i < iEnd; i++) {
+      EXPECT_EQ(chunkFaces[i - iStart], i);
+    }
+  }
+
+  // Drawing and picking with it
+  auto psMesh = polyscope::registerSurfaceMesh("ordered", points, faces);
+  std::vector<double> fScalar(psMesh->nFaces(), 8.);
+  std::vector<double> heScalar(psMesh->nHalfedges(), 9.);
+  psMesh->addFaceScalarQuantity("fScalar", fScalar)->setEnabled(true);
+  psMesh->addHalfedgeScalarQuantity("heScalar", heScalar);
+  psMesh->setDrawOrderOptimized(true);
+  EXPECT_TRUE(psMesh->isDrawOrderOptimized());
+  EXPECT_EQ(psMesh->faceDrawOrder, order);
+  polyscope::show(3);
+  psMesh->getQuantity("heScalar")->setEnabled(true);
+  psMesh->setEdgeWidth(1.);
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  psMesh->setDrawOrderOptimized(false);
+  EXPECT_FALSE(psMesh->isDrawOrderOptimized());
+  polyscope::show(3);
+  polyscope::removeAllStructures();
+}
+
 TEST_F(PolyscopeTest, SurfaceMeshPick) {
   auto psMesh = registerTriangleMesh();
 
@@ -303,6 +927,56 @@ TEST_F(PolyscopeTest, SurfaceMeshScalarVertex) {
   polyscope::removeAllStructures();
 }
 
+TEST_F(PolyscopeTest, SurfaceMeshBackgroundPrepare) {
+  auto psMesh = registerTriangleMesh();
+  std::vector<double> vScalar(psMesh->nVertices(), 7.);
+  auto q1 = psMesh->addVertexScalarQuantity("vScalar", vScalar);
+  q1->setEnabled(true);
+  polyscope::show(1);
+
+  // Changing or removing the mesh while its buffers may still be assembling should be safe
+  std::vector<glm::vec3> points;
+  std::vector<std::vector<size_t>> faces;
+  std::tie(points, faces) = getTriangleMesh();
+  psMesh->updateVertexPositions(points);
+  polyscope::show(1);
+  psMesh->setSmoothShade(true);
+  q1->setEnabled(false);
+  polyscope::show(1);
+  polyscope::removeAllStructures();
+
+  // Eventually everything is prepared and drawn
+  psMesh = registerTriangleMesh();
+  q1 = psMesh->addVertexScalarQuantity("vScalar", vScalar);
+  q1->setEnabled(true);
+  polyscope::show(10);
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshRemoveQuantityWhilePreparing) {
+  auto psMesh = registerTriangleMesh();
+  std::vector<double> vScalar(psMesh->nVertices(), 7.);
+  std::vector<double> fScalar(psMesh->nFaces(), 8.);
+
+  // The first frame starts assembling the quantity's buffers in the background
+  auto q1 = psMesh->addVertexScalarQuantity("vScalar", vScalar);
+  q1->setEnabled(true);
+  polyscope::show(1);
+  psMesh->removeQuantity("vScalar");
+  EXPECT_EQ(psMesh->getQuantity("vScalar"), nullptr);
+  polyscope::show(1);
+
+  // Replacing it with a quantity of the same name
+  auto q2 = psMesh->addFaceScalarQuantity("fScalar", fScalar);
+  q2->setEnabled(true);
+  polyscope::show(1);
+  q2 = psMesh->addFaceScalarQuantity("fScalar", fScalar);
+  EXPECT_TRUE(q2->isEnabled());
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
 TEST_F(PolyscopeTest, SurfaceMeshScalarFace) {
   auto psMesh = registerTriangleMesh();
   std::vector<double> fScalar(psMesh->nFaces(), 8.);
@@ -476,6 +1150,110 @@ TEST_F(PolyscopeTest, SurfaceMeshFaceIntrinsicRibbon) {
   polyscope::removeAllStructures();
 }
 
+TEST_F(PolyscopeTest, SurfaceMeshBackgroundTraceMatchesSync) {
+  auto psMesh = registerTriangleMesh();
+  std::vector<glm::vec3> basisX(psMesh->nFaces(), {1., 2., 3.});
+  psMesh->setFaceTangentBasisX(basisX);
+  std::vector<glm::vec2> vals(psMesh->nFaces(), {1., 2.});
+
+  std::vector<std::vector<std::array<glm::vec3, 2>>> syncLines = polyscope::traceField(*psMesh, vals, 1, 50);
+
+  polyscope::FieldTraceJob job(*psMesh, vals, 1, 50);
+  std::vector<std::vector<std::array<glm::vec3, 2>>> jobLines;
+  while (!job.isFinished()) {
+    std::this_thread::yield();
+  }
+  job.takeFinishedLines(jobLines);
+
+  // Lines may arrive in any order, but the same set of lines should be traced
+  auto lineLess = [](const std::vector<std::array<glm::vec3, 2>>& a, const std::vector<std::array<glm::vec3, 2>>& b) {
+    if (a.size() != b.size()) return a.size() < b.size();
+    for (size_t i = 0; i < a.size(); i++) {
+      for (int j = 0; j < 3; j++) {
+        if (a[i][0][j] != b[i][0][j]) return a[i][0][j] < b[i][0][j];
+      }
+    }
+    return false;
+  };
+  std::sort(syncLines.begin(), syncLines.end(), lineLess);
+  std::sort(jobLines.begin(), jobLines.end(), lineLess);
+  EXPECT_EQ(syncLines, jobLines);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshRibbonCancel) {
+  auto psMesh = registerTriangleMesh();
+  std::vector<glm::vec3> basisX(psMesh->nFaces(), {1., 2., 3.});
+  psMesh->setFaceTangentBasisX(basisX);
+  std::vector<glm::vec2> vals(psMesh->nFaces(), {1., 2.});
+  auto q1 = psMesh->addFaceIntrinsicVectorQuantity("param", vals);
+  q1->setEnabled(true);
+  q1->setRibbonEnabled(true);
+  polyscope::show(1);
+
+  // Disabling and refreshing while lines are still being traced should be safe
+  q1->setRibbonEnabled(false);
+  q1->setRibbonEnabled(true);
+  polyscope::show(1);
+  psMesh->refresh();
+  q1->setEnabled(false);
+  polyscope::show(3);
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshTracePolygonal) {
+  // A flat strip of quads and a pentagon, with a field pointing along the strip
+  std::vector<glm::vec3> points = {{0, 0, 0}, {1, 0, 0}, {2, 0, 0},   {3, 0, 0}, {0, 1, 0},
+                                   {1, 1, 0}, {2, 1, 0}, {3.5, .5, 0}, {3, 1, 0}};
+  std::vector<std::vector<size_t>> faces = {{0, 1, 5, 4}, {1, 2, 6, 5}, {2, 3, 7, 8, 6}};
+  auto psMesh = polyscope::registerSurfaceMesh("polygonal", points, faces);
+  std::vector<glm::vec3> basisX(psMesh->nFaces(), {1., 0., 0.});
+  psMesh->setFaceTangentBasisX(basisX);
+  std::vector<glm::vec2> vals(psMesh->nFaces(), {1., 0.});
+
+  std::vector<std::vector<std::array<glm::vec3, 2>>> lines = polyscope::traceField(*psMesh, vals, 1, 20);
+  EXPECT_EQ(lines.size(), 20u);
+  for (const std::vector<std::array<glm::vec3, 2>>& line : lines) {
+    ASSERT_GE(line.size(), 2u);
+    for (const std::array<glm::vec3, 2>& p : line) {
+      // Lines stay straight as they cross between polygons
+      EXPECT_NEAR(p[0].y, line.front()[0].y, 1e-3);
+      EXPECT_NEAR(p[0].z, 0., 1e-6);
+    }
+  }
+
+  auto q1 = psMesh->addFaceIntrinsicVectorQuantity("param", vals);
+  q1->setEnabled(true);
+  q1->setRibbonEnabled(true);
+  polyscope::show(3);
+  polyscope::removeAllStructures();
+}
+
+// The OBJ reader keeps a backslash continuation with its line when it cuts the file in to chunks there
+TEST_F(PolyscopeTest, SurfaceMeshOBJContinuationAtChunkCut) {
+  const size_t chunkBytes = 1 << 20; // the reader's chunk size
+  std::string head = "v 0 0 0\nv 1 0 0\nv 0 1 0\n#";
+  std::string tail = "\nf 1 2 \\\r\n3\n";
+
+  // Put the cut point on the backslash, and on each character of the line break after it
+  size_t backslash = tail.find('\\');
+  for (size_t cutAt = backslash; cutAt <= backslash + 2; cutAt++) {
+    std::ofstream out("test_continuation.obj", std::ios::binary);
+    out << head << std::string(chunkBytes - head.size() - cutAt, 'x') << tail;
+    out.close();
+
+    std::vector<std::array<double, 3>> vertices;
+    std::vector<std::vector<size_t>> faces;
+    polyscope::loadPolygonSoup("test_continuation.obj", vertices, faces);
+    std::remove("test_continuation.obj");
+
+    EXPECT_EQ(vertices.size(), 3u);
+    ASSERT_EQ(faces.size(), 1u);
+    EXPECT_EQ(faces[0], std::vector<size_t>({0, 1, 2}));
+  }
+}
+
 
 TEST_F(PolyscopeTest, SurfaceMeshVertexCount) {
   auto psMesh = registerTriangleMesh();
@@ -654,11 +1432,559 @@ TEST_F(PolyscopeTest, CurveNetworkFaceVector) {
 }
 
 
+// ============================================================
+// =============== Volume grid tests
+// ============================================================
+
+// Samples of (radius - distance from the center of the grid), so the zero isosurface is a sphere
+std::vector<float> getSphereVolume(size_t n, float radius) {
+  std::vector<float> values(n * n * n);
+  float center = .5 * (n - 1);
+  for (size_t k = 0; k < n; k++) {
+    for (size_t j = 0; j < n; j++) {
+      for (size_t i = 0; i < n; i++) {
+        values[i + n * (j + n * k)] = radius - glm::length(glm::vec3{i, j, k} - center);
+      }
+    }
+  }
+  return values;
+}
+
+TEST_F(PolyscopeTest, ShowVolumeGrid) {
+  size_t n = 16;
+  auto psGrid = polyscope::registerVolumeGrid("vol", glm::uvec3(n), glm::vec3{0., 0., 0.}, glm::vec3{.1, .1, .1},
+                                              getSphereVolume(n, 5.));
+  EXPECT_TRUE(polyscope::hasVolumeGrid("vol"));
+  EXPECT_EQ(psGrid->nSamples(), n * n * n);
+  polyscope::show(3);
+
+  // All of the slices
+  for (int axis = 0; axis < 3; axis++) {
+    psGrid->setAxisSliceEnabled(axis, true);
+    psGrid->setAxisSlicePosition(axis, .3);
+  }
+  psGrid->setPlaneSliceEnabled(true);
+  psGrid->setPlaneSlice(glm::vec3{.7, .7, .7}, glm::vec3{1., 2., 3.});
+  psGrid->setColorMap("blues");
+  polyscope::show(3);
+
+  // Isosurface, moving the iso-value while it is shown
+  psGrid->setIsosurfaceEnabled(true);
+  polyscope::show(3);
+  psGrid->setIsoValue(1.);
+  polyscope::show(3);
+  psGrid->setMaterial("wax");
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+  EXPECT_FALSE(polyscope::hasVolumeGrid("vol"));
+}
+
+TEST_F(PolyscopeTest, VolumeGridIsosurfaceSphere) {
+  size_t n = 24;
+  float radius = 8.;
+  auto psGrid = polyscope::registerVolumeGrid("vol", glm::uvec3(n), glm::vec3{0., 0., 0.}, glm::vec3{1., 1., 1.},
+                                              getSphereVolume(n, radius));
+  psGrid->setIsoValue(0.);
+  const polyscope::VolumeGridIsosurface& surface = psGrid->getIsosurface();
+  ASSERT_GT(surface.triangles.size(), 0u);
+  EXPECT_EQ(surface.normals.size(), surface.vertices.size());
+
+  // Vertices are on the sphere, and normals point outwards
+  float center = .5 * (n - 1);
+  for (size_t iV = 0; iV < surface.vertices.size(); iV++) {
+    glm::vec3 offset = surface.vertices[iV] - center;
+    EXPECT_NEAR(glm::length(offset), radius, .1);
+    EXPECT_GT(glm::dot(surface.normals[iV], offset), 0.);
+  }
+
+  // The surface is closed and consistently oriented: every directed edge appears once, and its twin once
+  std::vector<std::pair<uint32_t, uint32_t>> edges;
+  for (const std::array<uint32_t, 3>& tri : surface.triangles) {
+    for (int j = 0; j < 3; j++) {
+      edges.emplace_back(tri[j], tri[(j + 1) % 3]);
+    }
+  }
+  std::sort(edges.begin(), edges.end());
+  EXPECT_TRUE(std::adjacent_find(edges.begin(), edges.end()) == edges.end());
+  for (const std::pair<uint32_t, uint32_t>& e : edges) {
+    EXPECT_TRUE(std::binary_search(edges.begin(), edges.end(), std::make_pair(e.second, e.first)));
+  }
+
+  // Registering it as a mesh works like any other mesh
+  polyscope::SurfaceMesh* psMesh = psGrid->registerIsosurfaceAsMesh();
+  EXPECT_EQ(psMesh->nVertices(), surface.vertices.size());
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, VolumeGrid16Bit) {
+  size_t n = 8;
+  std::vector<uint16_t> values(n * n * n);
+  for (size_t i = 0; i < values.size(); i++) {
+    values[i] = static_cast<uint16_t>(i);
+  }
+  auto psGrid = polyscope::registerVolumeGrid("vol", glm::uvec3(n), glm::vec3{0., 0., 0.}, glm::vec3{1., 1., 1.},
+                                              values, polyscope::VolumeDataType::UInt16);
+  EXPECT_EQ(psGrid->getSample(1, 2, 3), 1 + n * (2 + n * 3));
+  psGrid->setIsosurfaceEnabled(true);
+  polyscope::show(3);
+
+  // 0x3c00 is 1 in half precision
+  std::vector<uint16_t> halfValues(n * n * n, 0x3c00);
+  auto psHalfGrid = polyscope::registerVolumeGrid("half vol", glm::uvec3(n), glm::vec3{0., 0., 0.},
+                                                  glm::vec3{1., 1., 1.}, halfValues, polyscope::VolumeDataType::Half);
+  EXPECT_EQ(psHalfGrid->getSample(4, 4, 4), 1.);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, VolumeGridFromRawFile) {
+  // A small header, then float samples
+  size_t n = 8;
+  size_t headerBytes = 16;
+  std::vector<float> values = getSphereVolume(n, 3.);
+  {
+    std::ofstream out("test_volume.raw", std::ios::binary);
+    out << std::string(headerBytes, 'h');
+    out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(float));
+  }
+
+  auto psGrid = polyscope::registerVolumeGridFromRawFile("raw vol", "test_volume.raw", glm::uvec3(n),
+                                                         glm::vec3{0., 0., 0.}, glm::vec3{1., 1., 1.},
+                                                         polyscope::VolumeDataType::Float, headerBytes);
+  ASSERT_NE(psGrid, nullptr);
+  EXPECT_EQ(psGrid->nSamples(), n * n * n);
+  EXPECT_EQ(psGrid->getSample(1, 2, 3), values[1 + n * (2 + n * 3)]);
+  EXPECT_EQ(psGrid->getSample(n - 1, n - 1, n - 1), values.back());
+  psGrid->setAxisSliceEnabled(2, true);
+  psGrid->setIsosurfaceEnabled(true);
+  polyscope::show(3);
+
+  // (the file is mapped until the grid is removed)
+  polyscope::removeAllStructures();
+  std::remove("test_volume.raw");
+}
+
+
+TEST_F(PolyscopeTest, SparseVolumeGrid) {
+  // A sphere in the middle of a mostly empty grid, clamped to a background value away from it
+  size_t n = 40;
+  std::vector<float> values = getSphereVolume(n, 8.);
+  for (float& v : values) {
+    v = std::max(v, -2.f);
+  }
+  polyscope::VolumeGridSamples dense(&values.front(), polyscope::VolumeDataType::Float, glm::uvec3(n));
+  polyscope::VolumeGridBricks bricks = polyscope::makeVolumeGridBricks(dense, -2.);
+  EXPECT_LT(bricks.nStoredBricks(), bricks.brickIndex.size());
+  EXPECT_GT(bricks.nStoredBricks(), 0u);
+
+  // The same bricks can be given directly
+  polyscope::VolumeGridBricks sameBricks =
+      polyscope::makeVolumeGridBricks(glm::uvec3(n), bricks.brickCoords, bricks.brickSamples, -2.);
+  EXPECT_EQ(sameBricks.brickIndex, bricks.brickIndex);
+
+  auto psDense = polyscope::registerVolumeGrid("dense", glm::uvec3(n), glm::vec3{0., 0., 0.}, glm::vec3{1., 1., 1.},
+                                               values);
+  auto psSparse = polyscope::registerSparseVolumeGrid("sparse", glm::vec3{0., 0., 0.}, glm::vec3{1., 1., 1.}, bricks);
+  EXPECT_TRUE(psSparse->isSparse());
+  EXPECT_EQ(psSparse->getSample(20, 17, 22), psDense->getSample(20, 17, 22));
+  EXPECT_EQ(psSparse->getSample(39, 39, 39), -2.);
+
+  // Isosurfaces match the dense grid
+  for (double isoValue : {0., -1.5}) {
+    psDense->setIsoValue(isoValue);
+    psSparse->setIsoValue(isoValue);
+    EXPECT_EQ(psSparse->getIsosurface().triangles, psDense->getIsosurface().triangles);
+    EXPECT_EQ(psSparse->getIsosurface().vertices, psDense->getIsosurface().vertices);
+  }
+
+  // Slices, with a budget too small for all of their bricks
+  psSparse->setAxisSliceEnabled(0, true);
+  psSparse->setPlaneSliceEnabled(true);
+  psSparse->setIsosurfaceEnabled(true);
+  polyscope::show(3);
+  psSparse->setBrickMemoryBudget(1 << 16);
+  polyscope::show(3);
+  psSparse->setAxisSlicePosition(2, .1);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, VolumeGridBrickCache) {
+  polyscope::VolumeGridBrickCache cache(3);
+  std::vector<std::pair<uint32_t, uint32_t>> toUpload;
+
+  std::vector<uint32_t> slots = cache.request({10, 11, 12}, toUpload);
+  EXPECT_EQ(toUpload.size(), 3u);
+  EXPECT_EQ(cache.nResident(), 3u);
+
+  // Resident bricks keep their slots, and new ones evict the least recently used
+  toUpload.clear();
+  std::vector<uint32_t> newSlots = cache.request({12, 13}, toUpload);
+  EXPECT_EQ(newSlots[0], slots[2]);
+  ASSERT_EQ(toUpload.size(), 1u);
+  EXPECT_EQ(toUpload[0], std::make_pair(13u, slots[0]));
+
+  // Requests larger than the cache fill it and leave the rest out
+  toUpload.clear();
+  newSlots = cache.request({1, 2, 3, 4}, toUpload);
+  EXPECT_EQ(toUpload.size(), 3u);
+  EXPECT_EQ(std::count(newSlots.begin(), newSlots.end(), polyscope::VolumeGridBrickCache::noSlot), 1);
+}
+
+
+// ============================================================
+// =============== Volume mesh tests
+// ============================================================
+
+// A block of n^3 unit cubes, as hexes
+void getHexBlock(size_t n, std::vector<glm::vec3>& vertices, std::vector<std::array<size_t, 8>>& hexes) {
+  auto vInd = [&](size_t i, size_t j, size_t k) { return i + (n + 1) * (j + (n + 1) * k); };
+  vertices.clear();
+  hexes.clear();
+  for (size_t k = 0; k <= n; k++) {
+    for (size_t j = 0; j <= n; j++) {
+      for (size_t i = 0; i <= n; i++) {
+        vertices.push_back(glm::vec3{i, j, k});
+      }
+    }
+  }
+  for (size_t k = 0; k < n; k++) {
+    for (size_t j = 0; j < n; j++) {
+      for (size_t i = 0; i < n; i++) {
+        hexes.push_back({vInd(i, j, k), vInd(i + 1, j, k), vInd(i + 1, j + 1, k), vInd(i, j + 1, k),
+                         vInd(i, j, k + 1), vInd(i + 1, j, k + 1), vInd(i + 1, j + 1, k + 1), vInd(i, j + 1, k + 1)});
+      }
+    }
+  }
+}
+
+// The same block, with each cube split into 6 tets around its diagonal
+std::vector<std::array<size_t, 4>> getTetBlock(const std::vector<std::array<size_t, 8>>& hexes) {
+  std::vector<std::array<size_t, 4>> tets;
+  const size_t paths[6][4] = {{0, 1, 2, 6}, {0, 2, 3, 6}, {0, 3, 7, 6}, {0, 7, 4, 6}, {0, 4, 5, 6}, {0, 5, 1, 6}};
+  for (const std::array<size_t, 8>& hex : hexes) {
+    for (const auto& path : paths) {
+      tets.push_back({hex[path[0]], hex[path[1]], hex[path[2]], hex[path[3]]});
+    }
+  }
+  return tets;
+}
+
+TEST_F(PolyscopeTest, ShowVolumeMesh) {
+  size_t n = 3;
+  std::vector<glm::vec3> vertices;
+  std::vector<std::array<size_t, 8>> hexes;
+  getHexBlock(n, vertices, hexes);
+
+  auto psMesh = polyscope::registerHexMesh("vmesh", vertices, hexes);
+  EXPECT_TRUE(polyscope::hasVolumeMesh("vmesh"));
+  EXPECT_EQ(psMesh->nHexes(), n * n * n);
+  EXPECT_EQ(psMesh->nExteriorFaces(), 6 * n * n);
+  polyscope::show(3);
+
+  // Slice and edges, moving the slice while it is shown
+  psMesh->setPlaneSliceEnabled(true);
+  polyscope::show(3);
+  psMesh->setPlaneSlice(glm::vec3{1.5, 1.5, 1.5}, glm::vec3{1., 2., 3.});
+  psMesh->setEdgeWidth(1.);
+  polyscope::show(3);
+
+  // Scalars
+  std::vector<double> vScalar(psMesh->nVertices(), 7.);
+  std::vector<double> cScalar(psMesh->nCells(), 7.);
+  auto q1 = psMesh->addVertexScalarQuantity("vScalar", vScalar);
+  q1->setEnabled(true);
+  polyscope::show(3);
+  auto q2 = psMesh->addCellScalarQuantity("cScalar", cScalar);
+  q2->setEnabled(true);
+  polyscope::show(3);
+  psMesh->setPlaneSlice(glm::vec3{1., 1., 1.}, glm::vec3{-1., 0., 0.});
+  polyscope::show(3);
+
+  // A mix of tets and hexes
+  std::vector<std::vector<size_t>> cells = {{0, 1, 4, 16}, {1, 2, 6, 5, 17, 18, 22, 21}};
+  auto psMixed = polyscope::registerVolumeMesh("mixed", vertices, cells);
+  EXPECT_EQ(psMixed->nTets(), 1u);
+  EXPECT_EQ(psMixed->nHexes(), 1u);
+  EXPECT_EQ(psMixed->getSlicePlane().point, glm::vec3(1.5, 1.5, 1.5)); // starts through the middle
+  polyscope::show(3);
+
+  // The slice point is remembered when a mesh with the same name is registered again
+  polyscope::removeStructure("vmesh");
+  psMesh = polyscope::registerHexMesh("vmesh", vertices, hexes);
+  EXPECT_EQ(psMesh->getSlicePlane().point, glm::vec3(1., 1., 1.));
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+  EXPECT_FALSE(polyscope::hasVolumeMesh("vmesh"));
+}
+
+TEST_F(PolyscopeTest, VolumeMeshExteriorAndSlice) {
+  size_t n = 4;
+  std::vector<glm::vec3> vertices;
+  std::vector<std::array<size_t, 8>> hexes;
+  getHexBlock(n, vertices, hexes);
+  polyscope::VolumeMeshCells cells = polyscope::makeVolumeMeshCells(getTetBlock(hexes));
+  EXPECT_EQ(polyscope::validateVolumeMeshCells(cells, vertices.size()), cells.nCells());
+
+  // The exterior is two triangles on each face of each boundary cube, all facing outwards
+  polyscope::VolumeMeshExterior exterior = polyscope::computeVolumeMeshExterior(vertices, cells);
+  ASSERT_EQ(exterior.nFaces(), 12 * n * n);
+  glm::vec3 center{.5 * n, .5 * n, .5 * n};
+  for (const std::array<uint32_t, 4>& face : exterior.faces) {
+    EXPECT_EQ(face[3], polyscope::VolumeMeshCells::noVertex);
+    glm::vec3 a = vertices[face[0]], b = vertices[face[1]], c = vertices[face[2]];
+    EXPECT_GT(glm::dot(glm::cross(b - a, c - a), (a + b + c) / 3.f - center), 0.);
+  }
+
+  // Slicing off the top half leaves a box with a cross-section of area n^2, and interpolates values onto it
+  float height = .5 * n + .3;
+  polyscope::VolumeMeshSlicePlane slice;
+  slice.enabled = true;
+  slice.point = glm::vec3{0., 0., height};
+  slice.normal = glm::vec3{0., 0., 1.};
+  std::vector<double> values(vertices.size());
+  for (size_t iV = 0; iV < vertices.size(); iV++) {
+    values[iV] = vertices[iV].z;
+  }
+  polyscope::VolumeMeshTriangles triangles =
+      polyscope::triangulateVolumeMesh(vertices, cells, exterior, slice, &values, false);
+  ASSERT_EQ(triangles.values.size(), triangles.positions.size());
+  double area = 0.;
+  double sliceArea = 0.;
+  for (size_t iT = 0; iT < triangles.nTriangles(); iT++) {
+    glm::vec3 a = triangles.positions[3 * iT], b = triangles.positions[3 * iT + 1], c = triangles.positions[3 * iT + 2];
+    double triArea = .5 * glm::length(glm::cross(b - a, c - a));
+    area += triArea;
+    if (triangles.normals[3 * iT] == slice.normal) {
+      sliceArea += triArea;
+    }
+    for (int j = 0; j < 3; j++) {
+      EXPECT_LE(triangles.positions[3 * iT + j].z, height + 1e-5);
+      EXPECT_NEAR(triangles.values[3 * iT + j], triangles.positions[3 * iT + j].z, 1e-5);
+    }
+  }
+  EXPECT_NEAR(sliceArea, n * n, 1e-3);
+  EXPECT_NEAR(area, 2. * n * n + 4. * n * height, 1e-3);
+}
+
+
 // ============================================================
 // =============== Combo test
 // ============================================================
 
 
+// Everything in the scene can be saved to a snapshot and loaded back
+TEST_F(PolyscopeTest, SnapshotSaveLoad) {
+  auto psMesh = registerTriangleMesh("snapshot mesh");
+  std::vector<double> vScalar(psMesh->nVertices(), 7.);
+  auto q = psMesh->addVertexScalarQuantity("vScalar", vScalar);
+  q->setEnabled(true);
+  q->setMapRange(std::make_pair(-1., 3.));
+  psMesh->setSurfaceColor(glm::vec3{0.1, 0.2, 0.3});
+  std::vector<glm::vec3> faceNormals = psMesh->faceNormals;
+
+  auto psPoints = registerPointCloud("snapshot points");
+  std::vector<glm::vec3> colors(psPoints->nPoints(), glm::vec3{.5, .5, .5});
+  psPoints->addColorQuantity("colors", colors);
+
+  polyscope::saveSnapshot("test_snapshot.pssnap");
+  polyscope::loadSnapshot("test_snapshot.pssnap");
+  std::remove("test_snapshot.pssnap");
+
+  ASSERT_TRUE(polyscope::hasSurfaceMesh("snapshot mesh"));
+  ASSERT_TRUE(polyscope::hasPointCloud("snapshot points"));
+  psMesh = polyscope::getSurfaceMesh("snapshot mesh");
+  EXPECT_EQ(psMesh->faceNormals, faceNormals);
+  EXPECT_EQ(psMesh->getSurfaceColor(), glm::vec3(0.1, 0.2, 0.3));
+  auto loadedQ = dynamic_cast<polyscope::SurfaceVertexScalarQuantity*>(psMesh->getQuantity("vScalar"));
+  ASSERT_NE(loadedQ, nullptr);
+  EXPECT_TRUE(loadedQ->isEnabled());
+  EXPECT_EQ(loadedQ->getMapRange(), std::make_pair(-1., 3.));
+  EXPECT_NE(polyscope::getPointCloud("snapshot points")->getQuantity("colors"), nullptr);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+// Write a snapshot file holding a structure (as it would write itself) followed by a quantity chunk, whose data is
+// written by `writeQuantity`
+void writeSnapshotWithQuantity(polyscope::Structure& s, std::string kind,
+                               std::function<void(polyscope::SnapshotWriter&)> writeQuantity) {
+  polyscope::SnapshotWriter writer;
+  writer.beginChunk("STRC");
+  writer.writeString(s.typeName());
+  writer.writeString(s.name);
+  s.writeSnapshot(writer);
+  writer.beginChunk("QNTY");
+  writer.writeString(kind);
+  writer.writeString("bad quantity");
+  writer.write<char>(true);
+  writeQuantity(writer);
+  writer.endChunk();
+  writer.endChunk();
+  writer.writeToFile("test_snapshot.pssnap");
+}
+
+// Snapshots with inconsistent data are rejected, rather than read out of bounds
+TEST_F(PolyscopeTest, SnapshotCorruptData) {
+  polyscope::options::errorsThrowExceptions = true;
+
+  // A surface mesh quantity with too few values
+  auto psMesh = registerTriangleMesh("snapshot mesh");
+  writeSnapshotWithQuantity(*psMesh, "faceScalar", [&](polyscope::SnapshotWriter& writer) {
+    writer.write<polyscope::DataType>(polyscope::DataType::STANDARD);
+    writer.writeArray(std::vector<double>(psMesh->nFaces() - 1, 1.));
+    writer.write<double>(0.);
+    writer.write<double>(1.);
+  });
+  EXPECT_THROW(polyscope::loadSnapshot("test_snapshot.pssnap"), std::logic_error);
+  ASSERT_TRUE(polyscope::hasSurfaceMesh("snapshot mesh")); // (the mesh itself was valid)
+  EXPECT_EQ(polyscope::getSurfaceMesh("snapshot mesh")->getQuantity("bad quantity"), nullptr);
+
+  polyscope::removeAllStructures();
+
+  // A point cloud quantity with an invalid enum
+  auto psPoints = registerPointCloud("snapshot points");
+  writeSnapshotWithQuantity(*psPoints, "vector", [&](polyscope::SnapshotWriter& writer) {
+    writer.write<int>(7); // not a VectorType
+    writer.writeArray(std::vector<glm::vec3>(psPoints->nPoints()));
+  });
+  EXPECT_THROW(polyscope::loadSnapshot("test_snapshot.pssnap"), std::logic_error);
+
+  polyscope::removeAllStructures();
+
+  // A point cloud quantity with too many values
+  psPoints = registerPointCloud("snapshot points");
+  writeSnapshotWithQuantity(*psPoints, "color", [&](polyscope::SnapshotWriter& writer) {
+    writer.writeArray(std::vector<glm::vec3>(psPoints->nPoints() + 1));
+  });
+  EXPECT_THROW(polyscope::loadSnapshot("test_snapshot.pssnap"), std::logic_error);
+
+  polyscope::removeAllStructures();
+
+  // A curve network quantity with too few values
+  std::vector<glm::vec3> nodes = {{0, 0, 0}, {1, 0, 0}, {1, 1, 0}};
+  std::vector<std::array<size_t, 2>> edges = {{{0, 1}}, {{1, 2}}};
+  auto psCurve = polyscope::registerCurveNetwork("snapshot curve", nodes, edges);
+  writeSnapshotWithQuantity(*psCurve, "edgeColor", [&](polyscope::SnapshotWriter& writer) {
+    writer.writeArray(std::vector<glm::vec3>(1));
+  });
+  EXPECT_THROW(polyscope::loadSnapshot("test_snapshot.pssnap"), std::logic_error);
+
+  { // A curve network edge with an invalid node
+    polyscope::SnapshotWriter writer;
+    writer.beginChunk("STRC");
+    writer.writeString(polyscope::CurveNetwork::structureTypeName);
+    writer.writeString("snapshot curve");
+    writer.writeArray(nodes);
+    writer.writeArray(std::vector<std::array<size_t, 2>>{{{0, 1}}, {{1, 3}}});
+    writer.endChunk();
+    writer.writeToFile("test_snapshot.pssnap");
+  }
+  EXPECT_THROW(polyscope::loadSnapshot("test_snapshot.pssnap"), std::logic_error);
+  EXPECT_FALSE(polyscope::hasCurveNetwork("snapshot curve"));
+
+  // Scene options with an invalid enum are rejected, and out of range values are clamped
+  auto writeOptions = [](int groundPlaneMode, int32_t ssaaFactor) {
+    polyscope::SnapshotWriter writer;
+    writer.beginChunk("OPTS");
+    writer.write<int>(groundPlaneMode);
+    writer.write<polyscope::ScaledValue<float>>(polyscope::relativeValue(0.f));
+    writer.write<int32_t>(2);
+    writer.write<float>(0.25);
+    writer.write<int32_t>(ssaaFactor);
+    writer.write<char>(false);
+    writer.write<polyscope::TransparencyMode>(polyscope::TransparencyMode::None);
+    writer.write<int32_t>(8);
+    writer.endChunk();
+    writer.writeToFile("test_snapshot.pssnap");
+  };
+  float shadowDarkness = polyscope::options::shadowDarkness;
+  writeOptions(12, 2);
+  EXPECT_THROW(polyscope::loadSnapshot("test_snapshot.pssnap"), std::logic_error);
+  EXPECT_EQ(polyscope::options::shadowDarkness.get(), shadowDarkness); // nothing was applied
+  writeOptions(static_cast<int>(polyscope::GroundPlaneMode::Tile), 100);
+  polyscope::loadSnapshot("test_snapshot.pssnap");
+  EXPECT_EQ(polyscope::options::ssaaFactor.get(), 4);
+  EXPECT_EQ(polyscope::options::shadowDarkness.get(), 0.25);
+  polyscope::options::ssaaFactor = 1;
+  polyscope::options::shadowDarkness = shadowDarkness;
+  polyscope::options::groundPlaneMode = polyscope::GroundPlaneMode::TileReflection;
+  polyscope::show(3);
+
+  std::remove("test_snapshot.pssnap");
+  polyscope::options::errorsThrowExceptions = false;
+  polyscope::removeAllStructures();
+}
+
+// A recorded trace replays the same structures and frames
+TEST_F(PolyscopeTest, ApiTraceRecordReplay) {
+  polyscope::startTrace("test_trace.pstrace");
+  EXPECT_TRUE(polyscope::isTracing());
+
+  auto psMesh = registerTriangleMesh("trace mesh");
+  auto psPoints = registerPointCloud("trace points");
+  std::vector<double> scalar(psPoints->nPoints(), 2.);
+  psPoints->addScalarQuantity("scalar", scalar)->setEnabled(true);
+  polyscope::show(2);
+  psPoints->setEnabled(false);
+  polyscope::show(1);
+  polyscope::removeStructure(psMesh);
+  polyscope::show(1);
+  polyscope::stopTrace();
+  EXPECT_FALSE(polyscope::isTracing());
+
+  polyscope::removeAllStructures();
+  EXPECT_EQ(polyscope::replayTrace("test_trace.pstrace"), 4u);
+  std::remove("test_trace.pstrace");
+
+  EXPECT_FALSE(polyscope::hasSurfaceMesh("trace mesh"));
+  ASSERT_TRUE(polyscope::hasPointCloud("trace points"));
+  psPoints = polyscope::getPointCloud("trace points");
+  EXPECT_FALSE(psPoints->isEnabled());
+  ASSERT_NE(psPoints->getQuantity("scalar"), nullptr);
+  EXPECT_TRUE(psPoints->getQuantity("scalar")->isEnabled());
+  polyscope::removeAllStructures();
+}
+
+// Long lists of structures and quantities switch to the clipped list UI
+TEST_F(PolyscopeTest, LongStructureAndQuantityLists) {
+  for (int i = 0; i < 40; i++) {
+    polyscope::registerPointCloud("list" + std::to_string(i), getPoints());
+  }
+  auto psMesh = registerTriangleMesh();
+  std::vector<double> vScalar(psMesh->nVertices(), 7.);
+  for (int i = 0; i < 40; i++) {
+    psMesh->addVertexScalarQuantity("vScalar" + std::to_string(i), vScalar);
+  }
+  ASSERT_GE(polyscope::state::structures[polyscope::PointCloud::structureTypeName].size(),
+            polyscope::ClippedListUI::minItems);
+  ASSERT_GE(psMesh->quantities.size(), polyscope::ClippedListUI::minItems);
+  psMesh->getQuantity("vScalar7")->setEnabled(true);
+  polyscope::show(3);
+
+  // Removing items while the clipped lists are showing them
+  psMesh->removeQuantity("vScalar3");
+  polyscope::removeStructure("list5");
+  polyscope::show(3);
+
+  EXPECT_EQ(polyscope::state::structures[polyscope::PointCloud::structureTypeName].size(), 39u);
+  EXPECT_FALSE(polyscope::hasPointCloud("list5"));
+  EXPECT_TRUE(polyscope::hasPointCloud("list6"));
+  EXPECT_EQ(psMesh->quantities.size(), 39u);
+  EXPECT_EQ(psMesh->getQuantity("vScalar3"), nullptr);
+  ASSERT_NE(psMesh->getQuantity("vScalar7"), nullptr);
+  EXPECT_TRUE(psMesh->getQuantity("vScalar7")->isEnabled());
+
+  polyscope::removeAllStructures();
+}
+
 // Register a handful of quantities / structures, then call refresh
 TEST_F(PolyscopeTest, RefreshMultiTest) {
 